@@ -4,6 +4,7 @@
 
 #include <string>
 #include <stdexcept>
+#include <algorithm>
 #include <cstring>
 
 #include <zlib.h>
@@ -98,3 +99,153 @@ bool decompress_string(const std::string& str, std::string *dest) {
 	*dest = outstring;
 	return true;
 }
+
+// LZ4 block format: a series of sequences, each a token (literal length << 4 | match length - 4),
+// the literals, and a 16-bit little endian match offset. Lengths of 15 continue in following bytes.
+// The last sequence only has literals.
+
+int lz4_decompress_block(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity) {
+	const uint8_t *ip = src;
+	const uint8_t *const ipEnd = src + srcSize;
+	uint8_t *op = dst;
+	uint8_t *const opEnd = dst + dstCapacity;
+
+	auto readLength = [&](size_t len, size_t *out) {
+		if (len == 15) {
+			uint8_t b;
+			do {
+				if (ip >= ipEnd)
+					return false;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		*out = len;
+		return true;
+	};
+
+	while (ip < ipEnd) {
+		const uint8_t token = *ip++;
+		size_t literals;
+		if (!readLength(token >> 4, &literals))
+			return -1;
+		if (literals > (size_t)(ipEnd - ip) || literals > (size_t)(opEnd - op))
+			return -1;
+		memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+
+		if (ip == ipEnd || op == opEnd) {
+			// The last sequence has no match. Stopping when full also skips any padding after the block.
+			break;
+		}
+
+		if (ipEnd - ip < 2)
+			return -1;
+		const size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst))
+			return -1;
+
+		size_t matchLen;
+		if (!readLength(token & 15, &matchLen))
+			return -1;
+		matchLen += 4;
+		if (matchLen > (size_t)(opEnd - op))
+			return -1;
+
+		const uint8_t *match = op - offset;
+		if (offset >= matchLen) {
+			memcpy(op, match, matchLen);
+			op += matchLen;
+		} else {
+			// Overlapping, repeats the last offset bytes.
+			for (size_t i = 0; i < matchLen; ++i)
+				*op++ = *match++;
+		}
+	}
+
+	return (int)(op - dst);
+}
+
+static inline uint32_t lz4_read32(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static bool lz4_write_sequence(uint8_t **opp, uint8_t *opEnd, const uint8_t *literals, size_t numLiterals, size_t offset, size_t matchLen) {
+	uint8_t *op = *opp;
+	// Worst case for the token, length bytes and offset.
+	const size_t worstCase = 1 + numLiterals / 255 + 1 + numLiterals + 2 + (matchLen / 255) + 1;
+	if (worstCase > (size_t)(opEnd - op))
+		return false;
+
+	auto writeLength = [&](size_t len) {
+		for (len -= 15; len >= 255; len -= 255)
+			*op++ = 255;
+		*op++ = (uint8_t)len;
+	};
+
+	uint8_t *token = op++;
+	*token = (uint8_t)(std::min(numLiterals, (size_t)15) << 4);
+	if (numLiterals >= 15)
+		writeLength(numLiterals);
+	memcpy(op, literals, numLiterals);
+	op += numLiterals;
+
+	if (matchLen != 0) {
+		*op++ = (uint8_t)offset;
+		*op++ = (uint8_t)(offset >> 8);
+		const size_t code = matchLen - 4;
+		*token |= (uint8_t)std::min(code, (size_t)15);
+		if (code >= 15)
+			writeLength(code);
+	}
+
+	*opp = op;
+	return true;
+}
+
+size_t lz4_compress_block(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity) {
+	// The format requires the last 5 bytes to be literals, and the last match to start 12 bytes before the end.
+	static const size_t LAST_LITERALS = 5;
+	static const size_t MATCH_START_LIMIT = 12;
+	static const int HASH_BITS = 12;
+
+	uint8_t *op = dst;
+	uint8_t *const opEnd = dst + dstCapacity;
+	size_t anchor = 0;
+
+	if (srcSize > MATCH_START_LIMIT) {
+		int32_t table[1 << HASH_BITS];
+		memset(table, 0xFF, sizeof(table));
+
+		const size_t matchStartEnd = srcSize - MATCH_START_LIMIT;
+		const size_t matchEnd = srcSize - LAST_LITERALS;
+		size_t pos = 0;
+		while (pos <= matchStartEnd) {
+			const uint32_t seq = lz4_read32(src + pos);
+			const uint32_t hash = (seq * 2654435761U) >> (32 - HASH_BITS);
+			const int32_t ref = table[hash];
+			table[hash] = (int32_t)pos;
+
+			if (ref < 0 || pos - ref > 65535 || lz4_read32(src + ref) != seq) {
+				pos++;
+				continue;
+			}
+
+			size_t len = 4;
+			while (pos + len < matchEnd && src[ref + len] == src[pos + len])
+				len++;
+			if (!lz4_write_sequence(&op, opEnd, src + anchor, pos - anchor, pos - ref, len))
+				return 0;
+			pos += len;
+			anchor = pos;
+		}
+	}
+
+	if (!lz4_write_sequence(&op, opEnd, src + anchor, srcSize - anchor, 0, 0))
+		return 0;
+	return op - dst;
+}
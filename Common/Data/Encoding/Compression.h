@@ -1,7 +1,16 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
-// inflate/deflate convenience wrapper. Uses zlib.
+// inflate/deflate convenience wrappers, using zlib.
 bool compress_string(const std::string& str, std::string *dest, int compressionlevel = 9);
 bool decompress_string(const std::string& str, std::string *dest);
+
+// Raw LZ4 blocks (no frame header), as used by ZSO and CSO v2 images.
+// Returns the number of bytes written to dst, or -1 if the data is corrupt or doesn't fit.
+// Decoding stops once dst is full, so padding after the block is ignored.
+int lz4_decompress_block(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity);
+// Simple greedy compressor. Returns 0 if the output wouldn't fit in dstCapacity.
+size_t lz4_compress_block(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity);
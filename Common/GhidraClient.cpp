@@ -198,7 +198,7 @@ bool GhidraClient::FetchResource(const std::string &path, std::string &outResult
 		pendingResult_.error = "can't resolve host";
 		return false;
 	}
-	bool cancelled = false;
+	std::atomic<bool> cancelled{ false };
 	if (!http.Connect(1, 5.0, &cancelled)) {
 		pendingResult_.error = "can't connect to host";
 		return false;
@@ -22,6 +22,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
+#include "Common/Log/LogManager.h"
 #include "StringUtils.h"
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/Thread/ThreadUtil.h"
@@ -92,6 +93,8 @@ bool HandleAssert(const char *function, const char *file, int line, const char *
 
 	// Normal logging (will also log to Android log)
 	ERROR_LOG(Log::System, "%s", formatted);
+	// With async logging, make sure it's actually out before we crash.
+	g_logManager.FlushAsync();
 	// Also do a simple printf for good measure, in case logging of System is disabled (should we disallow that?)
 	fprintf(stderr, "%s\n", formatted);
 
@@ -24,7 +24,9 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <ctime>
 
 #include "Common/Data/Encoding/Utf8.h"
 
@@ -134,6 +136,8 @@ void LogManager::Init(bool *enabledSetting, bool headless) {
 }
 
 void LogManager::Shutdown() {
+	StopAsyncWriter();
+
 	if (!initialized_) {
 		// already done
 		return;
@@ -290,8 +294,6 @@ void LogManager::LogLine(LogLevel level, Log type, const char *file, int line, c
 			message.log);
 	}
 
-	GetCurrentTimeFormatted(message.timestamp);
-
 	va_list args_copy;
 
 	va_copy(args_copy, args);
@@ -306,6 +308,17 @@ void LogManager::LogLine(LogLevel level, Log type, const char *file, int line, c
 	message.msg[neededBytes] = '\n';
 	va_end(args_copy);
 
+	if (asyncMode_ != LogAsyncMode::Off) {
+		// The writer thread fills in the timestamp, formatting it is surprisingly slow.
+		QueueMessage(std::move(message));
+		return;
+	}
+
+	GetCurrentTimeFormatted(message.timestamp);
+	OutputMessage(message, true);
+}
+
+void LogManager::OutputMessage(const LogMessage &message, bool flushFile) {
 	if (outputs_ & LogOutput::Stdio) {
 		// This has its own mutex.
 		StdioLog(message);
@@ -317,7 +330,9 @@ void LogManager::LogLine(LogLevel level, Log type, const char *file, int line, c
 			std::lock_guard<std::mutex> lk(logFileLock_);
 			fprintf(fp_, "%s %s %s", message.timestamp, message.header, message.msg.c_str());
 			// Is this really necessary to do every time? I guess to catch the last message before a crash..
-			fflush(fp_);
+			// The async writer only flushes once per batch.
+			if (flushFile)
+				fflush(fp_);
 		}
 	}
 
@@ -354,6 +369,228 @@ void LogManager::LogLine(LogLevel level, Log type, const char *file, int line, c
 	}
 }
 
+struct LogManager::AsyncEntry {
+	uint64_t sequence;
+	std::chrono::system_clock::time_point time;
+	LogMessage message;
+};
+
+// Same format as GetCurrentTimeFormatted(), but for when the message was queued.
+static void FormatQueuedTime(std::chrono::system_clock::time_point time, char formattedTime[13]) {
+	time_t sysTime = std::chrono::system_clock::to_time_t(time);
+	auto sinceEpoch = time.time_since_epoch();
+	uint32_t milliseconds = (uint32_t)(std::chrono::duration_cast<std::chrono::milliseconds>(sinceEpoch).count() % 1000);
+
+	struct tm *gmTime = localtime(&sysTime);
+	char tmp[6];
+	strftime(tmp, sizeof(tmp), "%M:%S", gmTime);
+	snprintf(formattedTime, 11, "%s:%03u", tmp, milliseconds);
+}
+
+// Only the owning thread pushes and only the writer thread pops, so no locks needed.
+struct LogManager::AsyncQueue {
+	enum { SIZE = 1024 };
+	AsyncEntry entries[SIZE];
+	std::atomic<uint32_t> head{ 0 };
+	std::atomic<uint32_t> tail{ 0 };
+	// Cleared when the thread exits, so a new thread can take over the queue.
+	std::atomic<bool> inUse{ true };
+};
+
+// How long queued messages may wait, unless a queue is filling up or there's a warning or error.
+static const int ASYNC_WRITE_INTERVAL_MS = 10;
+
+// Messages logged by the outputs themselves are written directly, the writer can't wait on itself.
+static thread_local bool isAsyncWriterThread = false;
+
+LogManager::AsyncQueue *LogManager::GetThreadQueue() {
+	struct ThreadQueue {
+		~ThreadQueue() {
+			if (queue)
+				queue->inUse = false;
+		}
+
+		LogManager *manager = nullptr;
+		std::shared_ptr<AsyncQueue> queue;
+	};
+	static thread_local ThreadQueue current;
+	if (current.manager == this)
+		return current.queue.get();
+
+	// First message from this thread (or it's switched managers, only happens in tests.)
+	if (current.queue)
+		current.queue->inUse = false;
+	current.queue.reset();
+
+	std::lock_guard<std::mutex> guard(asyncLock_);
+	for (auto &queue : asyncQueues_) {
+		bool expected = false;
+		if (queue->inUse.compare_exchange_strong(expected, true)) {
+			current.queue = queue;
+			break;
+		}
+	}
+	if (!current.queue) {
+		current.queue = std::make_shared<AsyncQueue>();
+		asyncQueues_.push_back(current.queue);
+	}
+	current.manager = this;
+	return current.queue.get();
+}
+
+void LogManager::QueueMessage(LogMessage &&message) {
+	if (isAsyncWriterThread) {
+		GetCurrentTimeFormatted(message.timestamp);
+		OutputMessage(message, true);
+		return;
+	}
+
+	AsyncQueue *queue = GetThreadQueue();
+	uint32_t head = queue->head.load(std::memory_order_relaxed);
+	while (head - queue->tail.load(std::memory_order_acquire) >= AsyncQueue::SIZE) {
+		if (asyncMode_ != LogAsyncMode::Block) {
+			asyncDropped_++;
+			return;
+		}
+		WakeAsyncWriter();
+		std::unique_lock<std::mutex> guard(asyncLock_);
+		asyncCond_.wait_for(guard, std::chrono::milliseconds(1));
+	}
+
+	// Warnings and errors go out right away, otherwise the writer picks things up on its own schedule.
+	const bool urgent = message.level <= LogLevel::LWARNING;
+	AsyncEntry &entry = queue->entries[head & (AsyncQueue::SIZE - 1)];
+	entry.sequence = asyncQueued_++;
+	entry.time = std::chrono::system_clock::now();
+	entry.message = std::move(message);
+	queue->head.store(head + 1, std::memory_order_release);
+	if (asyncIdle_ && (urgent || head - queue->tail.load(std::memory_order_relaxed) >= AsyncQueue::SIZE / 4))
+		WakeAsyncWriter();
+}
+
+void LogManager::WakeAsyncWriter() {
+	std::lock_guard<std::mutex> guard(asyncLock_);
+	asyncIdle_ = false;
+	asyncCond_.notify_all();
+}
+
+bool LogManager::CollectQueued(const std::vector<std::shared_ptr<AsyncQueue>> &queues, std::vector<AsyncEntry> &batch) {
+	batch.clear();
+	for (auto &queue : queues) {
+		uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+		uint32_t head = queue->head.load(std::memory_order_acquire);
+		for (; tail != head; ++tail) {
+			batch.push_back(std::move(queue->entries[tail & (AsyncQueue::SIZE - 1)]));
+		}
+		queue->tail.store(tail, std::memory_order_release);
+	}
+
+	// Put messages from different threads back in the order they were logged.
+	std::sort(batch.begin(), batch.end(), [](const AsyncEntry &a, const AsyncEntry &b) {
+		return a.sequence < b.sequence;
+	});
+	return !batch.empty();
+}
+
+void LogManager::WriteBatch(std::vector<AsyncEntry> &batch) {
+	for (AsyncEntry &entry : batch) {
+		FormatQueuedTime(entry.time, entry.message.timestamp);
+		OutputMessage(entry.message, false);
+	}
+
+	if (outputs_ & LogOutput::File) {
+		std::lock_guard<std::mutex> lk(logFileLock_);
+		if (fp_)
+			fflush(fp_);
+	}
+	asyncWritten_ += batch.size();
+}
+
+void LogManager::AsyncWriterThread() {
+	SetCurrentThreadName("LogWriter");
+	isAsyncWriterThread = true;
+
+	std::vector<std::shared_ptr<AsyncQueue>> queues;
+	std::vector<AsyncEntry> batch;
+	std::unique_lock<std::mutex> guard(asyncLock_);
+	while (true) {
+		// Queues are never removed, so this only needs to pick up new ones.
+		if (queues.size() != asyncQueues_.size())
+			queues = asyncQueues_;
+		guard.unlock();
+
+		bool wrote = CollectQueued(queues, batch);
+		if (wrote)
+			WriteBatch(batch);
+
+		guard.lock();
+		if (wrote) {
+			// Let any blocked or flushing threads know there's progress.
+			asyncCond_.notify_all();
+			continue;
+		}
+		if (asyncStop_)
+			break;
+
+		// Waking up on a timer means logging threads don't have to signal for every message.
+		asyncIdle_ = true;
+		asyncCond_.wait_for(guard, std::chrono::milliseconds(ASYNC_WRITE_INTERVAL_MS), [&] { return !asyncIdle_ || asyncStop_; });
+		asyncIdle_ = false;
+	}
+}
+
+void LogManager::SetAsyncMode(LogAsyncMode mode) {
+	if (mode == LogAsyncMode::Off) {
+		StopAsyncWriter();
+		return;
+	}
+
+	asyncMode_ = mode;
+	if (!asyncThread_.joinable()) {
+		asyncStop_ = false;
+		asyncThread_ = std::thread(&LogManager::AsyncWriterThread, this);
+	}
+}
+
+void LogManager::StopAsyncWriter() {
+	// From here on, new messages are written directly.  The writer drains everything else before exiting.
+	asyncMode_ = LogAsyncMode::Off;
+	if (!asyncThread_.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(asyncLock_);
+		asyncStop_ = true;
+		asyncCond_.notify_all();
+	}
+	asyncThread_.join();
+
+	// A thread may have queued something just before seeing the mode change, after the writer's last look.
+	std::vector<std::shared_ptr<AsyncQueue>> queues;
+	{
+		std::lock_guard<std::mutex> guard(asyncLock_);
+		queues = asyncQueues_;
+	}
+	std::vector<AsyncEntry> batch;
+	if (CollectQueued(queues, batch))
+		WriteBatch(batch);
+}
+
+void LogManager::FlushAsync() {
+	// The writer thread writes its own messages directly, and can't wait on itself.
+	if (!asyncThread_.joinable() || isAsyncWriterThread)
+		return;
+
+	const uint64_t target = asyncQueued_;
+	std::unique_lock<std::mutex> guard(asyncLock_);
+	asyncIdle_ = false;
+	asyncCond_.notify_all();
+	while (asyncWritten_ < target) {
+		// A thread may still be between taking a sequence number and publishing its message.
+		asyncCond_.wait_for(guard, std::chrono::milliseconds(1));
+	}
+}
+
 void RingbufferLog::Log(const LogMessage &message) {
 	messages_[curMessage_] = message;
 	curMessage_++;
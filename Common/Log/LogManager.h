@@ -19,7 +19,11 @@
 
 #include "ppsspp_config.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 #include <cstdio>
 
@@ -53,6 +57,16 @@ enum class LogOutput {
 };
 ENUM_CLASS_BITOPS(LogOutput);
 
+// In the async modes, LogLine only formats the message and queues it for a writer thread, which
+// does the actual output.  Each thread gets its own queue, so logging doesn't take any locks.
+enum class LogAsyncMode {
+	Off = 0,
+	// If a thread's queue is full, the message is dropped (see GetAsyncDroppedCount.)
+	Drop = 1,
+	// If a thread's queue is full, wait for the writer thread to catch up.
+	Block = 2,
+};
+
 class RingbufferLog {
 public:
 	void Log(const LogMessage &msg);
@@ -144,6 +158,16 @@ class LogManager {
 
 	void ChangeFileLog(const Path &filename);
 
+	void SetAsyncMode(LogAsyncMode mode);
+	LogAsyncMode GetAsyncMode() const {
+		return asyncMode_;
+	}
+	// Waits until everything queued so far has been written out.
+	void FlushAsync();
+	uint64_t GetAsyncDroppedCount() const {
+		return asyncDropped_;
+	}
+
 	void SaveConfig(Section *section);
 	void LoadConfig(const Section *section, bool debugDefaults);
 
@@ -156,6 +180,8 @@ class LogManager {
 
 	bool initialized_ = false;
 
+	void OutputMessage(const LogMessage &message, bool flushFile);
+
 #if PPSSPP_PLATFORM(WINDOWS)
 	ConsoleListener *consoleLog_ = nullptr;
 #endif
@@ -178,6 +204,29 @@ class LogManager {
 	// Callback
 	LogCallback externalCallback_ = nullptr;
 	void *externalUserData_ = nullptr;
+
+	// Async logging
+	struct AsyncQueue;
+	struct AsyncEntry;
+	AsyncQueue *GetThreadQueue();
+	void QueueMessage(LogMessage &&message);
+	bool CollectQueued(const std::vector<std::shared_ptr<AsyncQueue>> &queues, std::vector<AsyncEntry> &batch);
+	void WriteBatch(std::vector<AsyncEntry> &batch);
+	void WakeAsyncWriter();
+	void StopAsyncWriter();
+	void AsyncWriterThread();
+
+	std::atomic<LogAsyncMode> asyncMode_{ LogAsyncMode::Off };
+	std::thread asyncThread_;
+	std::mutex asyncLock_;
+	// The writer waits on this when idle, and blocked or flushing threads wait on it for progress.
+	std::condition_variable asyncCond_;
+	std::vector<std::shared_ptr<AsyncQueue>> asyncQueues_;
+	std::atomic<bool> asyncIdle_{ false };
+	bool asyncStop_ = false;
+	std::atomic<uint64_t> asyncQueued_{ 0 };
+	std::atomic<uint64_t> asyncWritten_{ 0 };
+	std::atomic<uint64_t> asyncDropped_{ 0 };
 };
 
 extern LogManager g_logManager;
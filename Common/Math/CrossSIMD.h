@@ -359,9 +359,49 @@ struct Vec8U16 {
 	static Vec8U16 Splat(uint16_t value) { return Vec8U16{ _mm_set1_epi16((int16_t)value) }; }
 
 	static Vec8U16 Load(const uint16_t *mem) { return Vec8U16{ _mm_loadu_si128((__m128i *)mem) }; }
+	// Zero-extends 8 bytes.
+	static Vec8U16 LoadU8(const uint8_t *mem) { return Vec8U16{ _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)mem), _mm_setzero_si128()) }; }
+	// Keeps the low 16 bits of 8 words. Sign extending first means the signed pack can't saturate.
+	static Vec8U16 LoadTruncateU32(const uint32_t *mem) {
+		__m128i lo = _mm_loadu_si128((const __m128i *)mem);
+		__m128i hi = _mm_loadu_si128((const __m128i *)(mem + 4));
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		return Vec8U16{ _mm_packs_epi32(lo, hi) };
+	}
 	void Store(uint16_t *mem) { _mm_storeu_si128((__m128i *)mem, v); }
+
+	Vec8U16 operator +(Vec8U16 other) const { return Vec8U16{ _mm_add_epi16(v, other.v) }; }
+	Vec8U16 operator |(Vec8U16 other) const { return Vec8U16{ _mm_or_si128(v, other.v) }; }
+	Vec8U16 operator &(Vec8U16 other) const { return Vec8U16{ _mm_and_si128(v, other.v) }; }
+	Vec8U16 AndNot(Vec8U16 inverted) const { return Vec8U16{ _mm_andnot_si128(inverted.v, v) }; }
 };
 
+// Writes a0 b0 c0 a1 b1 c1 ... (24 values), like NEON's vst3q_u16.
+// SSE2 has no full-width 16-bit shuffle, so we build a b c 0 groups and store them overlapping.
+// Each store's padding lane gets overwritten by the next one, and the last group is stored exactly.
+inline void StoreInterleaved3(uint16_t *dst, Vec8U16 a, Vec8U16 b, Vec8U16 c) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ab0 = _mm_unpacklo_epi16(a.v, b.v);  // a0 b0 a1 b1 a2 b2 a3 b3
+	const __m128i ab1 = _mm_unpackhi_epi16(a.v, b.v);  // a4 b4 a5 b5 a6 b6 a7 b7
+	const __m128i c0 = _mm_unpacklo_epi16(c.v, zero);  // c0 0 c1 0 c2 0 c3 0
+	const __m128i c1 = _mm_unpackhi_epi16(c.v, zero);  // c4 0 c5 0 c6 0 c7 0
+	const __m128i g01 = _mm_unpacklo_epi32(ab0, c0);   // a0 b0 c0 0 a1 b1 c1 0
+	const __m128i g23 = _mm_unpackhi_epi32(ab0, c0);
+	const __m128i g45 = _mm_unpacklo_epi32(ab1, c1);
+	const __m128i g67 = _mm_unpackhi_epi32(ab1, c1);
+	_mm_storel_epi64((__m128i *)dst, g01);
+	_mm_storel_epi64((__m128i *)(dst + 3), _mm_srli_si128(g01, 8));
+	_mm_storel_epi64((__m128i *)(dst + 6), g23);
+	_mm_storel_epi64((__m128i *)(dst + 9), _mm_srli_si128(g23, 8));
+	_mm_storel_epi64((__m128i *)(dst + 12), g45);
+	_mm_storel_epi64((__m128i *)(dst + 15), _mm_srli_si128(g45, 8));
+	_mm_storel_epi64((__m128i *)(dst + 18), g67);
+	const int a7b7 = _mm_cvtsi128_si32(_mm_srli_si128(g67, 8));
+	memcpy(dst + 21, &a7b7, sizeof(a7b7));
+	dst[23] = (uint16_t)_mm_extract_epi16(g67, 6);
+}
+
 inline Vec4U16 SignBits32ToMaskU16(Vec4S32 v) {
 	__m128i temp = _mm_srai_epi32(v.v, 31);
 	return Vec4U16 {
@@ -742,9 +782,27 @@ struct Vec8U16 {
 	static Vec8U16 Splat(uint16_t value) { return Vec8U16{ vdupq_n_u16(value) }; }
 
 	static Vec8U16 Load(const uint16_t *mem) { return Vec8U16{ vld1q_u16(mem) }; }
+	// Zero-extends 8 bytes.
+	static Vec8U16 LoadU8(const uint8_t *mem) { return Vec8U16{ vmovl_u8(vld1_u8(mem)) }; }
+	// Keeps the low 16 bits of 8 words.
+	static Vec8U16 LoadTruncateU32(const uint32_t *mem) { return Vec8U16{ vcombine_u16(vmovn_u32(vld1q_u32(mem)), vmovn_u32(vld1q_u32(mem + 4))) }; }
 	void Store(uint16_t *mem) { vst1q_u16(mem, v); }
+
+	Vec8U16 operator +(Vec8U16 other) const { return Vec8U16{ vaddq_u16(v, other.v) }; }
+	Vec8U16 operator |(Vec8U16 other) const { return Vec8U16{ vorrq_u16(v, other.v) }; }
+	Vec8U16 operator &(Vec8U16 other) const { return Vec8U16{ vandq_u16(v, other.v) }; }
+	Vec8U16 AndNot(Vec8U16 inverted) const { return Vec8U16{ vbicq_u16(v, inverted.v) }; }
 };
 
+// Writes a0 b0 c0 a1 b1 c1 ... (24 values).
+inline void StoreInterleaved3(uint16_t *dst, Vec8U16 a, Vec8U16 b, Vec8U16 c) {
+	uint16x8x3_t abc;
+	abc.val[0] = a.v;
+	abc.val[1] = b.v;
+	abc.val[2] = c.v;
+	vst3q_u16(dst, abc);
+}
+
 #else
 
 #define CROSSSIMD_SLOW 1
@@ -1186,9 +1244,60 @@ struct Vec8U16 {
 	}}; }
 
 	static Vec8U16 Load(const uint16_t *mem) { Vec8U16 tmp; memcpy(tmp.v, mem, sizeof(v)); return tmp; }
+	static Vec8U16 LoadU8(const uint8_t *mem) {
+		Vec8U16 tmp;
+		for (int i = 0; i < 8; i++) {
+			tmp.v[i] = mem[i];
+		}
+		return tmp;
+	}
+	static Vec8U16 LoadTruncateU32(const uint32_t *mem) {
+		Vec8U16 tmp;
+		for (int i = 0; i < 8; i++) {
+			tmp.v[i] = (uint16_t)mem[i];
+		}
+		return tmp;
+	}
 	void Store(uint16_t *mem) { memcpy(mem, v, sizeof(v)); }
+
+	Vec8U16 operator +(Vec8U16 other) const {
+		Vec8U16 temp;
+		for (int i = 0; i < 8; i++) {
+			temp.v[i] = (uint16_t)(v[i] + other.v[i]);
+		}
+		return temp;
+	}
+	Vec8U16 operator |(Vec8U16 other) const {
+		Vec8U16 temp;
+		for (int i = 0; i < 8; i++) {
+			temp.v[i] = v[i] | other.v[i];
+		}
+		return temp;
+	}
+	Vec8U16 operator &(Vec8U16 other) const {
+		Vec8U16 temp;
+		for (int i = 0; i < 8; i++) {
+			temp.v[i] = v[i] & other.v[i];
+		}
+		return temp;
+	}
+	Vec8U16 AndNot(Vec8U16 inverted) const {
+		Vec8U16 temp;
+		for (int i = 0; i < 8; i++) {
+			temp.v[i] = v[i] & ~inverted.v[i];
+		}
+		return temp;
+	}
 };
 
+inline void StoreInterleaved3(uint16_t *dst, Vec8U16 a, Vec8U16 b, Vec8U16 c) {
+	for (int i = 0; i < 8; i++) {
+		dst[i * 3 + 0] = a.v[i];
+		dst[i * 3 + 1] = b.v[i];
+		dst[i * 3 + 2] = c.v[i];
+	}
+}
+
 inline Vec4U16 SignBits32ToMaskU16(Vec4S32 v) {
 	return Vec4U16{ { (uint16_t)(v.v[0] >> 31), (uint16_t)(v.v[1] >> 31), (uint16_t)(v.v[2] >> 31), (uint16_t)(v.v[3] >> 31),  } };
 }
@@ -86,7 +86,7 @@ static void FormatAddr(char *addrbuf, size_t bufsize, const addrinfo *info) {
 	}
 }
 
-bool Connection::Connect(int maxTries, double timeout, bool *cancelConnect) {
+bool Connection::Connect(int maxTries, double timeout, const std::atomic<bool> *cancelConnect) {
 	if (port_ <= 0) {
 		ERROR_LOG(Log::IO, "Bad port");
 		return false;
@@ -343,7 +343,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, st
 		"Host: %s\r\n"
 		"User-Agent: %s\r\n"
 		"Accept: %s\r\n"
-		"Connection: close\r\n"
+		"Connection: %s\r\n"
 		"%s"
 		"\r\n";
 
@@ -352,6 +352,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, st
 		host_.c_str(),
 		userAgent_.c_str(),
 		req.acceptMime,
+		keepAlive_ ? "keep-alive" : "close",
 		otherHeaders ? otherHeaders : "");
 	buffer.Append(data);
 	bool flushed = buffer.FlushSocket(sock(), dataTimeout_, progress->cancelled);
@@ -364,28 +365,35 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, st
 int Client::ReadResponseHeaders(net::Buffer *readbuf, std::vector<std::string> &responseHeaders, net::RequestProgress *progress, std::string *statusLine) {
 	// Snarf all the data we can into RAM. A little unsafe but hey.
 	static constexpr float CANCEL_INTERVAL = 0.25f;
-	bool ready = false;
 	double endTimeout = time_now_d() + dataTimeout_;
-	while (!ready) {
-		if (progress->cancelled && *progress->cancelled)
-			return -1;
-		ready = fd_util::WaitUntilReady(sock(), CANCEL_INTERVAL, false);
-		if (!ready && time_now_d() > endTimeout) {
-			ERROR_LOG(Log::HTTP, "HTTP headers timed out");
-			return -1;
+	auto readMore = [&]() {
+		bool ready = false;
+		while (!ready) {
+			if (progress->cancelled && *progress->cancelled)
+				return false;
+			ready = fd_util::WaitUntilReady(sock(), CANCEL_INTERVAL, false);
+			if (!ready && time_now_d() > endTimeout) {
+				ERROR_LOG(Log::HTTP, "HTTP headers timed out");
+				return false;
+			}
+		}
+		size_t before = readbuf->size();
+		if (readbuf->Read(sock(), 4096) < 0 || readbuf->size() == before) {
+			ERROR_LOG(Log::HTTP, "Failed to read HTTP headers :(");
+			return false;
 		}
+		return true;
 	};
-	// Let's hope all the headers are available in a single packet...
-	if (readbuf->Read(sock(), 4096) < 0) {
-		ERROR_LOG(Log::HTTP, "Failed to read HTTP headers :(");
-		return -1;
+
+	// With keep-alive, this response might've arrived along with the last one, so only wait if we have to.
+	std::string line;
+	while (readbuf->TakeLineCRLF(&line) < 0) {
+		if (!readMore())
+			return -1;
 	}
 
 	// Grab the first header line that contains the http code.
 
-	std::string line;
-	readbuf->TakeLineCRLF(&line);
-
 	int code;
 	size_t code_pos = line.find(' ');
 	if (code_pos != line.npos) {
@@ -403,8 +411,15 @@ int Client::ReadResponseHeaders(net::Buffer *readbuf, std::vector<std::string> &
 		*statusLine = line;
 
 	while (true) {
+		line.clear();
 		int sz = readbuf->TakeLineCRLF(&line);
-		if (!sz || sz < 0)
+		if (sz < 0) {
+			// The rest didn't fit in the first packet.
+			if (!readMore())
+				return -1;
+			continue;
+		}
+		if (sz == 0)
 			break;
 		VERBOSE_LOG(Log::HTTP, "Header line: %s", line.c_str());
 		responseHeaders.push_back(line);
@@ -423,6 +438,7 @@ int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::stri
 
 	bool gzip = false;
 	bool chunked = false;
+	bool hasContentLength = false;
 	int contentLength = 0;
 	for (std::string line : responseHeaders) {
 		if (startsWithNoCase(line, "Content-Length:")) {
@@ -432,6 +448,7 @@ int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::stri
 			}
 			if (size_pos != line.npos) {
 				contentLength = atoi(&line[size_pos]);
+				hasContentLength = true;
 				chunked = false;
 			}
 		} else if (startsWithNoCase(line, "Content-Encoding:")) {
@@ -453,12 +470,21 @@ int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::stri
 		contentLength = 0;
 	}
 
-	if (!readbuf->ReadAllWithProgress(sock(), contentLength, progress))
+	// When keeping the connection open, we can't wait for the server to close it.
+	const bool exactLength = keepAlive_ && hasContentLength && !chunked;
+	if (exactLength) {
+		if (!readbuf->ReadAtLeast(sock(), contentLength, dataTimeout_, progress))
+			return -1;
+	} else if (!readbuf->ReadAllWithProgress(sock(), contentLength, progress)) {
 		return -1;
+	}
 
 	// output now contains the rest of the reply. Dechunk it.
 	if (!output->IsVoid()) {
-		if (chunked) {
+		if (exactLength) {
+			if (contentLength > 0)
+				readbuf->Take(contentLength, output->Append(contentLength));
+		} else if (chunked) {
 			if (!DeChunk(readbuf, output, contentLength)) {
 				ERROR_LOG(Log::HTTP, "Bad chunked data, couldn't read chunk size");
 				progress->Update(0, 0, true);
@@ -480,6 +506,8 @@ int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::stri
 			}
 			output->Append(decompressed);
 		}
+	} else if (exactLength) {
+		readbuf->Skip(contentLength);
 	}
 
 	progress->Update(contentLength, contentLength, true);
@@ -538,7 +566,7 @@ int HTTPRequest::Perform(const std::string &url) {
 	}
 
 	if (!client.Connect(2, 20.0, &cancelled_)) {
-		ERROR_LOG(Log::HTTP, "Failed connecting to server or cancelled (=%d).", cancelled_);
+		ERROR_LOG(Log::HTTP, "Failed connecting to server or cancelled (=%d).", (int)cancelled_);
 		return -1;
 	}
 
@@ -97,6 +97,7 @@ int RequestHeader::ParseHttpHeader(const char *buffer) {
 			type = FULL;
 		else
 			type = SIMPLE;
+		http11_ = strstr(buffer, "HTTP/1.1") != nullptr;
 		return 0;
 	}
 
@@ -155,6 +156,17 @@ void RequestHeader::ParseHeaders(net::InputSink *sink) {
 
 	VERBOSE_LOG(Log::IO, "finished parsing request.");
 	ok = line_count > 1 && resource != nullptr;
+
+	// HTTP/1.1 connections stay open unless the client says otherwise, 1.0 ones only if it asks.
+	keep_alive = http11_;
+	std::string connection;
+	if (GetOther("connection", &connection)) {
+		std::transform(connection.begin(), connection.end(), connection.begin(), tolower);
+		if (connection.find("close") != std::string::npos)
+			keep_alive = false;
+		else if (connection.find("keep-alive") != std::string::npos)
+			keep_alive = true;
+	}
 }
 
 }  // namespace http
@@ -37,6 +37,8 @@ class RequestHeader {
 		UNSUPPORTED,
 	};
 	Method method = UNSUPPORTED;
+	// Whether the client wants to send more requests on this connection afterward.
+	bool keep_alive = false;
 	bool ok = false;
 	void ParseHeaders(net::InputSink *sink);
 	bool GetParamValue(const char *param_name, std::string *value) const;
@@ -44,6 +46,7 @@ class RequestHeader {
 private:
 	int ParseHttpHeader(const char *buffer);
 	bool first_header_ = true;
+	bool http11_ = false;
 
 	DISALLOW_COPY_AND_ASSIGN(RequestHeader);
 };
@@ -17,6 +17,7 @@
 #include <sys/types.h>        /*  socket types              */
 #include <sys/wait.h>         /*  for waitpid()             */
 #include <netinet/in.h>       /*  struct sockaddr_in        */
+#include <netinet/tcp.h>      /*  TCP_NODELAY               */
 #include <arpa/inet.h>        /*  inet (3) funtions         */
 #include <unistd.h>           /*  misc. UNIX functions      */
 
@@ -37,13 +38,16 @@
 #include "Common/Net/HTTPServer.h"
 #include "Common/Net/NetBuffer.h"
 #include "Common/Net/Sinks.h"
+#include "Common/Net/SocketWatcher.h"
 #include "Common/File/FileDescriptor.h"
+#include "Common/Thread/ThreadUtil.h"
 
 #include "Common/Buffer.h"
 #include "Common/Log.h"
 
 
 void NewThreadExecutor::Run(std::function<void()> func) {
+	std::lock_guard<std::mutex> guard(lock_);
 	threads_.push_back(std::thread(func));
 }
 
@@ -54,13 +58,56 @@ NewThreadExecutor::~NewThreadExecutor() {
 	threads_.clear();
 }
 
+PooledExecutor::PooledExecutor(int numThreads) {
+	for (int i = 0; i < numThreads; ++i)
+		threads_.push_back(std::thread(&PooledExecutor::WorkerLoop, this));
+}
+
+PooledExecutor::~PooledExecutor() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		quit_ = true;
+	}
+	cond_.notify_all();
+	for (auto &thread : threads_)
+		thread.join();
+	threads_.clear();
+}
+
+void PooledExecutor::Run(std::function<void()> func) {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		queue_.push_back(std::move(func));
+	}
+	cond_.notify_one();
+}
+
+void PooledExecutor::WorkerLoop() {
+	SetCurrentThreadName("HTTPWorker");
+
+	std::unique_lock<std::mutex> guard(lock_);
+	while (true) {
+		cond_.wait(guard, [this] { return quit_ || !queue_.empty(); });
+		if (queue_.empty())
+			break;
+
+		std::function<void()> func = std::move(queue_.front());
+		queue_.pop_front();
+		guard.unlock();
+		func();
+		guard.lock();
+	}
+}
+
 namespace http {
 
 // Note: charset here helps prevent XSS.
 const char *const DEFAULT_MIME_TYPE = "text/html; charset=utf-8";
+// How long a keep-alive connection may sit around without sending its next request.
+static const double IDLE_CONNECTION_TIMEOUT = 15.0;
 
 ServerRequest::ServerRequest(int fd)
-	: fd_(fd) {
+	: fd_(fd), ownsConnection_(true) {
 	in_ = new net::InputSink(fd);
 	out_ = new net::OutputSink(fd);
 	header_.ParseHeaders(in_);
@@ -72,8 +119,25 @@ ServerRequest::ServerRequest(int fd)
 	}
 }
 
+ServerRequest::ServerRequest(int fd, net::InputSink *in, net::OutputSink *out)
+	: in_(in), out_(out), fd_(fd), ownsConnection_(false) {
+	header_.ParseHeaders(in_);
+
+	if (header_.ok) {
+		VERBOSE_LOG(Log::IO, "The request carried with it %i bytes", (int)header_.content_length);
+		// We don't know if the handler reads the body, so only when there isn't one.
+		canKeepAlive_ = header_.keep_alive && header_.content_length <= 0;
+	} else {
+		Close();
+	}
+}
+
 ServerRequest::~ServerRequest() {
 	Close();
+	if (!ownsConnection_) {
+		// The next request might already be waiting in the input, that's fine.
+		return;
+	}
 
 	if (!in_->Empty()) {
 		ERROR_LOG(Log::IO, "Input not empty - invalid request?");
@@ -109,9 +173,12 @@ void ServerRequest::WriteHttpResponseHeader(const char *ver, int status, int64_t
 	net::OutputSink *buffer = Out();
 	buffer->Printf("HTTP/%s %03d %s\r\n", ver, status, statusStr);
 	buffer->Push("Server: PPSSPPServer v0.1\r\n");
+	// Without a length, the client can only tell where the response ends when we close.
+	keepAlive_ = false;
 	if (!mimeType || strcmp(mimeType, "websocket") != 0) {
 		buffer->Printf("Content-Type: %s\r\n", mimeType ? mimeType : DEFAULT_MIME_TYPE);
-		buffer->Push("Connection: close\r\n");
+		keepAlive_ = canKeepAlive_ && size >= 0;
+		buffer->Push(keepAlive_ ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
 	}
 	if (size >= 0) {
 		buffer->Printf("Content-Length: %llu\r\n", size);
@@ -129,25 +196,48 @@ void ServerRequest::WritePartial() const {
 
 void ServerRequest::Write() {
 	_assert_(fd_);
-	WritePartial();
-	Close();
+	if (!out_->Flush())
+		keepAlive_ = false;
+	if (!keepAlive_)
+		Close();
 }
 
 void ServerRequest::Close() {
 	if (fd_) {
-		closesocket(fd_);
+		// Otherwise, the server closes the connection once we're done with it.
+		if (ownsConnection_)
+			closesocket(fd_);
 		fd_ = 0;
+		keepAlive_ = false;
 	}
 }
 
-Server::Server(NewThreadExecutor *executor)
+struct Server::Connection {
+	explicit Connection(int _fd) : fd(_fd), in(_fd), out(_fd) {}
+
+	int fd;
+	net::InputSink in;
+	net::OutputSink out;
+	int requests = 0;
+	double lastActive = 0.0;
+};
+
+Server::Server(ServerExecutor *executor)
 	: port_(0), executor_(executor) {
 	RegisterHandler("/", std::bind(&Server::HandleListing, this, std::placeholders::_1));
 	SetFallbackHandler(std::bind(&Server::Handle404, this, std::placeholders::_1));
 }
 
 Server::~Server() {
+	{
+		std::lock_guard<std::mutex> guard(idleLock_);
+		stopping_ = true;
+	}
+	// Running handlers won't park connections anymore, and the watcher can't dispatch new ones.
 	delete executor_;
+	delete watcher_;
+	watcher_ = nullptr;
+	CloseIdleConnections(true);
 }
 
 void Server::RegisterHandler(const char *url_path, UrlHandlerFunc handler) {
@@ -275,6 +365,7 @@ bool Server::RunSlice(double timeout) {
 	if (timeout <= 0.0) {
 		timeout = 86400.0;
 	}
+	CloseIdleConnections(false);
 	if (!fd_util::WaitUntilReady(listener_, timeout, false)) {
 		return false;
 	}
@@ -289,7 +380,10 @@ bool Server::RunSlice(double timeout) {
 	socklen_t client_addr_size = sizeof(client_addr);
 	int conn_fd = accept(listener_, &client_addr.sa, &client_addr_size);
 	if (conn_fd >= 0) {
-		executor_->Run(std::bind(&Server::HandleConnection, this, conn_fd));
+		// Responses are flushed as a whole, no need to hold back the tail end of one.
+		int opt = 1;
+		setsockopt(conn_fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&opt, sizeof(opt));
+		executor_->Run(std::bind(&Server::HandleConnection, this, new Connection(conn_fd)));
 		return true;
 	}
 	else {
@@ -315,19 +409,91 @@ void Server::Stop() {
 	closesocket(listener_);
 }
 
-void Server::HandleConnection(int conn_fd) {
-	ServerRequest request(conn_fd);
-	if (!request.IsOK()) {
-		WARN_LOG(Log::IO, "Bad request, ignoring.");
-		return;
+void Server::HandleConnection(Connection *conn) {
+	bool keepAlive;
+	do {
+		ServerRequest request(conn->fd, &conn->in, &conn->out);
+		if (!request.IsOK()) {
+			// Clients close idle keep-alive connections whenever they like.
+			if (conn->requests == 0)
+				WARN_LOG(Log::IO, "Bad request, ignoring.");
+			CloseConnection(conn);
+			return;
+		}
+		conn->requests++;
+		HandleRequest(request);
+
+		// TODO: Way to mark the content body as read, read it here if never read.
+		// This allows the handler to stream if need be.
+		request.Write();
+		keepAlive = request.KeepAlive();
+
+		// If the client pipelined its next request, it's probably already here.
+	} while (keepAlive && conn->in.TryFill());
+
+	if (keepAlive)
+		ParkConnection(conn);
+	else
+		CloseConnection(conn);
+}
+
+void Server::ParkConnection(Connection *conn) {
+	uint64_t id;
+	net::SocketWatcher *watcher;
+	{
+		std::lock_guard<std::mutex> guard(idleLock_);
+		if (stopping_) {
+			CloseConnection(conn);
+			return;
+		}
+		if (!watcher_) {
+			watcher_ = new net::SocketWatcher([this](uint64_t readyId) {
+				std::lock_guard<std::mutex> guard(idleLock_);
+				auto it = idle_.find(readyId);
+				if (it == idle_.end() || stopping_)
+					return;
+				executor_->Run(std::bind(&Server::HandleConnection, this, it->second));
+				idle_.erase(it);
+			});
+		}
+
+		conn->lastActive = time_now_d();
+		id = nextIdleId_++;
+		idle_[id] = conn;
+		watcher = watcher_;
 	}
-	HandleRequest(request);
+	// Has to happen outside the lock, since the watcher calls us with its own lock held.
+	// If we got swept in the meantime, this just fires once for nothing.
+	watcher->Watch(id, conn->fd, true, false);
+}
 
-	// TODO: Way to mark the content body as read, read it here if never read.
-	// This allows the handler to stream if need be.
+void Server::CloseConnection(Connection *conn) {
+	closesocket(conn->fd);
+	delete conn;
+}
+
+void Server::CloseIdleConnections(bool all) {
+	const double olderThan = time_now_d() - IDLE_CONNECTION_TIMEOUT;
+	std::vector<std::pair<uint64_t, Connection *>> expired;
+	net::SocketWatcher *watcher;
+	{
+		std::lock_guard<std::mutex> guard(idleLock_);
+		for (auto it = idle_.begin(); it != idle_.end(); ) {
+			if (all || it->second->lastActive < olderThan) {
+				expired.push_back(*it);
+				it = idle_.erase(it);
+			} else {
+				++it;
+			}
+		}
+		watcher = watcher_;
+	}
 
-	// TODO: Could handle keep alive here.
-	request.Write();
+	for (auto &it : expired) {
+		if (watcher)
+			watcher->Unwatch(it.first);
+		CloseConnection(it.second);
+	}
 }
 
 void Server::HandleRequest(const ServerRequest &request) {
@@ -1,25 +1,57 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <map>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "Common/Net/HTTPHeaders.h"
 #include "Common/Net/Resolve.h"
 
-class NewThreadExecutor {
+class ServerExecutor {
+public:
+	virtual ~ServerExecutor() {}
+	// Might be called from more than one thread.
+	virtual void Run(std::function<void()> func) = 0;
+};
+
+class NewThreadExecutor : public ServerExecutor {
 public:
 	~NewThreadExecutor();
-	void Run(std::function<void()> func);
+	void Run(std::function<void()> func) override;
+
+private:
+	std::mutex lock_;
+	std::vector<std::thread> threads_;
+};
+
+// A fixed set of worker threads, so lots of short requests don't each cost a thread.
+// Note that long-lived handlers (like websockets) keep a worker busy the whole time.
+class PooledExecutor : public ServerExecutor {
+public:
+	explicit PooledExecutor(int numThreads);
+	// Finishes everything already queued first.
+	~PooledExecutor();
+	void Run(std::function<void()> func) override;
 
 private:
+	void WorkerLoop();
+
+	std::mutex lock_;
+	std::condition_variable cond_;
+	std::deque<std::function<void()>> queue_;
 	std::vector<std::thread> threads_;
+	bool quit_ = false;
 };
 
 namespace net {
 
 class InputSink;
 class OutputSink;
+class SocketWatcher;
 
 }  // namespace net
 
@@ -28,6 +60,8 @@ namespace http {
 class ServerRequest {
 public:
 	ServerRequest(int fd);
+	// Uses the connection's sinks, and leaves it open afterward if keep-alive works out.
+	ServerRequest(int fd, net::InputSink *in, net::OutputSink *out);
 	~ServerRequest();
 
 	const char *resource() const {
@@ -57,6 +91,10 @@ class ServerRequest {
 	void Close();
 
 	bool IsOK() const { return fd_ > 0; }
+	// Only once a response header allowing it was written (it needs a Content-Length.)
+	bool KeepAlive() const { return keepAlive_; }
+	// For when the response can't be finished as promised.
+	void DisableKeepAlive() const { keepAlive_ = false; }
 
 	// If size is negative, no Content-Length: line is written.
 	void WriteHttpResponseHeader(const char *ver, int status, int64_t size = -1, const char *mimeType = nullptr, const char *otherHeaders = nullptr) const;
@@ -66,13 +104,16 @@ class ServerRequest {
 	net::OutputSink *out_;
 	RequestHeader header_;
 	int fd_;
+	bool ownsConnection_;
+	bool canKeepAlive_ = false;
+	mutable bool keepAlive_ = false;
 };
 
 // Register handlers on this class to serve stuff.
 class Server {
 public:
 	// Takes ownership.
-	Server(NewThreadExecutor *executor);
+	Server(ServerExecutor *executor);
 	virtual ~Server();
 
 	typedef std::function<void(const ServerRequest &)> UrlHandlerFunc;
@@ -101,10 +142,15 @@ class Server {
 	}
 
 private:
+	struct Connection;
+
 	bool Listen6(int port, bool ipv6_only, const char *reason);
 	bool Listen4(int port, const char *reason);
 
-	void HandleConnection(int conn_fd);
+	void HandleConnection(Connection *conn);
+	void ParkConnection(Connection *conn);
+	void CloseConnection(Connection *conn);
+	void CloseIdleConnections(bool all);
 
 	// Things like default 404, etc.
 	void HandleRequestDefault(const ServerRequest &request);
@@ -119,7 +165,14 @@ class Server {
 	UrlHandlerMap handlers_;
 	UrlHandlerFunc fallback_;
 
-	NewThreadExecutor *executor_;
+	ServerExecutor *executor_;
+
+	// Keep-alive connections waiting for their next request, by watch id.
+	std::mutex idleLock_;
+	std::map<uint64_t, Connection *> idle_;
+	uint64_t nextIdleId_ = 1;
+	bool stopping_ = false;
+	net::SocketWatcher *watcher_ = nullptr;
 };
 
 }  // namespace http
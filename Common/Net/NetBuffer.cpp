@@ -27,7 +27,7 @@ void RequestProgress::Update(int64_t downloaded, int64_t totalBytes, bool done)
 	}
 }
 
-bool Buffer::FlushSocket(uintptr_t sock, double timeout, bool *cancelled) {
+bool Buffer::FlushSocket(uintptr_t sock, double timeout, const std::atomic<bool> *cancelled) {
 	static constexpr float CANCEL_INTERVAL = 0.25f;
 
 	data_.iterate_blocks([&](const char *data, size_t size) {
@@ -106,6 +106,45 @@ bool Buffer::ReadAllWithProgress(int fd, int knownSize, RequestProgress *progres
 	return true;
 }
 
+bool Buffer::ReadAtLeast(int fd, size_t wanted, double timeout, RequestProgress *progress) {
+	static constexpr float CANCEL_INTERVAL = 0.25f;
+	std::vector<char> buf(std::min(wanted - std::min(wanted, size()), (size_t)65536) + 1);
+
+	double st = time_now_d();
+	size_t start = size();
+	while (size() < wanted) {
+		bool ready = false;
+		while (!ready) {
+			if (progress && progress->cancelled && *progress->cancelled)
+				return false;
+			ready = fd_util::WaitUntilReady(fd, CANCEL_INTERVAL, false);
+			if (!ready && time_now_d() > st + timeout) {
+				ERROR_LOG(Log::IO, "ReadAtLeast timed out");
+				return false;
+			}
+		}
+
+		int retval = recv(fd, &buf[0], buf.size(), MSG_NOSIGNAL);
+		if (retval == 0) {
+			// Closed before we got everything.
+			return false;
+		} else if (retval < 0) {
+			if (socket_errno != EWOULDBLOCK && socket_errno != EAGAIN) {
+				ERROR_LOG(Log::IO, "Error reading from buffer: %i", retval);
+				return false;
+			}
+			continue;
+		}
+		char *p = Append((size_t)retval);
+		memcpy(p, &buf[0], retval);
+		if (progress) {
+			progress->Update(size() - start, wanted - start, false);
+			progress->kBps = (float)((size() - start) / (time_now_d() - st)) / 1024.0f;
+		}
+	}
+	return true;
+}
+
 int Buffer::Read(int fd, size_t sz) {
 	char buf[4096];
 	int retval;
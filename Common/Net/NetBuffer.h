@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 
@@ -9,21 +10,23 @@ namespace net {
 
 class RequestProgress {
 public:
-	explicit RequestProgress(bool *c) : cancelled(c) {}
+	explicit RequestProgress(const std::atomic<bool> *c) : cancelled(c) {}
 
 	void Update(int64_t downloaded, int64_t totalBytes, bool done);
 
 	float progress = 0.0f;
 	float kBps = 0.0f;
-	bool *cancelled = nullptr;
+	const std::atomic<bool> *cancelled = nullptr;
 	std::function<void(int64_t, int64_t, bool)> callback;
 };
 
 class Buffer : public ::Buffer {
 public:
-	bool FlushSocket(uintptr_t sock, double timeout, bool *cancelled = nullptr);
+	bool FlushSocket(uintptr_t sock, double timeout, const std::atomic<bool> *cancelled = nullptr);
 
 	bool ReadAllWithProgress(int fd, int knownSize, RequestProgress *progress);
+	// Reads until there are at least this many bytes buffered, unlike the above this doesn't need the other end to close.
+	bool ReadAtLeast(int fd, size_t wanted, double timeout, RequestProgress *progress);
 
 	// < 0: error
 	// >= 0: number of bytes read
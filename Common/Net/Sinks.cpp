@@ -24,8 +24,11 @@ InputSink::InputSink(size_t fd) : fd_(fd), read_(0), write_(0), valid_(0) {
 
 bool InputSink::ReadLineWithEnding(std::string &s) {
 	size_t newline = FindNewline();
-	if (newline == BUFFER_SIZE) {
-		Block();
+	// The line might arrive in pieces, or wrap around the end of the buffer and need two reads.
+	while (newline == BUFFER_SIZE) {
+		size_t before = valid_;
+		if (!Block() || valid_ == before)
+			break;
 		newline = FindNewline();
 	}
 	if (newline == BUFFER_SIZE) {
@@ -231,6 +234,33 @@ bool OutputSink::Push(const char *buf, size_t bytes) {
 	return true;
 }
 
+bool OutputSink::PushDirect(const char *buf, size_t bytes) {
+	// Not worth the extra send for small things.
+	if (bytes <= PRESSURE)
+		return Push(buf, bytes);
+	if (!Flush())
+		return false;
+
+	while (bytes > 0) {
+		int sentBytes = send(fd_, buf, bytes, MSG_NOSIGNAL);
+		if (sentBytes > 0) {
+			buf += sentBytes;
+			bytes -= sentBytes;
+			continue;
+		}
+
+		int err = socket_errno;
+		if (sentBytes < 0 && err != EWOULDBLOCK && err != EAGAIN) {
+			ERROR_LOG(Log::IO, "Error writing to socket: %d", err);
+			return false;
+		}
+		if (!fd_util::WaitUntilReady((int)fd_, 5.0, true))
+			return false;
+	}
+
+	return true;
+}
+
 bool OutputSink::PushCRLF(const std::string &s) {
 	if (Push(s)) {
 		return Push("r\n", 2);
@@ -278,7 +308,7 @@ bool OutputSink::Printf(const char *fmt, ...) {
 		// There wasn't enough space.  Let's use a buffer instead.
 		// This could be caused by wraparound.
 		char temp[4096];
-		result = vsnprintf(temp, sizeof(temp), fmt, args);
+		result = vsnprintf(temp, sizeof(temp), fmt, backup);
 
 		if ((size_t)result < sizeof(temp) && result > 0) {
 			// In case it did return the null terminator.
@@ -316,8 +346,8 @@ bool OutputSink::Block() {
 		return false;
 	}
 
-	Drain();
-	return true;
+	// A socket that's ready but still won't take anything was closed on the other end.
+	return Drain();
 }
 
 bool OutputSink::Flush(bool allowBlock) {
@@ -350,19 +380,22 @@ void OutputSink::Discard() {
 	valid_ = 0;
 }
 
-void OutputSink::Drain() {
+bool OutputSink::Drain() {
 	// Avoid small reads if possible.
 	if (valid_ > PRESSURE) {
 		// Let's just do contiguous valid.
 		size_t avail = std::min(BUFFER_SIZE - read_, valid_);
 
 		int bytes = send(fd_, buf_ + read_, avail, MSG_NOSIGNAL);
+		bool failed = bytes < 0 && socket_errno != EAGAIN && socket_errno != EWOULDBLOCK;
 #if !PPSSPP_PLATFORM(WINDOWS)
 		if (bytes == -1 && (socket_errno == EAGAIN || socket_errno == EWOULDBLOCK))
 			bytes = 0;
 #endif
 		AccountDrain(bytes);
+		return !failed;
 	}
+	return true;
 }
 
 void OutputSink::AccountPush(size_t bytes) {
@@ -48,6 +48,8 @@ class OutputSink {
 	bool Push(const std::string &s);
 	bool Push(const char *buf, size_t bytes);
 	size_t PushAtMost(const char *buf, size_t bytes);
+	// Like Push, but large buffers are sent straight from buf (after flushing) instead of copied.
+	bool PushDirect(const char *buf, size_t bytes);
 	bool PushCRLF(const std::string &s);
 	bool Printf(const char *fmt, ...);
 
@@ -58,7 +60,7 @@ class OutputSink {
 	size_t BytesRemaining() const;
 
 private:
-	void Drain();
+	bool Drain();
 	bool Block();
 	void AccountPush(size_t bytes);
 	void AccountDrain(int bytes);
@@ -0,0 +1,167 @@
+#include "ppsspp_config.h"
+
+#include <vector>
+
+#include "Common/Net/SocketCompat.h"
+#include "Common/Net/SocketWatcher.h"
+
+#if !PPSSPP_PLATFORM(WINDOWS)
+#include <poll.h>
+#endif
+
+#include "Common/File/FileDescriptor.h"
+#include "Common/Log.h"
+#include "Common/Thread/ThreadUtil.h"
+
+namespace net {
+
+#if PPSSPP_PLATFORM(WINDOWS)
+typedef WSAPOLLFD watcher_pollfd;
+static int PollSockets(watcher_pollfd *fds, size_t count, int timeoutMS) { return WSAPoll(fds, (ULONG)count, timeoutMS); }
+#else
+typedef struct pollfd watcher_pollfd;
+static int PollSockets(watcher_pollfd *fds, size_t count, int timeoutMS) { return poll(fds, (nfds_t)count, timeoutMS); }
+#endif
+
+// Just in case a wakeup gets lost somehow.
+static const int WATCHER_MAX_WAIT_MS = 1000;
+
+SocketWatcher::SocketWatcher(ReadyCallback callback) : callback_(callback) {
+	int sock = (int)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		ERROR_LOG(Log::IO, "SocketWatcher: Unable to create wakeup socket (%d)", socket_errno);
+		return;
+	}
+
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addrlen = sizeof(addr);
+	if (bind(sock, (sockaddr *)&addr, sizeof(addr)) != 0 || getsockname(sock, (sockaddr *)&addr, &addrlen) != 0 || connect(sock, (sockaddr *)&addr, sizeof(addr)) != 0) {
+		ERROR_LOG(Log::IO, "SocketWatcher: Unable to set up wakeup socket (%d)", socket_errno);
+		closesocket(sock);
+		return;
+	}
+	fd_util::SetNonBlocking(sock, true);
+
+	wakeSock_ = sock;
+	thread_ = std::thread([this] { Run(); });
+}
+
+SocketWatcher::~SocketWatcher() {
+	if (wakeSock_ < 0)
+		return;
+	quit_ = true;
+	Wake();
+	thread_.join();
+	closesocket(wakeSock_);
+}
+
+void SocketWatcher::Watch(uint64_t id, int fd, bool read, bool write) {
+	if (wakeSock_ < 0 || fd < 0)
+		return;
+
+	short events = (read ? POLLIN : 0) | (write ? POLLOUT : 0);
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = watches_.find(id);
+	if (it != watches_.end() && it->second.fd == fd && it->second.events == events)
+		return;
+	watches_[id] = Entry{ fd, events };
+	generation_++;
+	Wake();
+}
+
+void SocketWatcher::Unwatch(uint64_t id) {
+	std::lock_guard<std::mutex> guard(lock_);
+	// No need to wake the thread, it'll just see a stale entry at worst.
+	if (watches_.erase(id) != 0)
+		generation_++;
+}
+
+void SocketWatcher::Clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	watches_.clear();
+	generation_++;
+}
+
+void SocketWatcher::Wake() {
+	char c = 0;
+	// If this fails because the buffer is full, there's already a wakeup pending anyway.
+	send(wakeSock_, &c, 1, MSG_NOSIGNAL);
+}
+
+void SocketWatcher::Run() {
+	SetCurrentThreadName("SocketWatcher");
+
+	// The wakeup socket always comes first, the rest match ids.
+	std::vector<watcher_pollfd> fds;
+	std::vector<uint64_t> ids;
+	uint32_t builtGeneration = 0;
+	bool built = false;
+
+	while (!quit_) {
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			if (!built || builtGeneration != generation_) {
+				fds.clear();
+				ids.clear();
+				watcher_pollfd wakefd{};
+				wakefd.fd = wakeSock_;
+				wakefd.events = POLLIN;
+				fds.push_back(wakefd);
+				for (const auto &it : watches_) {
+					watcher_pollfd pfd{};
+					pfd.fd = it.second.fd;
+					pfd.events = it.second.events;
+					fds.push_back(pfd);
+					ids.push_back(it.first);
+				}
+				builtGeneration = generation_;
+				built = true;
+			}
+		}
+
+		for (auto &pfd : fds)
+			pfd.revents = 0;
+		int result = PollSockets(fds.data(), fds.size(), WATCHER_MAX_WAIT_MS);
+		if (quit_)
+			break;
+
+		if (result < 0) {
+			if (socket_errno == EINTR)
+				continue;
+			// Most likely a socket was closed while we were watching it, and WSAPoll fails outright on that.
+			// Let everyone check for themselves, whoever is still waiting will watch again.
+			WARN_LOG(Log::IO, "SocketWatcher: poll failed (%d), waking all %d watches", socket_errno, (int)ids.size());
+			std::lock_guard<std::mutex> guard(lock_);
+			for (const auto &it : watches_)
+				callback_(it.first);
+			watches_.clear();
+			generation_++;
+			continue;
+		}
+		if (result == 0)
+			continue;
+
+		if (fds[0].revents != 0) {
+			char buf[64];
+			while (recv(wakeSock_, buf, sizeof(buf), MSG_NOSIGNAL) > 0)
+				continue;
+		}
+
+		std::lock_guard<std::mutex> guard(lock_);
+		for (size_t i = 1; i < fds.size(); ++i) {
+			if (fds[i].revents == 0)
+				continue;
+			// Might've been unwatched, or moved to a different socket, while we were polling.
+			auto it = watches_.find(ids[i - 1]);
+			if (it == watches_.end() || it->second.fd != (int)fds[i].fd)
+				continue;
+			watches_.erase(it);
+			generation_++;
+			callback_(ids[i - 1]);
+		}
+	}
+}
+
+}  // namespace net
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace net {
+
+// Waits for sockets to become readable or writable on a background thread, so that whoever is
+// blocked on them can be woken up right away instead of checking again on a timer.
+// Each watch fires once and is then removed, call Watch() again to keep waiting.
+class SocketWatcher {
+public:
+	// Called on the watcher thread, with the watcher locked: it must not call back into the watcher.
+	typedef std::function<void(uint64_t id)> ReadyCallback;
+
+	explicit SocketWatcher(ReadyCallback callback);
+	~SocketWatcher();
+
+	// Replaces any previous watch with the same id.  Errors and hangups count as ready, too.
+	void Watch(uint64_t id, int fd, bool read, bool write);
+	// After this returns, the callback won't be called for this id (unless it's watched again.)
+	void Unwatch(uint64_t id);
+	void Clear();
+
+	bool IsRunning() const { return wakeSock_ >= 0; }
+
+private:
+	struct Entry {
+		int fd;
+		short events;
+	};
+
+	void Run();
+	void Wake();
+
+	ReadyCallback callback_;
+	std::mutex lock_;
+	std::map<uint64_t, Entry> watches_;
+	// Bumped whenever watches_ changes, so the thread knows to rebuild its poll list.
+	uint32_t generation_ = 0;
+
+	// A loopback UDP socket connected to itself, written to interrupt a poll in progress.
+	int wakeSock_ = -1;
+	std::atomic<bool> quit_{ false };
+	std::thread thread_;
+};
+
+}  // namespace net
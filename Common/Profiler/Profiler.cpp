@@ -1,13 +1,20 @@
 // Ultra-lightweight category profiler with history.
 
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <vector>
 #include <cstring>
 
 #include "ppsspp_config.h"
 
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
 #include "Common/Render/DrawBuffer.h"
 
+#include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/TimeUtil.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/Log.h"
@@ -21,6 +28,8 @@
 #define MAX_THREADS 4     // Can be any number, represents concurrent threads calling the profiler.
 #endif
 #define HISTORY_SIZE 128 // Must be power of 2
+#define TRACE_RING_SIZE 32768 // Events kept per thread for the timeline. Must be power of 2
+#define MAX_DEAD_TRACE_THREADS 8 // Rings of exited threads kept around until exported.
 
 #ifndef _DEBUG
 // If the compiler can collapse identical strings, we don't even need the strcmp.
@@ -60,6 +69,115 @@ thread_local int profilerThreadId = -1;
 static int profilerThreadId = 0;
 #endif
 
+enum class TraceEventType : uint8_t {
+	BEGIN,
+	END,
+	FRAME,
+};
+
+struct TraceEvent {
+	double time;
+	// Only set for BEGIN. Category names are always string constants.
+	const char *name;
+	int frame;
+	TraceEventType type;
+};
+
+// Only written by its own thread, so recording doesn't need any locks.  The exporter just
+// has to watch out for events being overwritten while it reads.
+struct TraceThread {
+	TraceEvent events[TRACE_RING_SIZE];
+	std::atomic<uint32_t> writePos{};
+	std::string name;
+	int id = 0;
+	// The thread has exited.  Set under traceThreadsLock, like exported.
+	bool dead = false;
+	// A dead thread's events have been exported, so the ring can go to another thread.
+	bool exported = false;
+};
+
+static std::mutex traceThreadsLock;
+// Rings of running threads, and of exited ones until they're reused.  The exporter reads
+// them under the lock, so they can only be reused under the lock as well.
+static std::vector<TraceThread *> traceThreads;
+static int nextTraceThreadId = 0;
+static std::atomic<int> traceFrame;
+
+static TraceThread *AcquireTraceThread() {
+	const char *threadName = GetCurrentThreadName();
+
+	std::lock_guard<std::mutex> guard(traceThreadsLock);
+	// Prefer a ring that's already been exported.  Otherwise, once too many exited threads
+	// are waiting around, give up on the oldest one's events.
+	TraceThread *thread = nullptr;
+	TraceThread *oldestDead = nullptr;
+	int numDead = 0;
+	for (TraceThread *t : traceThreads) {
+		if (!t->dead)
+			continue;
+		if (t->exported) {
+			thread = t;
+			break;
+		}
+		if (!oldestDead || t->id < oldestDead->id)
+			oldestDead = t;
+		numDead++;
+	}
+	if (!thread && numDead >= MAX_DEAD_TRACE_THREADS)
+		thread = oldestDead;
+
+	if (thread) {
+		thread->writePos.store(0, std::memory_order_relaxed);
+		thread->dead = false;
+		thread->exported = false;
+	} else {
+		thread = new TraceThread();
+		traceThreads.push_back(thread);
+	}
+	thread->name = threadName ? threadName : "";
+	thread->id = nextTraceThreadId++;
+	return thread;
+}
+
+#if MAX_THREADS > 1
+// Marks the ring dead when the thread exits, so that threads coming and going (like
+// the ones loading games) don't keep adding rings.  Its events stay readable until reused.
+struct TraceThreadRef {
+	~TraceThreadRef() {
+		if (!thread)
+			return;
+		std::lock_guard<std::mutex> guard(traceThreadsLock);
+		thread->dead = true;
+	}
+
+	TraceThread *thread = nullptr;
+};
+
+thread_local TraceThreadRef traceThread;
+#else
+struct TraceThreadRef {
+	TraceThread *thread = nullptr;
+};
+
+static TraceThreadRef traceThread;
+#endif
+
+static void internal_profiler_trace(TraceEventType type, const char *name, double now) {
+	TraceThread *thread = traceThread.thread;
+	if (!thread) {
+		thread = AcquireTraceThread();
+		traceThread.thread = thread;
+	}
+
+	uint32_t pos = thread->writePos.load(std::memory_order_relaxed);
+	TraceEvent &ev = thread->events[pos & (TRACE_RING_SIZE - 1)];
+	ev.time = now;
+	ev.name = name;
+	ev.frame = traceFrame.load(std::memory_order_relaxed);
+	ev.type = type;
+	thread->writePos.store(pos + 1, std::memory_order_release);
+}
+
 void internal_profiler_init() {
 	memset(&profiler, 0, sizeof(profiler));
 #if MAX_THREADS == 1
@@ -129,6 +247,10 @@ static void internal_profiler_resume(int thread_id, int category, double now) {
 }
 
 int internal_profiler_enter(const char *category_name, int *out_thread_id) {
+	double now = time_now_d();
+	// The timeline has no limit on categories or threads, so always log that.
+	internal_profiler_trace(TraceEventType::BEGIN, category_name, now);
+
 	int category = internal_profiler_find_cat(category_name, true);
 	int thread_id = internal_profiler_find_thread();
 	if (category == -1 || !history) {
@@ -137,7 +259,6 @@ int internal_profiler_enter(const char *category_name, int *out_thread_id) {
 
 	int &depth = profiler.depth[thread_id];
 	if (profiler.eventStart[thread_id][category] == 0.0f) {
-		double now = time_now_d();
 		int parent = profiler.parentCategory[thread_id][depth];
 		// Temporarily suspend the parent on entering a child.
 		if (parent != -1) {
@@ -156,6 +277,9 @@ int internal_profiler_enter(const char *category_name, int *out_thread_id) {
 }
 
 void internal_profiler_leave(int thread_id, int category) {
+	double now = time_now_d();
+	internal_profiler_trace(TraceEventType::END, nullptr, now);
+
 	if (category == -1 || !history) {
 		return;
 	}
@@ -167,8 +291,6 @@ void internal_profiler_leave(int thread_id, int category) {
 		return;
 	}
 
-	double now = time_now_d();
-
 	depth--;
 	_assert_msg_(depth >= 0, "Profiler enter/leave mismatch!");
 
@@ -189,6 +311,8 @@ void internal_profiler_end_frame() {
 	int thread_id = internal_profiler_find_thread();
 	_assert_msg_(profiler.depth[thread_id] == 0, "Can't be inside a profiler scope at end of frame!");
 	profiler.curFrameStart = time_now_d();
+	traceFrame.fetch_add(1, std::memory_order_relaxed);
+	internal_profiler_trace(TraceEventType::FRAME, nullptr, profiler.curFrameStart);
 	profiler.historyPos++;
 	profiler.historyPos &= (HISTORY_SIZE - 1);
 	memset(&history[MAX_THREADS * profiler.historyPos], 0, sizeof(CategoryFrame) * MAX_THREADS);
@@ -261,3 +385,120 @@ void Profiler_GetHistory(int category, int thread, float *data, int count) {
 		data[i] = history[MAX_THREADS * x + thread].time_taken[category];
 	}
 }
+
+int Profiler_GetCurrentFrame() {
+	return traceFrame.load(std::memory_order_relaxed);
+}
+
+static void WriteTraceEvent(json::JsonWriter &j, const char *phase, const char *name, int tid, double time) {
+	j.pushDict();
+	if (name)
+		j.writeString("name", name);
+	j.writeString("ph", phase);
+	j.writeInt("pid", 1);
+	j.writeInt("tid", tid);
+	// Microseconds. The JSON writer doesn't print enough digits for this by default.
+	j.writeRaw("ts", StringFromFormat("%0.3f", time * 1000000.0));
+	if (!strcmp(phase, "i"))
+		j.writeString("s", "g");
+	j.pop();
+}
+
+std::string Profiler_GetChromeTrace(int firstFrame, int lastFrame) {
+	struct TraceThreadCopy {
+		std::string name;
+		int id;
+		std::vector<TraceEvent> events;
+	};
+
+	// Copy everything first, since a new thread may reuse the ring of one that exited.
+	std::vector<TraceThreadCopy> threads;
+	{
+		std::lock_guard<std::mutex> guard(traceThreadsLock);
+		threads.resize(traceThreads.size());
+		for (size_t t = 0; t < traceThreads.size(); ++t) {
+			TraceThread *thread = traceThreads[t];
+			TraceThreadCopy &copy = threads[t];
+			// Nothing more will be written, so it's free to go once we have it.
+			if (thread->dead)
+				thread->exported = true;
+			copy.name = thread->name;
+			copy.id = thread->id;
+
+			uint32_t end = thread->writePos.load(std::memory_order_acquire);
+			uint32_t start = end > TRACE_RING_SIZE ? end - TRACE_RING_SIZE : 0;
+			copy.events.reserve(end - start);
+			for (uint32_t i = start; i != end; ++i) {
+				copy.events.push_back(thread->events[i & (TRACE_RING_SIZE - 1)]);
+			}
+
+			// The thread may have kept going while we copied, so drop anything it might've overwritten
+			// (including the slot it may be writing right now.)
+			uint32_t after = thread->writePos.load(std::memory_order_acquire) + 1;
+			size_t skip = after - start > TRACE_RING_SIZE ? after - start - TRACE_RING_SIZE : 0;
+			copy.events.erase(copy.events.begin(), copy.events.begin() + std::min(skip, copy.events.size()));
+		}
+	}
+
+	json::JsonWriter j;
+	j.begin();
+	j.writeString("displayTimeUnit", "ms");
+	j.pushArray("traceEvents");
+
+	for (const TraceThreadCopy &thread : threads) {
+		j.pushDict();
+		j.writeString("name", "thread_name");
+		j.writeString("ph", "M");
+		j.writeInt("pid", 1);
+		j.writeInt("tid", thread.id);
+		j.pushDict("args");
+		j.writeString("name", thread.name.empty() ? StringFromFormat("Thread %d", thread.id) : thread.name);
+		j.pop();
+		j.pop();
+
+		// Only write ends that match a begin we wrote, since we may have cut the start off.
+		int depth = 0;
+		double lastTime = 0.0;
+		for (const TraceEvent &ev : thread.events) {
+			if (ev.frame < firstFrame || ev.frame > lastFrame)
+				continue;
+
+			switch (ev.type) {
+			case TraceEventType::BEGIN:
+				WriteTraceEvent(j, "B", ev.name, thread.id, ev.time);
+				depth++;
+				break;
+			case TraceEventType::END:
+				if (depth > 0) {
+					WriteTraceEvent(j, "E", nullptr, thread.id, ev.time);
+					depth--;
+				}
+				break;
+			case TraceEventType::FRAME:
+				WriteTraceEvent(j, "i", StringFromFormat("Frame %d", ev.frame).c_str(), thread.id, ev.time);
+				break;
+			}
+			lastTime = ev.time;
+		}
+
+		// And close off anything that continued past lastFrame.
+		while (depth > 0) {
+			WriteTraceEvent(j, "E", nullptr, thread.id, lastTime);
+			depth--;
+		}
+	}
+
+	j.pop();
+	j.end();
+	return j.str();
+}
+
+bool Profiler_SaveChromeTrace(const Path &filename, int firstFrame, int lastFrame) {
+	std::string trace = Profiler_GetChromeTrace(firstFrame, lastFrame);
+	if (!File::WriteStringToFile(false, trace, filename)) {
+		ERROR_LOG(Log::System, "Failed to write profiler trace to %s", filename.c_str());
+		return false;
+	}
+	INFO_LOG(Log::System, "Wrote profiler trace for frames %d-%d to %s", firstFrame, lastFrame, filename.c_str());
+	return true;
+}
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 
 // #define USE_PROFILER
 
 #ifdef USE_PROFILER
 
 class DrawBuffer;
+class Path;
 
 void internal_profiler_init();
 void internal_profiler_end_frame();
@@ -22,6 +24,13 @@ void Profiler_GetSlowestThreads(int *data, int count);
 void Profiler_GetSlowestHistory(int category, int *slowestThreads, float *data, int count);
 void Profiler_GetHistory(int category, int thread, float *data, int count);
 
+// Every scope is also logged to a per-thread timeline, for all threads.  These export the frames
+// firstFrame to lastFrame (inclusive) of it as Chrome trace JSON, for chrome://tracing or Perfetto.
+// Only the most recent events on each thread are kept, so don't go too far back.
+int Profiler_GetCurrentFrame();
+std::string Profiler_GetChromeTrace(int firstFrame, int lastFrame);
+bool Profiler_SaveChromeTrace(const Path &filename, int firstFrame, int lastFrame);
+
 class ProfileThis {
 public:
 	ProfileThis(const char *category) {
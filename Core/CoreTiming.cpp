@@ -21,6 +21,7 @@
 #include <cstring>
 #include <mutex>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "Common/Profiler/Profiler.h"
@@ -62,6 +63,11 @@ s64 lastGlobalTimeUs;
 
 std::vector<MHzChangeCallback> mhzChangeCallbacks;
 
+// Events scheduled from other threads, moved into the real queue by the CPU thread.
+static std::mutex tsEventsLock;
+static std::vector<std::pair<int, u64>> tsEvents;
+static std::atomic<bool> hasTsEvents;
+
 void FireMhzChange() {
 	for (MHzChangeCallback cb : mhzChangeCallbacks) {
 		cb();
@@ -220,6 +226,11 @@ u64 GetIdleTicks()
 
 void ClearPendingEvents()
 {
+	{
+		std::lock_guard<std::mutex> guard(tsEventsLock);
+		tsEvents.clear();
+		hasTsEvents = false;
+	}
 	while (first)
 	{
 		Event *e = first->next;
@@ -258,6 +269,20 @@ void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
 	AddEventToQueue(ne);
 }
 
+void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata) {
+	std::lock_guard<std::mutex> guard(tsEventsLock);
+	tsEvents.emplace_back(event_type, userdata);
+	hasTsEvents = true;
+}
+
+static void MoveEvents() {
+	std::lock_guard<std::mutex> guard(tsEventsLock);
+	for (const auto &ev : tsEvents)
+		ScheduleEvent(0, ev.first, ev.second);
+	tsEvents.clear();
+	hasTsEvents = false;
+}
+
 // Returns cycles left in timer.
 s64 UnscheduleEvent(int event_type, u64 userdata)
 {
@@ -396,6 +421,8 @@ void Advance() {
 	globalTimer += cyclesExecuted;
 	currentMIPS->downcount = slicelength;
 
+	if (hasTsEvents)
+		MoveEvents();
 	ProcessEvents();
 
 	if (!first) {
@@ -425,6 +452,12 @@ void LogPendingEvents() {
 }
 
 void Idle(int maxIdle) {
+	// Something's waiting to run from another thread, so handle it now rather than skipping past it.
+	if (hasTsEvents) {
+		ForceCheck();
+		return;
+	}
+
 	int cyclesDown = currentMIPS->downcount;
 	if (maxIdle != 0 && cyclesDown > maxIdle)
 		cyclesDown = maxIdle;
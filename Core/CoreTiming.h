@@ -107,6 +107,8 @@ namespace CoreTiming {
 	// when we implement state saves.
 	void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata=0);
 	s64 UnscheduleEvent(int event_type, u64 userdata);
+	// Can be called from any thread.  The event runs on the CPU thread, the next time it checks for events.
+	void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata = 0);
 
 	const std::vector<EventType> &GetEventTypes();
 	const Event *GetFirstEvent();
@@ -18,6 +18,8 @@
 #include <algorithm>
 #include <atomic>
 #include <cstring>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -36,7 +38,6 @@
 class MemSlabMap {
 public:
 	MemSlabMap();
-	~MemSlabMap();
 
 	bool Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc, bool allocated, const char *tag);
 	bool Find(MemBlockFlags flags, uint32_t addr, uint32_t size, std::vector<MemBlockInfo> &results);
@@ -47,37 +48,26 @@ class MemSlabMap {
 
 private:
 	struct Slab {
-		uint32_t start = 0;
 		uint32_t end = 0;
 		uint64_t ticks = 0;
 		uint32_t pc = 0;
 		bool allocated = false;
-		// Intentionally not save stated.
-		bool bulkStorage = false;
 		char tag[128]{};
-		Slab *prev = nullptr;
-		Slab *next = nullptr;
-
-		void DoState(PointerWrap &p);
 	};
 
+	// Keyed by start address.  The slabs always cover the whole space with no gaps or overlaps.
+	typedef std::map<uint32_t, Slab> SlabMap;
+
 	static constexpr uint32_t MAX_SIZE = 0x40000000;
-	static constexpr uint32_t SLICES = 65536;
-	static constexpr uint32_t SLICE_SIZE = MAX_SIZE / SLICES;
-
-	Slab *FindSlab(uint32_t addr);
-	void Clear();
-	// Returns the new slab after size.
-	Slab *Split(Slab *slab, uint32_t size);
-	void MergeAdjacent(Slab *slab);
-	static inline bool Same(const Slab *a, const Slab *b);
-	void Merge(Slab *a, Slab *b);
-	void FillHeads(Slab *slab);
-
-	Slab *first_ = nullptr;
-	Slab *lastFind_ = nullptr;
-	std::vector<Slab *> heads_;
-	Slab *bulkStorage_ = nullptr;
+
+	SlabMap::iterator FindSlab(uint32_t addr);
+	// Returns the slab starting at addr, splitting the one containing it if needed.
+	SlabMap::iterator Split(uint32_t addr);
+	void MergeAdjacent(SlabMap::iterator first, uint32_t end);
+	static inline bool Same(const Slab &a, const Slab &b);
+	static void DoStateSlab(PointerWrap &p, uint32_t &start, Slab &slab);
+
+	SlabMap slabs_;
 };
 
 struct PendingNotifyMem {
@@ -90,20 +80,29 @@ struct PendingNotifyMem {
 	char tag[128];
 };
 
-// 160 KB.
-static constexpr size_t MAX_PENDING_NOTIFIES = 1024;
-static constexpr size_t MAX_PENDING_NOTIFIES_THREAD = 1000;
+// Each thread queues notifications in its own buffer, so the lock is only contended while they're
+// being collected (once per frame, or when a buffer gets full.)
+struct PendingNotifyBuffer {
+	std::mutex lock;
+	std::vector<PendingNotifyMem> notifies;
+	// Cleared when the thread exits, so a new thread can take it over.
+	std::atomic<bool> inUse{ true };
+};
+
+// 640 KB per thread.
+static constexpr size_t MAX_PENDING_NOTIFIES = 4096;
+static constexpr size_t MAX_PENDING_NOTIFIES_THREAD = 4000;
 static MemSlabMap allocMap;
 static MemSlabMap suballocMap;
 static MemSlabMap writeMap;
 static MemSlabMap textureMap;
-static std::vector<PendingNotifyMem> pendingNotifies;
+static std::mutex pendingBuffersMutex;
+static std::vector<std::shared_ptr<PendingNotifyBuffer>> pendingBuffers;
 static std::atomic<uint32_t> pendingNotifyMinAddr1;
 static std::atomic<uint32_t> pendingNotifyMaxAddr1;
 static std::atomic<uint32_t> pendingNotifyMinAddr2;
 static std::atomic<uint32_t> pendingNotifyMaxAddr2;
-// To prevent deadlocks, acquire Read before Write if you're going to acquire both.
-static std::mutex pendingWriteMutex;
+// Held while flushing into or reading from the maps.  Take this before any buffer's lock.
 static std::mutex pendingReadMutex;
 static int detailedOverride;
 
@@ -117,78 +116,70 @@ MemSlabMap::MemSlabMap() {
 	Reset();
 }
 
-MemSlabMap::~MemSlabMap() {
-	Clear();
-}
-
 bool MemSlabMap::Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc, bool allocated, const char *tag) {
-	uint32_t end = addr + size;
-	Slab *slab = FindSlab(addr);
-	Slab *firstMatch = nullptr;
-	while (slab != nullptr && slab->start < end) {
-		if (slab->start < addr)
-			slab = Split(slab, addr - slab->start);
-		// Don't replace slab, the return is the after part.
-		if (slab->end > end) {
-			Split(slab, end - slab->start);
-		}
-
-		slab->allocated = allocated;
-		if (pc != 0) {
-			slab->ticks = ticks;
-			slab->pc = pc;
+	if (addr >= MAX_SIZE || size == 0)
+		return false;
+	uint32_t end = addr + size > MAX_SIZE || addr + size < addr ? MAX_SIZE : addr + size;
+
+	SlabMap::iterator first = Split(addr);
+	if (end < MAX_SIZE)
+		Split(end);
+	SlabMap::iterator last = end < MAX_SIZE ? slabs_.find(end) : slabs_.end();
+
+	if (pc != 0 && tag != nullptr) {
+		// Everything in range gets the same info, so it all becomes one slab.
+		slabs_.erase(std::next(first), last);
+		Slab &slab = first->second;
+		slab.end = end;
+		slab.allocated = allocated;
+		slab.ticks = ticks;
+		slab.pc = pc;
+		truncate_cpy(slab.tag, tag);
+	} else {
+		for (SlabMap::iterator it = first; it != last; ++it) {
+			Slab &slab = it->second;
+			slab.allocated = allocated;
+			if (pc != 0) {
+				slab.ticks = ticks;
+				slab.pc = pc;
+			}
+			if (tag)
+				truncate_cpy(slab.tag, tag);
 		}
-		if (tag)
-			truncate_cpy(slab->tag, tag);
-
-		// Move on to the next one.
-		if (firstMatch == nullptr)
-			firstMatch = slab;
-		slab = slab->next;
 	}
 
-	if (firstMatch != nullptr) {
-		// This will merge all those blocks to one.
-		MergeAdjacent(firstMatch);
-		return true;
-	}
-	return false;
+	// This will merge all those blocks to one, if they match, and with their neighbors.
+	MergeAdjacent(first, end);
+	return true;
 }
 
 bool MemSlabMap::Find(MemBlockFlags flags, uint32_t addr, uint32_t size, std::vector<MemBlockInfo> &results) {
 	uint32_t end = addr + size;
-	Slab *slab = FindSlab(addr);
 	bool found = false;
-	while (slab != nullptr && slab->start < end) {
-		if (slab->pc != 0 || slab->tag[0] != '\0') {
-			results.push_back({ flags, slab->start, slab->end - slab->start, slab->ticks, slab->pc, slab->tag, slab->allocated });
+	for (SlabMap::iterator it = FindSlab(addr); it != slabs_.end() && it->first < end; ++it) {
+		const Slab &slab = it->second;
+		if (slab.pc != 0 || slab.tag[0] != '\0') {
+			results.push_back({ flags, it->first, slab.end - it->first, slab.ticks, slab.pc, slab.tag, slab.allocated });
 			found = true;
 		}
-		slab = slab->next;
 	}
 	return found;
 }
 
 const char *MemSlabMap::FastFindWriteTag(MemBlockFlags flags, uint32_t addr, uint32_t size) {
 	uint32_t end = addr + size;
-	Slab *slab = FindSlab(addr);
-	while (slab != nullptr && slab->start < end) {
-		if (slab->pc != 0 || slab->tag[0] != '\0') {
-			return slab->tag;
+	for (SlabMap::iterator it = FindSlab(addr); it != slabs_.end() && it->first < end; ++it) {
+		const Slab &slab = it->second;
+		if (slab.pc != 0 || slab.tag[0] != '\0') {
+			return slab.tag;
 		}
-		slab = slab->next;
 	}
 	return nullptr;
 }
 
 void MemSlabMap::Reset() {
-	Clear();
-
-	first_ = new Slab();
-	first_->end = MAX_SIZE;
-	lastFind_ = first_;
-
-	heads_.resize(SLICES, first_);
+	slabs_.clear();
+	slabs_[0].end = MAX_SIZE;
 }
 
 void MemSlabMap::DoState(PointerWrap &p) {
@@ -198,202 +189,154 @@ void MemSlabMap::DoState(PointerWrap &p) {
 
 	int count = 0;
 	if (p.mode == p.MODE_READ) {
-		// Since heads_ is a static size, let's avoid clearing it.
-		// This helps in case a debugger call happens concurrently.
-		Slab *old = first_;
-		Slab *oldBulk = bulkStorage_;
 		Do(p, count);
 
-		first_ = new Slab();
-		first_->DoState(p);
-		lastFind_ = first_;
-		--count;
-
-		FillHeads(first_);
-
-		bulkStorage_ = new Slab[count];
-
-		Slab *slab = first_;
+		SlabMap loaded;
 		for (int i = 0; i < count; ++i) {
-			slab->next = &bulkStorage_[i];
-			slab->next->bulkStorage = true;
-			slab->next->DoState(p);
-
-			slab->next->prev = slab;
-			slab = slab->next;
-
-			FillHeads(slab);
+			uint32_t start = 0;
+			Slab slab;
+			DoStateSlab(p, start, slab);
+			loaded.emplace_hint(loaded.end(), start, slab);
 		}
 
-		// Now that it's entirely disconnected, delete the old slabs.
-		while (old != nullptr) {
-			Slab *next = old->next;
-			if (!old->bulkStorage)
-				delete old;
-			old = next;
+		if (loaded.empty() || loaded.begin()->first != 0) {
+			ERROR_LOG(Log::Loader, "Invalid MemSlabMap in savestate, resetting");
+			Reset();
+		} else {
+			slabs_ = std::move(loaded);
 		}
-		delete [] oldBulk;
 	} else {
-		for (Slab *slab = first_; slab != nullptr; slab = slab->next)
-			++count;
+		count = (int)slabs_.size();
 		Do(p, count);
 
-		first_->DoState(p);
-		--count;
-
-		Slab *slab = first_;
-		for (int i = 0; i < count; ++i) {
-			slab->next->DoState(p);
-			slab = slab->next;
+		for (auto &it : slabs_) {
+			uint32_t start = it.first;
+			DoStateSlab(p, start, it.second);
 		}
 	}
 }
 
-void MemSlabMap::Slab::DoState(PointerWrap &p) {
+// Compatible with the old linked list of slabs, so savestates still load.
+void MemSlabMap::DoStateSlab(PointerWrap &p, uint32_t &start, Slab &slab) {
 	auto s = p.Section("MemSlabMapSlab", 1, 3);
 	if (!s)
 		return;
 
 	Do(p, start);
-	Do(p, end);
-	Do(p, ticks);
-	Do(p, pc);
-	Do(p, allocated);
+	Do(p, slab.end);
+	Do(p, slab.ticks);
+	Do(p, slab.pc);
+	Do(p, slab.allocated);
 	if (s >= 3) {
-		Do(p, tag);
+		Do(p, slab.tag);
 	} else if (s >= 2) {
 		char shortTag[32];
 		Do(p, shortTag);
-		memcpy(tag, shortTag, sizeof(shortTag));
+		memcpy(slab.tag, shortTag, sizeof(shortTag));
 	} else {
 		std::string stringTag;
 		Do(p, stringTag);
-		truncate_cpy(tag, stringTag.c_str());
+		truncate_cpy(slab.tag, stringTag.c_str());
 	}
 }
 
-void MemSlabMap::Clear() {
-	Slab *s = first_;
-	while (s != nullptr) {
-		Slab *next = s->next;
-		if (!s->bulkStorage)
-			delete s;
-		s = next;
-	}
-	delete [] bulkStorage_;
-	bulkStorage_ = nullptr;
-	first_ = nullptr;
-	lastFind_ = nullptr;
-	heads_.clear();
-}
-
-MemSlabMap::Slab *MemSlabMap::FindSlab(uint32_t addr) {
-	// Jump ahead using our index.
-	Slab *slab = heads_[addr / SLICE_SIZE];
-	// We often move forward, so check the last find.
-	if (lastFind_->start > slab->start && lastFind_->start <= addr)
-		slab = lastFind_;
-
-	while (slab != nullptr && slab->start <= addr) {
-		if (slab->end > addr) {
-			lastFind_ = slab;
-			return slab;
-		}
-		slab = slab->next;
-	}
-	return nullptr;
+MemSlabMap::SlabMap::iterator MemSlabMap::FindSlab(uint32_t addr) {
+	if (addr >= MAX_SIZE)
+		return slabs_.end();
+	// There's always a slab at 0, so this can't be begin().
+	return std::prev(slabs_.upper_bound(addr));
 }
 
-MemSlabMap::Slab *MemSlabMap::Split(Slab *slab, uint32_t size) {
-	Slab *next = new Slab();
-	next->start = slab->start + size;
-	next->end = slab->end;
-	next->ticks = slab->ticks;
-	next->pc = slab->pc;
-	next->allocated = slab->allocated;
-	truncate_cpy(next->tag, slab->tag);
-	next->prev = slab;
-	next->next = slab->next;
-
-	slab->next = next;
-	if (next->next)
-		next->next->prev = next;
-
-	// If the split is big, we might have to update our index.
-	FillHeads(next);
+MemSlabMap::SlabMap::iterator MemSlabMap::Split(uint32_t addr) {
+	SlabMap::iterator it = FindSlab(addr);
+	if (it->first == addr)
+		return it;
 
-	slab->end = slab->start + size;
-	return next;
+	Slab after = it->second;
+	it->second.end = addr;
+	return slabs_.emplace_hint(std::next(it), addr, after);
 }
 
-bool MemSlabMap::Same(const Slab *a, const Slab *b) {
-	if (a->allocated != b->allocated)
+bool MemSlabMap::Same(const Slab &a, const Slab &b) {
+	if (a.allocated != b.allocated)
 		return false;
-	if (a->pc != b->pc)
+	if (a.pc != b.pc)
 		return false;
-	if (strcmp(a->tag, b->tag))
+	if (strcmp(a.tag, b.tag))
 		return false;
 	return true;
 }
 
-void MemSlabMap::MergeAdjacent(Slab *slab) {
-	while (slab->next != nullptr && Same(slab, slab->next)) {
-		Merge(slab, slab->next);
-	}
-	while (slab->prev != nullptr && Same(slab, slab->prev)) {
-		Merge(slab, slab->prev);
+void MemSlabMap::MergeAdjacent(SlabMap::iterator first, uint32_t end) {
+	// Start with the slab before, and go through the one just after end.
+	SlabMap::iterator it = first == slabs_.begin() ? first : std::prev(first);
+	SlabMap::iterator next = std::next(it);
+	while (next != slabs_.end() && next->first <= end) {
+		if (Same(it->second, next->second)) {
+			it->second.end = next->second.end;
+			it->second.ticks = std::max(it->second.ticks, next->second.ticks);
+			next = slabs_.erase(next);
+		} else {
+			it = next++;
+		}
 	}
 }
 
-void MemSlabMap::Merge(Slab *a, Slab *b) {
-	if (a->next == b) {
-		_assert_(a->end == b->start);
-		a->end = b->end;
-		a->next = b->next;
+static PendingNotifyBuffer *GetPendingNotifyBuffer() {
+	struct ThreadBuffer {
+		~ThreadBuffer() {
+			if (buffer)
+				buffer->inUse = false;
+		}
+
+		std::shared_ptr<PendingNotifyBuffer> buffer;
+	};
+	static thread_local ThreadBuffer current;
+	if (current.buffer)
+		return current.buffer.get();
+
+	std::lock_guard<std::mutex> guard(pendingBuffersMutex);
+	for (auto &buffer : pendingBuffers) {
+		bool expected = false;
+		if (buffer->inUse.compare_exchange_strong(expected, true)) {
+			current.buffer = buffer;
+			return buffer.get();
+		}
+	}
 
-		if (a->next)
-			a->next->prev = a;
-	} else if (a->prev == b) {
-		_assert_(b->end == a->start);
-		a->start = b->start;
-		a->prev = b->prev;
+	current.buffer = std::make_shared<PendingNotifyBuffer>();
+	current.buffer->notifies.reserve(MAX_PENDING_NOTIFIES);
+	pendingBuffers.push_back(current.buffer);
+	return current.buffer.get();
+}
 
-		if (a->prev)
-			a->prev->next = a;
-		else if (first_ == b)
-			first_ = a;
-	} else {
-		_assert_(false);
+static void ExpandPendingRange(uint32_t start, uint32_t end) {
+	std::atomic<uint32_t> &minAddr = start < 0x08000000 ? pendingNotifyMinAddr1 : pendingNotifyMinAddr2;
+	std::atomic<uint32_t> &maxAddr = start < 0x08000000 ? pendingNotifyMaxAddr1 : pendingNotifyMaxAddr2;
+	// Usually already covered, so only these loads happen.
+	uint32_t cur = minAddr.load(std::memory_order_relaxed);
+	while (start < cur && !minAddr.compare_exchange_weak(cur, start)) {
+		continue;
 	}
-	// Take over index entries b had.
-	FillHeads(a);
-	if (b->ticks > a->ticks) {
-		a->ticks = b->ticks;
-		// In case we ignore PC for same.
-		a->pc = b->pc;
+	cur = maxAddr.load(std::memory_order_relaxed);
+	while (end > cur && !maxAddr.compare_exchange_weak(cur, end)) {
+		continue;
 	}
-	if (lastFind_ == b)
-		lastFind_ = a;
-	if (!b->bulkStorage)
-		delete b;
 }
 
-void MemSlabMap::FillHeads(Slab *slab) {
-	uint32_t slice = slab->start / SLICE_SIZE;
-	uint32_t endSlice = (slab->end - 1) / SLICE_SIZE;
-
-	// For the first slice, only replace if it's the one we're removing.
-	if (slab->start == slice * SLICE_SIZE) {
-		heads_[slice] = slab;
-	}
+static void ResetPendingRange() {
+	pendingNotifyMinAddr1 = 0xFFFFFFFF;
+	pendingNotifyMaxAddr1 = 0;
+	pendingNotifyMinAddr2 = 0xFFFFFFFF;
+	pendingNotifyMaxAddr2 = 0;
+}
 
-	// Now replace all the rest - we definitely cover the start of them.
-	Slab **next = &heads_[slice + 1];
-	// We want to set slice + 1 through endSlice, inclusive.
-	size_t c = endSlice - slice;
-	for (size_t i = 0; i < c; ++i) {
-		next[i] = slab;
+static void WakeFlushThread() {
+	{
+		std::lock_guard<std::mutex> guard(flushLock);
+		flushThreadPending = true;
 	}
+	flushCond.notify_one();
 }
 
 size_t FormatMemWriteTagAtNoFlush(char *buf, size_t sz, const char *prefix, uint32_t start, uint32_t size);
@@ -401,17 +344,34 @@ size_t FormatMemWriteTagAtNoFlush(char *buf, size_t sz, const char *prefix, uint
 void FlushPendingMemInfo() {
 	// This lock prevents us from another thread reading while we're busy flushing.
 	std::lock_guard<std::mutex> guard(pendingReadMutex);
-	std::vector<PendingNotifyMem> thisBatch;
+	// Only touched with pendingReadMutex held, this just keeps the allocation around.
+	static std::vector<PendingNotifyMem> thisBatch;
+
+	// Reset first, anything queued after this will extend the range again.
+	ResetPendingRange();
+
+	std::vector<std::shared_ptr<PendingNotifyBuffer>> buffers;
 	{
-		std::lock_guard<std::mutex> guard(pendingWriteMutex);
-		thisBatch = std::move(pendingNotifies);
-		pendingNotifies.clear();
-		pendingNotifies.reserve(MAX_PENDING_NOTIFIES);
-
-		pendingNotifyMinAddr1 = 0xFFFFFFFF;
-		pendingNotifyMaxAddr1 = 0;
-		pendingNotifyMinAddr2 = 0xFFFFFFFF;
-		pendingNotifyMaxAddr2 = 0;
+		std::lock_guard<std::mutex> guard(pendingBuffersMutex);
+		buffers = pendingBuffers;
+	}
+
+	thisBatch.clear();
+	int sources = 0;
+	for (auto &buffer : buffers) {
+		std::lock_guard<std::mutex> guard(buffer->lock);
+		if (buffer->notifies.empty())
+			continue;
+		thisBatch.insert(thisBatch.end(), buffer->notifies.begin(), buffer->notifies.end());
+		buffer->notifies.clear();
+		sources++;
+	}
+
+	// Each thread's notifications are in order already, but interleave them if there's more than one.
+	if (sources > 1) {
+		std::stable_sort(thisBatch.begin(), thisBatch.end(), [](const PendingNotifyMem &a, const PendingNotifyMem &b) {
+			return a.ticks < b.ticks;
+		});
 	}
 
 	for (const auto &info : thisBatch) {
@@ -444,13 +404,20 @@ void FlushPendingMemInfo() {
 	}
 }
 
+static void FlushPendingIfOverlaps(uint32_t start, uint32_t size) {
+	if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
+		FlushPendingMemInfo();
+	else if (pendingNotifyMinAddr2 < start + size && pendingNotifyMaxAddr2 >= start)
+		FlushPendingMemInfo();
+}
+
 static inline uint32_t NormalizeAddress(uint32_t addr) {
 	if ((addr & 0x3F000000) == 0x04000000)
 		return addr & 0x041FFFFF;
 	return addr & 0x3FFFFFFF;
 }
 
-static inline bool MergeRecentMemInfo(const PendingNotifyMem &info, size_t copyLength) {
+static inline bool MergeRecentMemInfo(std::vector<PendingNotifyMem> &pendingNotifies, const PendingNotifyMem &info, size_t copyLength) {
 	if (pendingNotifies.size() < 4)
 		return false;
 
@@ -500,28 +467,18 @@ void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_
 		memcpy(info.tag, tagStr, copyLength);
 		info.tag[copyLength] = 0;
 
-		std::lock_guard<std::mutex> guard(pendingWriteMutex);
+		PendingNotifyBuffer *buffer = GetPendingNotifyBuffer();
+		std::lock_guard<std::mutex> guard(buffer->lock);
 		// Sometimes we get duplicates, quickly check.
-		if (!MergeRecentMemInfo(info, copyLength)) {
-			if (start < 0x08000000) {
-				pendingNotifyMinAddr1 = std::min(pendingNotifyMinAddr1.load(), start);
-				pendingNotifyMaxAddr1 = std::max(pendingNotifyMaxAddr1.load(), start + size);
-			} else {
-				pendingNotifyMinAddr2 = std::min(pendingNotifyMinAddr2.load(), start);
-				pendingNotifyMaxAddr2 = std::max(pendingNotifyMaxAddr2.load(), start + size);
-			}
-			pendingNotifies.push_back(info);
-		}
-		needFlush = pendingNotifies.size() > MAX_PENDING_NOTIFIES_THREAD;
+		if (!MergeRecentMemInfo(buffer->notifies, info, copyLength))
+			buffer->notifies.push_back(info);
+		// Even when merged, the size may have grown.
+		ExpandPendingRange(start, start + size);
+		needFlush = buffer->notifies.size() > MAX_PENDING_NOTIFIES_THREAD;
 	}
 
-	if (needFlush) {
-		{
-			std::lock_guard<std::mutex> guard(flushLock);
-			flushThreadPending = true;
-		}
-		flushCond.notify_one();
-	}
+	if (needFlush)
+		WakeFlushThread();
 
 	if (!(flags & MemBlockFlags::SKIP_MEMCHECK)) {
 		if (flags & MemBlockFlags::WRITE) {
@@ -559,36 +516,23 @@ void NotifyMemInfoCopy(uint32_t destPtr, uint32_t srcPtr, uint32_t size, const c
 		// Store the prefix for now.  The correct tag will be calculated on flush.
 		truncate_cpy(info.tag, prefix);
 
-		std::lock_guard<std::mutex> guard(pendingWriteMutex);
-		if (destPtr < 0x08000000) {
-			pendingNotifyMinAddr1 = std::min(pendingNotifyMinAddr1.load(), destPtr);
-			pendingNotifyMaxAddr1 = std::max(pendingNotifyMaxAddr1.load(), destPtr + size);
-		} else {
-			pendingNotifyMinAddr2 = std::min(pendingNotifyMinAddr2.load(), destPtr);
-			pendingNotifyMaxAddr2 = std::max(pendingNotifyMaxAddr2.load(), destPtr + size);
-		}
-		pendingNotifies.push_back(info);
-		needsFlush = pendingNotifies.size() > MAX_PENDING_NOTIFIES_THREAD;
+		PendingNotifyBuffer *buffer = GetPendingNotifyBuffer();
+		std::lock_guard<std::mutex> guard(buffer->lock);
+		buffer->notifies.push_back(info);
+		ExpandPendingRange(destPtr, destPtr + size);
+		needsFlush = buffer->notifies.size() > MAX_PENDING_NOTIFIES_THREAD;
 	}
 
-	if (needsFlush) {
-		{
-			std::lock_guard<std::mutex> guard(flushLock);
-			flushThreadPending = true;
-		}
-		flushCond.notify_one();
-	}
+	if (needsFlush)
+		WakeFlushThread();
 }
 
 std::vector<MemBlockInfo> FindMemInfo(uint32_t start, uint32_t size) {
 	start = NormalizeAddress(start);
-
-	if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
-		FlushPendingMemInfo();
-	if (pendingNotifyMinAddr2 < start + size && pendingNotifyMaxAddr2 >= start)
-		FlushPendingMemInfo();
+	FlushPendingIfOverlaps(start, size);
 
 	std::vector<MemBlockInfo> results;
+	std::lock_guard<std::mutex> guard(pendingReadMutex);
 	allocMap.Find(MemBlockFlags::ALLOC, start, size, results);
 	suballocMap.Find(MemBlockFlags::SUB_ALLOC, start, size, results);
 	writeMap.Find(MemBlockFlags::WRITE, start, size, results);
@@ -598,13 +542,10 @@ std::vector<MemBlockInfo> FindMemInfo(uint32_t start, uint32_t size) {
 
 std::vector<MemBlockInfo> FindMemInfoByFlag(MemBlockFlags flags, uint32_t start, uint32_t size) {
 	start = NormalizeAddress(start);
-
-	if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
-		FlushPendingMemInfo();
-	if (pendingNotifyMinAddr2 < start + size && pendingNotifyMaxAddr2 >= start)
-		FlushPendingMemInfo();
+	FlushPendingIfOverlaps(start, size);
 
 	std::vector<MemBlockInfo> results;
+	std::lock_guard<std::mutex> guard(pendingReadMutex);
 	if (flags & MemBlockFlags::ALLOC)
 		allocMap.Find(MemBlockFlags::ALLOC, start, size, results);
 	if (flags & MemBlockFlags::SUB_ALLOC)
@@ -616,16 +557,10 @@ std::vector<MemBlockInfo> FindMemInfoByFlag(MemBlockFlags flags, uint32_t start,
 	return results;
 }
 
-static const char *FindWriteTagByFlag(MemBlockFlags flags, uint32_t start, uint32_t size, bool flush = true) {
+// Caller must hold pendingReadMutex, the returned tag is only valid until the next flush.
+static const char *FindWriteTagByFlag(MemBlockFlags flags, uint32_t start, uint32_t size) {
 	start = NormalizeAddress(start);
 
-	if (flush) {
-		if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
-			FlushPendingMemInfo();
-		if (pendingNotifyMinAddr2 < start + size && pendingNotifyMaxAddr2 >= start)
-			FlushPendingMemInfo();
-	}
-
 	if (flags & MemBlockFlags::ALLOC) {
 		const char *tag = allocMap.FastFindWriteTag(MemBlockFlags::ALLOC, start, size);
 		if (tag)
@@ -650,25 +585,19 @@ static const char *FindWriteTagByFlag(MemBlockFlags flags, uint32_t start, uint3
 }
 
 size_t FormatMemWriteTagAt(char *buf, size_t sz, const char *prefix, uint32_t start, uint32_t size) {
-	const char *tag = FindWriteTagByFlag(MemBlockFlags::WRITE, start, size);
-	if (tag && strcmp(tag, "MemInit") != 0) {
-		return snprintf(buf, sz, "%s%s", prefix, tag);
-	}
-	// Fall back to alloc and texture, especially for VRAM.  We prefer write above.
-	tag = FindWriteTagByFlag(MemBlockFlags::ALLOC | MemBlockFlags::TEXTURE, start, size);
-	if (tag) {
-		return snprintf(buf, sz, "%s%s", prefix, tag);
-	}
-	return snprintf(buf, sz, "%s%08x_size_%08x", prefix, start, size);
+	FlushPendingIfOverlaps(NormalizeAddress(start), size);
+
+	std::lock_guard<std::mutex> guard(pendingReadMutex);
+	return FormatMemWriteTagAtNoFlush(buf, sz, prefix, start, size);
 }
 
 size_t FormatMemWriteTagAtNoFlush(char *buf, size_t sz, const char *prefix, uint32_t start, uint32_t size) {
-	const char *tag = FindWriteTagByFlag(MemBlockFlags::WRITE, start, size, false);
+	const char *tag = FindWriteTagByFlag(MemBlockFlags::WRITE, start, size);
 	if (tag && strcmp(tag, "MemInit") != 0) {
 		return snprintf(buf, sz, "%s%s", prefix, tag);
 	}
 	// Fall back to alloc and texture, especially for VRAM.  We prefer write above.
-	tag = FindWriteTagByFlag(MemBlockFlags::ALLOC | MemBlockFlags::TEXTURE, start, size, false);
+	tag = FindWriteTagByFlag(MemBlockFlags::ALLOC | MemBlockFlags::TEXTURE, start, size);
 	if (tag) {
 		return snprintf(buf, sz, "%s%s", prefix, tag);
 	}
@@ -691,12 +620,7 @@ static void FlushMemInfoThread() {
 
 void MemBlockInfoInit() {
 	std::lock_guard<std::mutex> guard(pendingReadMutex);
-	std::lock_guard<std::mutex> guardW(pendingWriteMutex);
-	pendingNotifies.reserve(MAX_PENDING_NOTIFIES);
-	pendingNotifyMinAddr1 = 0xFFFFFFFF;
-	pendingNotifyMaxAddr1 = 0;
-	pendingNotifyMinAddr2 = 0xFFFFFFFF;
-	pendingNotifyMaxAddr2 = 0;
+	ResetPendingRange();
 
 	flushThreadRunning = true;
 	flushThreadPending = false;
@@ -706,12 +630,17 @@ void MemBlockInfoInit() {
 void MemBlockInfoShutdown() {
 	{
 		std::lock_guard<std::mutex> guard(pendingReadMutex);
-		std::lock_guard<std::mutex> guardW(pendingWriteMutex);
 		allocMap.Reset();
 		suballocMap.Reset();
 		writeMap.Reset();
 		textureMap.Reset();
-		pendingNotifies.clear();
+
+		std::lock_guard<std::mutex> guardBuffers(pendingBuffersMutex);
+		for (auto &buffer : pendingBuffers) {
+			std::lock_guard<std::mutex> guardW(buffer->lock);
+			buffer->notifies.clear();
+		}
+		ResetPendingRange();
 	}
 
 	if (flushThreadRunning.load()) {
@@ -723,12 +652,19 @@ void MemBlockInfoShutdown() {
 	flushThread.join();
 }
 
+void MemBlockInfoFrameEnd() {
+	// Merge everything queued during the frame, if there was anything.
+	if (pendingNotifyMaxAddr1 != 0 || pendingNotifyMaxAddr2 != 0)
+		WakeFlushThread();
+}
+
 void MemBlockInfoDoState(PointerWrap &p) {
 	auto s = p.Section("MemBlockInfo", 0, 1);
 	if (!s)
 		return;
 
 	FlushPendingMemInfo();
+	std::lock_guard<std::mutex> guard(pendingReadMutex);
 	allocMap.DoState(p);
 	suballocMap.DoState(p);
 	writeMap.DoState(p);
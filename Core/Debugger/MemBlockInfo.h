@@ -74,6 +74,8 @@ size_t FormatMemWriteTagAt(char *buf, size_t sz, const char *prefix, uint32_t st
 
 void MemBlockInfoInit();
 void MemBlockInfoShutdown();
+// Called once per frame, merges notifications queued since the last one on the flush thread.
+void MemBlockInfoFrameEnd();
 void MemBlockInfoDoState(PointerWrap &p);
 
 void MemBlockOverrideDetailed();
@@ -17,6 +17,7 @@
 
 #include <mutex>
 #include <vector>
+#include "Common/Profiler/Profiler.h"
 #include "Core/Debugger/WebSocket/GPUStatsSubscriber.h"
 #include "Core/HW/Display.h"
 #include "Core/System.h"
@@ -71,6 +72,7 @@ struct WebSocketGPUStatsState : public DebuggerSubscriber {
 	~WebSocketGPUStatsState();
 	void Get(DebuggerRequest &req);
 	void Feed(DebuggerRequest &req);
+	void Trace(DebuggerRequest &req);
 
 	void Broadcast(net::WebSocketServer *ws) override;
 
@@ -91,6 +93,7 @@ DebuggerSubscriber *WebSocketGPUStatsInit(DebuggerEventHandlerMap &map) {
 	auto p = new WebSocketGPUStatsState();
 	map["gpu.stats.get"] = std::bind(&WebSocketGPUStatsState::Get, p, std::placeholders::_1);
 	map["gpu.stats.feed"] = std::bind(&WebSocketGPUStatsState::Feed, p, std::placeholders::_1);
+	map["gpu.stats.trace"] = std::bind(&WebSocketGPUStatsState::Trace, p, std::placeholders::_1);
 
 	return p;
 }
@@ -183,6 +186,37 @@ void WebSocketGPUStatsState::Feed(DebuggerRequest &req) {
 	}
 }
 
+// Get a timeline of profiled scopes (gpu.stats.trace)
+//
+// Parameters:
+//  - firstFrame: optional number, first frame to include (default: 60 frames before lastFrame.)
+//  - lastFrame: optional number, last frame to include (default: current frame.)
+//
+// Response (same event name):
+//  - frame: number, the current frame.
+//  - trace: object in Chrome trace event format, for chrome://tracing or Perfetto.
+//
+// Note: only available in builds with USE_PROFILER.  Older frames may already be overwritten.
+void WebSocketGPUStatsState::Trace(DebuggerRequest &req) {
+#ifdef USE_PROFILER
+	int currentFrame = Profiler_GetCurrentFrame();
+	uint32_t lastFrame = currentFrame;
+	if (!req.ParamU32("lastFrame", &lastFrame, false, DebuggerParamType::OPTIONAL))
+		return;
+	uint32_t firstFrame = lastFrame > 60 ? lastFrame - 60 : 0;
+	if (!req.ParamU32("firstFrame", &firstFrame, false, DebuggerParamType::OPTIONAL))
+		return;
+	if (firstFrame > lastFrame)
+		return req.Fail("Parameter 'firstFrame' must not be after 'lastFrame'");
+
+	JsonWriter &json = req.Respond();
+	json.writeInt("frame", currentFrame);
+	json.writeRaw("trace", Profiler_GetChromeTrace((int)firstFrame, (int)lastFrame));
+#else
+	req.Fail("Profiler not enabled in this build");
+#endif
+}
+
 void WebSocketGPUStatsState::Broadcast(net::WebSocketServer *ws) {
 	std::lock_guard<std::mutex> guard(pendingLock_);
 	if (lastTicket_.empty() && !sendFeed_) {
@@ -23,6 +23,8 @@
 #include "Common/TimeUtil.h"
 #include "Core/FileLoaders/CachingFileLoader.h"
 
+FileLoaderCacheStats CachingFileLoader::stats_;
+
 // Takes ownership of backend.
 CachingFileLoader::CachingFileLoader(FileLoader *backend)
 	: ProxiedFileLoader(backend) {
@@ -82,6 +84,7 @@ size_t CachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flag
 		readSize = backend_->ReadAt(absolutePos, bytes, data, flags);
 	} else {
 		readSize = ReadFromCache(absolutePos, bytes, data);
+		const size_t cachedSize = readSize;
 		// While in case the cache size is too small for the entire read.
 		while (readSize < bytes) {
 			SaveIntoCache(absolutePos + readSize, bytes - readSize, flags);
@@ -93,12 +96,25 @@ size_t CachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flag
 			}
 		}
 
-		StartReadAhead(absolutePos + readSize);
+		stats_.hitBytes += cachedSize;
+		stats_.missBytes += readSize - cachedSize;
+		StartReadAhead(absolutePos + readSize, ReadAheadSize(absolutePos, readSize));
 	}
 
 	return readSize;
 }
 
+void CachingFileLoader::Prefetch(s64 absolutePos, size_t bytes) {
+	Prepare();
+	if (absolutePos >= filesize_ || bytes == 0) {
+		return;
+	}
+
+	// It's only a guess, so don't let it push too much out of the cache.
+	bytes = (size_t)std::min((s64)bytes, filesize_ - absolutePos);
+	StartReadAhead(absolutePos, std::min(bytes, (size_t)BLOCK_SIZE * MAX_BLOCKS_PER_READ));
+}
+
 void CachingFileLoader::InitCache() {
 	cacheSize_ = 0;
 	oldestGeneration_ = 0;
@@ -109,6 +125,10 @@ void CachingFileLoader::ShutdownCache() {
 	// TODO: Maybe add some hint that deletion is coming soon?
 	// We can't delete while the thread is running, so have to wait.
 	// This should only happen from the menu.
+	{
+		std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+		aheadPendingBytes_ = 0;
+	}
 	while (aheadThreadRunning_) {
 		sleep_ms(1, "shutdown-cache-poll");
 	}
@@ -117,6 +137,8 @@ void CachingFileLoader::ShutdownCache() {
 
 	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
 	for (auto block : blocks_) {
+		if (block.second.prefetched)
+			stats_.prefetchWastedBytes += BLOCK_SIZE;
 		delete [] block.second.ptr;
 	}
 	blocks_.clear();
@@ -138,6 +160,7 @@ size_t CachingFileLoader::ReadFromCache(s64 pos, size_t bytes, void *data) {
 			return readSize;
 		}
 		block->second.generation = generation_;
+		block->second.prefetched = false;
 
 		size_t toRead = std::min(bytes - readSize, (size_t)BLOCK_SIZE - offset);
 		memcpy(p + readSize, block->second.ptr + offset, toRead);
@@ -153,6 +176,9 @@ void CachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool r
 	s64 cacheStartPos = pos >> BLOCK_SHIFT;
 	s64 cacheEndPos = (pos + bytes - 1) >> BLOCK_SHIFT;
 
+	// Reading ahead, it's worth asking for more at once, so the backend can keep more requests in flight.
+	const size_t maxBlocks = readingAhead ? MAX_BLOCKS_READAHEAD : MAX_BLOCKS_PER_READ;
+
 	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
 	size_t blocksToRead = 0;
 	for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
@@ -161,7 +187,7 @@ void CachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool r
 			break;
 		}
 		++blocksToRead;
-		if (blocksToRead >= MAX_BLOCKS_PER_READ) {
+		if (blocksToRead >= maxBlocks) {
 			break;
 		}
 	}
@@ -181,6 +207,9 @@ void CachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool r
 		// If so, free the one we just read.
 		if (blocks_.find(cacheStartPos) == blocks_.end()) {
 			blocks_[cacheStartPos] = BlockInfo(buf);
+			blocks_[cacheStartPos].prefetched = readingAhead;
+			if (readingAhead)
+				stats_.prefetchBytes += BLOCK_SIZE;
 		} else {
 			delete [] buf;
 		}
@@ -199,6 +228,9 @@ void CachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool r
 			u8 *buf = new u8[BLOCK_SIZE];
 			memcpy(buf, wholeRead + (i << BLOCK_SHIFT), BLOCK_SIZE);
 			blocks_[cacheStartPos + i] = BlockInfo(buf);
+			blocks_[cacheStartPos + i].prefetched = readingAhead;
+			if (readingAhead)
+				stats_.prefetchBytes += BLOCK_SIZE;
 		}
 		delete[] wholeRead;
 	}
@@ -229,6 +261,8 @@ bool CachingFileLoader::MakeCacheSpaceFor(size_t blocks, bool readingAhead) {
 			// 0 means it was never used yet or was the first read (e.g. block descriptor.)
 			if (it->second.generation == oldestGeneration_ || it->second.generation == 0) {
 				s64 pos = it->first;
+				if (it->second.prefetched)
+					stats_.prefetchWastedBytes += BLOCK_SIZE;
 				delete it->second.ptr;
 				blocks_.erase(it);
 				--cacheSize_;
@@ -252,13 +286,17 @@ bool CachingFileLoader::MakeCacheSpaceFor(size_t blocks, bool readingAhead) {
 	return true;
 }
 
-void CachingFileLoader::StartReadAhead(s64 pos) {
+void CachingFileLoader::StartReadAhead(s64 pos, size_t bytes) {
 	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
 	if (aheadThreadRunning_) {
-		// Already going.
+		// Already going, queue it up.  Keep whichever request reaches further.
+		if (aheadPendingBytes_ == 0 || pos + (s64)bytes > aheadPendingPos_ + (s64)aheadPendingBytes_) {
+			aheadPendingPos_ = pos;
+			aheadPendingBytes_ = bytes;
+		}
 		return;
 	}
-	if (cacheSize_ + BLOCK_READAHEAD > MAX_BLOCKS_CACHED) {
+	if (cacheSize_ + ((bytes + BLOCK_SIZE - 1) >> BLOCK_SHIFT) > MAX_BLOCKS_CACHED) {
 		// Not enough space to readahead.
 		return;
 	}
@@ -266,24 +304,59 @@ void CachingFileLoader::StartReadAhead(s64 pos) {
 	aheadThreadRunning_ = true;
 	if (aheadThread_.joinable())
 		aheadThread_.join();
-	aheadThread_ = std::thread([this, pos] {
+	aheadThread_ = std::thread([this, pos, bytes] {
 		SetCurrentThreadName("FileLoaderReadAhead");
 
 		AndroidJNIThreadContext jniContext;
 
-		std::unique_lock<std::recursive_mutex> guard(blocksMutex_);
-		s64 cacheStartPos = pos >> BLOCK_SHIFT;
-		s64 cacheEndPos = cacheStartPos + BLOCK_READAHEAD - 1;
-
-		for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
-			auto block = blocks_.find(i);
-			if (block == blocks_.end()) {
-				guard.unlock();
-				SaveIntoCache(i << BLOCK_SHIFT, BLOCK_SIZE * BLOCK_READAHEAD, Flags::NONE, true);
+		s64 nextPos = pos;
+		size_t nextBytes = bytes;
+		while (true) {
+			ReadAheadRange(nextPos, nextBytes);
+
+			std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+			if (aheadPendingBytes_ == 0) {
+				aheadThreadRunning_ = false;
 				break;
 			}
+			nextPos = aheadPendingPos_;
+			nextBytes = aheadPendingBytes_;
+			aheadPendingBytes_ = 0;
 		}
-
-		aheadThreadRunning_ = false;
 	});
 }
+
+size_t CachingFileLoader::ReadAheadSize(s64 pos, size_t bytes) {
+	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+	// The longer a game keeps reading straight through, the further ahead it's worth reading.
+	// The backend can then keep several requests in flight (see HTTPFileLoader.)
+	if (pos == lastReadEnd_) {
+		sequentialReads_ = std::min(sequentialReads_ + 1, 4);
+	} else {
+		sequentialReads_ = 0;
+	}
+	lastReadEnd_ = pos + (s64)bytes;
+	return (size_t)BLOCK_SIZE * std::min(BLOCK_READAHEAD << sequentialReads_, (int)MAX_BLOCKS_READAHEAD);
+}
+
+void CachingFileLoader::ReadAheadRange(s64 pos, size_t bytes) {
+	s64 cacheStartPos = pos >> BLOCK_SHIFT;
+	s64 cacheEndPos = (pos + bytes - 1) >> BLOCK_SHIFT;
+
+	for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
+		std::unique_lock<std::recursive_mutex> guard(blocksMutex_);
+		if (blocks_.find(i) != blocks_.end()) {
+			continue;
+		}
+		guard.unlock();
+
+		// This reads all the missing blocks in a row at once.
+		SaveIntoCache(i << BLOCK_SHIFT, (size_t)((cacheEndPos - i + 1) << BLOCK_SHIFT), Flags::NONE, true);
+
+		guard.lock();
+		if (blocks_.find(i) == blocks_.end()) {
+			// No space left, give up.
+			return;
+		}
+	}
+}
@@ -38,6 +38,11 @@ class CachingFileLoader : public ProxiedFileLoader {
 		return ReadAt(absolutePos, bytes * count, data, flags) / bytes;
 	}
 	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override;
+	void Prefetch(s64 absolutePos, size_t bytes) override;
+
+	static const FileLoaderCacheStats &GetStats() {
+		return stats_;
+	}
 
 private:
 	void Prepare();
@@ -47,7 +52,9 @@ class CachingFileLoader : public ProxiedFileLoader {
 	// Guaranteed to read at least one block into the cache.
 	void SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool readingAhead = false);
 	bool MakeCacheSpaceFor(size_t blocks, bool readingAhead);
-	void StartReadAhead(s64 pos);
+	void StartReadAhead(s64 pos, size_t bytes);
+	size_t ReadAheadSize(s64 pos, size_t bytes);
+	void ReadAheadRange(s64 pos, size_t bytes);
 
 	enum {
 		BLOCK_SIZE = 65536,
@@ -55,6 +62,8 @@ class CachingFileLoader : public ProxiedFileLoader {
 		MAX_BLOCKS_PER_READ = 16,
 		MAX_BLOCKS_CACHED = 4096, // 256 MB
 		BLOCK_READAHEAD = 4,
+		// When reading straight through, how far the readahead grows (in several reads.)
+		MAX_BLOCKS_READAHEAD = 64,
 	};
 
 	s64 filesize_ = 0;
@@ -67,6 +76,8 @@ class CachingFileLoader : public ProxiedFileLoader {
 	struct BlockInfo {
 		u8 *ptr;
 		u64 generation;
+		// Read ahead, and not yet used.
+		bool prefetched = false;
 
 		BlockInfo() : ptr(nullptr), generation(0) {
 		}
@@ -77,6 +88,14 @@ class CachingFileLoader : public ProxiedFileLoader {
 	std::map<s64, BlockInfo> blocks_;
 	std::recursive_mutex blocksMutex_;
 	bool aheadThreadRunning_ = false;
+	// Next range for the ahead thread, if a request came in while it was busy.
+	s64 aheadPendingPos_ = 0;
+	size_t aheadPendingBytes_ = 0;
+	// To notice reads that go straight through the file.
+	s64 lastReadEnd_ = -1;
+	int sequentialReads_ = 0;
 	std::thread aheadThread_;
 	std::once_flag preparedFlag_;
+
+	static FileLoaderCacheStats stats_;
 };
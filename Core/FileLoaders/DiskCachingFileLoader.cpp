@@ -51,6 +51,7 @@ Path DiskCachingFileLoaderCache::cacheDir_;
 
 std::map<Path, DiskCachingFileLoaderCache *> DiskCachingFileLoader::caches_;
 std::mutex DiskCachingFileLoader::cachesMutex_;
+FileLoaderCacheStats DiskCachingFileLoader::stats_;
 
 // Takes ownership of backend.
 DiskCachingFileLoader::DiskCachingFileLoader(FileLoader *backend)
@@ -100,15 +101,19 @@ size_t DiskCachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data,
 
 	if (cache_ && cache_->IsValid() && (flags & Flags::HINT_UNCACHED) == 0) {
 		readSize = cache_->ReadFromCache(absolutePos, bytes, data);
+		stats_.hitBytes += readSize;
 		// While in case the cache size is too small for the entire read.
 		while (readSize < bytes) {
-			readSize += cache_->SaveIntoCache(backend_, absolutePos + readSize, bytes - readSize, (u8 *)data + readSize, flags);
+			size_t bytesFromBackend = cache_->SaveIntoCache(backend_, absolutePos + readSize, bytes - readSize, (u8 *)data + readSize, flags);
+			stats_.missBytes += bytesFromBackend;
+			readSize += bytesFromBackend;
 			// We're done, nothing more to read.
 			if (readSize == bytes) {
 				break;
 			}
 			// If there are already-cached blocks afterward, we have to read them.
 			size_t bytesFromCache = cache_->ReadFromCache(absolutePos + readSize, bytes - readSize, (u8 *)data + readSize);
+			stats_.hitBytes += bytesFromCache;
 			readSize += bytesFromCache;
 			if (bytesFromCache == 0) {
 				// We can't read any more.
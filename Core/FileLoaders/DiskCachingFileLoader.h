@@ -43,6 +43,9 @@ class DiskCachingFileLoader : public ProxiedFileLoader {
 	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override;
 
 	static std::vector<Path> GetCachedPathsInUse();
+	static const FileLoaderCacheStats &GetStats() {
+		return stats_;
+	}
 
 private:
 	void Prepare();
@@ -57,6 +60,7 @@ class DiskCachingFileLoader : public ProxiedFileLoader {
 	// So we have to ensure there's only one of these per.
 	static std::map<Path, DiskCachingFileLoaderCache *> caches_;
 	static std::mutex cachesMutex_;
+	static FileLoaderCacheStats stats_;
 };
 
 class DiskCachingFileLoaderCache {
@@ -17,25 +17,60 @@
 
 #include <algorithm>
 
+#include "Common/File/FileDescriptor.h"
+#include "Common/Net/SocketCompat.h"
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
 #include "Core/FileLoaders/HTTPFileLoader.h"
 
+// Larger reads are split into requests of this size, spread over several connections.
+static const s64 RANGE_PIECE_SIZE = 64 * 1024;
+static const size_t MAX_RANGE_CONNECTIONS = 4;
+// Leave a connection for whoever else is reading (usually, reading ahead and reading what's needed right now.)
+static const size_t MAX_RANGE_CONNECTIONS_PER_READ = MAX_RANGE_CONNECTIONS - 1;
+
+static bool ResponseKeepsAlive(const std::string &statusLine, const std::vector<std::string> &responseHeaders) {
+	std::string connection;
+	if (http::GetHeaderValue(responseHeaders, "Connection", &connection)) {
+		std::transform(connection.begin(), connection.end(), connection.begin(), tolower);
+		if (connection.find("close") != connection.npos)
+			return false;
+		if (connection.find("keep-alive") != connection.npos)
+			return true;
+	}
+	// HTTP/1.1 keeps connections open by default.
+	return startsWith(statusLine, "HTTP/1.1");
+}
+
 HTTPFileLoader::HTTPFileLoader(const ::Path &filename)
-	: url_(filename.ToString()), progress_(&cancel_), filename_(filename) {
+	: url_(filename.ToString()), filename_(filename) {
+}
+
+HTTPFileLoader::ActiveRequest::ActiveRequest(HTTPFileLoader *loader) : loader_(loader) {
+	std::lock_guard<std::mutex> guard(loader_->connectionsMutex_);
+	loader_->activeCancels_.push_back(&cancelled);
+}
+
+HTTPFileLoader::ActiveRequest::~ActiveRequest() {
+	std::lock_guard<std::mutex> guard(loader_->connectionsMutex_);
+	auto &active = loader_->activeCancels_;
+	active.erase(std::find(active.begin(), active.end(), &cancelled));
 }
 
 void HTTPFileLoader::Prepare() {
 	std::call_once(preparedFlag_, [this](){
 		client_.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
+		// Just to find out if the server supports it, this connection isn't reused.
+		client_.SetKeepAlive(true);
 
 		std::vector<std::string> responseHeaders;
+		std::string statusLine;
 		Url resourceURL = url_;
 		int redirectsLeft = 20;
 		while (redirectsLeft > 0) {
 			responseHeaders.clear();
-			int code = SendHEAD(resourceURL, responseHeaders);
+			int code = SendHEAD(resourceURL, responseHeaders, &statusLine);
 			if (code == -400) {
 				// Already reported the error.
 				return;
@@ -77,6 +112,7 @@ void HTTPFileLoader::Prepare() {
 			// We got a good, non-redirect response.
 			redirectsLeft = 0;
 			url_ = resourceURL;
+			keepAlive_ = ResponseKeepsAlive(statusLine, responseHeaders);
 		}
 
 		// TODO: Expire cache via ETag, etc.
@@ -101,7 +137,6 @@ void HTTPFileLoader::Prepare() {
 			}
 		}
 
-		// TODO: Keepalive instead.
 		Disconnect();
 
 		if (!acceptsRange) {
@@ -115,7 +150,7 @@ void HTTPFileLoader::Prepare() {
 	});
 }
 
-int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseHeaders) {
+int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseHeaders, std::string *statusLine) {
 	if (!url.Valid()) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, invalid URL: '%s'", url.ToString().c_str());
 		latestError_ = "Invalid URL";
@@ -131,15 +166,17 @@ int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseH
 	double timeout = 20.0;
 
 	client_.SetDataTimeout(timeout);
-	Connect(10.0);
+	ActiveRequest active(this);
+	Connect(10.0, &active.cancelled);
 	if (!connected_) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, failed to connect: %s port %d (resource: '%s')", url.Host().c_str(), url.Port(), url.Resource().c_str());
 		latestError_ = "Could not connect (refused to connect)";
 		return -400;
 	}
 
+	net::RequestProgress progress(&active.cancelled);
 	http::RequestParams req(url.Resource(), "*/*");
-	int err = client_.SendRequest("HEAD", req, nullptr, &progress_);
+	int err = client_.SendRequest("HEAD", req, nullptr, &progress);
 	if (err < 0) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, failed to send request: %s port %d", url.Host().c_str(), url.Port());
 		latestError_ = "Could not connect (could not request data)";
@@ -148,11 +185,13 @@ int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseH
 	}
 
 	net::Buffer readbuf;
-	return client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
+	return client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress, statusLine);
 }
 
 HTTPFileLoader::~HTTPFileLoader() {
 	Disconnect();
+	for (auto &conn : connections_)
+		DisconnectRange(conn.get());
 }
 
 bool HTTPFileLoader::Exists() {
@@ -180,7 +219,6 @@ Path HTTPFileLoader::GetPath() const {
 
 size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags) {
 	Prepare();
-	std::lock_guard<std::mutex> guard(readAtMutex_);
 
 	s64 absoluteEnd = std::min(absolutePos + (s64)bytes, filesize_);
 	if (absolutePos >= filesize_ || bytes == 0) {
@@ -188,32 +226,146 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		return 0;
 	}
 
-	Connect(10.0);
-	if (!connected_) {
-		return 0;
+	// If the server closes after each request, pipelining won't work, so just ask for it all at once.
+	const s64 pieceSize = keepAlive_ ? RANGE_PIECE_SIZE : absoluteEnd - absolutePos;
+	std::vector<RangeConnection *> conns = AcquireConnections((size_t)((absoluteEnd - absolutePos + pieceSize - 1) / pieceSize));
+
+	// Spread the pieces over the connections, each one gets all its requests sent before reading any responses.
+	std::vector<RangePiece> pieces;
+	for (s64 pos = absolutePos; pos < absoluteEnd; pos += pieceSize) {
+		RangePiece piece;
+		piece.pos = pos;
+		piece.bytes = (size_t)std::min(pieceSize, absoluteEnd - pos);
+		piece.conn = conns[pieces.size() % conns.size()];
+		pieces.push_back(piece);
+	}
+
+	ActiveRequest active(this);
+	net::RequestProgress progress(&active.cancelled);
+	for (RangeConnection *conn : conns) {
+		PrepareConnection(conn, &active.cancelled);
 	}
+	for (RangePiece &piece : pieces) {
+		if (piece.conn->connected && !SendRangeRequest(piece, &progress)) {
+			latestError_ = "Invalid response reading data";
+			DisconnectRange(piece.conn);
+		}
+	}
+
+	// Each connection answers in order, so this goes through them round robin too.
+	for (RangePiece &piece : pieces) {
+		if (!piece.conn->connected)
+			continue;
+		piece.ok = ReadRangeResponse(piece, (u8 *)data + (piece.pos - absolutePos), &progress);
+		if (!piece.ok || !keepAlive_) {
+			// Whatever else was in flight on this connection is lost now.
+			DisconnectRange(piece.conn);
+		}
+	}
+	ReleaseConnections(conns);
+
+	// Only what we got in one piece from the start counts, the caller can retry the rest.
+	size_t readBytes = 0;
+	for (const RangePiece &piece : pieces) {
+		if (!piece.ok)
+			break;
+		readBytes += piece.bytes;
+	}
+	return readBytes;
+}
+
+std::vector<HTTPFileLoader::RangeConnection *> HTTPFileLoader::AcquireConnections(size_t wanted) {
+	wanted = std::max((size_t)1, std::min(wanted, MAX_RANGE_CONNECTIONS_PER_READ));
+
+	std::unique_lock<std::mutex> guard(connectionsMutex_);
+	connectionsCond_.wait(guard, [&] {
+		return !freeConnections_.empty() || connections_.size() < MAX_RANGE_CONNECTIONS;
+	});
+
+	// Prefer ones that are already connected, but open new ones rather than waiting.
+	std::vector<RangeConnection *> conns;
+	while (conns.size() < wanted) {
+		if (!freeConnections_.empty()) {
+			conns.push_back(freeConnections_.back());
+			freeConnections_.pop_back();
+		} else if (connections_.size() < MAX_RANGE_CONNECTIONS) {
+			connections_.push_back(std::make_unique<RangeConnection>());
+			conns.push_back(connections_.back().get());
+		} else {
+			break;
+		}
+	}
+	return conns;
+}
+
+void HTTPFileLoader::ReleaseConnections(const std::vector<RangeConnection *> &conns) {
+	{
+		std::lock_guard<std::mutex> guard(connectionsMutex_);
+		freeConnections_.insert(freeConnections_.end(), conns.begin(), conns.end());
+	}
+	connectionsCond_.notify_all();
+}
 
+bool HTTPFileLoader::PrepareConnection(RangeConnection *conn, const std::atomic<bool> *cancelled) {
+	if (conn->connected) {
+		// Nothing should be waiting on an idle connection, unless the server closed it on us.
+		if (conn->readbuf.empty() && !fd_util::WaitUntilReady((int)conn->client.sock(), 0.0, false))
+			return true;
+		DisconnectRange(conn);
+	}
+
+	if (!conn->resolved) {
+		conn->client.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
+		conn->client.SetDataTimeout(20.0);
+		conn->client.SetKeepAlive(keepAlive_);
+		conn->resolved = conn->client.Resolve(url_.Host().c_str(), url_.Port());
+		if (!conn->resolved) {
+			latestError_ = "Could not connect (name not resolved)";
+			return false;
+		}
+	}
+
+	conn->connected = conn->client.Connect(3, 10.0, cancelled);
+	if (!conn->connected) {
+		ERROR_LOG(Log::Loader, "HTTP request failed, failed to connect: %s port %d", url_.Host().c_str(), url_.Port());
+		latestError_ = "Could not connect (refused to connect)";
+		return false;
+	}
+
+	// Pipelined requests are small, they shouldn't wait for each other to be acked.
+	int opt = 1;
+	setsockopt((int)conn->client.sock(), IPPROTO_TCP, TCP_NODELAY, (const char *)&opt, sizeof(opt));
+	return true;
+}
+
+void HTTPFileLoader::DisconnectRange(RangeConnection *conn) {
+	if (conn->connected) {
+		conn->client.Disconnect();
+	}
+	conn->connected = false;
+	conn->readbuf.clear();
+}
+
+bool HTTPFileLoader::SendRangeRequest(RangePiece &piece, net::RequestProgress *progress) {
 	char requestHeaders[4096];
 	// Note that the Range header is *inclusive*.
 	snprintf(requestHeaders, sizeof(requestHeaders),
-		"Range: bytes=%lld-%lld\r\n", absolutePos, absoluteEnd - 1);
+		"Range: bytes=%lld-%lld\r\n", piece.pos, piece.pos + (s64)piece.bytes - 1);
 
 	http::RequestParams req(url_.Resource(), "*/*");
-	int err = client_.SendRequest("GET", req, requestHeaders, &progress_);
-	if (err < 0) {
-		latestError_ = "Invalid response reading data";
-		Disconnect();
-		return 0;
-	}
+	return piece.conn->client.SendRequest("GET", req, requestHeaders, progress) >= 0;
+}
+
+bool HTTPFileLoader::ReadRangeResponse(RangePiece &piece, u8 *dest, net::RequestProgress *progress) {
+	RangeConnection *conn = piece.conn;
+	const s64 absoluteEnd = piece.pos + (s64)piece.bytes;
 
-	net::Buffer readbuf;
 	std::vector<std::string> responseHeaders;
-	int code = client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
+	int code = conn->client.ReadResponseHeaders(&conn->readbuf, responseHeaders, progress);
 	if (code != 206) {
 		ERROR_LOG(Log::Loader, "HTTP server did not respond with range, received code=%03d", code);
 		latestError_ = "Invalid response reading data";
-		Disconnect();
-		return 0;
+		return false;
 	}
 
 	// TODO: Expire cache via ETag, etc.
@@ -226,10 +378,10 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 			std::string lowerHeader = header;
 			std::transform(lowerHeader.begin(), lowerHeader.end(), lowerHeader.begin(), tolower);
 			if (sscanf(lowerHeader.c_str(), "content-range: bytes %lld-%lld/%lld", &first, &last, &total) >= 2) {
-				if (first == absolutePos && last == absoluteEnd - 1) {
+				if (first == piece.pos && last == absoluteEnd - 1) {
 					supportedResponse = true;
 				} else {
-					ERROR_LOG(Log::Loader, "Unexpected HTTP range: got %lld-%lld, wanted %lld-%lld.", first, last, absolutePos, absoluteEnd - 1);
+					ERROR_LOG(Log::Loader, "Unexpected HTTP range: got %lld-%lld, wanted %lld-%lld.", first, last, piece.pos, absoluteEnd - 1);
 				}
 			} else {
 				ERROR_LOG(Log::Loader, "Unexpected HTTP range response: %s", header.c_str());
@@ -239,30 +391,25 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 
 	// TODO: Would be nice to read directly.
 	net::Buffer output;
-	int res = client_.ReadResponseEntity(&readbuf, responseHeaders, &output, &progress_);
+	int res = conn->client.ReadResponseEntity(&conn->readbuf, responseHeaders, &output, progress);
 	if (res != 0) {
 		ERROR_LOG(Log::Loader, "Unable to read HTTP response entity: %d", res);
-		// Let's take anything we got anyway.  Not worse than returning nothing?
+		latestError_ = "Invalid response reading data";
+		return false;
 	}
 
-	// TODO: Keepalive instead.
-	Disconnect();
-
-	if (!supportedResponse) {
+	if (!supportedResponse || output.size() != piece.bytes) {
 		ERROR_LOG(Log::Loader, "HTTP server did not respond with the range we wanted.");
 		latestError_ = "Invalid response reading data";
-		return 0;
+		return false;
 	}
 
-	size_t readBytes = output.size();
-	output.Take(readBytes, (char *)data);
-	filepos_ = absolutePos + readBytes;
-	return readBytes;
+	output.Take(piece.bytes, (char *)dest);
+	return true;
 }
 
-void HTTPFileLoader::Connect(double timeout) {
+void HTTPFileLoader::Connect(double timeout, const std::atomic<bool> *cancelled) {
 	if (!connected_) {
-		cancel_ = false;
-		connected_ = client_.Connect(3, timeout, &cancel_);
+		connected_ = client_.Connect(3, timeout, cancelled);
 	}
 }
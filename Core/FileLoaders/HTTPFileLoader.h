@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -47,18 +50,57 @@ class HTTPFileLoader : public FileLoader {
 	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override;
 
 	void Cancel() override {
-		cancel_ = true;
+		// Only stops the requests in progress, anything started after goes ahead as usual.
+		std::lock_guard<std::mutex> guard(connectionsMutex_);
+		for (std::atomic<bool> *cancelled : activeCancels_)
+			*cancelled = true;
 	}
 
 	std::string LatestError() const override {
-		return latestError_;
+		return latestError_.load();
 	}
 
 private:
+	// A persistent connection for range requests, which can have several of them in flight at once.
+	struct RangeConnection {
+		http::Client client;
+		// Whatever was read past the last response, probably the start of the next one.
+		net::Buffer readbuf;
+		bool resolved = false;
+		bool connected = false;
+	};
+
+	// Gives each request its own flag for Cancel() to set, so starting one never clears another's cancel.
+	class ActiveRequest {
+	public:
+		explicit ActiveRequest(HTTPFileLoader *loader);
+		~ActiveRequest();
+
+		std::atomic<bool> cancelled{ false };
+
+	private:
+		HTTPFileLoader *loader_;
+	};
+
+	// One range request, as part of a (possibly) larger read.
+	struct RangePiece {
+		s64 pos;
+		size_t bytes;
+		RangeConnection *conn;
+		bool ok = false;
+	};
+
 	void Prepare();
-	int SendHEAD(const Url &url, std::vector<std::string> &responseHeaders);
+	int SendHEAD(const Url &url, std::vector<std::string> &responseHeaders, std::string *statusLine);
+
+	std::vector<RangeConnection *> AcquireConnections(size_t wanted);
+	void ReleaseConnections(const std::vector<RangeConnection *> &conns);
+	bool PrepareConnection(RangeConnection *conn, const std::atomic<bool> *cancelled);
+	void DisconnectRange(RangeConnection *conn);
+	bool SendRangeRequest(RangePiece &piece, net::RequestProgress *progress);
+	bool ReadRangeResponse(RangePiece &piece, u8 *dest, net::RequestProgress *progress);
 
-	void Connect(double timeout);
+	void Connect(double timeout, const std::atomic<bool> *cancelled);
 
 	void Disconnect() {
 		if (connected_) {
@@ -68,15 +110,20 @@ class HTTPFileLoader : public FileLoader {
 	}
 
 	s64 filesize_ = 0;
-	s64 filepos_ = 0;
 	Url url_;
 	http::Client client_;
-	net::RequestProgress progress_;
 	::Path filename_;
 	bool connected_ = false;
-	bool cancel_ = false;
-	const char *latestError_ = "";
+	std::atomic<const char *> latestError_{ "" };
+	// Whether the server said it would keep connections open, otherwise there's no point pipelining.
+	bool keepAlive_ = false;
 
 	std::once_flag preparedFlag_;
-	std::mutex readAtMutex_;
+
+	std::vector<std::unique_ptr<RangeConnection>> connections_;
+	std::vector<RangeConnection *> freeConnections_;
+	// Flags of the requests in progress, for Cancel().
+	std::vector<std::atomic<bool> *> activeCancels_;
+	std::mutex connectionsMutex_;
+	std::condition_variable connectionsCond_;
 };
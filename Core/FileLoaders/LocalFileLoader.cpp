@@ -18,9 +18,12 @@
 
 #include "ppsspp_config.h"
 
+#include <algorithm>
+
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/DirListing.h"
+#include "Core/Config.h"
 #include "Core/FileLoaders/LocalFileLoader.h"
 
 #if PPSSPP_PLATFORM(ANDROID)
@@ -36,6 +39,14 @@
 #include <fcntl.h>
 #endif
 
+// Mapping the whole ISO needs the address space, and on Android a removed SD card would crash on access.
+// Even elsewhere, an I/O error or truncation while mapped raises SIGBUS instead of failing a read, so it's opt-in.
+#if PPSSPP_ARCH(64BIT) && !defined(HAVE_LIBRETRO_VFS) && ((PPSSPP_PLATFORM(LINUX) && !PPSSPP_PLATFORM(ANDROID)) || PPSSPP_PLATFORM(MAC))
+#define LOCAL_FILE_LOADER_MMAP 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #ifdef HAVE_LIBRETRO_VFS
 #include <streams/file_stream.h>
 #endif
@@ -125,6 +136,11 @@ LocalFileLoader::~LocalFileLoader() {
 #if defined(HAVE_LIBRETRO_VFS)
     filestream_close(handle_);
 #elif !defined(_WIN32)
+#ifdef LOCAL_FILE_LOADER_MMAP
+	if (mapped_) {
+		munmap((void *)mapped_, (size_t)filesize_);
+	}
+#endif
 	if (fd_ != -1) {
 		close(fd_);
 	}
@@ -215,3 +231,42 @@ size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void
 	return result == TRUE ? (size_t)read / bytes : -1;
 #endif
 }
+
+void LocalFileLoader::Prefetch(s64 absolutePos, size_t bytes) {
+#ifdef LOCAL_FILE_LOADER_MMAP
+	if (mapped_) {
+		if (absolutePos >= (s64)filesize_)
+			return;
+		// madvise wants page aligned ranges.
+		const u64 pageMask = (u64)sysconf(_SC_PAGESIZE) - 1;
+		const u64 start = (u64)absolutePos & ~pageMask;
+		const u64 end = std::min((u64)absolutePos + bytes, filesize_);
+		madvise((void *)(mapped_ + start), (size_t)(end - start), MADV_WILLNEED);
+		return;
+	}
+#endif
+#if PPSSPP_PLATFORM(LINUX) && !defined(HAVE_LIBRETRO_VFS)
+	// Let the OS start reading it into the page cache, so the actual read doesn't wait on storage.
+	if (fd_ != -1)
+		posix_fadvise(fd_, absolutePos, bytes, POSIX_FADV_WILLNEED);
+#endif
+}
+
+const u8 *LocalFileLoader::GetMappedData() {
+#ifdef LOCAL_FILE_LOADER_MMAP
+	std::call_once(mapFlag_, [this]() {
+		if (!g_Config.bMemoryMapIso || fd_ == -1 || filesize_ == 0) {
+			return;
+		}
+		void *ptr = mmap(nullptr, (size_t)filesize_, PROT_READ, MAP_SHARED, fd_, 0);
+		if (ptr == MAP_FAILED) {
+			WARN_LOG(Log::FileSystem, "Unable to map '%s', using regular reads", filename_.c_str());
+			return;
+		}
+		mapped_ = (const u8 *)ptr;
+	});
+	return mapped_;
+#else
+	return nullptr;
+#endif
+}
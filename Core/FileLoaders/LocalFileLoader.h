@@ -45,6 +45,8 @@ class LocalFileLoader : public FileLoader {
 		return filename_;
 	}
 	size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override;
+	void Prefetch(s64 absolutePos, size_t bytes) override;
+	const u8 *GetMappedData() override;
 
 private:
 #if !defined(_WIN32) && !defined(HAVE_LIBRETRO_VFS)
@@ -57,4 +59,7 @@ class LocalFileLoader : public FileLoader {
 	Path filename_;
 	std::mutex readLock_;
 	bool isOpenedByFd_ = false;
+	// Only mapped on request, see GetMappedData().
+	std::once_flag mapFlag_;
+	const u8 *mapped_ = nullptr;
 };
@@ -17,8 +17,12 @@
 
 #include <algorithm>
 #include <cstring>
+#include <vector>
 
+#include "Common/Data/Encoding/Compression.h"
 #include "Common/Data/Text/I18n.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Common/System/OSD.h"
 #include "Common/Log.h"
 #include "Common/Swap.h"
@@ -51,8 +55,8 @@ BlockDevice *constructBlockDevice(FileLoader *fileLoader) {
 		return nullptr;
 	}
 
-	// Check for CISO
-	if (!memcmp(buffer, "CISO", 4)) {
+	// Check for CISO, or ZSO which is the same thing with LZ4.
+	if (!memcmp(buffer, "CISO", 4) || !memcmp(buffer, "ZISO", 4)) {
 		return new CISOFileBlockDevice(fileLoader);
 	} else if (!memcmp(buffer, "\x00PBP", 4)) {
 		uint32_t psarOffset = 0;
@@ -78,12 +82,19 @@ void BlockDevice::NotifyReadError() {
 FileBlockDevice::FileBlockDevice(FileLoader *fileLoader)
 	: BlockDevice(fileLoader) {
 	filesize_ = fileLoader->FileSize();
+	// Uncompressed, so if the loader can map the file, we can read straight from it.
+	mapped_ = fileLoader->GetMappedData();
 }
 
 FileBlockDevice::~FileBlockDevice() {
 }
 
 bool FileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
+	if (mapped_ && blockNumber >= 0 && ((u64)blockNumber + 1) * GetBlockSize() <= filesize_) {
+		memcpy(outPtr, mapped_ + (u64)blockNumber * GetBlockSize(), GetBlockSize());
+		return true;
+	}
+
 	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
 	size_t retval = fileLoader_->ReadAt((u64)blockNumber * (u64)GetBlockSize(), 1, 2048, outPtr, flags);
 	if (retval != 2048) {
@@ -95,6 +106,11 @@ bool FileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
 }
 
 bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	if (mapped_ && count >= 0 && ((u64)minBlock + count) * GetBlockSize() <= filesize_) {
+		memcpy(outPtr, mapped_ + (u64)minBlock * GetBlockSize(), (size_t)count * GetBlockSize());
+		return true;
+	}
+
 	size_t retval = fileLoader_->ReadAt((u64)minBlock * (u64)GetBlockSize(), 2048, count, outPtr);
 	if (retval != (size_t)count) {
 		ERROR_LOG(Log::FileSystem, "Could not read %d blocks, at block offset %d. Only got %d blocks", count, minBlock, (int)retval);
@@ -103,6 +119,10 @@ bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	return true;
 }
 
+void FileBlockDevice::PrefetchBlocks(u32 minBlock, int count) {
+	fileLoader_->Prefetch((u64)minBlock * (u64)GetBlockSize(), (size_t)count * GetBlockSize());
+}
+
 // .CSO format
 
 // compressed ISO(9660) header format
@@ -132,6 +152,76 @@ typedef struct ciso_header
 // TODO: Need much better error handling.
 
 static const u32 CSO_READ_BUFFER_SIZE = 256 * 1024;
+// Minimum decompressed bytes per task when decoding frames in parallel, or the overhead dominates.
+static const u32 CSO_PARALLEL_MIN_BYTES = 64 * 1024;
+
+enum class CSOFrameEncoding {
+	PLAIN,
+	DEFLATE,
+	LZ4,
+};
+
+static CSOFrameEncoding GetCSOFrameEncoding(int ver, bool isZSO, u32 frameSize, u32 idx, u32 compressedSize) {
+	if (ver >= 2) {
+		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means LZ4.
+		if (compressedSize >= frameSize)
+			return CSOFrameEncoding::PLAIN;
+		return (idx & 0x80000000) != 0 ? CSOFrameEncoding::LZ4 : CSOFrameEncoding::DEFLATE;
+	}
+	if ((idx & 0x80000000) != 0)
+		return CSOFrameEncoding::PLAIN;
+	return isZSO ? CSOFrameEncoding::LZ4 : CSOFrameEncoding::DEFLATE;
+}
+
+// Keeps the inflate state around between frames, since init is relatively expensive.
+struct CSOFrameDecoder {
+	~CSOFrameDecoder() {
+		if (zInit)
+			inflateEnd(&z);
+	}
+
+	bool Decode(CSOFrameEncoding encoding, const u8 *src, u32 srcSize, u8 *dst, u32 frameSize, u32 frame);
+
+	z_stream z{};
+	bool zInit = false;
+};
+
+bool CSOFrameDecoder::Decode(CSOFrameEncoding encoding, const u8 *src, u32 srcSize, u8 *dst, u32 frameSize, u32 frame) {
+	if (encoding == CSOFrameEncoding::LZ4) {
+		int result = lz4_decompress_block(src, srcSize, dst, frameSize);
+		if (result != (int)frameSize) {
+			ERROR_LOG(Log::Loader, "LZ4 frame %d: decompression failed (%d)", frame, result);
+			return false;
+		}
+		return true;
+	}
+
+	if (!zInit) {
+		if (inflateInit2(&z, -15) != Z_OK) {
+			ERROR_LOG(Log::Loader, "Unable to initialize inflate: %s", (z.msg) ? z.msg : "?");
+			return false;
+		}
+		zInit = true;
+	} else {
+		inflateReset(&z);
+	}
+
+	z.avail_in = srcSize;
+	z.next_in = (Bytef *)src;
+	z.avail_out = frameSize;
+	z.next_out = dst;
+
+	int status = inflate(&z, Z_FINISH);
+	if (status != Z_STREAM_END) {
+		ERROR_LOG(Log::Loader, "Inflate frame %d: failed - %s[%d]", frame, (z.msg) ? z.msg : "error", status);
+		return false;
+	}
+	if (z.total_out != frameSize) {
+		ERROR_LOG(Log::Loader, "Inflate frame %d: block size error %d != %d", frame, (u32)z.total_out, frameSize);
+		return false;
+	}
+	return true;
+}
 
 CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	: BlockDevice(fileLoader)
@@ -140,10 +230,12 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 
 	CISO_H hdr;
 	size_t readSize = fileLoader->ReadAt(0, sizeof(CISO_H), 1, &hdr);
-	if (readSize != 1 || memcmp(hdr.magic, "CISO", 4) != 0) {
+	if (readSize == 1 && memcmp(hdr.magic, "ZISO", 4) == 0) {
+		isZSO_ = true;
+	} else if (readSize != 1 || memcmp(hdr.magic, "CISO", 4) != 0) {
 		WARN_LOG(Log::Loader, "Invalid CSO!");
 	}
-	if (hdr.ver > 1) {
+	if (hdr.ver > 2 || (isZSO_ && hdr.ver > 1)) {
 		WARN_LOG(Log::Loader, "CSO version too high!");
 	}
 
@@ -165,12 +257,11 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	VERBOSE_LOG(Log::Loader, "CSO numBlocks=%i numFrames=%i align=%i", numBlocks, numFrames, indexShift);
 
 	// We might read a bit of alignment too, so be prepared.
-	if (frameSize + (1 << indexShift) < CSO_READ_BUFFER_SIZE)
-		readBuffer = new u8[CSO_READ_BUFFER_SIZE];
-	else
-		readBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBufferFrame = numFrames;
+	readBufferSize_ = std::max(CSO_READ_BUFFER_SIZE, frameSize + (1 << indexShift));
+	readBuffer = new u8[readBufferSize_];
+	frameCache_ = new u8[(size_t)frameSize * FRAME_CACHE_SIZE];
+	for (int i = 0; i < FRAME_CACHE_SIZE; ++i)
+		frameCacheFrames_[i] = numFrames;
 
 	const u32 indexSize = numFrames + 1;
 	const size_t headerEnd = hdr.ver > 1 ? (size_t)hdr.header_size : sizeof(hdr);
@@ -213,7 +304,37 @@ CISOFileBlockDevice::~CISOFileBlockDevice()
 {
 	delete [] index;
 	delete [] readBuffer;
-	delete [] zlibBuffer;
+	delete [] frameCache_;
+}
+
+u8 *CISOFileBlockDevice::FindCachedFrame(u32 frame) {
+	for (int i = 0; i < FRAME_CACHE_SIZE; ++i) {
+		if (frameCacheFrames_[i] == frame) {
+			frameCacheLastUse_[i] = ++frameCacheTick_;
+			return frameCache_ + (size_t)i * frameSize;
+		}
+	}
+	return nullptr;
+}
+
+u8 *CISOFileBlockDevice::CacheFrameSlot(u32 frame) {
+	int oldest = 0;
+	for (int i = 1; i < FRAME_CACHE_SIZE; ++i) {
+		if (frameCacheLastUse_[i] < frameCacheLastUse_[oldest])
+			oldest = i;
+	}
+	frameCacheFrames_[oldest] = frame;
+	frameCacheLastUse_[oldest] = ++frameCacheTick_;
+	return frameCache_ + (size_t)oldest * frameSize;
+}
+
+void CISOFileBlockDevice::UncacheFrame(u32 frame) {
+	for (int i = 0; i < FRAME_CACHE_SIZE; ++i) {
+		if (frameCacheFrames_[i] == frame) {
+			frameCacheFrames_[i] = numFrames;
+			frameCacheLastUse_[i] = 0;
+		}
+	}
 }
 
 bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
@@ -228,62 +349,36 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 	const u32 idx = index[frameNumber];
 	const u32 indexPos = idx & 0x7FFFFFFF;
 	const u32 nextIndexPos = index[frameNumber + 1] & 0x7FFFFFFF;
-	z_stream z{};
 
 	const u64 compressedReadPos = (u64)indexPos << indexShift;
 	const u64 compressedReadEnd = (u64)nextIndexPos << indexShift;
 	const size_t compressedReadSize = (size_t)(compressedReadEnd - compressedReadPos);
 	const u32 compressedOffset = (blockNumber & ((1 << blockShift) - 1)) * GetBlockSize();
 
-	bool plain = (idx & 0x80000000) != 0;
-	if (ver_ >= 2) {
-		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
-		plain = compressedReadSize >= frameSize;
-	}
-	if (plain) {
+	const CSOFrameEncoding encoding = GetCSOFrameEncoding(ver_, isZSO_, frameSize, idx, (u32)compressedReadSize);
+	if (encoding == CSOFrameEncoding::PLAIN) {
 		int readSize = (u32)fileLoader_->ReadAt(compressedReadPos + compressedOffset, 1, GetBlockSize(), outPtr, flags);
 		if (readSize < GetBlockSize())
 			memset(outPtr + readSize, 0, GetBlockSize() - readSize);
-	} else if (zlibBufferFrame == frameNumber) {
+	} else if (const u8 *cached = FindCachedFrame(frameNumber)) {
 		// We already have it.  Just apply the offset and copy.
-		memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
+		memcpy(outPtr, cached + compressedOffset, GetBlockSize());
 	} else {
-		const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer, flags);
-
-		z.zalloc = Z_NULL;
-		z.zfree = Z_NULL;
-		z.opaque = Z_NULL;
-		if (inflateInit2(&z, -15) != Z_OK) {
-			ERROR_LOG(Log::Loader, "GetBlockSize() ERROR: %s\n", (z.msg) ? z.msg : "?");
-			NotifyReadError();
-			return false;
-		}
-		z.avail_in = readSize;
-		z.next_out = frameSize == (u32)GetBlockSize() ? outPtr : zlibBuffer;
-		z.avail_out = frameSize;
-		z.next_in = readBuffer;
-
-		int status = inflate(&z, Z_FINISH);
-		if (status != Z_STREAM_END) {
-			ERROR_LOG(Log::Loader, "block %d: inflate : %s[%d]\n", blockNumber, (z.msg) ? z.msg : "error", status);
+		const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, std::min(compressedReadSize, (size_t)readBufferSize_), readBuffer, flags);
+
+		u8 *target = frameSize == (u32)GetBlockSize() ? outPtr : CacheFrameSlot(frameNumber);
+		CSOFrameDecoder decoder;
+		if (!decoder.Decode(encoding, readBuffer, readSize, target, frameSize, frameNumber)) {
+			ERROR_LOG(Log::Loader, "block %d: decompression failed", blockNumber);
+			if (target != outPtr)
+				UncacheFrame(frameNumber);
 			NotifyReadError();
-			inflateEnd(&z);
 			memset(outPtr, 0, GetBlockSize());
 			return false;
 		}
-		if (z.total_out != frameSize) {
-			ERROR_LOG(Log::Loader, "block %d: block size error %d != %d\n", blockNumber, (u32)z.total_out, frameSize);
-			NotifyReadError();
-			inflateEnd(&z);
-			memset(outPtr, 0, GetBlockSize());
-			return false;
-		}
-		inflateEnd(&z);
 
-		if (frameSize != (u32)GetBlockSize()) {
-			zlibBufferFrame = frameNumber;
-			memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-		}
+		if (target != outPtr)
+			memcpy(outPtr, target + compressedOffset, GetBlockSize());
 	}
 	return true;
 }
@@ -305,76 +400,270 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 
 	const u32 minFrameNumber = minBlock >> blockShift;
 	const u32 lastFrameNumber = lastBlock >> blockShift;
-	const u32 afterLastIndexPos = index[lastFrameNumber + 1] & 0x7FFFFFFF;
-	const u64 totalReadEnd = (u64)afterLastIndexPos << indexShift;
+	const u32 blocksPerFrame = 1 << blockShift;
+	const u32 blockSize = GetBlockSize();
+
+	struct FrameRead {
+		u32 frame;
+		u32 srcOffset;
+		u32 srcSize;
+		u32 blockOffset;
+		u32 blocks;
+		CSOFrameEncoding encoding;
+		u8 *out;
+		// Where to decode to: directly to out for whole frames, or the frame cache.  Null if already done.
+		u8 *target;
+		bool ok;
+	};
+	std::vector<FrameRead> frames;
+	frames.reserve(std::min(lastFrameNumber - minFrameNumber + 1, readBufferSize_ / 64));
 
-	z_stream z{};
-	if (inflateInit2(&z, -15) != Z_OK) {
-		ERROR_LOG(Log::Loader, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
-		return false;
+	u32 block = minBlock;
+	u32 frame = minFrameNumber;
+	while (frame <= lastFrameNumber) {
+		// Gather as many frames as fit in the read buffer, so they can be read at once and decoded together.
+		const u64 batchReadPos = (u64)(index[frame] & 0x7FFFFFFF) << indexShift;
+		u64 batchReadEnd = batchReadPos;
+		frames.clear();
+		while (frame <= lastFrameNumber) {
+			const u32 idx = index[frame];
+			const u64 frameReadPos = (u64)(idx & 0x7FFFFFFF) << indexShift;
+			const u64 frameReadEnd = std::max(frameReadPos, (u64)(index[frame + 1] & 0x7FFFFFFF) << indexShift);
+			if (!frames.empty() && frameReadEnd - batchReadPos > readBufferSize_)
+				break;
+
+			FrameRead f{};
+			f.frame = frame;
+			f.srcOffset = (u32)(frameReadPos - batchReadPos);
+			// Only possible with a corrupt index.  Decoding will just fail.
+			f.srcSize = (u32)std::min(frameReadEnd - frameReadPos, (u64)(readBufferSize_ - f.srcOffset));
+			f.blockOffset = block & (blocksPerFrame - 1);
+			f.blocks = std::min(lastBlock - block + 1, blocksPerFrame - f.blockOffset);
+			f.encoding = GetCSOFrameEncoding(ver_, isZSO_, frameSize, idx, (u32)(frameReadEnd - frameReadPos));
+			f.out = outPtr;
+			f.ok = true;
+			frames.push_back(f);
+
+			block += f.blocks;
+			outPtr += f.blocks * blockSize;
+			batchReadEnd = frameReadEnd;
+			++frame;
+		}
+
+		const size_t chunkSize = (size_t)std::min(batchReadEnd - batchReadPos, (u64)readBufferSize_);
+		const size_t readSize = fileLoader_->ReadAt(batchReadPos, 1, chunkSize, readBuffer);
+		if (readSize < chunkSize) {
+			memset(readBuffer + readSize, 0, chunkSize - readSize);
+		}
+
+		int toDecode = 0;
+		for (FrameRead &f : frames) {
+			const u8 *src = readBuffer + f.srcOffset;
+			if (f.encoding == CSOFrameEncoding::PLAIN) {
+				memcpy(f.out, src + f.blockOffset * blockSize, f.blocks * blockSize);
+			} else if (f.blocks == blocksPerFrame) {
+				f.target = f.out;
+				toDecode++;
+			} else if (const u8 *cached = FindCachedFrame(f.frame)) {
+				memcpy(f.out, cached + f.blockOffset * blockSize, f.blocks * blockSize);
+			} else {
+				// Partial frames at the start or end go through the cache, the next read will likely want the rest.
+				f.target = CacheFrameSlot(f.frame);
+				toDecode++;
+			}
+		}
+
+		auto decodeRange = [&](int lower, int upper) {
+			CSOFrameDecoder decoder;
+			for (int i = lower; i < upper; ++i) {
+				FrameRead &f = frames[i];
+				if (f.target)
+					f.ok = decoder.Decode(f.encoding, readBuffer + f.srcOffset, f.srcSize, f.target, frameSize, f.frame);
+			}
+		};
+
+		const int minFramesPerTask = std::max(1, (int)(CSO_PARALLEL_MIN_BYTES / frameSize));
+		if (toDecode > minFramesPerTask && g_threadManager.IsInitialized()) {
+			ParallelRangeLoop(&g_threadManager, decodeRange, 0, (int)frames.size(), minFramesPerTask);
+		} else if (toDecode != 0) {
+			decodeRange(0, (int)frames.size());
+		}
+
+		for (const FrameRead &f : frames) {
+			if (!f.ok) {
+				if (f.target != f.out)
+					UncacheFrame(f.frame);
+				NotifyReadError();
+				memset(f.out, 0, f.blocks * blockSize);
+			} else if (f.target && f.target != f.out) {
+				memcpy(f.out, f.target + f.blockOffset * blockSize, f.blocks * blockSize);
+			}
+		}
 	}
 
-	u64 readBufferStart = 0;
-	u64 readBufferEnd = 0;
-	u32 block = minBlock;
-	const u32 blocksPerFrame = 1 << blockShift;
-	for (u32 frame = minFrameNumber; frame <= lastFrameNumber; ++frame) {
-		const u32 idx = index[frame];
-		const u32 indexPos = idx & 0x7FFFFFFF;
-		const u32 nextIndexPos = index[frame + 1] & 0x7FFFFFFF;
-
-		const u64 frameReadPos = (u64)indexPos << indexShift;
-		const u64 frameReadEnd = (u64)nextIndexPos << indexShift;
-		const u32 frameReadSize = (u32)(frameReadEnd - frameReadPos);
-		const u32 frameBlockOffset = block & ((1 << blockShift) - 1);
-		const u32 frameBlocks = std::min(lastBlock - block + 1, blocksPerFrame - frameBlockOffset);
-
-		if (frameReadEnd > readBufferEnd) {
-			const s64 maxNeeded = totalReadEnd - frameReadPos;
-			const size_t chunkSize = (size_t)std::min(maxNeeded, (s64)std::max(frameReadSize, CSO_READ_BUFFER_SIZE));
-
-			const u32 readSize = (u32)fileLoader_->ReadAt(frameReadPos, 1, chunkSize, readBuffer);
-			if (readSize < chunkSize) {
-				memset(readBuffer + readSize, 0, chunkSize - readSize);
+	return true;
+}
+
+void CISOFileBlockDevice::PrefetchBlocks(u32 minBlock, int count) {
+	if (minBlock >= numBlocks || count <= 0) {
+		return;
+	}
+
+	// Translate to the compressed range in the file.
+	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
+	const u64 readPos = (u64)(index[minBlock >> blockShift] & 0x7FFFFFFF) << indexShift;
+	const u64 readEnd = (u64)(index[(lastBlock >> blockShift) + 1] & 0x7FFFFFFF) << indexShift;
+	if (readEnd > readPos) {
+		fileLoader_->Prefetch(readPos, (size_t)(readEnd - readPos));
+	}
+}
+
+// Compresses frames for WriteCompressedISO.  Output is the data to store for the frame, and the index flag bit.
+struct CSOFrameEncoder {
+	CSOFrameEncoder(CompressedISOFormat format) : format_(format) {
+		if (format_ != CompressedISOFormat::ZSO) {
+			zInit_ = deflateInit2(&z_, 9, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+		}
+	}
+	~CSOFrameEncoder() {
+		if (zInit_)
+			deflateEnd(&z_);
+	}
+
+	// Returns the size written to out, which has room for frameSize bytes.  0 means store plain.
+	u32 Encode(const u8 *src, u32 frameSize, u8 *out, u8 *scratch, bool *lz4) {
+		u32 best = 0;
+		*lz4 = false;
+		if (format_ != CompressedISOFormat::ZSO && zInit_) {
+			deflateReset(&z_);
+			z_.next_in = (Bytef *)src;
+			z_.avail_in = frameSize;
+			z_.next_out = out;
+			z_.avail_out = frameSize;
+			if (deflate(&z_, Z_FINISH) == Z_STREAM_END)
+				best = (u32)z_.total_out;
+		}
+		if (format_ != CompressedISOFormat::CSO) {
+			size_t size = lz4_compress_block(src, frameSize, scratch, frameSize);
+			if (size != 0 && (best == 0 || size < best)) {
+				memcpy(out, scratch, size);
+				best = (u32)size;
+				*lz4 = true;
 			}
+		}
+		return best;
+	}
+
+	CompressedISOFormat format_;
+	z_stream z_{};
+	bool zInit_ = false;
+};
+
+bool WriteCompressedISO(BlockDevice *source, const Path &outputPath, CompressedISOFormat format, std::string *errorString) {
+	const u32 frameSize = source->GetBlockSize();
+	const u32 numFrames = source->GetNumBlocks();
+	const u64 totalBytes = (u64)numFrames * frameSize;
+	const u32 indexSize = numFrames + 1;
+	const u64 dataStart = sizeof(CISO_H) + (u64)indexSize * sizeof(u32_le);
+
+	// Index positions only have 31 bits, so large images need alignment.  Plain frames are the worst case.
+	u8 align = 0;
+	while (((dataStart + totalBytes + ((u64)numFrames << align)) >> align) > 0x7FFFFFFF)
+		align++;
+	const u64 alignMask = (1ULL << align) - 1;
 
-			readBufferStart = frameReadPos;
-			readBufferEnd = frameReadPos + readSize;
+	File::IOFile out(outputPath, "wb");
+	if (!out.IsOpen()) {
+		*errorString = "Unable to open output file";
+		return false;
+	}
+
+	CISO_H hdr{};
+	memcpy(hdr.magic, format == CompressedISOFormat::ZSO ? "ZISO" : "CISO", 4);
+	hdr.header_size = sizeof(CISO_H);
+	hdr.total_bytes = totalBytes;
+	hdr.block_size = frameSize;
+	hdr.ver = format == CompressedISOFormat::CSO2 ? 2 : 1;
+	hdr.align = align;
+
+	// The index is written last, once we know where everything ended up.
+	std::vector<u32_le> index(indexSize);
+	out.WriteBytes(&hdr, sizeof(hdr));
+	out.WriteArray(index.data(), indexSize);
+
+	// Frames are compressed in parallel in batches, then written in order.
+	const u32 batchFrames = 1024;
+	std::vector<u8> input((size_t)batchFrames * frameSize);
+	std::vector<u8> output((size_t)batchFrames * frameSize);
+	std::vector<u32> sizes(batchFrames);
+	std::vector<u8> lz4(batchFrames);
+
+	u64 pos = dataStart;
+	const u8 padding[2048]{};
+	for (u32 base = 0; base < numFrames; base += batchFrames) {
+		const u32 count = std::min(batchFrames, numFrames - base);
+		if (!source->ReadBlocks(base, count, input.data())) {
+			*errorString = StringFromFormat("Failed to read blocks %d-%d", base, base + count);
+			return false;
 		}
 
-		u8 *rawBuffer = &readBuffer[frameReadPos - readBufferStart];
-		const int plain = idx & 0x80000000;
-		if (plain) {
-			memcpy(outPtr, rawBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
+		auto encodeRange = [&](int lower, int upper) {
+			CSOFrameEncoder encoder(format);
+			std::vector<u8> scratch(frameSize);
+			for (int i = lower; i < upper; ++i) {
+				bool usedLZ4;
+				sizes[i] = encoder.Encode(&input[(size_t)i * frameSize], frameSize, &output[(size_t)i * frameSize], scratch.data(), &usedLZ4);
+				lz4[i] = usedLZ4;
+			}
+		};
+		if (g_threadManager.IsInitialized()) {
+			ParallelRangeLoop(&g_threadManager, encodeRange, 0, (int)count, 32);
 		} else {
-			z.avail_in = frameReadSize;
-			z.next_out = frameBlocks == blocksPerFrame ? outPtr : zlibBuffer;
-			z.avail_out = frameSize;
-			z.next_in = rawBuffer;
-
-			int status = inflate(&z, Z_FINISH);
-			if (status != Z_STREAM_END) {
-				ERROR_LOG(Log::Loader, "Inflate frame %d: failed - %s[%d]\n", frame, (z.msg) ? z.msg : "error", status);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (z.total_out != frameSize) {
-				ERROR_LOG(Log::Loader, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z.total_out, frameSize);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (frameBlocks != blocksPerFrame) {
-				memcpy(outPtr, zlibBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-				// In case we end up reusing it in a single read later.
-				zlibBufferFrame = frame;
+			encodeRange(0, (int)count);
+		}
+
+		for (u32 i = 0; i < count; ++i) {
+			u32 size = sizes[i];
+			// v2 decides plain by size, so anything that doesn't shrink even with padding is stored plain.
+			if (format == CompressedISOFormat::CSO2 && ((size + alignMask) & ~alignMask) >= frameSize)
+				size = 0;
+
+			u32 flags = 0;
+			const u8 *data = &output[(size_t)i * frameSize];
+			if (size == 0) {
+				data = &input[(size_t)i * frameSize];
+				size = frameSize;
+				flags = format == CompressedISOFormat::CSO2 ? 0 : 0x80000000;
+			} else if (format == CompressedISOFormat::CSO2 && lz4[i]) {
+				flags = 0x80000000;
 			}
 
-			inflateReset(&z);
+			index[base + i] = (u32)(pos >> align) | flags;
+			out.WriteBytes(data, size);
+			pos += size;
+
+			u32 pad = (u32)(((pos + alignMask) & ~alignMask) - pos);
+			while (pad != 0) {
+				const u32 chunk = std::min(pad, (u32)sizeof(padding));
+				out.WriteBytes(padding, chunk);
+				pos += chunk;
+				pad -= chunk;
+			}
 		}
 
-		block += frameBlocks;
-		outPtr += frameBlocks * GetBlockSize();
+		if (!out.IsGood()) {
+			*errorString = "Failed writing output file";
+			return false;
+		}
 	}
+	index[numFrames] = (u32)(pos >> align);
 
-	inflateEnd(&z);
+	out.Seek(sizeof(CISO_H), SEEK_SET);
+	out.WriteArray(index.data(), indexSize);
+	if (!out.IsGood()) {
+		*errorString = "Failed writing output file";
+		return false;
+	}
 	return true;
 }
 
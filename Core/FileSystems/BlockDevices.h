@@ -18,17 +18,19 @@
 #pragma once
 
 // Abstractions around read-only blockdevices, such as PSP UMD discs.
-// CISOFileBlockDevice implements compressed iso images, CISO format.
+// CISOFileBlockDevice implements compressed iso images, CISO format (including CSO v2 and ZSO).
 //
 // The ISOFileSystemReader reads from a BlockDevice, so it automatically works
 // with CISO images.
 
 #include <mutex>
 #include <memory>
+#include <string>
 
 #include "Common/CommonTypes.h"
 
 class FileLoader;
+class Path;
 
 class BlockDevice {
 public:
@@ -44,6 +46,10 @@ class BlockDevice {
 		}
 		return true;
 	}
+	// Hint that these blocks will likely be read soon, so the file loader can start fetching them.
+	virtual void PrefetchBlocks(u32 minBlock, int count) {}
+	// The whole uncompressed image, if it's directly accessible in memory (GetUncompressedSize() bytes.)
+	virtual const u8 *GetMappedData() const { return nullptr; }
 	int GetBlockSize() const { return 2048;}  // forced, it cannot be changed by subclasses
 	virtual u32 GetNumBlocks() const = 0;
 	virtual u64 GetUncompressedSize() const {
@@ -64,22 +70,44 @@ class CISOFileBlockDevice : public BlockDevice {
 	~CISOFileBlockDevice();
 	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
 	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	void PrefetchBlocks(u32 minBlock, int count) override;
 	u32 GetNumBlocks() const override { return numBlocks; }
 	bool IsDisc() const override { return true; }
 
 private:
+	// Small LRU of decoded frames, for frames larger than a block that are read piecemeal.
+	u8 *FindCachedFrame(u32 frame);
+	u8 *CacheFrameSlot(u32 frame);
+	void UncacheFrame(u32 frame);
+
+	enum { FRAME_CACHE_SIZE = 8 };
+
 	u32 *index = nullptr;
 	u8 *readBuffer = nullptr;
-	u8 *zlibBuffer = nullptr;
-	u32 zlibBufferFrame = 0;
+	u32 readBufferSize_ = 0;
+	u8 *frameCache_ = nullptr;
+	u32 frameCacheFrames_[FRAME_CACHE_SIZE]{};
+	u32 frameCacheLastUse_[FRAME_CACHE_SIZE]{};
+	u32 frameCacheTick_ = 0;
 	u8 indexShift = 0;
 	u8 blockShift = 0;
 	u32 frameSize = 0;
 	u32 numBlocks = 0;
 	u32 numFrames = 0;
 	int ver_ = 0;
+	// ZSO is the CSO v1 layout with LZ4 instead of deflate.
+	bool isZSO_ = false;
 };
 
+enum class CompressedISOFormat {
+	CSO,   // deflate, version 1.
+	CSO2,  // deflate or LZ4 per frame, whichever is smaller.
+	ZSO,   // LZ4.
+};
+
+// Writes the contents of the block device as a compressed image. Frames are compressed in parallel.
+bool WriteCompressedISO(BlockDevice *source, const Path &outputPath, CompressedISOFormat format, std::string *errorString);
+
 
 class FileBlockDevice : public BlockDevice {
 public:
@@ -87,6 +115,8 @@ class FileBlockDevice : public BlockDevice {
 	~FileBlockDevice();
 	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
 	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	void PrefetchBlocks(u32 minBlock, int count) override;
+	const u8 *GetMappedData() const override { return mapped_; }
 	u32 GetNumBlocks() const override {return (u32)(filesize_ / GetBlockSize());}
 	bool IsDisc() const override { return true; }
 	u64 GetUncompressedSize() const override {
@@ -94,6 +124,7 @@ class FileBlockDevice : public BlockDevice {
 	}
 private:
 	u64 filesize_;
+	const u8 *mapped_ = nullptr;
 };
 
 
@@ -18,6 +18,7 @@
 #include "ppsspp_config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <ctime>
 #include <limits>
 
@@ -62,6 +63,9 @@
 #include <fcntl.h>
 #endif
 
+// Bumped whenever files are changed from outside, each DirectoryFileSystem checks it before using its cache.
+static std::atomic<int> hostFilesGeneration;
+
 DirectoryFileSystem::DirectoryFileSystem(IHandleAllocator *_hAlloc, const Path & _basePath, FileSystemFlags _flags) : basePath(_basePath), flags(_flags) {
 	File::CreateFullPath(basePath);
 
@@ -462,9 +466,11 @@ void DirectoryFileSystem::CloseAll() {
 		iter->second.hFile.Close();
 	}
 	entries.clear();
+	InvalidatePathCache();
 }
 
 bool DirectoryFileSystem::MkDir(const std::string &dirname) {
+	InvalidatePathCache();
 	bool result;
 	if (flags & FileSystemFlags::CASE_SENSITIVE) {
 		// Must fix case BEFORE attempting, because MkDir would create
@@ -483,6 +489,7 @@ bool DirectoryFileSystem::MkDir(const std::string &dirname) {
 }
 
 bool DirectoryFileSystem::RmDir(const std::string &dirname) {
+	InvalidatePathCache();
 	Path fullName = GetLocalPath(dirname);
 
 	if (flags & FileSystemFlags::CASE_SENSITIVE) {
@@ -506,6 +513,7 @@ bool DirectoryFileSystem::RmDir(const std::string &dirname) {
 }
 
 int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &to) {
+	InvalidatePathCache();
 	std::string fullTo = to;
 
 	// Rename ignores the path (even if specified) on to.
@@ -553,6 +561,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 }
 
 bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
+	InvalidatePathCache();
 	Path localPath = GetLocalPath(filename);
 
 	bool retValue = File::Delete(localPath);
@@ -577,7 +586,21 @@ int DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const
 	OpenFileEntry entry;
 	entry.hFile.fileSystemFlags_ = flags;
 	u32 err = 0;
-	bool success = entry.hFile.Open(basePath, filename, (FileAccess)(access & FILEACCESS_PSP_FLAGS), err);
+	bool success = false;
+	bool writing = (access & (FILEACCESS_APPEND | FILEACCESS_CREATE | FILEACCESS_WRITE | FILEACCESS_TRUNCATE)) != 0;
+	CheckHostFilesChanged();
+	auto cached = writing ? pathCache.end() : pathCache.find(filename);
+	if (writing) {
+		InvalidatePathCache();
+	} else if (cached != pathCache.end() && !cached->second.info.exists) {
+		// We already know it's not there, no need to search for it again.
+		err = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
+	} else if (cached != pathCache.end()) {
+		// Skip straight to the right case.
+		filename = cached->second.fixedPath;
+	}
+	if (err == 0)
+		success = entry.hFile.Open(basePath, filename, (FileAccess)(access & FILEACCESS_PSP_FLAGS), err);
 	if (err == 0 && !success) {
 		err = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
 	}
@@ -619,6 +642,9 @@ void DirectoryFileSystem::CloseFile(u32 handle) {
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		hAlloc->FreeHandle(handle);
+		// Truncation happens on close, among other things.
+		if (iter->second.access & (FILEACCESS_APPEND | FILEACCESS_CREATE | FILEACCESS_WRITE | FILEACCESS_TRUNCATE))
+			InvalidatePathCache();
 		iter->second.hFile.Close();
 		entries.erase(iter);
 	} else {
@@ -670,6 +696,7 @@ size_t DirectoryFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size) {
 size_t DirectoryFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec) {
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
+		InvalidatePathCache();
 		size_t bytesWritten = iter->second.hFile.Write(pointer,size);
 		return bytesWritten;
 	} else {
@@ -690,22 +717,35 @@ size_t DirectoryFileSystem::SeekFile(u32 handle, s32 position, FileMove type) {
 	}
 }
 
-PSPFileInfo DirectoryFileSystem::GetFileInfo(std::string filename) {
-	PSPFileInfo x;
+const DirectoryFileSystem::CachedPath &DirectoryFileSystem::LookupPath(const std::string &filename) {
+	CheckHostFilesChanged();
+	auto cached = pathCache.find(filename);
+	if (cached != pathCache.end())
+		return cached->second;
+
+	// Plenty for any game, this just keeps it from growing forever.
+	if (pathCache.size() >= 1024)
+		pathCache.clear();
+
+	CachedPath &entry = pathCache[filename];
+	entry.fixedPath = filename;
+	PSPFileInfo &x = entry.info;
 	x.name = filename;
 
 	File::FileInfo info;
 	Path fullName = GetLocalPath(filename);
 	if (!File::GetFileInfo(fullName, &info)) {
 		if (flags & FileSystemFlags::CASE_SENSITIVE) {
-			if (!FixPathCase(basePath, filename, FPC_FILE_MUST_EXIST))
-				return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
-			fullName = GetLocalPath(filename);
+			std::string fixedPath = filename;
+			if (!FixPathCase(basePath, fixedPath, FPC_FILE_MUST_EXIST))
+				return entry;
+			fullName = GetLocalPath(fixedPath);
 
 			if (!File::GetFileInfo(fullName, &info))
-				return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
+				return entry;
+			entry.fixedPath = fixedPath;
 		} else {
-			return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
+			return entry;
 		}
 	}
 
@@ -724,7 +764,29 @@ PSPFileInfo DirectoryFileSystem::GetFileInfo(std::string filename) {
 	localtime_r((time_t*)&ctime, &x.ctime);
 	localtime_r((time_t*)&mtime, &x.mtime);
 
-	return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
+	return entry;
+}
+
+void DirectoryFileSystem::InvalidatePathCache() {
+	// Clearing an unordered_map touches every bucket, even when it's empty.
+	if (!pathCache.empty())
+		pathCache.clear();
+}
+
+void DirectoryFileSystem::CheckHostFilesChanged() {
+	int generation = hostFilesGeneration.load(std::memory_order_acquire);
+	if (generation != pathCacheGeneration) {
+		InvalidatePathCache();
+		pathCacheGeneration = generation;
+	}
+}
+
+void DirectoryFileSystem::NotifyHostFilesChanged() {
+	hostFilesGeneration.fetch_add(1, std::memory_order_release);
+}
+
+PSPFileInfo DirectoryFileSystem::GetFileInfo(std::string filename) {
+	return ReplayApplyDiskFileInfo(LookupPath(filename).info, CoreTiming::GetGlobalTimeUs());
 }
 
 PSPFileInfo DirectoryFileSystem::GetFileInfoByHandle(u32 handle) {
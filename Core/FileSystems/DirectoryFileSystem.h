@@ -20,6 +20,7 @@
 // TODO: Remove the Windows-specific code, FILE is fine there too.
 
 #include <map>
+#include <unordered_map>
 
 #include "Common/File/Path.h"
 #include "Core/FileSystems/FileSystem.h"
@@ -62,6 +63,10 @@ class DirectoryFileSystem : public IFileSystem {
 	DirectoryFileSystem(IHandleAllocator *_hAlloc, const Path &_basePath, FileSystemFlags _flags = FileSystemFlags::NONE);
 	~DirectoryFileSystem();
 
+	// Call after changing files under a mounted directory from outside the game, like when deleting
+	// savedata from the menu, so cached lookups get redone.  Safe from any thread.
+	static void NotifyHostFilesChanged();
+
 	void CloseAll();
 
 	void DoState(PointerWrap &p) override;
@@ -96,13 +101,27 @@ class DirectoryFileSystem : public IFileSystem {
 		FileAccess access = FILEACCESS_NONE;
 	};
 
+	// What we found at a guest path last time, including the fixed case.  On case sensitive hosts
+	// that can take a directory scan per component, and games tend to check the same files repeatedly.
+	// Anything we write clears it, and replays still see every lookup through ReplayApplyDiskFileInfo.
+	struct CachedPath {
+		std::string fixedPath;
+		PSPFileInfo info;
+	};
+
 	typedef std::map<u32, OpenFileEntry> EntryMap;
 	EntryMap entries;
+	std::unordered_map<std::string, CachedPath> pathCache;
+	// Compared against NotifyHostFilesChanged() calls.
+	int pathCacheGeneration = 0;
 	Path basePath;
 	IHandleAllocator *hAlloc;
 	FileSystemFlags flags;
 
 	Path GetLocalPath(std::string internalPath) const;
+	const CachedPath &LookupPath(const std::string &filename);
+	void InvalidatePathCache();
+	void CheckHostFilesChanged();
 };
 
 // VFSFileSystem: Ability to map in Android APK paths as well! Does not support all features, only meant for fonts.
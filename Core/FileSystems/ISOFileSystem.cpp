@@ -485,6 +485,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 		if (e.isBlockSectorMode) {
 			// Whole sectors! Shortcut to this simple code.
 			blockDevice->ReadBlocks(e.seekPos, (int)size, pointer);
+			TrackReadPattern(e.pattern, e.seekPos, (u32)size);
 			if (abs((int)lastReadBlock_ - (int)e.seekPos) > 100) {
 				// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
 				usec = 100000;
@@ -537,24 +538,37 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 		}
 
 		const u8 *const start = pointer;
-		if (firstBlockSize > 0) {
-			blockDevice->ReadBlock(secNum++, theSector);
-			memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
-			pointer += firstBlockSize;
-		}
-		if (middleSize > 0) {
-			const u32 sectors = (u32)(middleSize / 2048);
-			blockDevice->ReadBlocks(secNum, sectors, pointer);
-			secNum += sectors;
-			pointer += middleSize;
-		}
-		if (lastBlockSize > 0) {
-			blockDevice->ReadBlock(secNum++, theSector);
-			memcpy(pointer, theSector, lastBlockSize);
-			pointer += lastBlockSize;
+		const u8 *mapped = blockDevice->GetMappedData();
+		if (mapped && positionOnIso + size <= blockDevice->GetUncompressedSize()) {
+			// The image is mapped, so we can skip the sector splitting and copy straight into the destination.
+			memcpy(pointer, mapped + positionOnIso, (size_t)size);
+			pointer += size;
+			secNum = (u32)((positionOnIso + size + 2047) / 2048);
+		} else {
+			if (firstBlockSize > 0) {
+				blockDevice->ReadBlock(secNum++, theSector);
+				memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
+				pointer += firstBlockSize;
+			}
+			if (middleSize > 0) {
+				const u32 sectors = (u32)(middleSize / 2048);
+				blockDevice->ReadBlocks(secNum, sectors, pointer);
+				secNum += sectors;
+				pointer += middleSize;
+			}
+			if (lastBlockSize > 0) {
+				blockDevice->ReadBlock(secNum++, theSector);
+				memcpy(pointer, theSector, lastBlockSize);
+				pointer += lastBlockSize;
+			}
 		}
 
 		size_t totalBytes = pointer - start;
+		if (totalBytes != 0) {
+			const u32 firstSecNum = (u32)(positionOnIso / 2048);
+			const bool endsMidBlock = ((positionOnIso + totalBytes) & 2047) != 0;
+			TrackReadPattern(e.pattern, firstSecNum, secNum - firstSecNum, endsMidBlock);
+		}
 		if (abs((int)lastReadBlock_ - (int)secNum) > 100) {
 			// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
 			usec = 100000;
@@ -569,6 +583,53 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 	}
 }
 
+void ISOFileSystem::TrackReadPattern(ReadPattern &pattern, u32 firstBlock, u32 numBlocks, bool endsMidBlock) {
+	// Ramp up from a small window, so a couple of sequential reads don't trigger a lot of IO.
+	static const u32 PREFETCH_MIN_BLOCKS = 16;
+	static const u32 PREFETCH_MAX_BLOCKS = 512;
+	static const int MAX_CONFIDENCE = 6;
+
+	if (numBlocks == 0) {
+		return;
+	}
+
+	// Byte-sized reads that don't end on a sector boundary pick up again in the same sector.
+	const bool sequential = firstBlock == pattern.lastEnd || (pattern.lastEndPartial && firstBlock + 1 == pattern.lastEnd);
+	const s32 stride = (s32)(firstBlock - pattern.lastStart);
+	if (sequential || (stride > 0 && stride == pattern.stride)) {
+		pattern.confidence = std::min(pattern.confidence + 1, MAX_CONFIDENCE);
+	} else {
+		pattern.confidence = 0;
+		pattern.prefetchedEnd = 0;
+	}
+	pattern.stride = stride;
+	pattern.lastStart = firstBlock;
+	pattern.lastEnd = firstBlock + numBlocks;
+	pattern.lastEndPartial = endsMidBlock;
+
+	if (pattern.confidence < 2) {
+		return;
+	}
+
+	u32 prefetchStart;
+	u32 prefetchEnd;
+	if (sequential) {
+		const u32 window = std::clamp(numBlocks << (pattern.confidence - 2), PREFETCH_MIN_BLOCKS, PREFETCH_MAX_BLOCKS);
+		prefetchStart = std::max(pattern.lastEnd, pattern.prefetchedEnd);
+		prefetchEnd = pattern.lastEnd + window;
+	} else {
+		// Strided, probably reading records out of a big archive.  Just get the next one.
+		prefetchStart = firstBlock + stride;
+		prefetchEnd = prefetchStart + std::min(numBlocks, PREFETCH_MAX_BLOCKS);
+	}
+
+	prefetchEnd = std::min(prefetchEnd, blockDevice->GetNumBlocks());
+	if (prefetchStart < prefetchEnd) {
+		blockDevice->PrefetchBlocks(prefetchStart, (int)(prefetchEnd - prefetchStart));
+		pattern.prefetchedEnd = prefetchEnd;
+	}
+}
+
 size_t ISOFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size) {
 	ERROR_LOG(Log::FileSystem, "Hey, what are you doing? You can't write to an ISO!");
 	return 0;
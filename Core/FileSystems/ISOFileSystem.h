@@ -79,6 +79,18 @@ class ISOFileSystem : public IFileSystem {
 		std::vector<TreeEntry *> children;
 	};
 
+	// Recent reads on a handle, to detect sequential or strided access and prefetch ahead of it.
+	// Not saved in states, it just starts over.
+	struct ReadPattern {
+		u32 lastStart = 0;
+		u32 lastEnd = 0;
+		// The last read stopped partway into lastEnd - 1, so the next sequential read starts in that block.
+		bool lastEndPartial = false;
+		s32 stride = 0;
+		int confidence = 0;
+		u32 prefetchedEnd = 0;
+	};
+
 	struct OpenFileEntry {
 		TreeEntry *file;
 		unsigned int seekPos;  // TODO: Make 64-bit?
@@ -86,6 +98,7 @@ class ISOFileSystem : public IFileSystem {
 		bool isBlockSectorMode;  // "umd:" mode: all sizes and offsets are in 2048 byte chunks
 		u32 sectorStart;
 		u32 openSize;
+		ReadPattern pattern;
 	};
 
 	typedef std::map<u32, OpenFileEntry> EntryMap;
@@ -98,6 +111,7 @@ class ISOFileSystem : public IFileSystem {
 	TreeEntry entireISO;
 
 	void ReadDirectory(TreeEntry *root);
+	void TrackReadPattern(ReadPattern &pattern, u32 firstBlock, u32 numBlocks, bool endsMidBlock = false);
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
 	std::string EntryFullPath(TreeEntry *e);
 };
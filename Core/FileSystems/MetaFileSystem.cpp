@@ -20,11 +20,17 @@
 #include "Common/Serialize/SerializeMap.h"
 #include "Common/StringUtils.h"
 #include "Core/FileSystems/MetaFileSystem.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HLE/sceKernelThread.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 
-static bool ApplyPathStringToComponentsVector(std::vector<std::string> &vector, const std::string &pathString)
+// Components point into the strings they came from, and live in the syscall's scratch space.
+typedef std::vector<std::string_view, HLEScratchAllocator<std::string_view>> PathComponents;
+// Paths being worked on, before they're mapped.
+typedef std::basic_string<char, std::char_traits<char>, HLEScratchAllocator<char>> ScratchPath;
+
+static bool ApplyPathStringToComponentsVector(PathComponents &vector, std::string_view pathString)
 {
 	size_t len = pathString.length();
 	size_t start = 0;
@@ -33,12 +39,12 @@ static bool ApplyPathStringToComponentsVector(std::vector<std::string> &vector,
 	{
 		// TODO: This should only be done for ms0:/ etc.
 		size_t i = pathString.find_first_of("/\\", start);
-		if (i == std::string::npos)
+		if (i == std::string_view::npos)
 			i = len;
 
 		if (i > start)
 		{
-			std::string component = pathString.substr(start, i - start);
+			std::string_view component = pathString.substr(start, i - start);
 			if (component != ".")
 			{
 				if (component == "..")
@@ -50,7 +56,7 @@ static bool ApplyPathStringToComponentsVector(std::vector<std::string> &vector,
 					else
 					{
 						// The PSP silently ignores attempts to .. to parent of root directory
-						WARN_LOG(Log::FileSystem, "RealPath: ignoring .. beyond root - root directory is its own parent: \"%s\"", pathString.c_str());
+						WARN_LOG(Log::FileSystem, "RealPath: ignoring .. beyond root - root directory is its own parent: \"%.*s\"", (int)pathString.size(), pathString.data());
 					}
 				}
 				else
@@ -71,12 +77,12 @@ static bool ApplyPathStringToComponentsVector(std::vector<std::string> &vector,
  * "drive:./blah" is absolute (ignore the dot) and "/blah" is relative (because it's missing "drive:")
  * babel (and possibly other games) use "/directoryThatDoesNotExist/../directoryThatExists/filename"
  */
-static bool RealPath(const std::string &currentDirectory, const std::string &inPath, std::string &outPath)
+static bool RealPath(const std::string &currentDirectory, std::string_view inPath, ScratchPath &outPath)
 {
 	size_t inLen = inPath.length();
 	if (inLen == 0)
 	{
-		outPath = currentDirectory;
+		outPath.assign(currentDirectory.data(), currentDirectory.size());
 		return true;
 	}
 
@@ -84,14 +90,15 @@ static bool RealPath(const std::string &currentDirectory, const std::string &inP
 	if (inColon + 1 == inLen)
 	{
 		// There's nothing after the colon, e.g. umd0: - this is perfectly valid.
-		outPath = inPath;
+		outPath.assign(inPath.data(), inPath.size());
 		return true;
 	}
 
-	bool relative = (inColon == std::string::npos);
+	bool relative = (inColon == std::string_view::npos);
 	
-	std::string prefix, inAfterColon;
-	std::vector<std::string> cmpnts;  // path components
+	std::string_view prefix, inAfterColon;
+	PathComponents cmpnts;  // path components
+	cmpnts.reserve(16);
 	size_t outPathCapacityGuess = inPath.length();
 
 	if (relative)
@@ -99,23 +106,23 @@ static bool RealPath(const std::string &currentDirectory, const std::string &inP
 		size_t curDirLen = currentDirectory.length();
 		if (curDirLen == 0)
 		{
-			ERROR_LOG(Log::FileSystem, "RealPath: inPath \"%s\" is relative, but current directory is empty", inPath.c_str());
+			ERROR_LOG(Log::FileSystem, "RealPath: inPath \"%.*s\" is relative, but current directory is empty", (int)inPath.size(), inPath.data());
 			return false;
 		}
 		
 		size_t curDirColon = currentDirectory.find(':');
 		if (curDirColon == std::string::npos)
 		{
-			ERROR_LOG(Log::FileSystem, "RealPath: inPath \"%s\" is relative, but current directory \"%s\" has no prefix", inPath.c_str(), currentDirectory.c_str());
+			ERROR_LOG(Log::FileSystem, "RealPath: inPath \"%.*s\" is relative, but current directory \"%s\" has no prefix", (int)inPath.size(), inPath.data(), currentDirectory.c_str());
 			return false;
 		}
 		if (curDirColon + 1 == curDirLen)
 		{
-			WARN_LOG(Log::FileSystem, "RealPath: inPath \"%s\" is relative, but current directory \"%s\" is all prefix and no path. Using \"/\" as path for current directory.", inPath.c_str(), currentDirectory.c_str());
+			WARN_LOG(Log::FileSystem, "RealPath: inPath \"%.*s\" is relative, but current directory \"%s\" is all prefix and no path. Using \"/\" as path for current directory.", (int)inPath.size(), inPath.data(), currentDirectory.c_str());
 		}
 		else
 		{
-			const std::string curDirAfter = currentDirectory.substr(curDirColon + 1);
+			std::string_view curDirAfter = std::string_view(currentDirectory).substr(curDirColon + 1);
 			if (! ApplyPathStringToComponentsVector(cmpnts, curDirAfter) )
 			{
 				ERROR_LOG(Log::FileSystem,"RealPath: currentDirectory is not a valid path: \"%s\"", currentDirectory.c_str());
@@ -125,7 +132,7 @@ static bool RealPath(const std::string &currentDirectory, const std::string &inP
 			outPathCapacityGuess += curDirLen;
 		}
 
-		prefix = currentDirectory.substr(0, curDirColon + 1);
+		prefix = std::string_view(currentDirectory).substr(0, curDirColon + 1);
 		inAfterColon = inPath;
 	}
 	else
@@ -136,27 +143,27 @@ static bool RealPath(const std::string &currentDirectory, const std::string &inP
 		// Special case: "disc0:" is different from "disc0:/", so keep track of the single slash.
 		if (inAfterColon == "/")
 		{
-			outPath = prefix + inAfterColon;
+			outPath.assign(inPath.data(), inPath.size());
 			return true;
 		}
 	}
 
 	if (! ApplyPathStringToComponentsVector(cmpnts, inAfterColon) )
 	{
-		WARN_LOG(Log::FileSystem, "RealPath: inPath is not a valid path: \"%s\"", inPath.c_str());
+		WARN_LOG(Log::FileSystem, "RealPath: inPath is not a valid path: \"%.*s\"", (int)inPath.size(), inPath.data());
 		return false;
 	}
 
 	outPath.clear();
 	outPath.reserve(outPathCapacityGuess);
 
-	outPath.append(prefix);
+	outPath.append(prefix.data(), prefix.size());
 
 	size_t numCmpnts = cmpnts.size();
 	for (size_t i = 0; i < numCmpnts; i++)
 	{
 		outPath.append(1, '/');
-		outPath.append(cmpnts[i]);
+		outPath.append(cmpnts[i].data(), cmpnts[i].size());
 	}
 
 	return true;
@@ -179,9 +186,43 @@ int MetaFileSystem::MapFilePath(const std::string &_inpath, std::string &outpath
 {
 	int error = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
 	std::lock_guard<std::recursive_mutex> guard(lock);
-	std::string realpath;
 
-	std::string inpath = _inpath;
+	const std::string *currentDirectory = &startingDirectory;
+
+	int currentThread = __KernelGetCurThread();
+	currentDir_t::iterator it = currentDir.find(currentThread);
+	bool hasCurrentDir = it != currentDir.end();
+	if (hasCurrentDir)
+		currentDirectory = &(it->second);
+
+	// Relative paths depend on the directory, so it's part of the key.  Also whether it was set at all.
+	// The buffer is kept around, so looking up a path that's already mapped doesn't allocate.
+	std::string &cacheKey = mappedPathKey;
+	cacheKey.clear();
+	cacheKey.append(_inpath);
+	cacheKey.push_back('\0');
+	if (!hasCurrentDir)
+		cacheKey.push_back('\1');
+	cacheKey.append(*currentDirectory);
+
+	auto cached = mappedPaths.find(cacheKey);
+	if (cached != mappedPaths.end()) {
+		const MappedPath &mapped = cached->second;
+		if (mapped.mountIndex >= 0) {
+			outpath = mapped.outpath;
+			*system = &fileSystems[mapped.mountIndex];
+		}
+		return mapped.error;
+	}
+
+	// Plenty for any game, this just keeps it from growing forever.
+	if (mappedPaths.size() >= 1024)
+		mappedPaths.clear();
+
+	// Everything below works on views of _inpath or scratch strings, only the results are kept.
+	ScratchPath realpath;
+	ScratchPath hostPath;
+	std::string_view inpath = _inpath;
 
 	// "ms0:/file.txt" is equivalent to "   ms0:/file.txt".  Yes, really.
 	if (inpath.find(':') != inpath.npos) {
@@ -196,22 +237,20 @@ int MetaFileSystem::MapFilePath(const std::string &_inpath, std::string &outpath
 
 	// Special handling: host0:command.txt (as seen in Super Monkey Ball Adventures, for example)
 	// appears to mean the current directory on the UMD. Let's just assume the current directory.
-	if (strncasecmp(inpath.c_str(), "host0:", strlen("host0:")) == 0) {
-		INFO_LOG(Log::FileSystem, "Host0 path detected, stripping: %s", inpath.c_str());
+	if (inpath.size() >= strlen("host0:") && strncasecmp(inpath.data(), "host0:", strlen("host0:")) == 0) {
+		INFO_LOG(Log::FileSystem, "Host0 path detected, stripping: %.*s", (int)inpath.size(), inpath.data());
 		// However, this causes trouble when running tests, since our test framework uses host0:.
 		// Maybe it's really just supposed to map to umd0 or something?
 		if (PSP_CoreParameter().headLess) {
-			inpath = "umd0:" + inpath.substr(strlen("host0:"));
+			hostPath = "umd0:";
+			hostPath.append(inpath.data() + strlen("host0:"), inpath.size() - strlen("host0:"));
+			inpath = std::string_view(hostPath.data(), hostPath.size());
 		} else {
 			inpath = inpath.substr(strlen("host0:"));
 		}
 	}
 
-	const std::string *currentDirectory = &startingDirectory;
-
-	int currentThread = __KernelGetCurThread();
-	currentDir_t::iterator it = currentDir.find(currentThread);
-	if (it == currentDir.end()) 
+	if (!hasCurrentDir)
 	{
 		//Attempt to emulate SCE_KERNEL_ERROR_NOCWD / 8002032C: may break things requiring fixes elsewhere
 		if (inpath.find(':') == std::string::npos /* means path is relative */) 
@@ -220,36 +259,40 @@ int MetaFileSystem::MapFilePath(const std::string &_inpath, std::string &outpath
 			WARN_LOG(Log::FileSystem, "Path is relative, but current directory not set for thread %i. returning 8002032C(SCE_KERNEL_ERROR_NOCWD) instead.", currentThread);
 		}
 	}
-	else
-	{
-		currentDirectory = &(it->second);
-	}
 
 	if (RealPath(*currentDirectory, inpath, realpath))
 	{
-		std::string prefix = realpath;
+		// Prefixes are short enough not to need the heap.
+		std::string normalizedPrefix;
+		const char *prefix = realpath.c_str();
 		size_t prefixPos = realpath.find(':');
-		if (prefixPos != realpath.npos)
-			prefix = NormalizePrefix(realpath.substr(0, prefixPos + 1));
+		if (prefixPos != realpath.npos) {
+			normalizedPrefix = NormalizePrefix(std::string(realpath.data(), prefixPos + 1));
+			prefix = normalizedPrefix.c_str();
+		}
 
 		for (size_t i = 0; i < fileSystems.size(); i++)
 		{
 			size_t prefLen = fileSystems[i].prefix.size();
-			if (strncasecmp(fileSystems[i].prefix.c_str(), prefix.c_str(), prefLen) == 0)
+			if (strncasecmp(fileSystems[i].prefix.c_str(), prefix, prefLen) == 0)
 			{
-				outpath = realpath.substr(prefixPos + 1);
+				// Without a prefix, that's all of it.
+				outpath.assign(realpath.begin() + (prefixPos + 1), realpath.end());
 				*system = &(fileSystems[i]);
 
-				VERBOSE_LOG(Log::FileSystem, "MapFilePath: mapped \"%s\" to prefix: \"%s\", path: \"%s\"", inpath.c_str(), fileSystems[i].prefix.c_str(), outpath.c_str());
+				VERBOSE_LOG(Log::FileSystem, "MapFilePath: mapped \"%.*s\" to prefix: \"%s\", path: \"%s\"", (int)inpath.size(), inpath.data(), fileSystems[i].prefix.c_str(), outpath.c_str());
 
-				return error == SCE_KERNEL_ERROR_NOCWD ? error : 0;
+				error = error == SCE_KERNEL_ERROR_NOCWD ? error : 0;
+				mappedPaths[cacheKey] = MappedPath{ error, (int)i, outpath };
+				return error;
 			}
 		}
 
 		error = SCE_KERNEL_ERROR_NODEV;
 	}
 
-	DEBUG_LOG(Log::FileSystem, "MapFilePath: failed mapping \"%s\", returning false", inpath.c_str());
+	DEBUG_LOG(Log::FileSystem, "MapFilePath: failed mapping \"%.*s\", returning false", (int)inpath.size(), inpath.data());
+	mappedPaths[cacheKey] = MappedPath{ error, -1 };
 	return error;
 }
 
@@ -273,6 +316,7 @@ std::string MetaFileSystem::NormalizePrefix(std::string prefix) const {
 
 void MetaFileSystem::Mount(const std::string &prefix, std::shared_ptr<IFileSystem> system) {
 	std::lock_guard<std::recursive_mutex> guard(lock);
+	mappedPaths.clear();
 	for (auto &it : fileSystems) {
 		if (it.prefix == prefix) {
 			// Overwrite the old mount.
@@ -293,10 +337,12 @@ void MetaFileSystem::Mount(const std::string &prefix, std::shared_ptr<IFileSyste
 void MetaFileSystem::UnmountAll() {
 	fileSystems.clear();
 	currentDir.clear();
+	mappedPaths.clear();
 }
 
 void MetaFileSystem::Unmount(const std::string &prefix) {
 	std::lock_guard<std::recursive_mutex> guard(lock);
+	mappedPaths.clear();
 	for (auto iter = fileSystems.begin(); iter != fileSystems.end(); iter++) {
 		if (iter->prefix == prefix) {
 			fileSystems.erase(iter);
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
 #include <memory>
@@ -45,6 +46,16 @@ class MetaFileSystem : public IHandleAllocator, public IFileSystem {
 	std::string startingDirectory;
 	mutable std::recursive_mutex lock;  // must be recursive. TODO: fix that
 
+	// Games tend to map the same few paths over and over.  Indexes into fileSystems, so cleared on any mount change.
+	struct MappedPath {
+		int error;
+		int mountIndex;
+		std::string outpath;
+	};
+	std::unordered_map<std::string, MappedPath> mappedPaths;
+	// Reused for building the keys, under the lock.
+	std::string mappedPathKey;
+
 	// Assumes the lock is held
 	void Reset() {
 		// This used to be 6, probably an attempt to replicate PSP handles.
@@ -86,6 +86,12 @@ static int splitSyscallEatCycles = 0;
 static double hleSteppingTime = 0.0;
 static double hleFlipTime = 0.0;
 
+// Syscall scratch memory.  Only the emu thread makes syscalls, so it's the only one using the arena.
+static const size_t HLE_SCRATCH_SIZE = 64 * 1024;
+alignas(16) static u8 hleScratch[HLE_SCRATCH_SIZE];
+static size_t hleScratchUsed = 0;
+static thread_local int hleScratchDepth = 0;
+
 struct HLEMipsCallInfo {
 	u32 func;
 	PSPAction *action;
@@ -796,7 +802,39 @@ void hleFinishSyscallAfterGe() {
 	hleFinishSyscall(nullptr);
 }
 
-static void updateSyscallStats(int modulenum, int funcnum, double total)
+HLEScratchScope::HLEScratchScope() {
+	hleScratchDepth++;
+}
+
+HLEScratchScope::~HLEScratchScope() {
+	if (--hleScratchDepth == 0)
+		hleScratchUsed = 0;
+}
+
+void *hleScratchAlloc(size_t size) {
+	// Keep everything aligned like the heap would.
+	size_t alignedSize = (size + 15) & ~(size_t)15;
+	if (hleScratchDepth > 0 && alignedSize <= HLE_SCRATCH_SIZE - hleScratchUsed) {
+		void *ptr = hleScratch + hleScratchUsed;
+		hleScratchUsed += alignedSize;
+		kernelStats.scratchAllocs++;
+		return ptr;
+	}
+
+	// Only count it against the syscall if we're in one.
+	if (hleScratchDepth > 0)
+		kernelStats.scratchHeapAllocs++;
+	return ::operator new(size);
+}
+
+void hleScratchFree(void *ptr) {
+	// Arena memory is all released together when the syscall finishes.
+	if ((u8 *)ptr >= hleScratch && (u8 *)ptr < hleScratch + HLE_SCRATCH_SIZE)
+		return;
+	::operator delete(ptr);
+}
+
+static void updateSyscallStats(int modulenum, int funcnum, double total, int heapAllocs)
 {
 	const char *name = moduleDB[modulenum].funcTable[funcnum].name;
 	// Ignore this one, especially for msInSyscalls (although that ignores CoreTiming events.)
@@ -810,6 +848,11 @@ static void updateSyscallStats(int modulenum, int funcnum, double total)
 	}
 	kernelStats.msInSyscalls += total;
 
+	if (heapAllocs > kernelStats.mostHeapAllocsSyscall) {
+		kernelStats.mostHeapAllocsSyscall = heapAllocs;
+		kernelStats.mostHeapAllocsSyscallName = name;
+	}
+
 	KernelStatsSyscall statCall(modulenum, funcnum);
 	auto summedStat = kernelStats.summedMsInSyscalls.find(statCall);
 	if (summedStat == kernelStats.summedMsInSyscalls.end())
@@ -833,6 +876,7 @@ static void updateSyscallStats(int modulenum, int funcnum, double total)
 }
 
 static void CallSyscallWithFlags(const HLEFunction *info) {
+	HLEScratchScope scratch;
 	// _dbg_assert_(g_stackSize == 0);
 	g_stackSize = 0;
 
@@ -873,6 +917,7 @@ static void CallSyscallWithFlags(const HLEFunction *info) {
 }
 
 static void CallSyscallWithoutFlags(const HLEFunction *info) {
+	HLEScratchScope scratch;
 	// _dbg_assert_(g_stackSize == 0);
 	g_stackSize = 0;
 
@@ -942,8 +987,10 @@ void hleSetFlipTime(double t) {
 void CallSyscall(MIPSOpcode op) {
 	PROFILE_THIS_SCOPE("syscall");
 	double start = 0.0;  // need to initialize to fix the race condition where coreCollectDebugStats is enabled in the middle of this func.
+	int heapAllocsStart = 0;
 	if (coreCollectDebugStats) {
 		start = time_now_d();
+		heapAllocsStart = kernelStats.kernelObjectAllocs + kernelStats.scratchHeapAllocs;
 	}
 
 	const HLEFunction *info = GetSyscallFuncPointer(op);
@@ -975,7 +1022,8 @@ void CallSyscall(MIPSOpcode op) {
 			total -= hleFlipTime;
 		_dbg_assert_msg_(total >= 0.0, "Time spent in syscall became negative");
 		hleFlipTime = 0.0;
-		updateSyscallStats(modulenum, funcnum, total);
+		int heapAllocs = kernelStats.kernelObjectAllocs + kernelStats.scratchHeapAllocs - heapAllocsStart;
+		updateSyscallStats(modulenum, funcnum, total, heapAllocs);
 	}
 }
 
@@ -161,6 +161,40 @@ void hleSplitSyscallOverGe();
 // Called after a split syscall from System.cpp
 void hleFinishSyscallAfterGe();
 
+// Scratch memory for temporaries within a syscall, all released at once when the syscall finishes.
+// Outside of a syscall (or on other threads), this just falls back to the heap.
+void *hleScratchAlloc(size_t size);
+void hleScratchFree(void *ptr);
+
+// Syscalls are run inside one of these, scratch allocations are released when the outermost one ends.
+class HLEScratchScope {
+public:
+	HLEScratchScope();
+	~HLEScratchScope();
+};
+
+// For std containers holding syscall temporaries.
+template <typename T>
+struct HLEScratchAllocator {
+	typedef T value_type;
+
+	HLEScratchAllocator() = default;
+	template <typename U>
+	HLEScratchAllocator(const HLEScratchAllocator<U> &) {}
+
+	T *allocate(size_t n) {
+		return (T *)hleScratchAlloc(n * sizeof(T));
+	}
+	void deallocate(T *ptr, size_t n) {
+		hleScratchFree(ptr);
+	}
+
+	template <typename U>
+	bool operator==(const HLEScratchAllocator<U> &) const { return true; }
+	template <typename U>
+	bool operator!=(const HLEScratchAllocator<U> &) const { return false; }
+};
+
 [[nodiscard]]
 inline int hleDelayResult(int result, const char *reason, int usec) {
 	return hleDelayResult((u32) result, reason, usec);
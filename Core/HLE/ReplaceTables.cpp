@@ -29,6 +29,7 @@
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/MemMap.h"
+#include "Core/MemMapHelpers.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSAnalyst.h"
@@ -113,6 +114,24 @@ static int Replace_ceilf() {
 	return 30;  // guess number of cycles
 }
 
+// Shared by the memcpy replacements, with a special case for video frames.
+static void NotifyReplaceMemcpy(u32 destPtr, u32 srcPtr, u32 bytes) {
+	// It's pretty common that games will copy video data.
+	// Detect that by manually reading the tag when the size looks right.
+	if (bytes == 512 * 272 * 4 && MemBlockInfoDetailed(bytes)) {
+		char tagData[128];
+		size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), "ReplaceMemcpy/", srcPtr, bytes);
+		NotifyMemInfo(MemBlockFlags::READ, srcPtr, bytes, tagData, tagSize);
+		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, tagData, tagSize);
+
+		if (!strcmp(tagData, "ReplaceMemcpy/VideoDecode") || !strcmp(tagData, "ReplaceMemcpy/VideoDecodeRange")) {
+			gpu->PerformWriteFormattedFromMemory(destPtr, bytes, 512, GE_FORMAT_8888);
+		}
+	} else {
+		Memory::NotifyCopyRange(destPtr, srcPtr, bytes, "ReplaceMemcpy/");
+	}
+}
+
 // Should probably do JIT versions of this, possibly ones that only delegate
 // large copies to a C function.
 static int Replace_memcpy() {
@@ -153,22 +172,7 @@ static int Replace_memcpy() {
 	}
 	RETURN(destPtr);
 
-	if (MemBlockInfoDetailed(bytes)) {
-		// It's pretty common that games will copy video data.
-		// Detect that by manually reading the tag when the size looks right.
-		if (bytes == 512 * 272 * 4) {
-			char tagData[128];
-			size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), "ReplaceMemcpy/", srcPtr, bytes);
-			NotifyMemInfo(MemBlockFlags::READ, srcPtr, bytes, tagData, tagSize);
-			NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, tagData, tagSize);
-
-			if (!strcmp(tagData, "ReplaceMemcpy/VideoDecode") || !strcmp(tagData, "ReplaceMemcpy/VideoDecodeRange")) {
-				gpu->PerformWriteFormattedFromMemory(destPtr, bytes, 512, GE_FORMAT_8888);
-			}
-		} else {
-			NotifyMemInfoCopy(destPtr, srcPtr, bytes, "ReplaceMemcpy/");
-		}
-	}
+	NotifyReplaceMemcpy(destPtr, srcPtr, bytes);
 
 	return 10 + bytes / 4;  // approximation
 }
@@ -200,13 +204,20 @@ static int Replace_memcpy_jak() {
 		sliced = true;
 	}
 	if (!skip && bytes != 0) {
-		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
-		const u8 *src = Memory::GetPointerRange(srcPtr, bytes);
-
-		if (dst && src) {
-			// Jak style overlap.
-			for (u32 i = 0; i < bytes; i++) {
-				dst[i] = src[i];
+		if (!Memory::GetPointerWriteRange(destPtr, bytes) || !Memory::GetPointerRange(srcPtr, bytes)) {
+			// Already logged.
+		} else {
+			// Through the same mirror for both, like in Memory::CopyRange().
+			u8 *dst = Memory::GetPointerWriteUnchecked(Memory::CanonicalAddress(destPtr));
+			const u8 *src = Memory::GetPointerUnchecked(Memory::CanonicalAddress(srcPtr));
+			if (dst != src && Memory::IsAddressInRange(destPtr, srcPtr, bytes)) {
+				// Jak style overlap, repeating the start of the source forward.
+				for (u32 i = 0; i < bytes; i++) {
+					dst[i] = src[i];
+				}
+			} else {
+				// Otherwise, copying forward byte by byte is the same as a memmove.
+				memmove(dst, src, bytes);
 			}
 		}
 	}
@@ -226,22 +237,7 @@ static int Replace_memcpy_jak() {
 		RETURN(destPtr);
 	}
 
-	if (MemBlockInfoDetailed(bytes)) {
-		// It's pretty common that games will copy video data.
-		// Detect that by manually reading the tag when the size looks right.
-		if (bytes == 512 * 272 * 4) {
-			char tagData[128];
-			size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), "ReplaceMemcpy/", srcPtr, bytes);
-			NotifyMemInfo(MemBlockFlags::READ, srcPtr, bytes, tagData, tagSize);
-			NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, tagData, tagSize);
-
-			if (!strcmp(tagData, "ReplaceMemcpy/VideoDecode") || !strcmp(tagData, "ReplaceMemcpy/VideoDecodeRange")) {
-				gpu->PerformWriteFormattedFromMemory(destPtr, bytes, 512, GE_FORMAT_8888);
-			}
-		} else {
-			NotifyMemInfoCopy(destPtr, srcPtr, bytes, "ReplaceMemcpy/");
-		}
-	}
+	NotifyReplaceMemcpy(destPtr, srcPtr, bytes);
 
 	if (sliced) {
 		// Negative causes the function to be run again for the next slice.
@@ -264,19 +260,12 @@ static int Replace_memcpy16() {
 			skip = gpu->PerformMemoryCopy(destPtr, srcPtr, bytes);
 		}
 	}
-	if (!skip && bytes != 0) {
-		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
-		const u8 *src = Memory::GetPointerRange(srcPtr, bytes);
-		if (dst && src) {
-			memmove(dst, src, bytes);
-		}
-	}
+	if (!skip)
+		Memory::CopyRange(destPtr, srcPtr, bytes, "ReplaceMemcpy16/");
+	else
+		Memory::NotifyCopyRange(destPtr, srcPtr, bytes, "ReplaceMemcpy16/");
 	RETURN(destPtr);
 
-	if (MemBlockInfoDetailed(bytes)) {
-		NotifyMemInfoCopy(destPtr, srcPtr, bytes, "ReplaceMemcpy16/");
-	}
-
 	return 10 + bytes / 4;  // approximation
 }
 
@@ -312,9 +301,7 @@ static int Replace_memcpy_swizzled() {
 
 	RETURN(0);
 
-	if (MemBlockInfoDetailed(pitch * h)) {
-		NotifyMemInfoCopy(destPtr, srcPtr, pitch * h, "ReplaceMemcpySwizzle/");
-	}
+	Memory::NotifyCopyRange(destPtr, srcPtr, pitch * h, "ReplaceMemcpySwizzle/");
 
 	return 10 + (pitch * h) / 4;  // approximation
 }
@@ -332,19 +319,12 @@ static int Replace_memmove() {
 			skip = gpu->PerformMemoryCopy(destPtr, srcPtr, bytes);
 		}
 	}
-	if (!skip && bytes != 0) {
-		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
-		const u8 *src = Memory::GetPointerRange(srcPtr, bytes);
-		if (dst && src) {
-			memmove(dst, src, bytes);
-		}
-	}
+	if (!skip)
+		Memory::CopyRange(destPtr, srcPtr, bytes, "ReplaceMemmove/");
+	else
+		Memory::NotifyCopyRange(destPtr, srcPtr, bytes, "ReplaceMemmove/");
 	RETURN(destPtr);
 
-	if (MemBlockInfoDetailed(bytes)) {
-		NotifyMemInfoCopy(destPtr, srcPtr, bytes, "ReplaceMemmove/");
-	}
-
 	return 10 + bytes / 4;  // approximation
 }
 
@@ -356,16 +336,12 @@ static int Replace_memset() {
 	if (Memory::IsVRAMAddress(destPtr) && (skipGPUReplacements & (int)GPUReplacementSkip::MEMSET) == 0) {
 		skip = gpu->PerformMemorySet(destPtr, value, bytes);
 	}
-	if (!skip && bytes != 0) {
-		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
-		if (dst) {
-			memset(dst, value, bytes);
-		}
-	}
+	if (!skip)
+		Memory::FillRange(destPtr, value, bytes, "ReplaceMemset");
+	else
+		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, "ReplaceMemset");
 	RETURN(destPtr);
 
-	NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, "ReplaceMemset");
-
 	return 10 + bytes / 4;  // approximation
 }
 
@@ -390,14 +366,10 @@ static int Replace_memset_jak() {
 		bytes = SLICE_SIZE;
 		sliced = true;
 	}
-	if (!skip && bytes != 0) {
-		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
-		if (dst) {
-			memset(dst, value, bytes);
-		}
-	}
-
-	NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, "ReplaceMemset");
+	if (!skip)
+		Memory::FillRange(destPtr, value, bytes, "ReplaceMemset");
+	else
+		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, "ReplaceMemset");
 
 	if (sliced) {
 		currentMIPS->r[MIPS_REG_A0] += SLICE_SIZE;
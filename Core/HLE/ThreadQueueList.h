@@ -18,6 +18,7 @@
 #pragma once
 
 #include "Core/HLE/sceKernel.h"
+#include "Common/BitSet.h"
 #include "Common/Serialize/Serializer.h"
 
 struct ThreadQueueList {
@@ -25,6 +26,8 @@ struct ThreadQueueList {
 	static const int NUM_QUEUES = 128;
 	// Initial number of threads a single queue can handle.
 	static const int INITIAL_CAPACITY = 32;
+	// Words in the bitmap of non-empty queues.
+	static const int NUM_MASK_WORDS = NUM_QUEUES / 32;
 
 	struct Queue {
 		// Next ever-been-used queue (worse priority.)
@@ -51,6 +54,7 @@ struct ThreadQueueList {
 
 	ThreadQueueList() {
 		memset(queues, 0, sizeof(queues));
+		memset(readyMask, 0, sizeof(readyMask));
 		first = invalid();
 	}
 
@@ -75,37 +79,27 @@ struct ThreadQueueList {
 	}
 
 	inline SceUID pop_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
+		int priority = first_ready();
+		if (priority >= 0)
+			return pop(priority);
 
 		_dbg_assert_msg_(false, "ThreadQueueList should not be empty.");
 		return 0;
 	}
 
 	inline SceUID pop_first_better(u32 priority) {
-		Queue *cur = first;
 		// Don't bother looking past (worse than) this priority.
-		Queue *stop = &queues[priority];
-		while (cur < stop) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
+		int best = first_ready();
+		if (best >= 0 && best < (int)priority)
+			return pop(best);
 
 		return 0;
 	}
 
 	inline SceUID peek_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first];
-			cur = cur->next;
-		}
+		int priority = first_ready();
+		if (priority >= 0)
+			return queues[priority].data[queues[priority].first];
 
 		return 0;
 	}
@@ -113,6 +107,7 @@ struct ThreadQueueList {
 	inline void push_front(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
 		cur->data[--cur->first] = threadID;
+		mark_ready(priority);
 		// If we ran out of room toward the front, add more room for next time.
 		if (cur->first == 0)
 			rebalance(priority);
@@ -121,6 +116,7 @@ struct ThreadQueueList {
 	inline void push_back(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
 		cur->data[cur->end++] = threadID;
+		mark_ready(priority);
 		if (cur->full())
 			rebalance(priority);
 	}
@@ -139,6 +135,8 @@ struct ThreadQueueList {
 
 				// Now we're one shorter.
 				--cur->end;
+				if (cur->empty())
+					mark_empty(priority);
 				return;
 			}
 		}
@@ -163,6 +161,7 @@ struct ThreadQueueList {
 			free(queues[i].data);
 		}
 		memset(queues, 0, sizeof(queues));
+		memset(readyMask, 0, sizeof(readyMask));
 		first = invalid();
 	}
 
@@ -209,8 +208,11 @@ struct ThreadQueueList {
 				cur->end = cur->first + size;
 			}
 
-			if (size != 0)
+			if (size != 0) {
 				DoArray(p, &cur->data[cur->first], size);
+				if (p.mode == p.MODE_READ)
+					mark_ready(i);
+			}
 		}
 	}
 
@@ -219,6 +221,31 @@ struct ThreadQueueList {
 		return (Queue *)-1;
 	}
 
+	// Lowest (best) priority level with any threads in it, or -1 if all are empty.
+	inline int first_ready() const {
+		for (int i = 0; i < NUM_MASK_WORDS; ++i) {
+			if (readyMask[i] != 0)
+				return i * 32 + LeastSignificantSetBit(readyMask[i]);
+		}
+		return -1;
+	}
+
+	inline void mark_ready(u32 priority) {
+		readyMask[priority >> 5] |= 1U << (priority & 31);
+	}
+
+	inline void mark_empty(u32 priority) {
+		readyMask[priority >> 5] &= ~(1U << (priority & 31));
+	}
+
+	inline SceUID pop(u32 priority) {
+		Queue *cur = &queues[priority];
+		SceUID threadID = cur->data[cur->first++];
+		if (cur->empty())
+			mark_empty(priority);
+		return threadID;
+	}
+
 	// Initialize a priority level and link to other queues.
 	void link(u32 priority, int size) {
 		_dbg_assert_msg_(queues[priority].data == nullptr, "ThreadQueueList::Queue should only be initialized once.");
@@ -283,6 +310,8 @@ struct ThreadQueueList {
 
 	// The first queue that's ever been used.
 	Queue *first;
+	// One bit per priority level, set when that queue is non-empty.  Makes picking the next thread O(1).
+	u32 readyMask[NUM_MASK_WORDS];
 	// The priority level queues of thread ids.
 	Queue queues[NUM_QUEUES];
 };
@@ -1373,6 +1373,9 @@ int friendFinder() {
 	// Finder Loop
 	friendFinderRunning = true;
 	while (friendFinderRunning) {
+		// Server closed the connection, so the socket would always look readable
+		bool serverClosed = false;
+
 		// Acquire Network Lock
 		//_acquireNetworkLock();
 
@@ -1450,6 +1453,8 @@ int friendFinder() {
 					// Log Incoming Traffic
 					//printf("Received %d Bytes of Data from Server\n", received);
 					INFO_LOG(Log::sceNet, "Received %d Bytes of Data from Adhoc Server", received);
+				} else if (received == 0) {
+					serverClosed = true;
 				}
 			}
 
@@ -1459,8 +1464,10 @@ int friendFinder() {
 				notifyAdhocctlHandlers(ADHOCCTL_EVENT_ERROR, ERROR_NET_ADHOC_TIMEOUT);
 			}
 
-			// Handle Packets
-			if (rxpos > 0) {
+			// Handle Packets, all the complete ones at once since a scan result or a big group sends many
+			while (rxpos > 0) {
+				const int prevrxpos = rxpos;
+
 				// BSSID Packet
 				if (rx[0] == OPCODE_CONNECT_BSSID) {
 					// Enough Data available
@@ -1734,10 +1741,17 @@ int friendFinder() {
 					// Fix RX Buffer Length
 					rxpos -= 1;
 				}
+
+				// Wait for the rest of the Packet
+				if (rxpos == prevrxpos)
+					break;
 			}
 		}
-		// This delay time should be 100ms when there is an event otherwise 500ms ?
-		sleep_ms(10, "pro-adhoc-poll-2"); // Using 1ms for faster response just like AdhocServer?
+		// Wake up as soon as the server sends something, but still run the pings and timeouts above every 10ms
+		if (g_adhocServerConnected && metasocket != (int)INVALID_SOCKET && !serverClosed)
+			IsSocketReady((int)metasocket, true, false, nullptr, 10000);
+		else
+			sleep_ms(10, "pro-adhoc-poll-2");
 
 		// Don't do anything if it's paused, otherwise the log will be flooded
 		while (Core_IsStepping() && coreState != CORE_POWERDOWN && friendFinderRunning)
@@ -2224,7 +2238,9 @@ int initNetwork(SceNetAdhocctlAdhocId *adhoc_id){
 			if (coreState == CORE_POWERDOWN) 
 				return iResult;
 
-			done = (IsSocketReady((int)metasocket, false, true) > 0);
+			// Wait until it's writable rather than sleeping a fixed time, so we're done as soon as it connects.
+			int ready = IsSocketReady((int)metasocket, false, true, nullptr, 10000);
+			done = (ready > 0);
 			struct sockaddr_in sin;
 			socklen_t sinlen = sizeof(sin);
 			memset(&sin, 0, sinlen);
@@ -2236,7 +2252,9 @@ int initNetwork(SceNetAdhocctlAdhocId *adhoc_id){
 					errorcode = ETIMEDOUT;
 				break;
 			}
-			sleep_ms(10, "pro-adhoc-socket-poll");
+			// Writable without being connected (ie. refused), don't spin on it.
+			if (!done && ready != 0)
+				sleep_ms(10, "pro-adhoc-socket-poll");
 		}
 		if (!done) {
 			ERROR_LOG(Log::sceNet, "Socket error (%i) when connecting to AdhocServer [%s/%s:%u]", errorcode, g_Config.proAdhocServer.c_str(), ip2str(g_adhocServerIP.in.sin_addr).c_str(), ntohs(g_adhocServerIP.in.sin_port));
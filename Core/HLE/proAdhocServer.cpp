@@ -27,9 +27,15 @@
 #include <cstdio>
 #include <cstring>
 #include <signal.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <sys/types.h>
 #include "Common/Net/SocketCompat.h"
+#if !PPSSPP_PLATFORM(WINDOWS)
+#include <poll.h>
+#endif
 #include "Common/Data/Text/I18n.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/System/OSD.h"
@@ -55,6 +61,20 @@ SceNetAdhocctlUserNode * _db_user = NULL;
 // Game Database
 SceNetAdhocctlGameNode * _db_game = NULL;
 
+// Hashed lookups into the lists above, so logins and group changes don't have to walk every user.
+static std::unordered_map<uint32_t, SceNetAdhocctlUserNode *> userByIP;
+static std::unordered_map<int, SceNetAdhocctlUserNode *> userByStream;
+static std::unordered_multimap<uint64_t, SceNetAdhocctlUserNode *> userByMAC;
+static std::unordered_map<std::string, SceNetAdhocctlGameNode *> gameByProduct;
+// Keyed by product code followed by group name.
+static std::unordered_map<std::string, SceNetAdhocctlGroupNode *> groupByName;
+
+// Outgoing data per user, sent in one go at the end of each server loop pass.
+static std::unordered_map<SceNetAdhocctlUserNode *, std::vector<uint8_t>> pendingSends;
+
+// Status logfile needs rewriting (done at most once a second by the server loop.)
+static bool statusDirty = false;
+
 // Server Status
 std::atomic<bool> adhocServerRunning(false);
 std::thread adhocServerThread;
@@ -296,6 +316,10 @@ static const db_crosslink default_crosslinks[] = {
 	{ "ULES01474", "ULJM05734" },
 };
 
+// Index of crosslinks and productids by product code.
+static std::unordered_map<std::string, size_t> crosslinkIndex;
+static std::unordered_map<std::string, size_t> productidIndex;
+
 std::vector<db_productid> productids;
 static const db_productid default_productids[] = {
 	{ "ULUS10511", "Ace Combat X2 - Joint Assault" },
@@ -476,10 +500,104 @@ void change_blocking_mode(int fd, int nonblocking);
 int create_listen_socket(uint16_t port);
 int server_loop(int server);
 
+static uint64_t mac_key(const SceNetEtherAddr &mac) {
+	uint64_t key = 0;
+	memcpy(&key, mac.data, ETHER_ADDR_LEN);
+	return key;
+}
+
+static std::string product_key(const SceNetAdhocctlProductCode &product) {
+	return std::string(product.data, PRODUCT_CODE_LENGTH);
+}
+
+static std::string group_key(const SceNetAdhocctlGameNode *game, const SceNetAdhocctlGroupName *group) {
+	// Like the strncmp this replaces, anything after the terminator doesn't count.
+	size_t len = 0;
+	while (len < ADHOCCTL_GROUPNAME_LEN && group->data[len] != 0) len++;
+	return product_key(game->game) + std::string((const char *)group->data, len);
+}
+
+static void erase_user_mac(SceNetAdhocctlUserNode *user) {
+	auto range = userByMAC.equal_range(mac_key(user->resolver.mac));
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == user) {
+			userByMAC.erase(it);
+			return;
+		}
+	}
+}
+
+// The handlers may log out the user they're given, this tells if that happened.
+static bool user_still_connected(SceNetAdhocctlUserNode *user, int stream) {
+	auto it = userByStream.find(stream);
+	return it != userByStream.end() && it->second == user;
+}
+
+static void schedule_status_update() {
+	statusDirty = true;
+}
+
+/**
+ * Queue Data for a User, sent with everything else queued at the end of the Server Loop pass
+ * @param user User Node
+ * @param data Packet Data
+ * @param size Packet Size
+ */
+static void queue_user_send(SceNetAdhocctlUserNode *user, const void *data, size_t size) {
+	std::vector<uint8_t> &buf = pendingSends[user];
+	// A client that stopped reading shouldn't be able to eat all our memory.
+	if (buf.size() + size > SERVER_USER_SEND_BUFFER) {
+		ERROR_LOG(Log::sceNet, "AdhocServer: Send buffer full for %s, dropping %d bytes", ip2str(*(in_addr*)&user->resolver.ip).c_str(), (int)size);
+		return;
+	}
+	const uint8_t *p = (const uint8_t *)data;
+	buf.insert(buf.end(), p, p + size);
+}
+
+/**
+ * Send queued Data for a User
+ * @param user User Node
+ * @param buf Queued Data (sent data is removed)
+ */
+static void flush_user_sends(SceNetAdhocctlUserNode *user, std::vector<uint8_t> &buf) {
+	size_t sent = 0;
+	while (sent < buf.size()) {
+		int iResult = (int)send(user->stream, (const char *)buf.data() + sent, (int)(buf.size() - sent), MSG_NOSIGNAL);
+		if (iResult <= 0) {
+			if (iResult < 0 && socket_errno != EAGAIN && socket_errno != EWOULDBLOCK) {
+				ERROR_LOG(Log::sceNet, "AdhocServer: flush_user_sends[send user] (Socket error %d)", socket_errno);
+				// Nothing more will get through, the next recv will notice the connection is gone.
+				sent = buf.size();
+			}
+			break;
+		}
+		sent += iResult;
+	}
+	buf.erase(buf.begin(), buf.begin() + sent);
+}
+
+static void flush_pending_sends() {
+	for (auto it = pendingSends.begin(); it != pendingSends.end(); ) {
+		flush_user_sends(it->first, it->second);
+		if (it->second.empty())
+			it = pendingSends.erase(it);
+		else
+			++it;
+	}
+}
+
 void __AdhocServerInit() {
 	// Database Product name will update if new game region played on my server to list possible crosslinks
 	productids = std::vector<db_productid>(default_productids, default_productids + ARRAY_SIZE(default_productids));
 	crosslinks = std::vector<db_crosslink>(default_crosslinks, default_crosslinks + ARRAY_SIZE(default_crosslinks));
+
+	// Keep the first entry for duplicates, like the linear search did.
+	productidIndex.clear();
+	for (size_t i = 0; i < productids.size(); i++)
+		productidIndex.emplace(productids[i].id, i);
+	crosslinkIndex.clear();
+	for (size_t i = 0; i < crosslinks.size(); i++)
+		crosslinkIndex.emplace(crosslinks[i].id_from, i);
 }
 
 /**
@@ -493,8 +611,8 @@ void login_user_stream(int fd, uint32_t ip)
 	if(_db_user_count < SERVER_USER_MAXIMUM)
 	{
 		// Check IP Duplication
-		SceNetAdhocctlUserNode * u = _db_user;
-		while(u != NULL && u->resolver.ip != ip) u = u->next;
+		auto existing = userByIP.find(ip);
+		SceNetAdhocctlUserNode * u = existing != userByIP.end() ? existing->second : NULL;
 
 		if (u != NULL) { // IP Already existed
 			WARN_LOG(Log::sceNet, "AdhocServer: Already Existing IP: %s\n", ip2str(*(in_addr*)&u->resolver.ip).c_str());
@@ -523,6 +641,10 @@ void login_user_stream(int fd, uint32_t ip)
 				if(_db_user != NULL) _db_user->prev = user;
 				_db_user = user;
 
+				// Hash Socket and IP
+				userByStream[fd] = user;
+				userByIP[ip] = user;
+
 				// Initialize Death Clock
 				user->last_recv = time(NULL);
 
@@ -533,7 +655,7 @@ void login_user_stream(int fd, uint32_t ip)
 				_db_user_count++;
 
 				// Update Status Log
-				update_status();
+				schedule_status_update();
 
 				// Exit Function
 				return;
@@ -566,8 +688,8 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 	if(valid_product_code == 1 && memcmp(&data->mac, "\xFF\xFF\xFF\xFF\xFF\xFF", sizeof(data->mac)) != 0 && memcmp(&data->mac, "\x00\x00\x00\x00\x00\x00", sizeof(data->mac)) != 0 && data->name.data[0] != 0)
 	{
 		// Check for duplicated MAC as most games identify Players by MAC
-		SceNetAdhocctlUserNode* u = _db_user;
-		while (u != NULL && !IsMatch(u->resolver.mac, data->mac)) u = u->next;
+		auto existing = userByMAC.find(mac_key(data->mac));
+		SceNetAdhocctlUserNode* u = existing != userByMAC.end() ? existing->second : NULL;
 
 		if (u != NULL) { // MAC Already existed
 			WARN_LOG(Log::sceNet, "AdhocServer: Already Existing MAC: %s [%s]\n", mac2str(&data->mac).c_str(), ip2str(*(in_addr*)&u->resolver.ip).c_str());
@@ -577,8 +699,8 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 		game_product_override(&data->game);
 
 		// Find existing Game
-		SceNetAdhocctlGameNode * game = _db_game;
-		while(game != NULL && strncmp(game->game.data, data->game.data, PRODUCT_CODE_LENGTH) != 0) game = game->next;
+		auto existingGame = gameByProduct.find(product_key(data->game));
+		SceNetAdhocctlGameNode * game = existingGame != gameByProduct.end() ? existingGame->second : NULL;
 
 		// Game not found
 		if(game == NULL)
@@ -599,6 +721,9 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 				game->next = _db_game;
 				if(_db_game != NULL) _db_game->prev = game;
 				_db_game = game;
+
+				// Hash Game Product ID
+				gameByProduct[product_key(game->game)] = game;
 			}
 		}
 
@@ -607,6 +732,7 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 		{
 			// Save MAC
 			user->resolver.mac = data->mac;
+			userByMAC.emplace(mac_key(user->resolver.mac), user);
 
 			// Save Nickname
 			user->resolver.name = data->name;
@@ -624,7 +750,7 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 			INFO_LOG(Log::sceNet, "AdhocServer: %s (MAC: %s - IP: %s) started playing %s", (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str(), safegamestr);
 
 			// Update Status Log
-			update_status();
+			schedule_status_update();
 
 			// Leave Function
 			return;
@@ -660,6 +786,19 @@ void logout_user(SceNetAdhocctlUserNode * user)
 	// Unlink Rightside
 	if(user->next != NULL) user->next->prev = user->prev;
 
+	// Unhash Socket and IP
+	userByStream.erase(user->stream);
+	auto byIP = userByIP.find(user->resolver.ip);
+	if(byIP != userByIP.end() && byIP->second == user) userByIP.erase(byIP);
+
+	// Send whatever is still queued (ie. the shutdown notice), then forget about it
+	auto pending = pendingSends.find(user);
+	if(pending != pendingSends.end())
+	{
+		flush_user_sends(user, pending->second);
+		pendingSends.erase(pending);
+	}
+
 	// Close Stream
 	closesocket(user->stream);
 
@@ -672,6 +811,9 @@ void logout_user(SceNetAdhocctlUserNode * user)
 		strncpy(safegamestr, user->game->game.data, PRODUCT_CODE_LENGTH);
 		INFO_LOG(Log::sceNet, "AdhocServer: %s (MAC: %s - IP: %s) stopped playing %s", (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str(), safegamestr);
 
+		// Unhash MAC (only known once playing)
+		erase_user_mac(user);
+
 		// Fix Game Player Count
 		user->game->playercount--;
 
@@ -687,6 +829,9 @@ void logout_user(SceNetAdhocctlUserNode * user)
 			// Unlink Rightside
 			if(user->game->next != NULL) user->game->next->prev = user->game->prev;
 
+			// Unhash Game Product ID
+			gameByProduct.erase(product_key(user->game->game));
+
 			// Free Game Node Memory
 			free(user->game);
 		}
@@ -706,7 +851,7 @@ void logout_user(SceNetAdhocctlUserNode * user)
 	_db_user_count--;
 
 	// Update Status Log
-	update_status();
+	schedule_status_update();
 }
 
 /**
@@ -773,8 +918,9 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 		if(user->group == NULL)
 		{
 			// Find Group in Game Node
-			SceNetAdhocctlGroupNode * g = user->game->group;
-			while(g != NULL && strncmp((char *)g->group.data, (char *)group->data, ADHOCCTL_GROUPNAME_LEN) != 0) g = g->next;
+			std::string groupname = group_key(user->game, group);
+			auto existing = groupByName.find(groupname);
+			SceNetAdhocctlGroupNode * g = existing != groupByName.end() ? existing->second : NULL;
 
 			// BSSID Packet
 			SceNetAdhocctlConnectBSSIDPacketS2C bssid;
@@ -810,6 +956,9 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 
 					// Increase Group Counter for Game
 					g->game->groupcount++;
+
+					// Hash Group Name
+					groupByName[groupname] = g;
 				}
 			}
 
@@ -838,9 +987,8 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 					// Set Player IP
 					packet.ip = user->resolver.ip;
 
-					// Send Data
-					int iResult = (int)send(peer->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-					if (iResult < 0) ERROR_LOG(Log::sceNet, "AdhocServer: connect_user[send peer] (Socket error %d)", socket_errno);
+					// Queue Data
+					queue_user_send(peer, &packet, sizeof(packet));
 
 					// Set Player Name
 					packet.name = peer->resolver.name;
@@ -851,9 +999,8 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 					// Set Player IP
 					packet.ip = peer->resolver.ip;
 
-					// Send Data
-					iResult = (int)send(user->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-					if (iResult < 0) ERROR_LOG(Log::sceNet, "AdhocServer: connect_user[send user] (Socket error %d)", socket_errno);
+					// Queue Data
+					queue_user_send(user, &packet, sizeof(packet));
 
 					// Set BSSID
 					if(peer->group_next == NULL) bssid.mac = peer->resolver.mac;
@@ -874,8 +1021,7 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 				g->playercount++;
 
 				// Send Network BSSID to User
-				int iResult = (int)send(user->stream, (const char*)&bssid, sizeof(bssid), MSG_NOSIGNAL);
-				if (iResult < 0) ERROR_LOG(Log::sceNet, "AdhocServer: connect_user[send user bssid] (Socket error %d)", socket_errno);
+				queue_user_send(user, &bssid, sizeof(bssid));
 
 				// Notify User
 				char safegamestr[10];
@@ -887,7 +1033,7 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 				INFO_LOG(Log::sceNet, "AdhocServer: %s (MAC: %s - IP: %s) joined %s group %s", (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str(), safegamestr, safegroupstr);
 
 				// Update Status Log
-				update_status();
+				schedule_status_update();
 
 				// Exit Function
 				return;
@@ -965,9 +1111,8 @@ void disconnect_user(SceNetAdhocctlUserNode * user)
 			// Set User IP
 			packet.ip = user->resolver.ip;
 
-			// Send Data
-			int iResult = (int)send(peer->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-			if (iResult < 0) ERROR_LOG(Log::sceNet, "AdhocServer: disconnect_user[send peer] (Socket error %d)", socket_errno);
+			// Queue Data
+			queue_user_send(peer, &packet, sizeof(packet));
 
 			// Move Pointer
 			peer = peer->group_next;
@@ -994,6 +1139,9 @@ void disconnect_user(SceNetAdhocctlUserNode * user)
 			// Unlink Rightside
 			if(user->group->next != NULL) user->group->next->prev = user->group->prev;
 
+			// Unhash Group Name
+			groupByName.erase(group_key(user->game, &user->group->group));
+
 			// Free Group Memory
 			free(user->group);
 
@@ -1007,7 +1155,7 @@ void disconnect_user(SceNetAdhocctlUserNode * user)
 		user->group_prev = NULL;
 
 		// Update Status Log
-		update_status();
+		schedule_status_update();
 
 		// Exit Function
 		return;
@@ -1064,15 +1212,13 @@ void send_scan_results(SceNetAdhocctlUserNode * user)
 				}
 			}
 
-			// Send Group Packet
-			int iResult = (int)send(user->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-			if (iResult < 0) ERROR_LOG(Log::sceNet, "AdhocServer: send_scan_result[send user] (Socket error %d)", socket_errno);
+			// Queue Group Packet
+			queue_user_send(user, &packet, sizeof(packet));
 		}
 
 		// Notify Player of End of Scan
 		uint8_t opcode = OPCODE_SCAN_COMPLETE;
-		int iResult = (int)send(user->stream, (const char*)&opcode, 1, MSG_NOSIGNAL);
-		if (iResult < 0) ERROR_LOG(Log::sceNet, "AdhocServer: send_scan_result[send peer complete] (Socket error %d)", socket_errno);
+		queue_user_send(user, &opcode, 1);
 
 		// Notify User
 		char safegamestr[10];
@@ -1129,9 +1275,8 @@ void spread_message(SceNetAdhocctlUserNode *user, const char *message)
 				// Set Chat Message
 				strcpy(packet.base.message, message);
 
-				// Send Data
-				int iResult = (int)send(user->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-				if (iResult < 0) ERROR_LOG(Log::sceNet, "AdhocServer: spread_message[send user chat] (Socket error %d)", socket_errno);
+				// Queue Data
+				queue_user_send(user, &packet, sizeof(packet));
 			}
 		}
 
@@ -1171,9 +1316,8 @@ void spread_message(SceNetAdhocctlUserNode *user, const char *message)
 			// Set Sender Nickname
 			packet.name = user->resolver.name;
 
-			// Send Data
-			int iResult = (int)send(peer->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-			if (iResult < 0) ERROR_LOG(Log::sceNet, "AdhocServer: spread_message[send peer chat] (Socket error %d)", socket_errno);
+			// Queue Data
+			queue_user_send(peer, &packet, sizeof(packet));
 
 			// Move Pointer
 			peer = peer->group_next;
@@ -1317,23 +1461,23 @@ void game_product_override(SceNetAdhocctlProductCode * product)
 			// Destroy Prepared SQL Statement
 			sqlite3_finalize(statement);
 		}*/
-		for (const auto &link : crosslinks) {
-			if (IsMatch(link.id_from, productid)) {
-				// Grab Crosslink ID
-				char crosslink[PRODUCT_CODE_LENGTH + 1];
-				strncpy(crosslink, link.id_to, PRODUCT_CODE_LENGTH);
-				crosslink[PRODUCT_CODE_LENGTH] = 0; // null terminated
-
-				// Crosslink Product Code
-				strncpy(product->data, link.id_to, PRODUCT_CODE_LENGTH);
-
-				// Log Crosslink
-				INFO_LOG(Log::sceNet, "AdhocServer: Crosslinked %s to %s", productid, crosslink);
-
-				// Set Crosslinked Flag
-				crosslinked = 1;
-				break;
-			}
+		auto linkIt = crosslinkIndex.find(productid);
+		if (linkIt != crosslinkIndex.end()) {
+			const db_crosslink &link = crosslinks[linkIt->second];
+
+			// Grab Crosslink ID
+			char crosslink[PRODUCT_CODE_LENGTH + 1];
+			strncpy(crosslink, link.id_to, PRODUCT_CODE_LENGTH);
+			crosslink[PRODUCT_CODE_LENGTH] = 0; // null terminated
+
+			// Crosslink Product Code
+			strncpy(product->data, link.id_to, PRODUCT_CODE_LENGTH);
+
+			// Log Crosslink
+			INFO_LOG(Log::sceNet, "AdhocServer: Crosslinked %s to %s", productid, crosslink);
+
+			// Set Crosslinked Flag
+			crosslinked = 1;
 		}
 
 		// Not Crosslinked
@@ -1356,12 +1500,9 @@ void game_product_override(SceNetAdhocctlProductCode * product)
 				// Destroy Prepare SQL Statement
 				sqlite3_finalize(statement);
 			}*/
-			for (const auto &product : productids) {
-				if (IsMatch(product.id, productid)) {
-					// Set Exists Flag
-					exists = 1;
-					break;
-				}
+			if (productidIndex.find(productid) != productidIndex.end()) {
+				// Set Exists Flag
+				exists = 1;
 			}
 
 			// Game doesn't exist in Database
@@ -1388,6 +1529,7 @@ void game_product_override(SceNetAdhocctlProductCode * product)
 				strncpy(unkproduct.id, productid, sizeof(unkproduct.id));
 				strncpy(unkproduct.name, productid, sizeof(unkproduct.name));
 				productids.push_back(unkproduct); //productids[productids.size()] = unkproduct;
+				productidIndex.emplace(productid, productids.size() - 1);
 				// Log Addition
 				INFO_LOG(Log::sceNet, "AdhocServer: Added Unknown Product ID %s to Database", productid);
 			}
@@ -1471,13 +1613,11 @@ void update_status()
 				}*/
 				//db_productid *foundid = NULL;
 				bool found = false;
-				for (const auto &product : productids) {
-					if (IsMatch(product.id, productid)) {
-						// Copy Game Name
-						strcpyxml(displayname, product.name, sizeof(displayname));
-						found = true;
-						break;
-					}
+				auto product = productidIndex.find(productid);
+				if (product != productidIndex.end()) {
+					// Copy Game Name
+					strcpyxml(displayname, productids[product->second].name, sizeof(displayname));
+					found = true;
 				}
 
 				if (!found) {
@@ -1852,6 +1992,136 @@ int create_listen_socket(uint16_t port)
 	return -1;
 }
 
+/**
+ * Handle the first Packet in a User's RX Buffer (does nothing until it's complete)
+ * @param user User Node (may get logged out)
+ */
+static void handle_user_packet(SceNetAdhocctlUserNode * user)
+{
+	// Waiting for Login Packet
+	if(get_user_state(user) == USER_STATE_WAITING)
+	{
+		// Valid Opcode
+		if(user->rx[0] == OPCODE_LOGIN)
+		{
+			// Enough Data available
+			if(user->rxpos >= sizeof(SceNetAdhocctlLoginPacketC2S))
+			{
+				// Clone Packet
+				SceNetAdhocctlLoginPacketC2S packet = *(SceNetAdhocctlLoginPacketC2S *)user->rx;
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlLoginPacketC2S));
+
+				// Login User (Data)
+				login_user_data(user, &packet);
+			}
+		}
+
+		// Invalid Opcode
+		else
+		{
+			// Notify User
+			WARN_LOG(Log::sceNet, "AdhocServer: Invalid Opcode 0x%02X in Waiting State from %s", user->rx[0], ip2str(*(in_addr*)&user->resolver.ip).c_str());
+
+			// Logout User
+			logout_user(user);
+		}
+	}
+
+	// Logged-In User
+	else if(get_user_state(user) == USER_STATE_LOGGED_IN)
+	{
+		// Ping Packet
+		if(user->rx[0] == OPCODE_PING)
+		{
+			// Delete Packet from RX Buffer
+			clear_user_rxbuf(user, 1);
+		}
+
+		// Group Connect Packet
+		else if(user->rx[0] == OPCODE_CONNECT)
+		{
+			// Enough Data available
+			if(user->rxpos >= sizeof(SceNetAdhocctlConnectPacketC2S))
+			{
+				// Cast Packet
+				SceNetAdhocctlConnectPacketC2S * packet = (SceNetAdhocctlConnectPacketC2S *)user->rx;
+
+				// Clone Group Name
+				SceNetAdhocctlGroupName group = packet->group;
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlConnectPacketC2S));
+
+				// Change Game Group
+				connect_user(user, &group);
+			}
+		}
+
+		// Group Disconnect Packet
+		else if(user->rx[0] == OPCODE_DISCONNECT)
+		{
+			// Remove Packet from RX Buffer
+			clear_user_rxbuf(user, 1);
+
+			// Leave Game Group
+			disconnect_user(user);
+		}
+
+		// Network Scan Packet
+		else if(user->rx[0] == OPCODE_SCAN)
+		{
+			// Remove Packet from RX Buffer
+			clear_user_rxbuf(user, 1);
+
+			// Send Network List
+			send_scan_results(user);
+		}
+
+		// Chat Text Packet
+		else if(user->rx[0] == OPCODE_CHAT)
+		{
+			// Enough Data available
+			if(user->rxpos >= sizeof(SceNetAdhocctlChatPacketC2S))
+			{
+				// Cast Packet
+				SceNetAdhocctlChatPacketC2S * packet = (SceNetAdhocctlChatPacketC2S *)user->rx;
+
+				// Clone Buffer for Message
+				char message[64];
+				memset(message, 0, sizeof(message));
+				strncpy(message, packet->message, sizeof(message) - 1);
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlChatPacketC2S));
+
+				// Spread Chat Message
+				spread_message(user, message);
+			}
+		}
+
+		// Invalid Opcode
+		else
+		{
+			// Notify User
+			WARN_LOG(Log::sceNet, "AdhocServer: Invalid Opcode 0x%02X in Logged-In State from %s (MAC: %s - IP: %s)", user->rx[0], (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str());
+
+			// Logout User
+			logout_user(user);
+		}
+	}
+}
+
+
+#if PPSSPP_PLATFORM(WINDOWS)
+typedef WSAPOLLFD server_pollfd;
+static int poll_sockets(server_pollfd * fds, size_t count, int timeout) { return WSAPoll(fds, (ULONG)count, timeout); }
+#else
+typedef struct pollfd server_pollfd;
+static int poll_sockets(server_pollfd * fds, size_t count, int timeout) { return poll(fds, (nfds_t)count, timeout); }
+#endif
+
 /**
  * Server Main Loop
  * @param server Server Listening Socket
@@ -1865,11 +2135,88 @@ int server_loop(int server)
 
 	// Create Empty Status Logfile
 	update_status();
+	statusDirty = false;
+	time_t lastStatusUpdate = time(NULL);
+
+	// Last Timeout Check
+	time_t lastTimeoutCheck = time(NULL);
+
+	// Poll Descriptors, the first one is the Listening Socket and the rest match pollUsers
+	std::vector<server_pollfd> pollfds;
+	std::vector<SceNetAdhocctlUserNode *> pollUsers;
 
 	// Handling Loop
 	while (adhocServerRunning) //(_status == 1)
 	{
+		// Wait for something to happen (or the timeout, to notice shutdown requests and dead users)
+		pollfds.clear();
+		pollUsers.clear();
+		server_pollfd serverfd{};
+		serverfd.fd = server;
+		serverfd.events = POLLIN;
+		pollfds.push_back(serverfd);
+		for(SceNetAdhocctlUserNode * user = _db_user; user != NULL; user = user->next)
+		{
+			server_pollfd userfd{};
+			userfd.fd = user->stream;
+			userfd.events = POLLIN;
+			// Data that didn't fit in the socket buffer last time
+			if(pendingSends.find(user) != pendingSends.end()) userfd.events |= POLLOUT;
+			pollfds.push_back(userfd);
+			pollUsers.push_back(user);
+		}
+
+		int pollresult = poll_sockets(pollfds.data(), pollfds.size(), SERVER_POLL_TIMEOUT);
+		if(pollresult < 0 && socket_errno != EINTR)
+		{
+			ERROR_LOG(Log::sceNet, "AdhocServer: poll failed (Socket error %d)", socket_errno);
+			sleep_ms(10, "pro-adhoc-poll-error");
+		}
+
+		// Receive Data from Users (each can only be freed while handling its own packets)
+		for(size_t i = 0; pollresult > 0 && i < pollUsers.size(); i++)
+		{
+			// Nothing to read
+			short revents = pollfds[i + 1].revents;
+			if((revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL)) == 0) continue;
+
+			SceNetAdhocctlUserNode * user = pollUsers[i];
+			int stream = user->stream;
+
+			// Receive Data from User
+			int recvresult = (int)recv(user->stream, (char*)user->rx + user->rxpos, sizeof(user->rx) - user->rxpos, MSG_NOSIGNAL);
+
+			// Connection Closed or Broken
+			if(recvresult == 0 || (recvresult == -1 && socket_errno != EAGAIN && socket_errno != EWOULDBLOCK) || (revents & POLLNVAL))
+			{
+				// Logout User
+				logout_user(user);
+				continue;
+			}
+
+			// New Incoming Data
+			if(recvresult > 0)
+			{
+				// Move RX Pointer
+				user->rxpos += recvresult;
+
+				// Update Death Clock
+				user->last_recv = time(NULL);
+			}
+
+			// Handle every complete Packet, not just one per wakeup
+			while(user->rxpos > 0)
+			{
+				uint32_t rxpos = user->rxpos;
+				handle_user_packet(user);
+
+				// Logged out, or waiting for the rest of the Packet
+				if(!user_still_connected(user, stream) || user->rxpos == rxpos) break;
+			}
+		}
+
 		// Login Block
+		if(pollresult > 0 && (pollfds[0].revents & POLLIN))
 		{
 			// Login Result
 			int loginresult = 0;
@@ -1911,158 +2258,35 @@ int server_loop(int server)
 			} while(loginresult != -1);
 		}
 
-		// Receive Data from Users
-		SceNetAdhocctlUserNode * user = _db_user;
-		while(user != NULL)
-		{
-			// Next User (for safe delete)
-			SceNetAdhocctlUserNode * next = user->next;
+		// Send everything queued up while handling Packets, one send per User
+		flush_pending_sends();
 
-			// Receive Data from User
-			int recvresult = (int)recv(user->stream, (char*)user->rx + user->rxpos, sizeof(user->rx) - user->rxpos, MSG_NOSIGNAL);
-
-			// Connection Closed or Timed Out
-			if(recvresult == 0 || (recvresult == -1 && socket_errno != EAGAIN && socket_errno != EWOULDBLOCK) || get_user_state(user) == USER_STATE_TIMED_OUT)
-			{
-				// Logout User
-				logout_user(user);
-			}
-
-			// Received Data (or leftovers in RX-Buffer)
-			else if(recvresult > 0 || user->rxpos > 0)
+		// Drop Users that stopped talking (the timeout is in seconds, no need to check more often)
+		time_t now = time(NULL);
+		if(now != lastTimeoutCheck)
+		{
+			lastTimeoutCheck = now;
+			SceNetAdhocctlUserNode * user = _db_user;
+			while(user != NULL)
 			{
-				// New Incoming Data
-				if(recvresult > 0)
-				{
-					// Move RX Pointer
-					user->rxpos += recvresult;
-
-					// Update Death Clock
-					user->last_recv = time(NULL);
-				}
-
-				// Waiting for Login Packet
-				if(get_user_state(user) == USER_STATE_WAITING)
-				{
-					// Valid Opcode
-					if(user->rx[0] == OPCODE_LOGIN)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlLoginPacketC2S))
-						{
-							// Clone Packet
-							SceNetAdhocctlLoginPacketC2S packet = *(SceNetAdhocctlLoginPacketC2S *)user->rx;
-
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlLoginPacketC2S));
-
-							// Login User (Data)
-							login_user_data(user, &packet);
-						}
-					}
-
-					// Invalid Opcode
-					else
-					{
-						// Notify User
-						WARN_LOG(Log::sceNet, "AdhocServer: Invalid Opcode 0x%02X in Waiting State from %s", user->rx[0], ip2str(*(in_addr*)&user->resolver.ip).c_str());
-
-						// Logout User
-						logout_user(user);
-					}
-				}
+				// Next User (for safe delete)
+				SceNetAdhocctlUserNode * next = user->next;
 
-				// Logged-In User
-				else if(get_user_state(user) == USER_STATE_LOGGED_IN)
-				{
-					// Ping Packet
-					if(user->rx[0] == OPCODE_PING)
-					{
-						// Delete Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
-					}
-
-					// Group Connect Packet
-					else if(user->rx[0] == OPCODE_CONNECT)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlConnectPacketC2S))
-						{
-							// Cast Packet
-							SceNetAdhocctlConnectPacketC2S * packet = (SceNetAdhocctlConnectPacketC2S *)user->rx;
-
-							// Clone Group Name
-							SceNetAdhocctlGroupName group = packet->group;
-
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlConnectPacketC2S));
-
-							// Change Game Group
-							connect_user(user, &group);
-						}
-					}
-
-					// Group Disconnect Packet
-					else if(user->rx[0] == OPCODE_DISCONNECT)
-					{
-						// Remove Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
+				// Timed Out
+				if(get_user_state(user) == USER_STATE_TIMED_OUT) logout_user(user);
 
-						// Leave Game Group
-						disconnect_user(user);
-					}
-
-					// Network Scan Packet
-					else if(user->rx[0] == OPCODE_SCAN)
-					{
-						// Remove Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
-
-						// Send Network List
-						send_scan_results(user);
-					}
-
-					// Chat Text Packet
-					else if(user->rx[0] == OPCODE_CHAT)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlChatPacketC2S))
-						{
-							// Cast Packet
-							SceNetAdhocctlChatPacketC2S * packet = (SceNetAdhocctlChatPacketC2S *)user->rx;
-
-							// Clone Buffer for Message
-							char message[64];
-							memset(message, 0, sizeof(message));
-							strncpy(message, packet->message, sizeof(message) - 1);
-
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlChatPacketC2S));
-
-							// Spread Chat Message
-							spread_message(user, message);
-						}
-					}
-
-					// Invalid Opcode
-					else
-					{
-						// Notify User
-						WARN_LOG(Log::sceNet, "AdhocServer: Invalid Opcode 0x%02X in Logged-In State from %s (MAC: %s - IP: %s)", user->rx[0], (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str());
-
-						// Logout User
-						logout_user(user);
-					}
-				}
+				// Move Pointer
+				user = next;
 			}
-
-			// Move Pointer
-			user = next;
 		}
 
-		// Prevent needless CPU Overload (1ms Sleep)
-		// !!!! COMMENT NOT REFLECTING REALITY
-		sleep_ms(10, "pro-adhoc-poll");
+		// Rewriting the Status Logfile on every change gets slow with lots of users
+		if(statusDirty && now - lastStatusUpdate >= 1)
+		{
+			update_status();
+			statusDirty = false;
+			lastStatusUpdate = now;
+		}
 
 		// Don't do anything if it's paused, otherwise the log will be flooded
 		while (adhocServerRunning && Core_IsStepping() && coreState != CORE_POWERDOWN)
@@ -2072,6 +2296,10 @@ int server_loop(int server)
 	// Free User Database Memory
 	free_database();
 
+	// Write final Status
+	update_status();
+	statusDirty = false;
+
 	// Close Server Socket
 	closesocket(server);
 
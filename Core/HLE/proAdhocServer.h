@@ -39,6 +39,12 @@
 // Server User Timeout (in seconds)
 #define SERVER_USER_TIMEOUT 15
 
+// Server Poll Timeout (in milliseconds), also how long a shutdown request may take to be noticed
+#define SERVER_POLL_TIMEOUT 100
+
+// Server User Send Buffer (queued bytes per user before dropping)
+#define SERVER_USER_SEND_BUFFER (256 * 1024)
+
 // Server SQLite3 Database
 #define SERVER_DATABASE "database.db"
 
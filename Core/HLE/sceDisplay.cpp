@@ -40,6 +40,7 @@
 #include "Core/CoreParameter.h"
 #include "Core/FrameTiming.h"
 #include "Core/Reporting.h"
+#include "Core/Debugger/MemBlockInfo.h"
 #include "Core/Core.h"
 #include "Core/System.h"
 #include "Core/HLE/HLE.h"
@@ -510,6 +511,7 @@ void hleEnterVblank(u64 userdata, int cyclesLate) {
 	VERBOSE_LOG(Log::sceDisplay, "Enter VBlank %i", vbCount);
 
 	DisplayFireVblankStart();
+	MemBlockInfoFrameEnd();
 
 	CoreTiming::ScheduleEvent(msToCycles(vblankMs) - cyclesLate, leaveVblankEvent, vbCount + 1);
 
@@ -52,12 +52,9 @@ static int __DmacMemcpy(u32 dst, u32 src, u32 size) {
 	}
 	if (!skip && size != 0) {
 		currentMIPS->InvalidateICache(src, size);
-		if (Memory::IsValidRange(dst, size) && Memory::IsValidRange(src, size)) {
-			memcpy(Memory::GetPointerWriteUnchecked(dst), Memory::GetPointerUnchecked(src), size);
-		}
-		if (MemBlockInfoDetailed(size)) {
-			NotifyMemInfoCopy(dst, src, size, "DmacMemcpy/");
-		}
+		// Bad ranges are silently ignored here, CopyRange would report a memory exception.
+		if (Memory::IsValidRange(dst, size) && Memory::IsValidRange(src, size))
+			Memory::CopyRange(dst, src, size, "DmacMemcpy/");
 		currentMIPS->InvalidateICache(dst, size);
 	}
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include "Common/Net/HTTPClient.h"
 
@@ -257,7 +258,7 @@ class HTTPRequest : public HTTPConnection {
 
 	u32 headerAddr_ = 0;
 	u32 headerSize_ = 0;
-	bool cancelled_ = false;
+	std::atomic<bool> cancelled_{ false };
 	int responseCode_ = -1;
 	int entityLength_ = -1;
 
@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <vector>
+
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Log/LogManager.h"
 #include "Common/System/OSD.h"
@@ -230,6 +232,7 @@ void __KernelShutdown()
 	CoreTiming::UnregisterAllEvents();
 	Reporting::Shutdown();
 	SaveState::Shutdown();
+	KernelObject::ClearFreeLists();
 
 	kernelRunning = false;
 }
@@ -496,6 +499,62 @@ void KernelObject::GetLongInfo(char *ptr, int size) const {
 	strcpy(ptr, "-");
 }
 
+struct KernelObjectFreeList {
+	size_t size;
+	std::vector<void *> ptrs;
+};
+
+// Only a few types ever get created, and only so many of each are worth keeping around.
+static std::vector<KernelObjectFreeList> kernelObjectFreeLists;
+static const size_t MAX_KERNEL_OBJECT_FREE_LISTS = 32;
+static const size_t MAX_KERNEL_OBJECT_FREE_LIST_SIZE = 32;
+
+void *KernelObject::operator new(size_t size) {
+	for (KernelObjectFreeList &list : kernelObjectFreeLists) {
+		if (list.size == size) {
+			if (list.ptrs.empty())
+				break;
+			void *ptr = list.ptrs.back();
+			list.ptrs.pop_back();
+			kernelStats.kernelObjectsReused++;
+			return ptr;
+		}
+	}
+
+	kernelStats.kernelObjectAllocs++;
+	return ::operator new(size);
+}
+
+void KernelObject::operator delete(void *ptr, size_t size) {
+	for (KernelObjectFreeList &list : kernelObjectFreeLists) {
+		if (list.size == size) {
+			if (list.ptrs.size() < MAX_KERNEL_OBJECT_FREE_LIST_SIZE) {
+				list.ptrs.push_back(ptr);
+				return;
+			}
+			::operator delete(ptr);
+			return;
+		}
+	}
+
+	if (kernelObjectFreeLists.size() < MAX_KERNEL_OBJECT_FREE_LISTS) {
+		KernelObjectFreeList list{ size };
+		list.ptrs.reserve(MAX_KERNEL_OBJECT_FREE_LIST_SIZE);
+		list.ptrs.push_back(ptr);
+		kernelObjectFreeLists.push_back(std::move(list));
+		return;
+	}
+	::operator delete(ptr);
+}
+
+void KernelObject::ClearFreeLists() {
+	for (KernelObjectFreeList &list : kernelObjectFreeLists) {
+		for (void *ptr : list.ptrs)
+			::operator delete(ptr);
+	}
+	kernelObjectFreeLists.clear();
+}
+
 KernelObjectPool::KernelObjectPool() {
 	memset(occupied, 0, sizeof(bool)*maxCount);
 	nextID = initialNextID;
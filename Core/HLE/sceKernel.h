@@ -124,6 +124,13 @@ class KernelObject {
 	u32 uid;
 public:
 	virtual ~KernelObject() {}
+
+	// Freed objects are kept around for reuse by the next object of the same size (so, mostly the same type),
+	// since some games open files, set alarms, or allocate memory blocks all the time.
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
+	static void ClearFreeLists();
+
 	SceUID GetUID() const {return uid;}
 	virtual const char *GetTypeName() {return "[BAD KERNEL OBJECT TYPE]";}
 	virtual const char *GetName() {return "[UNKNOWN KERNEL OBJECT]";}
@@ -279,6 +286,12 @@ struct KernelStats {
 		summedMsInSyscalls.clear();
 		summedSlowestSyscallTime = 0;
 		summedSlowestSyscallName = 0;
+		kernelObjectAllocs = 0;
+		kernelObjectsReused = 0;
+		scratchAllocs = 0;
+		scratchHeapAllocs = 0;
+		mostHeapAllocsSyscall = 0;
+		mostHeapAllocsSyscallName = 0;
 	}
 
 	double msInSyscalls;
@@ -287,6 +300,15 @@ struct KernelStats {
 	std::map<KernelStatsSyscall, double> summedMsInSyscalls;
 	double summedSlowestSyscallTime;
 	const char *summedSlowestSyscallName;
+	// Kernel objects, either new from the heap or reused from a free list (see KernelObject.)
+	int kernelObjectAllocs;
+	int kernelObjectsReused;
+	// Syscall scratch memory (see hleScratchAlloc), from the arena or from the heap once that's full.
+	int scratchAllocs;
+	int scratchHeapAllocs;
+	// Only kernel objects and scratch memory are counted, not every heap allocation a syscall makes.
+	int mostHeapAllocsSyscall;
+	const char *mostHeapAllocsSyscallName;
 };
 
 extern KernelStats kernelStats;
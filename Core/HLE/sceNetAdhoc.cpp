@@ -24,6 +24,7 @@
 #include <string>
 
 #include "Common/Net/SocketCompat.h"
+#include "Common/Net/SocketWatcher.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -81,6 +82,11 @@ int adhocEventPollDelay = 100000; //100000; // Same timings with PSP_ADHOCCTL_RE
 int adhocMatchingEventDelay = 30000; //30000
 int adhocEventDelay = 2000000; //2000000 on real PSP ?
 
+// How often blocked socket operations are checked again.  Waits for incoming data also get woken up by
+// adhocSocketWatcher as soon as something arrives, so they only need the slower timer for timeouts.
+constexpr int adhocSocketRetryDelayUS = 500;
+constexpr int adhocSocketWatchedRetryDelayUS = 4000;
+
 constexpr u32 defaultLastRecvDelta = 10000; //10000 usec worked well for games published by Falcom (ie. Ys vs Sora Kiseki, Vantage Master Portable)
 
 SceUID threadAdhocID;
@@ -94,9 +100,12 @@ int IsAdhocctlInCB = 0;
 int adhocctlNotifyEvent = -1;
 int adhocctlStateEvent = -1;
 int adhocSocketNotifyEvent = -1;
+int adhocSocketReadyEvent = -1;
 std::map<int, AdhocctlRequest> adhocctlRequests;
 std::map<u64, AdhocSocketRequest> adhocSocketRequests;
 std::map<u64, AdhocSendTargets> sendTargetPeers;
+// Created on the first blocking socket operation.
+static net::SocketWatcher *adhocSocketWatcher = nullptr;
 
 int gameModeNotifyEvent = -1;
 
@@ -137,6 +146,8 @@ void __NetAdhocShutdown() {
 	if (netAdhocInited) {
 		NetAdhoc_Term();
 	}
+	delete adhocSocketWatcher;
+	adhocSocketWatcher = nullptr;
 	if (dummyThreadHackAddr) {
 		kernelMemory.Free(dummyThreadHackAddr);
 		dummyThreadHackAddr = 0;
@@ -965,13 +976,44 @@ int DoBlockingAdhocPollSocket(AdhocSocketRequest& req, s64& result) {
 	return 0;
 }
 
+// Host socket to watch for a blocked request, or -1 if it can only be checked on a timer.
+static int GetAdhocSocketWatchFd(const AdhocSocketRequest &req) {
+	if (req.id <= 0 || req.id > MAX_SOCKET || adhocSockets[req.id - 1] == NULL)
+		return -1;
+	const AdhocSocket *sock = adhocSockets[req.id - 1];
+	switch (req.type) {
+	case PDP_RECV:
+		return sock->type == SOCK_PDP ? sock->data.pdp.id : -1;
+	case PTP_RECV:
+	case PTP_ACCEPT:
+		return sock->type == SOCK_PTP ? sock->data.ptp.id : -1;
+	default:
+		// A writable socket doesn't mean a send, connect or flush is done, so these stay on the timer.
+		return -1;
+	}
+}
+
+static void ScheduleAdhocSocketRetry(u64 userdata, const AdhocSocketRequest &req, int cyclesLate) {
+	int delayUS = adhocSocketRetryDelayUS;
+	int fd = adhocSocketWatcher ? GetAdhocSocketWatchFd(req) : -1;
+	if (fd >= 0 && adhocSocketWatcher->IsRunning()) {
+		delayUS = adhocSocketWatchedRetryDelayUS;
+		// Still need to wake up in time to notice the timeout.
+		if (req.timeout != 0) {
+			s64 remainingUS = (s64)(req.startTime + req.timeout) - (s64)(time_now_d() * 1000000.0);
+			delayUS = (int)std::clamp(remainingUS, (s64)adhocSocketRetryDelayUS, (s64)delayUS);
+		}
+		adhocSocketWatcher->Watch(userdata, fd, true, false);
+	}
+	CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+}
+
 static void __AdhocSocketNotify(u64 userdata, int cyclesLate) {
 	SceUID threadID = userdata >> 32;
 	int uid = (int)(userdata & 0xFFFFFFFF); // fd/socket id
 
 	s64 result = -1;
 	u32 error = 0;
-	int delayUS = 500;
 
 	SceUID waitID = __KernelGetWaitID(threadID, WAITTYPE_NET, error);
 	if (waitID == 0 || error != 0) {
@@ -983,6 +1025,8 @@ static void __AdhocSocketNotify(u64 userdata, int cyclesLate) {
 	if (adhocSocketRequests.find(userdata) == adhocSocketRequests.end()) {
 		WARN_LOG(Log::sceNet, "sceNetAdhoc Socket WaitID(%i) on Thread(%i) not found!", uid, threadID);
 		__KernelResumeThreadFromWait(threadID, ERROR_NET_ADHOC_TIMEOUT);
+		if (adhocSocketWatcher)
+			adhocSocketWatcher->Unwatch(userdata);
 		return;
 	}
 
@@ -996,8 +1040,8 @@ static void __AdhocSocketNotify(u64 userdata, int cyclesLate) {
 			break;
 		}
 		if (DoBlockingPdpSend(req, result, sendTargetPeers[userdata])) {
-			// Try again in another 0.5ms until data available or timedout.
-			CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+			// Try again later until done or timedout.
+			ScheduleAdhocSocketRetry(userdata, req, cyclesLate);
 			return;
 		}
 		sendTargetPeers.erase(userdata);
@@ -1005,56 +1049,56 @@ static void __AdhocSocketNotify(u64 userdata, int cyclesLate) {
 
 	case PDP_RECV:
 		if (DoBlockingPdpRecv(req, result)) {
-			// Try again in another 0.5ms until data available or timedout.
-			CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+			// Try again later until done or timedout.
+			ScheduleAdhocSocketRetry(userdata, req, cyclesLate);
 			return;
 		}
 		break;
 
 	case PTP_SEND:
 		if (DoBlockingPtpSend(req, result)) {
-			// Try again in another 0.5ms until data available or timedout.
-			CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+			// Try again later until done or timedout.
+			ScheduleAdhocSocketRetry(userdata, req, cyclesLate);
 			return;
 		}
 		break;
 
 	case PTP_RECV:
 		if (DoBlockingPtpRecv(req, result)) {
-			// Try again in another 0.5ms until data available or timedout.
-			CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+			// Try again later until done or timedout.
+			ScheduleAdhocSocketRetry(userdata, req, cyclesLate);
 			return;
 		}
 		break;
 
 	case PTP_ACCEPT:
 		if (DoBlockingPtpAccept(req, result)) {
-			// Try again in another 0.5ms until data available or timedout.
-			CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+			// Try again later until done or timedout.
+			ScheduleAdhocSocketRetry(userdata, req, cyclesLate);
 			return;
 		}
 		break;
 
 	case PTP_CONNECT:
 		if (DoBlockingPtpConnect(req, result, sendTargetPeers[userdata])) {
-			// Try again in another 0.5ms until data available or timedout.
-			CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+			// Try again later until done or timedout.
+			ScheduleAdhocSocketRetry(userdata, req, cyclesLate);
 			return;
 		}
 		break;
 
 	case PTP_FLUSH:
 		if (DoBlockingPtpFlush(req, result)) {
-			// Try again in another 0.5ms until data available or timedout.
-			CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+			// Try again later until done or timedout.
+			ScheduleAdhocSocketRetry(userdata, req, cyclesLate);
 			return;
 		}
 		break;
 
 	case ADHOC_POLL_SOCKET:
 		if (DoBlockingAdhocPollSocket(req, result)) {
-			// Try again in another 0.5ms until data available or timedout.
-			CoreTiming::ScheduleEvent(usToCycles(delayUS) - cyclesLate, adhocSocketNotifyEvent, userdata);
+			// Try again later until done or timedout.
+			ScheduleAdhocSocketRetry(userdata, req, cyclesLate);
 			return;
 		}
 		break;
@@ -1065,6 +1109,25 @@ static void __AdhocSocketNotify(u64 userdata, int cyclesLate) {
 
 	// We are done with this socket
 	adhocSocketRequests.erase(userdata);
+	if (adhocSocketWatcher)
+		adhocSocketWatcher->Unwatch(userdata);
+}
+
+// The watcher saw data arrive (or the socket got an alert), so check right away instead of waiting for the retry.
+static void __AdhocSocketReady(u64 userdata, int cyclesLate) {
+	// Might have finished or timed out already, that's fine.
+	if (adhocSocketRequests.find(userdata) == adhocSocketRequests.end())
+		return;
+
+	CoreTiming::UnscheduleEvent(adhocSocketNotifyEvent, userdata);
+	__AdhocSocketNotify(userdata, 0);
+}
+
+static void WakeAdhocSocketRequests(int socketId) {
+	for (const auto &it : adhocSocketRequests) {
+		if (it.second.id == socketId)
+			CoreTiming::ScheduleEvent(0, adhocSocketReadyEvent, it.first);
+	}
 }
 
 // input threadSocketId = ((u64)__KernelGetCurThread()) << 32 | socketId;
@@ -1084,6 +1147,11 @@ int WaitBlockingAdhocSocket(u64 threadSocketId, int type, int pspSocketId, void*
 
 	u64 startTime = (u64)(time_now_d() * 1000000.0);
 	adhocSocketRequests[threadSocketId] = { type, pspSocketId, buffer, len, tmout, startTime, remoteMAC, remotePort };
+	if (!adhocSocketWatcher) {
+		adhocSocketWatcher = new net::SocketWatcher([](uint64_t id) {
+			CoreTiming::ScheduleEvent_Threadsafe_Immediate(adhocSocketReadyEvent, id);
+		});
+	}
 	// Some games (ie. Hitman Reborn Battle Arena 2) are using as small as 50 usec timeout
 	CoreTiming::ScheduleEvent(usToCycles(1), adhocSocketNotifyEvent, threadSocketId);
 	__KernelWaitCurThread(WAITTYPE_NET, uid, 0, 0, false, reason);
@@ -1103,7 +1171,7 @@ void netAdhocValidateLoopMemory() {
 }
 
 void __NetAdhocDoState(PointerWrap &p) {
-	auto s = p.Section("sceNetAdhoc", 1, 8);
+	auto s = p.Section("sceNetAdhoc", 1, 9);
 	if (!s)
 		return;
 
@@ -1183,12 +1251,20 @@ void __NetAdhocDoState(PointerWrap &p) {
 		netAdhocGameModeEntered = false;
 		netAdhocEnterGameModeTimeout = 15000000;
 	}
+	if (s >= 9) {
+		Do(p, adhocSocketReadyEvent);
+	} else {
+		adhocSocketReadyEvent = -1;
+	}
+	CoreTiming::RestoreRegisterEvent(adhocSocketReadyEvent, "__AdhocSocketReady", __AdhocSocketReady);
 
 	if (p.mode == p.MODE_READ) {
 		// Discard leftover events
 		adhocctlEvents.clear();
 		adhocctlRequests.clear();
 		adhocSocketRequests.clear();
+		if (adhocSocketWatcher)
+			adhocSocketWatcher->Clear();
 		sendTargetPeers.clear();
 		deleteAllAdhocSockets();
 		deleteMatchingEvents();
@@ -1226,6 +1302,7 @@ void __AdhocNotifInit() {
 	adhocSocketNotifyEvent = CoreTiming::RegisterEvent("__AdhocSocketNotify", __AdhocSocketNotify);
 	gameModeNotifyEvent = CoreTiming::RegisterEvent("__GameModeNotify", __GameModeNotify);
 	adhocctlStateEvent = CoreTiming::RegisterEvent("__AdhocctlState", __AdhocctlState);
+	adhocSocketReadyEvent = CoreTiming::RegisterEvent("__AdhocSocketReady", __AdhocSocketReady);
 
 	adhocctlRequests.clear();
 	adhocSocketRequests.clear();
@@ -1990,6 +2067,9 @@ int sceNetAdhocSetSocketAlert(int id, int flag) {
  	WARN_LOG_REPORT_ONCE(sceNetAdhocSetSocketAlert, Log::sceNet, "UNTESTED sceNetAdhocSetSocketAlert(%d, %08x) at %08x", id, flag, currentMIPS->pc);
 
 	int retval = NetAdhoc_SetSocketAlert(id, flag);
+	// Anything blocked on this socket may have to return now.
+	if (retval == 0)
+		WakeAdhocSocketRequests(id);
 	return hleDelayResult(hleLogDebug(Log::sceNet, retval), "set socket alert delay", 1000);
 }
 
@@ -1471,8 +1471,16 @@ int matchingInputThread(int matchingId) { // TODO: The MatchingInput thread is u
 				else
 					break;
 			}
-			// Share CPU Time
-			sleep_ms(10, "pro-adhoc-4"); //1 //sceKernelDelayThread(10000);
+			// Share CPU Time, but wake up as soon as the next packet arrives instead of sleeping through it
+			int hostSocket = -1;
+			if (context != NULL) {
+				context->socketlock->lock();
+				if (context->socket > 0 && context->socket <= MAX_SOCKET && adhocSockets[context->socket - 1] != NULL)
+					hostSocket = adhocSockets[context->socket - 1]->data.pdp.id;
+				context->socketlock->unlock();
+			}
+			if (hostSocket < 0 || IsSocketReady(hostSocket, true, false, nullptr, 10000) < 0)
+				sleep_ms(10, "pro-adhoc-4"); //1 //sceKernelDelayThread(10000);
 
 			// Don't do anything if it's paused, otherwise the log will be flooded
 			while (Core_IsStepping() && coreState != CORE_POWERDOWN && contexts != NULL && context->inputRunning)
@@ -191,12 +191,21 @@ void __DisplayGetDebugStats(char *stats, size_t bufsize) {
 	snprintf(stats, bufsize,
 		"Kernel processing time: %0.2f ms\n"
 		"Slowest syscall: %s : %0.2f ms\n"
-		"Most active syscall: %s : %0.2f ms\n%s",
+		"Most active syscall: %s : %0.2f ms\n"
+		"Kernel objects: %d new, %d reused\n"
+		"Syscall scratch: %d arena, %d heap\n"
+		"Most heap allocations: %s : %d\n%s",
 		kernelStats.msInSyscalls * 1000.0f,
 		kernelStats.slowestSyscallName ? kernelStats.slowestSyscallName : "(none)",
 		kernelStats.slowestSyscallTime * 1000.0f,
 		kernelStats.summedSlowestSyscallName ? kernelStats.summedSlowestSyscallName : "(none)",
 		kernelStats.summedSlowestSyscallTime * 1000.0f,
+		kernelStats.kernelObjectAllocs,
+		kernelStats.kernelObjectsReused,
+		kernelStats.scratchAllocs,
+		kernelStats.scratchHeapAllocs,
+		kernelStats.mostHeapAllocsSyscallName ? kernelStats.mostHeapAllocsSyscallName : "(none)",
+		kernelStats.mostHeapAllocsSyscall,
 		statbuf);
 }
 
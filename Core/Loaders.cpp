@@ -83,7 +83,7 @@ IdentifiedFileType Identify_File(FileLoader *fileLoader, std::string *errorStrin
 			// maybe it also just happened to have that size, let's assume it's a PSP ISO and error out later if it's not.
 		}
 		return IdentifiedFileType::PSP_ISO;
-	} else if (extension == ".cso" || extension == ".chd") {
+	} else if (extension == ".cso" || extension == ".zso" || extension == ".chd") {
 		return IdentifiedFileType::PSP_ISO;
 	} else if (extension == ".ppst") {
 		return IdentifiedFileType::PPSSPP_SAVESTATE;
@@ -155,7 +155,7 @@ IdentifiedFileType Identify_File(FileLoader *fileLoader, std::string *errorStrin
 				return IdentifiedFileType::UNKNOWN_ISO;
 			}
 		}
-	} else if (!memcmp(&_id, "CISO", 4)) {
+	} else if (!memcmp(&_id, "CISO", 4) || !memcmp(&_id, "ZISO", 4)) {
 		// CISO are not used for many other kinds of ISO so let's just guess it's a PSP one and let it
 		// fail later...
 		return IdentifiedFileType::PSP_ISO;
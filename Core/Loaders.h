@@ -17,6 +17,7 @@
 
 #pragma	once
 
+#include <atomic>
 #include <string>
 #include <memory>
 
@@ -87,6 +88,15 @@ class FileLoader {
 		return ReadAt(absolutePos, 1, bytes, data, flags);
 	}
 
+	// If the whole file can be mapped into memory, returns a pointer to it, so reads can just copy from there.
+	// Not forwarded by proxies, since they'd be bypassed.
+	virtual const u8 *GetMappedData() {
+		return nullptr;
+	}
+
+	// Hint that this range will likely be read soon.  Loaders with a cache may start reading it in the background.
+	virtual void Prefetch(s64 absolutePos, size_t bytes) {}
+
 	// Cancel any operations that might block, if possible.
 	virtual void Cancel() {}
 
@@ -120,6 +130,9 @@ class ProxiedFileLoader : public FileLoader {
 	Path GetPath() const override {
 		return backend_->GetPath();
 	}
+	void Prefetch(s64 absolutePos, size_t bytes) override {
+		backend_->Prefetch(absolutePos, bytes);
+	}
 	void Cancel() override {
 		backend_->Cancel();
 	}
@@ -142,6 +155,15 @@ class ProxiedFileLoader : public FileLoader {
 	FileLoader *backend_;
 };
 
+// Effectiveness of a read cache, in bytes.  Caching loaders keep one of these for all their instances.
+struct FileLoaderCacheStats {
+	std::atomic<u64> hitBytes{};
+	std::atomic<u64> missBytes{};
+	std::atomic<u64> prefetchBytes{};
+	// Prefetched, but dropped before anything read it.
+	std::atomic<u64> prefetchWastedBytes{};
+};
+
 inline u32 operator & (const FileLoader::Flags &a, const FileLoader::Flags &b) {
 	return (u32)a & (u32)b;
 }
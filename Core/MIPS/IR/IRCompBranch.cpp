@@ -54,6 +54,17 @@ using namespace MIPSAnalyst;
 namespace MIPSComp
 {
 
+// A tight loop polling memory (say, waiting for a vblank or GE flag set from an interrupt)
+// can't make progress until the next CoreTiming event, so skip straight to it when taken.
+bool IRFrontend::IsIdleLoopBranch(u32 targetAddr) {
+	if (!opts.skipIdleLoops)
+		return false;
+	// The whole loop body must have run in this block, not just the tail of it.
+	if (js.blockStart > targetAddr)
+		return false;
+	return MIPSAnalyst::IsIdleLoop(GetCompilerPC());
+}
+
 void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	if (js.inDelaySlot) {
 		ERROR_LOG_REPORT(Log::JIT, "Branch in RSRTComp delay slot at %08x in block starting at %08x", GetCompilerPC(), js.blockStart);
@@ -66,6 +77,7 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 
 	BranchInfo branchInfo(GetCompilerPC(), op, GetOffsetInstruction(1), false, likely);
 	branchInfo.delaySlotIsNice = IsDelaySlotNiceReg(op, branchInfo.delaySlotOp, rt, rs);
+	bool idleLoop = IsIdleLoopBranch(targetAddr);
 
 	js.downcountAmount += MIPSGetInstructionCycleEstimate(branchInfo.delaySlotOp);
 
@@ -114,6 +126,8 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	}
 
 	FlushAll();
+	if (idleLoop)
+		ir.Write(IROp::IdleLoop);
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -132,6 +146,7 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 
 	BranchInfo branchInfo(GetCompilerPC(), op, GetOffsetInstruction(1), andLink, likely);
 	branchInfo.delaySlotIsNice = IsDelaySlotNiceReg(op, branchInfo.delaySlotOp, rs);
+	bool idleLoop = !andLink && IsIdleLoopBranch(targetAddr);
 
 	js.downcountAmount += MIPSGetInstructionCycleEstimate(branchInfo.delaySlotOp);
 
@@ -165,6 +180,8 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 
 	// Taken
 	FlushAll();
+	if (idleLoop)
+		ir.Write(IROp::IdleLoop);
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -208,6 +208,9 @@ enum class IROp : uint8_t {
 	// that will be used at the actual exit.
 	Downcount,  // src1 + (src2<<8)
 
+	// Placed before the taken exit of a busy-wait loop, fast-forwards to the next CoreTiming event.
+	IdleLoop,
+
 	// End-of-basic-block.
 	ExitToConst,   // 0, const, downcount
 	ExitToReg,
@@ -419,6 +422,7 @@ struct IROptions {
 	bool preferVec4;
 	bool preferVec4Dot;
 	bool optimizeForInterpreter;
+	bool skipIdleLoops;
 };
 
 const IRMeta *GetIRMeta(IROp op);
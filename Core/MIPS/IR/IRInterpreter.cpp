@@ -1123,6 +1123,11 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst) {
 			mips->downcount -= (int)inst->constant;
 			break;
 
+		case IROp::IdleLoop:
+			// Nothing can change until the next event, so skip ahead to it.
+			CoreTiming::Idle();
+			break;
+
 		case IROp::SetPC:
 			mips->pc = mips->r[inst->src1];
 			break;
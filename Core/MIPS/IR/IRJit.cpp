@@ -74,6 +74,7 @@ IRJit::IRJit(MIPSState *mipsState, bool actualJit) : frontend_(mipsState->HasDef
 	opts.preferVec4 = true;
 #endif
 	opts.optimizeForInterpreter = jo.optimizeForInterpreter;
+	opts.skipIdleLoops = (opts.disableFlags & (uint32_t)JitDisable::IDLE_LOOPS) == 0;
 	frontend_.SetOptions(opts);
 }
 
@@ -450,6 +450,11 @@ void IRNativeBackend::CompileIRInst(IRInst inst) {
 		CompIR_Breakpoint(inst);
 		break;
 
+	case IROp::IdleLoop:
+		// Rare and followed by an exit, so not worth a native implementation.
+		CompIR_Generic(inst);
+		break;
+
 	case IROp::ValidateAddress8:
 	case IROp::ValidateAddress16:
 	case IROp::ValidateAddress32:
@@ -586,6 +586,54 @@ namespace MIPSAnalyst {
 		return (op >> 26) == 0 && (op & 0x3f) == 12;
 	}
 
+	// Anything not in here (stores, FPU/VFPU, LO/HI, syscalls, jumps, cache ops...) disqualifies a loop.
+	static const u64 IDLE_LOOP_ALLOWED_INFO = IN_RS_ADDR | IN_RS_SHIFT | IN_RT | IN_SA | IN_IMM16 | IN_MEM | OUT_RT | OUT_RD | MEMTYPE_MASK;
+	static const int IDLE_LOOP_MAX_INSTRUCTIONS = 8;
+
+	bool IsIdleLoop(u32 branchAddr) {
+		MIPSOpcode branchOp = Memory::Read_Instruction(branchAddr, true);
+		MIPSInfo branchInfo = MIPSGetInfo(branchOp);
+		// Only plain conditional branches on GPRs, no linking.
+		if ((branchInfo & IS_CONDBRANCH) == 0 || (branchInfo & (OUT_RA | IN_FPUFLAG | IN_VFPU_CC | IS_FPU | IS_VFPU)) != 0)
+			return false;
+		u32 target = GetBranchTarget(branchAddr);
+		if (target == INVALIDTARGET || target > branchAddr || branchAddr - target >= IDLE_LOOP_MAX_INSTRUCTIONS * 4)
+			return false;
+
+		// Walk one iteration in execution order: the body, the branch itself, then the delay slot.
+		// Every register read must either be invariant (never written in the loop), or written
+		// earlier in the same iteration.  Otherwise there's a counter or similar carried over.
+		u32 written = 0;
+		u32 readBeforeWrite = 0;
+		for (u32 addr = target; addr <= branchAddr + 4; addr += 4) {
+			MIPSOpcode op = addr == branchAddr ? branchOp : Memory::Read_Instruction(addr, true);
+			MIPSInfo info = MIPSGetInfo(op);
+			if (addr != branchAddr) {
+				if ((info & ~IDLE_LOOP_ALLOWED_INFO) != 0)
+					return false;
+				// Nothing at all means break, halt, eret, and friends.
+				if ((info & IDLE_LOOP_ALLOWED_INFO) == 0)
+					return false;
+				// Loads only, cache and prefetch ops have side effects we don't want to skip.
+				if ((info & IN_MEM) != 0 && (info & OUT_RT) == 0)
+					return false;
+			}
+
+			u32 reads = 0;
+			if (info & IN_RS)
+				reads |= 1U << MIPS_GET_RS(op);
+			if (info & IN_RT)
+				reads |= 1U << MIPS_GET_RT(op);
+			readBeforeWrite |= reads & ~written;
+
+			MIPSGPReg out = addr == branchAddr ? MIPS_REG_INVALID : GetOutGPReg(op);
+			if (out != MIPS_REG_INVALID && out != MIPS_REG_ZERO)
+				written |= 1U << out;
+		}
+
+		return (readBeforeWrite & written) == 0;
+	}
+
 	static bool IsSWInstr(MIPSOpcode op) {
 		return (op & MIPSTABLE_IMM_MASK) == 0xAC000000;
 	}
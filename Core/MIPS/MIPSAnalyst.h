@@ -131,6 +131,9 @@ namespace MIPSAnalyst {
 	bool IsDelaySlotNiceVFPU(MIPSOpcode branchOp, MIPSOpcode op);
 	bool IsDelaySlotNiceFPU(MIPSOpcode branchOp, MIPSOpcode op);
 	bool IsSyscall(MIPSOpcode op);
+	// True if the backwards conditional branch at branchAddr closes a short loop that only reads
+	// registers and memory, so taking it again can't change anything until an interrupt/event.
+	bool IsIdleLoop(u32 branchAddr);
 
 	bool OpWouldChangeMemory(u32 pc, u32 addr, u32 size);
 	int OpMemoryAccessSize(u32 pc);
@@ -267,6 +267,24 @@ inline bool IsDepthTexVRAMAddress(const u32 address) {
 	return ((address & 0x3FE00000) == 0x04200000) || ((address & 0x3FE00000) == 0x04600000);
 }
 
+// Strips the mirror bits (uncached, kernel, and the VRAM mirrors), so addresses of the same memory
+// compare equal.  On 64-bit fastmem each mirror is its own mapping, so host pointers differ.
+inline u32 CanonicalAddress(const u32 address) {
+	if (IsVRAMAddress(address))
+		return address & 0x041FFFFF;
+	return address & 0x3FFFFFFF;
+}
+
+// Whether address is within len bytes after start, in the same memory (through any mirror.)
+inline bool IsAddressInRange(const u32 address, const u32 start, const u32 len) {
+	const u32 offset = CanonicalAddress(address) - CanonicalAddress(start);
+	if (IsVRAMAddress(address) && IsVRAMAddress(start)) {
+		// A range can run on into the next mirror, which wraps back to the start of VRAM.
+		return (offset & (VRAM_SIZE - 1)) < len;
+	}
+	return offset < len;
+}
+
 // 0x08000000 -> 0x08800000
 inline bool IsKernelAddress(const u32 address) {
 	return ((address & 0x3F800000) == 0x08000000);
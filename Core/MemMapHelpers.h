@@ -31,6 +31,21 @@ extern MIPSState *currentMIPS;
 namespace Memory
 {
 
+// Bulk guest copies and fills, for HLE and DMA.  The ranges are checked once up front (and logged if
+// bad, in which case nothing happens), then memory info is updated in one go.
+// Copies may overlap, including through mirrors, and then behave like memmove.
+// With a tagPrefix, the destination is tagged after the source (see NotifyMemInfoCopy.)
+bool CopyRange(u32 to_address, u32 from_address, u32 len, const char *tagPrefix);
+bool FillRange(u32 to_address, u8 value, u32 len, const char *tag, size_t tagLen);
+
+// Just the notification part of CopyRange, for when something else (like the GPU) did the copy.
+void NotifyCopyRange(u32 to_address, u32 from_address, u32 len, const char *tagPrefix);
+
+template<size_t tagLen>
+inline bool FillRange(u32 to_address, u8 value, u32 len, const char(&tag)[tagLen]) {
+	return FillRange(to_address, value, len, tag, tagLen - 1);
+}
+
 inline void Memcpy(const u32 to_address, const void *from_data, const u32 len, const char *tag, size_t tagLen) {
 	u8 *to = GetPointerWriteRange(to_address, len);
 	if (to) {
@@ -58,23 +73,14 @@ inline void Memcpy(void *to_data, const u32 from_address, const u32 len, const c
 }
 
 inline void Memcpy(const u32 to_address, const u32 from_address, const u32 len, const char *tag, size_t tagLen) {
-	u8 *to = GetPointerWriteRange(to_address, len);
-	// If not, GetPointer will log.
-	if (!to)
+	// Without a tag, the destination just inherits the source's.  With one, CopyRange doesn't
+	// notify anything, so the read and write below are the only notifications.
+	if (!CopyRange(to_address, from_address, len, tag ? nullptr : "Memcpy/") || !tag)
 		return;
-	const u8 *from = GetPointerRange(from_address, len);
-	if (!from)
-		return;
-
-	memcpy(to, from, len);
 
 	if (MemBlockInfoDetailed(len)) {
-		if (!tag) {
-			NotifyMemInfoCopy(to_address, from_address, len, "Memcpy/");
-		} else {
-			NotifyMemInfo(MemBlockFlags::READ, from_address, len, tag, tagLen);
-			NotifyMemInfo(MemBlockFlags::WRITE, to_address, len, tag, tagLen);
-		}
+		NotifyMemInfo(MemBlockFlags::READ, from_address, len, tag, tagLen);
+		NotifyMemInfo(MemBlockFlags::WRITE, to_address, len, tag, tagLen);
 	}
 }
 
@@ -25,7 +25,10 @@
 #include "Core/Util/BlockAllocator.h"
 #include "Core/Reporting.h"
 
-// Slow freaking thing but works (eventually) :)
+// Blocks form a doubly-linked list in address order, which is what gets saved.  On top of that,
+// they're indexed by start address, and the free ones are kept in a treap ordered by address where
+// each node knows the largest free block below it.  That finds the lowest (or highest) block that
+// fits in O(log n), the same one a walk over the list would.
 
 BlockAllocator::~BlockAllocator()
 {
@@ -39,6 +42,7 @@ void BlockAllocator::Init(u32 rangeStart, u32 rangeSize, bool suballoc) {
 	//Initial block, covering everything
 	top_ = new Block(rangeStart_, rangeSize_, false, NULL, NULL);
 	bottom_ = top_;
+	IndexBlock(top_);
 	suballoc_ = suballoc;
 }
 
@@ -51,6 +55,9 @@ void BlockAllocator::Shutdown()
 		bottom_ = next;
 	}
 	top_ = NULL;
+	blocksByStart_.clear();
+	freeRoot_ = NULL;
+	totalFree_ = 0;
 }
 
 u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop, const char *tag)
@@ -70,67 +77,30 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	// upalign size to grain
 	size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
 
-	if (!fromTop)
+	u32 offset = 0;
+	Block *bp = FindFreeBlock(size, grain, fromTop, offset);
+	if (bp != NULL)
 	{
-		//Allocate from bottom of mem
-		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		Block &b = *bp;
+		u32 needed = offset + size;
+		if (!fromTop)
 		{
-			Block &b = *bp;
-			u32 offset = b.start % grain;
-			if (offset != 0)
-				offset = grain - offset;
-			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeAfter(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-			}
+			// Allocate from bottom of mem, any alignment padding goes in front.
+			if (b.size != needed)
+				InsertFreeAfter(&b, b.size - needed);
+			if (offset >= grain_)
+				InsertFreeBefore(&b, offset);
 		}
-	}
-	else
-	{
-		// Allocate from top of mem.
-		for (Block *bp = top_; bp != NULL; bp = bp->prev)
+		else
 		{
-			Block &b = *bp;
-			u32 offset = (b.start + b.size - size) % grain;
-			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeBefore(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-			}
+			// Allocate from top of mem, any alignment padding goes after.
+			if (b.size != needed)
+				InsertFreeBefore(&b, b.size - needed);
+			if (offset >= grain_)
+				InsertFreeAfter(&b, offset);
 		}
+		TakeBlock(&b, tag);
+		return b.start;
 	}
 
 	//Out of memory :(
@@ -139,6 +109,131 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	return -1;
 }
 
+// Finds the same block a linear walk would: the lowest (or highest, if fromTop) free block
+// that fits size after alignment.
+BlockAllocator::Block *BlockAllocator::FindFreeBlock(u32 size, u32 grain, bool fromTop, u32 &offset)
+{
+	return FindFreeIn(freeRoot_, size, grain, fromTop, offset);
+}
+
+BlockAllocator::Block *BlockAllocator::FindFreeIn(Block *n, u32 size, u32 grain, bool fromTop, u32 &offset)
+{
+	// Subtrees without anything large enough are skipped entirely.  A block can still be passed over
+	// for alignment, but only if it's less than grain larger than size, so this stays cheap.
+	if (n == NULL || n->maxFree < size)
+		return NULL;
+
+	Block *found = FindFreeIn(fromTop ? n->right : n->left, size, grain, fromTop, offset);
+	if (found != NULL)
+		return found;
+
+	if (n->size >= size)
+	{
+		u32 blockOffset;
+		if (!fromTop)
+		{
+			blockOffset = n->start % grain;
+			if (blockOffset != 0)
+				blockOffset = grain - blockOffset;
+		}
+		else
+		{
+			blockOffset = (n->start + n->size - size) % grain;
+		}
+		if (n->size >= blockOffset + size)
+		{
+			offset = blockOffset;
+			return n;
+		}
+	}
+
+	return FindFreeIn(fromTop ? n->left : n->right, size, grain, fromTop, offset);
+}
+
+// Treap priority.  Any well mixed function of the address works, and keeps the shape deterministic.
+static inline u32 FreePriority(u32 start)
+{
+	u32 x = start * 0x9E3779B1;
+	x ^= x >> 15;
+	x *= 0x85EBCA77;
+	x ^= x >> 13;
+	return x;
+}
+
+void BlockAllocator::UpdateFree(Block *n)
+{
+	u32 maxFree = n->size;
+	if (n->left != NULL && n->left->maxFree > maxFree)
+		maxFree = n->left->maxFree;
+	if (n->right != NULL && n->right->maxFree > maxFree)
+		maxFree = n->right->maxFree;
+	n->maxFree = maxFree;
+}
+
+// Every block in l must be below every block in r.
+BlockAllocator::Block *BlockAllocator::JoinFree(Block *l, Block *r)
+{
+	if (l == NULL)
+		return r;
+	if (r == NULL)
+		return l;
+
+	if (FreePriority(l->start) > FreePriority(r->start))
+	{
+		l->right = JoinFree(l->right, r);
+		UpdateFree(l);
+		return l;
+	}
+	r->left = JoinFree(l, r->left);
+	UpdateFree(r);
+	return r;
+}
+
+// Splits t into the blocks below start (l) and the rest (r.)
+void BlockAllocator::SplitFree(Block *t, u32 start, Block *&l, Block *&r)
+{
+	if (t == NULL)
+	{
+		l = NULL;
+		r = NULL;
+		return;
+	}
+
+	if (t->start < start)
+	{
+		SplitFree(t->right, start, t->right, r);
+		l = t;
+	}
+	else
+	{
+		SplitFree(t->left, start, l, t->left);
+		r = t;
+	}
+	UpdateFree(t);
+}
+
+void BlockAllocator::InsertFree(Block *b)
+{
+	b->left = NULL;
+	b->right = NULL;
+	b->maxFree = b->size;
+
+	Block *l, *r;
+	SplitFree(freeRoot_, b->start, l, r);
+	freeRoot_ = JoinFree(JoinFree(l, b), r);
+	totalFree_ += b->size;
+}
+
+void BlockAllocator::RemoveFree(Block *b)
+{
+	Block *l, *mid, *r;
+	SplitFree(freeRoot_, b->start, l, mid);
+	SplitFree(mid, b->start + 1, mid, r);
+	_dbg_assert_(mid == b);
+	freeRoot_ = JoinFree(l, r);
+	totalFree_ -= b->size;
+}
+
 u32 BlockAllocator::Alloc(u32 &size, bool fromTop, const char *tag)
 {
 	// We want to make sure it's aligned in case AllocAt() was used.
@@ -191,8 +286,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 			{
 				if (b.size != alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
-				b.SetAllocated(tag, suballoc_);
+				TakeBlock(&b, tag);
 				CheckBlocks();
 				return position;
 			}
@@ -201,8 +295,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 				InsertFreeBefore(&b, alignedPosition - b.start);
 				if (b.size > alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
-				b.SetAllocated(tag, suballoc_);
+				TakeBlock(&b, tag);
 
 				return position;
 			}
@@ -220,6 +313,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 	return -1;
 }
 
+// fromBlock must already be unindexed, it's indexed again as free after merging.
 void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 {
 	VERBOSE_LOG(Log::sceKernel, "Merging Blocks");
@@ -228,6 +322,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (prev != NULL && prev->taken == false)
 	{
 		VERBOSE_LOG(Log::sceKernel, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(prev);
 		prev->size += fromBlock->size;
 		if (fromBlock->next == NULL)
 			top_ = prev;
@@ -248,6 +343,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (next != NULL && next->taken == false)
 	{
 		VERBOSE_LOG(Log::sceKernel, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(next);
 		fromBlock->size += next->size;
 		fromBlock->next = next->next;
 		delete next;
@@ -258,6 +354,32 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 		top_ = fromBlock;
 	else
 		next->prev = fromBlock;
+
+	IndexBlock(fromBlock);
+}
+
+void BlockAllocator::IndexBlock(Block *b)
+{
+	blocksByStart_[b->start] = b;
+	if (!b->taken)
+		InsertFree(b);
+}
+
+void BlockAllocator::UnindexBlock(Block *b)
+{
+	auto it = blocksByStart_.find(b->start);
+	if (it != blocksByStart_.end() && it->second == b)
+		blocksByStart_.erase(it);
+	if (!b->taken)
+		RemoveFree(b);
+}
+
+void BlockAllocator::TakeBlock(Block *b, const char *tag)
+{
+	if (!b->taken)
+		RemoveFree(b);
+	b->taken = true;
+	b->SetAllocated(tag, suballoc_);
 }
 
 bool BlockAllocator::Free(u32 position)
@@ -266,6 +388,7 @@ bool BlockAllocator::Free(u32 position)
 	if (b && b->taken)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
+		UnindexBlock(b);
 		b->taken = false;
 		MergeFreeBlocks(b);
 		return true;
@@ -283,6 +406,7 @@ bool BlockAllocator::FreeExact(u32 position)
 	if (b && b->taken && b->start == position)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
+		UnindexBlock(b);
 		b->taken = false;
 		MergeFreeBlocks(b);
 		return true;
@@ -296,6 +420,7 @@ bool BlockAllocator::FreeExact(u32 position)
 
 BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 {
+	UnindexBlock(b);
 	Block *inserted = new Block(b->start, size, false, b->prev, b);
 	b->prev = inserted;
 	if (inserted->prev == NULL)
@@ -305,11 +430,14 @@ BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 
 	b->start += size;
 	b->size -= size;
+	IndexBlock(inserted);
+	IndexBlock(b);
 	return inserted;
 }
 
 BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 {
+	UnindexBlock(b);
 	Block *inserted = new Block(b->start + b->size - size, size, false, b, b->next);
 	b->next = inserted;
 	if (inserted->next == NULL)
@@ -318,6 +446,8 @@ BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 		inserted->next->prev = inserted;
 
 	b->size -= size;
+	IndexBlock(b);
+	IndexBlock(inserted);
 	return inserted;
 }
 
@@ -341,31 +471,28 @@ const char *BlockAllocator::GetBlockTag(u32 addr) const {
 	return b->tag;
 }
 
-inline BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
+BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
 {
-	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
+	// The last block starting at or before addr is the only one that could contain it.
+	auto it = blocksByStart_.upper_bound(addr);
+	if (it == blocksByStart_.begin())
+		return NULL;
+	--it;
+	Block *bp = it->second;
+	if (bp->start + bp->size > addr)
+		return bp;
 	return NULL;
 }
 
 const BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr) const
 {
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		const Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
+	auto it = blocksByStart_.upper_bound(addr);
+	if (it == blocksByStart_.begin())
+		return NULL;
+	--it;
+	const Block *bp = it->second;
+	if (bp->start + bp->size > addr)
+		return bp;
 	return NULL;
 }
 
@@ -401,15 +528,8 @@ void BlockAllocator::ListBlocks() const
 u32 BlockAllocator::GetLargestFreeBlockSize() const
 {
 	u32 maxFreeBlock = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		const Block &b = *bp;
-		if (!b.taken)
-		{
-			if (b.size > maxFreeBlock)
-				maxFreeBlock = b.size;
-		}
-	}
+	if (freeRoot_ != NULL)
+		maxFreeBlock = freeRoot_->maxFree;
 	if (maxFreeBlock & (grain_ - 1))
 		WARN_LOG_REPORT(Log::HLE, "GetLargestFreeBlockSize: free size %08x does not align to grain %08x.", maxFreeBlock, grain_);
 	return maxFreeBlock;
@@ -417,15 +537,7 @@ u32 BlockAllocator::GetLargestFreeBlockSize() const
 
 u32 BlockAllocator::GetTotalFreeBytes() const
 {
-	u32 sum = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		const Block &b = *bp;
-		if (!b.taken)
-		{
-			sum += b.size;
-		}
-	}
+	u32 sum = totalFree_;
 	if (sum & (grain_ - 1))
 		WARN_LOG_REPORT(Log::HLE, "GetTotalFreeBytes: free size %08x does not align to grain %08x.", sum, grain_);
 	return sum;
@@ -455,6 +567,9 @@ void BlockAllocator::DoState(PointerWrap &p)
 			top_->next->DoState(p);
 			top_ = top_->next;
 		}
+
+		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+			IndexBlock(bp);
 	}
 	else
 	{
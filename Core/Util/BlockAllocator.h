@@ -19,6 +19,8 @@
 
 class PointerWrap;
 
+#include <map>
+
 #include "Common/CommonTypes.h"
 
 class BlockAllocator
@@ -69,10 +71,20 @@ class BlockAllocator
 		char tag[32];
 		Block *prev;
 		Block *next;
+		// Free tree links, only valid while the block is free.
+		Block *left = nullptr;
+		Block *right = nullptr;
+		// Largest free block size in this subtree.
+		u32 maxFree = 0;
 	};
 
 	Block *bottom_ = nullptr;
 	Block *top_ = nullptr;
+	// Every block by start address, for address lookups.
+	std::map<u32, Block *> blocksByStart_;
+	// Only the free blocks, as a treap ordered by address, with the largest free size of each subtree.
+	Block *freeRoot_ = nullptr;
+	u32 totalFree_ = 0;
 	u32 rangeStart_ = 0;
 	u32 rangeSize_ = 0;
 
@@ -80,6 +92,16 @@ class BlockAllocator
 	bool suballoc_ = false;
 
 	void MergeFreeBlocks(Block *fromBlock);
+	void IndexBlock(Block *b);
+	void UnindexBlock(Block *b);
+	void TakeBlock(Block *b, const char *tag);
+	Block *FindFreeBlock(u32 size, u32 grain, bool fromTop, u32 &offset);
+	void InsertFree(Block *b);
+	void RemoveFree(Block *b);
+	static void UpdateFree(Block *n);
+	static Block *JoinFree(Block *l, Block *r);
+	static void SplitFree(Block *t, u32 start, Block *&l, Block *&r);
+	static Block *FindFreeIn(Block *n, u32 size, u32 grain, bool fromTop, u32 &offset);
 	Block *GetBlockFromAddress(u32 addr);
 	const Block *GetBlockFromAddress(u32 addr) const;
 	Block *InsertFreeBefore(Block *b, u32 size);
@@ -0,0 +1,248 @@
+// Copyright (c) 2013- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <atomic>
+#include <vector>
+
+#include "ppsspp_config.h"
+#ifdef _WIN32
+#include "Common/CommonWindows.h"
+#endif
+
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
+#include "Common/StringUtils.h"
+#include "Common/SysError.h"
+#include "Common/TimeUtil.h"
+#include "Core/Config.h"
+#include "Core/Loaders.h"
+#include "Core/System.h"
+#include "Core/Util/GameInfoIndex.h"
+
+// Do() on a std::string stops at the first NUL, and both PARAM.SFO and PNG data are full of them.
+static void DoBinaryString(PointerWrap &p, std::string &data) {
+	u32 len = (u32)data.size();
+	Do(p, len);
+	if (p.mode == PointerWrap::MODE_READ) {
+		// Not exactly sane, but a corrupt index shouldn't make us allocate gigabytes.
+		if (len > 16 * 1024 * 1024) {
+			p.SetError(PointerWrap::ERROR_FAILURE);
+			return;
+		}
+		data.resize(len);
+	}
+	if (len != 0)
+		p.DoVoid(&data[0], (int)len);
+}
+
+void GameInfoIndexEntry::DoState(PointerWrap &p) {
+	// Version 1 truncated the PARAM.SFO and icon, those indexes just get rebuilt.
+	auto s = p.Section("GameInfoIndexEntry", 2);
+	if (!s)
+		return;
+
+	Do(p, size);
+	Do(p, mtime);
+	Do(p, fileType);
+	DoBinaryString(p, paramSFO);
+	Do(p, id);
+	Do(p, id_version);
+	Do(p, region);
+	DoBinaryString(p, icon);
+}
+
+void GameInfoIndexData::DoState(PointerWrap &p) {
+	auto s = p.Section("GameInfoIndex", 1);
+	if (!s)
+		return;
+
+	// Same layout as Do() on a map of plain entries.
+	u32 count = (u32)entries.size();
+	Do(p, count);
+	if (p.mode == PointerWrap::MODE_READ) {
+		entries.clear();
+		for (u32 i = 0; i < count && p.error == PointerWrap::ERROR_NONE; ++i) {
+			std::string key;
+			Do(p, key);
+			auto entry = std::make_shared<GameInfoIndexEntry>();
+			entry->DoState(p);
+			entries[key] = std::move(entry);
+		}
+	} else {
+		for (auto &iter : entries) {
+			std::string key = iter.first;
+			Do(p, key);
+			iter.second->DoState(p);
+		}
+	}
+}
+
+// Replaces an existing file in one step, so a concurrent load never finds it missing.
+static bool ReplaceWithFile(const Path &from, const Path &to) {
+#if defined(_WIN32) && !PPSSPP_PLATFORM(UWP)
+	// rename() won't replace an existing file here.
+	if (MoveFileExW(from.ToWString().c_str(), to.ToWString().c_str(), MOVEFILE_REPLACE_EXISTING))
+		return true;
+	WARN_LOG(Log::Loader, "Failed to replace %s: %s", to.c_str(), GetLastErrorMsg().c_str());
+	return false;
+#else
+#if PPSSPP_PLATFORM(UWP)
+	// No MoveFileEx from app storage, so there's a short window without an index.
+	if (File::Exists(to))
+		File::Delete(to);
+#endif
+	return File::Rename(from, to);
+#endif
+}
+
+bool GameInfoIndex::CanIndex(const Path &path, IdentifiedFileType fileType) {
+	if (path.Type() != PathType::NATIVE)
+		return false;
+	return fileType == IdentifiedFileType::PSP_ISO || fileType == IdentifiedFileType::PSP_ISO_NP || fileType == IdentifiedFileType::PSP_PBP;
+}
+
+Path GameInfoIndex::Filename() const {
+	if (!filename_.empty())
+		return filename_;
+	return GetSysDirectory(DIRECTORY_APP_CACHE) / "gameinfo.ppidx";
+}
+
+void GameInfoIndex::EnsureLoadedNoLock() {
+	if (loaded_)
+		return;
+	// Don't retry on failure, we'll just rebuild it.
+	loaded_ = true;
+
+	const Path filename = Filename();
+	if (!File::Exists(filename))
+		return;
+
+	double st = time_now_d();
+	std::string gitVersion;
+	std::string errorString;
+	if (CChunkFileReader::Load(filename, &gitVersion, data_, &errorString) != CChunkFileReader::ERROR_NONE) {
+		WARN_LOG(Log::Loader, "Failed to load game info index, rebuilding: %s", errorString.c_str());
+		data_.entries.clear();
+		return;
+	}
+	INFO_LOG(Log::Loader, "Loaded game info index with %d entries in %0.1f ms", (int)data_.entries.size(), (time_now_d() - st) * 1000.0);
+}
+
+bool GameInfoIndex::Lookup(const Path &path, GameInfoIndexEntry *entry) {
+	File::FileInfo fileInfo;
+	if (!File::GetFileInfo(path, &fileInfo) || fileInfo.isDirectory)
+		return false;
+
+	std::shared_ptr<GameInfoIndexEntry> found;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		EnsureLoadedNoLock();
+		auto iter = data_.entries.find(path.ToString());
+		if (iter == data_.entries.end())
+			return false;
+		if (iter->second->size != fileInfo.size || iter->second->mtime != fileInfo.mtime) {
+			// The file was replaced or patched, this will get refreshed after it's read again.
+			data_.entries.erase(iter);
+			unsavedChanges_++;
+			return false;
+		}
+		found = iter->second;
+	}
+
+	// It won't change, so no need to hold the lock while copying the icon.
+	*entry = *found;
+	return true;
+}
+
+void GameInfoIndex::Update(const Path &path, GameInfoIndexEntry &&entry) {
+	File::FileInfo fileInfo;
+	if (!File::GetFileInfo(path, &fileInfo) || fileInfo.isDirectory)
+		return;
+	entry.size = fileInfo.size;
+	entry.mtime = fileInfo.mtime;
+	auto updated = std::make_shared<GameInfoIndexEntry>(std::move(entry));
+
+	bool save = false;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		EnsureLoadedNoLock();
+		std::shared_ptr<GameInfoIndexEntry> &existing = data_.entries[path.ToString()];
+		// We might've only fetched the PARAM.SFO this time, keep the icon from before.
+		if (existing && updated->icon.empty() && existing->size == updated->size && existing->mtime == updated->mtime)
+			updated->icon = existing->icon;
+		existing = std::move(updated);
+		save = ++unsavedChanges_ >= SAVE_INTERVAL;
+	}
+
+	// We're on a background thread already, so might as well write it here.
+	if (save)
+		Save();
+}
+
+void GameInfoIndex::Save() {
+	std::lock_guard<std::mutex> saveGuard(saveLock_);
+
+	// Lookups and updates only wait for copying the map (not the entries), not for any of the file I/O below.
+	GameInfoIndexData snapshot;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!loaded_ || unsavedChanges_ == 0)
+			return;
+		snapshot = data_;
+		unsavedChanges_ = 0;
+	}
+
+	// Forget about games that were deleted or moved.
+	std::vector<std::pair<std::string, u64>> removed;
+	for (auto iter = snapshot.entries.begin(); iter != snapshot.entries.end(); ) {
+		if (!File::Exists(Path(iter->first))) {
+			removed.emplace_back(iter->first, iter->second->mtime);
+			iter = snapshot.entries.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+	if (!removed.empty()) {
+		std::lock_guard<std::mutex> guard(lock_);
+		for (const auto &key : removed) {
+			// Unless it was updated meanwhile, which means it's back.
+			auto iter = data_.entries.find(key.first);
+			if (iter != data_.entries.end() && iter->second->mtime == key.second)
+				data_.entries.erase(iter);
+		}
+	}
+
+	// Write a temporary file and move it over the index, so nobody loads a partial one.
+	// Another cache may be saving the same index at the same time, so the name must be unique.
+	static std::atomic<int> tempCounter;
+	const Path filename = Filename();
+	const Path tempFilename = filename.WithExtraExtension(StringFromFormat(".%d.tmp", tempCounter++));
+
+	File::CreateFullPath(filename.NavigateUp());
+	if (CChunkFileReader::Save(tempFilename, "GameInfoIndex", PPSSPP_GIT_VERSION, snapshot) != CChunkFileReader::ERROR_NONE) {
+		WARN_LOG(Log::Loader, "Failed to save game info index");
+		File::Delete(tempFilename);
+		return;
+	}
+	if (!ReplaceWithFile(tempFilename, filename)) {
+		WARN_LOG(Log::Loader, "Failed to replace game info index");
+		File::Delete(tempFilename);
+	}
+}
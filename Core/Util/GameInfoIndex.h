@@ -0,0 +1,82 @@
+// Copyright (c) 2013- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+
+class PointerWrap;
+enum class IdentifiedFileType;
+
+// The parts of a GameInfo that the game list needs, saved so we don't have to open every
+// ISO/CSO/PBP again on the next startup. Only trusted while the file's size and mtime match.
+struct GameInfoIndexEntry {
+	u64 size = 0;
+	u64 mtime = 0;
+	int fileType = 0;
+	std::string paramSFO;
+	// These don't always come straight from the PARAM.SFO (homebrew), so keep them too.
+	std::string id;
+	std::string id_version;
+	int region = -1;
+	// ICON0.PNG from inside the game (already compressed.) Empty if it didn't have one.
+	std::string icon;
+
+	void DoState(PointerWrap &p);
+};
+
+// Kept separate from the locks so it can be copied and saved in the background.
+// Entries are never modified once added, only replaced, so a copy shares all the PARAM.SFO and icon data.
+struct GameInfoIndexData {
+	std::map<std::string, std::shared_ptr<GameInfoIndexEntry>> entries;
+
+	void DoState(PointerWrap &p);
+};
+
+class GameInfoIndex {
+public:
+	// By default, the index lives in the app cache directory.
+	GameInfoIndex() {}
+	explicit GameInfoIndex(const Path &filename) : filename_(filename) {}
+
+	// Only plain game files - directories don't change mtime when their contents do.
+	static bool CanIndex(const Path &path, IdentifiedFileType fileType);
+
+	bool Lookup(const Path &path, GameInfoIndexEntry *entry);
+	void Update(const Path &path, GameInfoIndexEntry &&entry);
+	void Save();
+
+private:
+	// Write out this often while browsing, in case we don't get a clean shutdown.
+	enum { SAVE_INTERVAL = 64 };
+
+	Path Filename() const;
+	void EnsureLoadedNoLock();
+
+	Path filename_;
+	std::mutex lock_;
+	std::mutex saveLock_;
+	GameInfoIndexData data_;
+	bool loaded_ = false;
+	int unsavedChanges_ = 0;
+};
@@ -16,8 +16,13 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <tuple>
+#include <vector>
 
 #include "Common/Net/HTTPClient.h"
 #include "Common/Net/HTTPServer.h"
@@ -52,6 +57,36 @@ static ServerStatus serverStatus;
 static std::mutex serverStatusLock;
 static int serverFlags;
 
+// Requests are mostly tiny range reads, so a few threads go a long way.
+// Each connected debugger keeps one busy, though.
+static const int SERVER_WORKER_THREADS = 8;
+
+// Disc images are read in blocks of this size, which stay cached for the next request (or client.)
+static const s64 DISC_CACHE_BLOCK_SIZE = 64 * 1024;
+// 32 MB.
+static const size_t DISC_CACHE_MAX_BLOCKS = 512;
+
+struct DiscCacheKey {
+	std::string path;
+	// In case the file gets replaced or patched.
+	s64 fileSize;
+	uint64_t mtime;
+	s64 block;
+
+	bool operator <(const DiscCacheKey &other) const {
+		return std::tie(path, fileSize, mtime, block) < std::tie(other.path, other.fileSize, other.mtime, other.block);
+	}
+};
+
+struct DiscCacheBlock {
+	std::shared_ptr<std::vector<u8>> data;
+	uint64_t lastUsed;
+};
+
+static std::mutex discCacheLock;
+static std::map<DiscCacheKey, DiscCacheBlock> discCache;
+static uint64_t discCacheCounter;
+
 // NOTE: These *only* encode spaces, which is almost enough.
 
 std::string ServerUriEncode(std::string_view plain) {
@@ -77,7 +112,7 @@ static ServerStatus RetrieveStatus() {
 static bool RegisterServer(int port) {
 	bool success = false;
 	http::Client http;
-	bool cancelled = false;
+	std::atomic<bool> cancelled{ false };
 	net::RequestProgress progress(&cancelled);
 	Buffer theVoid = Buffer::Void();
 
@@ -203,8 +238,54 @@ static Path LocalFromRemotePath(const std::string &path) {
 	}
 }
 
-static void DiscHandler(const http::ServerRequest &request, const Path &filename) {
-	s64 sz = File::GetFileSize(filename);
+// Opens the file on the first miss.  Blocks stay valid even if they get evicted meanwhile.
+static std::shared_ptr<std::vector<u8>> ReadDiscBlock(FILE *&fp, const Path &filename, const File::FileInfo &info, s64 block) {
+	const s64 fileSize = (s64)info.size;
+	DiscCacheKey key{ filename.ToString(), fileSize, info.mtime, block };
+	{
+		std::lock_guard<std::mutex> guard(discCacheLock);
+		auto it = discCache.find(key);
+		if (it != discCache.end()) {
+			it->second.lastUsed = ++discCacheCounter;
+			return it->second.data;
+		}
+	}
+
+	// Not under the lock, so hits don't have to wait.  Two clients might read the same block, no harm done.
+	if (!fp) {
+		fp = File::OpenCFile(filename, "rb");
+		if (!fp)
+			return nullptr;
+	}
+	s64 pos = block * DISC_CACHE_BLOCK_SIZE;
+	size_t len = (size_t)std::min(DISC_CACHE_BLOCK_SIZE, fileSize - pos);
+	auto data = std::make_shared<std::vector<u8>>(len);
+	if (fseek(fp, pos, SEEK_SET) != 0 || fread(data->data(), len, 1, fp) != 1)
+		return nullptr;
+
+	std::lock_guard<std::mutex> guard(discCacheLock);
+	if (discCache.size() >= DISC_CACHE_MAX_BLOCKS) {
+		auto oldest = discCache.begin();
+		for (auto it = discCache.begin(); it != discCache.end(); ++it) {
+			if (it->second.lastUsed < oldest->second.lastUsed)
+				oldest = it;
+		}
+		discCache.erase(oldest);
+	}
+	discCache[key] = DiscCacheBlock{ data, ++discCacheCounter };
+	return data;
+}
+
+static void ClearDiscCache() {
+	std::lock_guard<std::mutex> guard(discCacheLock);
+	discCache.clear();
+}
+
+void ServeDiscImage(const http::ServerRequest &request, const Path &filename) {
+	File::FileInfo info;
+	if (!File::GetFileInfo(filename, &info))
+		info.size = 0;
+	s64 sz = (s64)info.size;
 	if (sz == 0) {
 		// Probably failed
 		request.WriteHttpResponseHeader("1.0", 404, -1, "text/plain");
@@ -229,8 +310,11 @@ static void DiscHandler(const http::ServerRequest &request, const Path &filename
 			return;
 		}
 
-		FILE *fp = File::OpenCFile(filename, "rb");
-		if (!fp || fseek(fp, begin, SEEK_SET) != 0) {
+		// Get the first block before committing to a response.
+		FILE *fp = nullptr;
+		s64 block = begin / DISC_CACHE_BLOCK_SIZE;
+		std::shared_ptr<std::vector<u8>> data = ReadDiscBlock(fp, filename, info, block);
+		if (!data) {
 			request.WriteHttpResponseHeader("1.0", 500, -1, "text/plain");
 			request.Out()->Push("File access failed.");
 			if (fp) {
@@ -244,16 +328,30 @@ static void DiscHandler(const http::ServerRequest &request, const Path &filename
 		snprintf(contentRange, sizeof(contentRange), "Content-Range: bytes %lld-%lld/%lld\r\n", begin, last, sz);
 		request.WriteHttpResponseHeader("1.0", 206, len, "application/octet-stream", contentRange);
 
-		const size_t CHUNK_SIZE = 16 * 1024;
-		char *buf = new char[CHUNK_SIZE];
-		for (s64 pos = 0; pos < len; pos += CHUNK_SIZE) {
-			s64 chunklen = std::min(len - pos, (s64)CHUNK_SIZE);
-			if (fread(buf, chunklen, 1, fp) != 1)
+		// The blocks are sent as they are, no need to copy them around first.
+		for (s64 pos = begin; pos <= last; ) {
+			if (!data) {
+				data = ReadDiscBlock(fp, filename, info, block);
+				if (!data) {
+					// We promised more than we're sending, so the connection can't be reused.
+					request.DisableKeepAlive();
+					break;
+				}
+			}
+			s64 offset = pos - block * DISC_CACHE_BLOCK_SIZE;
+			s64 chunklen = std::min(last + 1 - pos, (s64)data->size() - offset);
+			if (!request.Out()->PushDirect((const char *)data->data() + offset, (size_t)chunklen)) {
+				// Same here, the client may still be waiting for the rest (or just stopped reading.)
+				request.DisableKeepAlive();
 				break;
-			request.Out()->Push(buf, chunklen);
+			}
+			pos += chunklen;
+			block++;
+			data.reset();
+		}
+		if (fp) {
+			fclose(fp);
 		}
-		fclose(fp);
-		delete[] buf;
 		request.Out()->Flush();
 	} else {
 		request.WriteHttpResponseHeader("1.0", 418, -1, "text/plain");
@@ -359,7 +457,7 @@ static void HandleFallback(const http::ServerRequest &request) {
 			if (File::IsDirectory(localPath)) {
 				HandleListing(request);
 			} else {
-				DiscHandler(request, localPath);
+				ServeDiscImage(request, localPath);
 			}
 			return;
 		}
@@ -408,7 +506,7 @@ static void ExecuteWebServer() {
 
 	AndroidJNIThreadContext context;  // Destructor detaches.
 
-	auto http = new http::Server(new NewThreadExecutor());
+	auto http = new http::Server(new PooledExecutor(SERVER_WORKER_THREADS));
 	http->RegisterHandler("/", &HandleListing);
 	// This lists all the (current) recent ISOs.
 	http->SetFallbackHandler(&HandleFallback);
@@ -439,6 +537,7 @@ static void ExecuteWebServer() {
 	http->Stop();
 	StopAllDebuggers();
 	delete http;
+	ClearDiscCache();
 
 	UpdateStatus(ServerStatus::FINISHED);
 }
@@ -19,6 +19,12 @@
 
 #include "Common/Common.h"
 
+class Path;
+
+namespace http {
+class ServerRequest;
+}
+
 enum class WebServerFlags {
 	NONE = 0,
 	DISCS = 1,
@@ -35,3 +41,6 @@ bool WebServerStopped(WebServerFlags flags);
 void ShutdownWebServer();
 
 bool RemoteISOFileSupported(const std::string &filename);
+
+// Answers HEAD and range requests for a disc image, from a block cache shared by all clients.
+void ServeDiscImage(const http::ServerRequest &request, const Path &filename);
@@ -843,6 +843,83 @@ bool DrawEngineCommon::CanUseHardwareTessellation(GEPatchPrimType prim) const {
 	return false;
 }
 
+bool DrawEngineCommon::IsStateChangeIgnored(u8 cmd) {
+	// Only state that's purely a parameter of a feature with its own enable is listed here.
+	// The enables themselves always flush, so the queued draws and any that follow agree on them.
+	switch (cmd) {
+	case GE_CMD_AMBIENTCOLOR:
+	case GE_CMD_AMBIENTALPHA:
+	case GE_CMD_MATERIALDIFFUSE:
+	case GE_CMD_MATERIALEMISSIVE:
+	case GE_CMD_MATERIALSPECULAR:
+	case GE_CMD_MATERIALSPECULARCOEF:
+	case GE_CMD_MATERIALUPDATE:
+	case GE_CMD_LIGHTMODE:
+	case GE_CMD_LIGHTTYPE0: case GE_CMD_LIGHTTYPE1: case GE_CMD_LIGHTTYPE2: case GE_CMD_LIGHTTYPE3:
+	case GE_CMD_LKA0: case GE_CMD_LKB0: case GE_CMD_LKC0:
+	case GE_CMD_LKA1: case GE_CMD_LKB1: case GE_CMD_LKC1:
+	case GE_CMD_LKA2: case GE_CMD_LKB2: case GE_CMD_LKC2:
+	case GE_CMD_LKA3: case GE_CMD_LKB3: case GE_CMD_LKC3:
+	case GE_CMD_LKS0: case GE_CMD_LKS1: case GE_CMD_LKS2: case GE_CMD_LKS3:
+	case GE_CMD_LKO0: case GE_CMD_LKO1: case GE_CMD_LKO2: case GE_CMD_LKO3:
+	case GE_CMD_LAC0: case GE_CMD_LDC0: case GE_CMD_LSC0:
+	case GE_CMD_LAC1: case GE_CMD_LDC1: case GE_CMD_LSC1:
+	case GE_CMD_LAC2: case GE_CMD_LDC2: case GE_CMD_LSC2:
+	case GE_CMD_LAC3: case GE_CMD_LDC3: case GE_CMD_LSC3:
+		return !gstate.isLightingEnabled();
+
+	case GE_CMD_LX0: case GE_CMD_LY0: case GE_CMD_LZ0:
+	case GE_CMD_LX1: case GE_CMD_LY1: case GE_CMD_LZ1:
+	case GE_CMD_LX2: case GE_CMD_LY2: case GE_CMD_LZ2:
+	case GE_CMD_LX3: case GE_CMD_LY3: case GE_CMD_LZ3:
+	case GE_CMD_LDX0: case GE_CMD_LDY0: case GE_CMD_LDZ0:
+	case GE_CMD_LDX1: case GE_CMD_LDY1: case GE_CMD_LDZ1:
+	case GE_CMD_LDX2: case GE_CMD_LDY2: case GE_CMD_LDZ2:
+	case GE_CMD_LDX3: case GE_CMD_LDY3: case GE_CMD_LDZ3:
+		// Light positions and directions are also used for environment mapping.
+		if (gstate.isTextureMapEnabled() && gstate.getUVGenMode() == GE_TEXMAP_ENVIRONMENT_MAP)
+			return false;
+		return !gstate.isLightingEnabled();
+
+	case GE_CMD_FOGCOLOR:
+	case GE_CMD_FOG1:
+	case GE_CMD_FOG2:
+		return !gstate.isFogEnabled();
+
+	case GE_CMD_ALPHATEST:
+		return !gstate.isAlphaTestEnabled();
+
+	case GE_CMD_COLORTEST:
+	case GE_CMD_COLORREF:
+	case GE_CMD_COLORTESTMASK:
+		return !gstate.isColorTestEnabled();
+
+	case GE_CMD_LOGICOP:
+		return !gstate.isLogicOpEnabled();
+
+	case GE_CMD_TEXMODE:
+	case GE_CMD_TEXFUNC:
+	case GE_CMD_TEXENVCOLOR:
+	case GE_CMD_TEXFILTER:
+	case GE_CMD_TEXWRAP:
+	case GE_CMD_TEXFORMAT:
+	case GE_CMD_TEXLODSLOPE:
+	case GE_CMD_TEXSIZE1: case GE_CMD_TEXSIZE2: case GE_CMD_TEXSIZE3: case GE_CMD_TEXSIZE4:
+	case GE_CMD_TEXSIZE5: case GE_CMD_TEXSIZE6: case GE_CMD_TEXSIZE7:
+	case GE_CMD_TEXADDR0: case GE_CMD_TEXADDR1: case GE_CMD_TEXADDR2: case GE_CMD_TEXADDR3:
+	case GE_CMD_TEXADDR4: case GE_CMD_TEXADDR5: case GE_CMD_TEXADDR6: case GE_CMD_TEXADDR7:
+	case GE_CMD_TEXBUFWIDTH0: case GE_CMD_TEXBUFWIDTH1: case GE_CMD_TEXBUFWIDTH2: case GE_CMD_TEXBUFWIDTH3:
+	case GE_CMD_TEXBUFWIDTH4: case GE_CMD_TEXBUFWIDTH5: case GE_CMD_TEXBUFWIDTH6: case GE_CMD_TEXBUFWIDTH7:
+	case GE_CMD_CLUTADDR:
+	case GE_CMD_CLUTADDRUPPER:
+	case GE_CMD_CLUTFORMAT:
+		return !gstate.isTextureMapEnabled();
+
+	default:
+		return false;
+	}
+}
+
 void TessellationDataTransfer::CopyControlPoints(float *pos, float *tex, float *col, int posStride, int texStride, int colStride, const SimpleVertex *const *points, int size, u32 vertType) {
 	bool hasColor = (vertType & GE_VTYPE_COL_MASK) != 0;
 	bool hasTexCoord = (vertType & GE_VTYPE_TC_MASK) != 0;
@@ -127,6 +127,10 @@ class DrawEngineCommon {
 	bool CanUseHardwareTransform(int prim) const;
 	bool CanUseHardwareTessellation(GEPatchPrimType prim) const;
 
+	// Returns true if a change to cmd can't affect how the queued draws render, because the feature
+	// it configures is disabled. Skipping the flush then lets draws on both sides of the change merge.
+	static bool IsStateChangeIgnored(u8 cmd);
+
 	std::vector<std::string> DebugGetVertexLoaderIDs();
 	std::string DebugGetVertexLoaderString(std::string id, DebugShaderStringType stringType);
 
@@ -20,8 +20,37 @@
 #include "ppsspp_config.h"
 
 #include "Common/Math/SIMDHeaders.h"
+#include "Common/Math/CrossSIMD.h"
 #include "GPU/Common/IndexGenerator.h"
 
+#if !defined(CROSSSIMD_SLOW) && COMMON_LITTLE_ENDIAN
+#define INDEXGEN_SIMD 1
+
+// Loads eight indices of any size as u16. Like the scalar paths, 32-bit indices are truncated.
+static inline Vec8U16 LoadIndices8(const u8 *inds) { return Vec8U16::LoadU8(inds); }
+static inline Vec8U16 LoadIndices8(const u16_le *inds) { return Vec8U16::Load(inds); }
+static inline Vec8U16 LoadIndices8(const u32_le *inds) { return Vec8U16::LoadTruncateU32(inds); }
+
+alignas(16) static const u16 evenLanes[8] = { 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0 };
+alignas(16) static const u16 laneIndex[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+#endif
+
+// Adds the offset to a run of indices. Points, line lists, rectangles and clockwise
+// triangle lists all boil down to this.
+template <class ITypeLE>
+static inline u16 *TranslateIndices(u16 *outInds, int count, const ITypeLE *inds, int indexOffset) {
+	int i = 0;
+#ifdef INDEXGEN_SIMD
+	const Vec8U16 offset = Vec8U16::Splat((u16)indexOffset);
+	for (; i + 8 <= count; i += 8) {
+		(LoadIndices8(inds + i) + offset).Store(outInds + i);
+	}
+#endif
+	for (; i < count; i++)
+		outInds[i] = indexOffset + inds[i];
+	return outInds + count;
+}
+
 // Points don't need indexing...
 const u8 IndexGenerator::indexedPrimitiveType[7] = {
 	GE_PRIM_POINTS,
@@ -178,13 +207,26 @@ void IndexGenerator::AddStrip(int numVerts, int indexOffset, bool clockwise) {
 #endif
 }
 
-// God of War uses this for text. Otherwise rare, not much reason to optimize.
+// God of War uses this for text, and some games tessellate with large fans.
 void IndexGenerator::AddFan(int numVerts, int indexOffset, bool clockwise) {
 	const int numTris = numVerts - 2;
 	u16 *outInds = inds_;
+	int i = 0;
+#ifdef INDEXGEN_SIMD
+	const Vec8U16 first = Vec8U16::Splat((u16)indexOffset);
+	const Vec8U16 one = Vec8U16::Splat(1);
+	const Vec8U16 eight = Vec8U16::Splat(8);
+	Vec8U16 next = Vec8U16::Load(laneIndex) + first + one;
+	for (; i + 8 <= numTris; i += 8) {
+		const Vec8U16 last = next + one;
+		StoreInterleaved3(outInds, first, clockwise ? next : last, clockwise ? last : next);
+		next = next + eight;
+		outInds += 24;
+	}
+#endif
 	const int v1 = clockwise ? 1 : 2;
 	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numTris; i++) {
+	for (; i < numTris; i++) {
 		*outInds++ = indexOffset;
 		*outInds++ = indexOffset + i + v1;
 		*outInds++ = indexOffset + i + v2;
@@ -226,21 +268,16 @@ void IndexGenerator::AddRectangles(int numVerts, int indexOffset) {
 
 template <class ITypeLE>
 void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int indexOffset) {
-	u16 *outInds = inds_;
-	for (int i = 0; i < numInds; i++)
-		*outInds++ = indexOffset + inds[i];
-	inds_ = outInds;
+	if (numInds <= 0)
+		return;
+	inds_ = TranslateIndices(inds_, numInds, inds, indexOffset);
 }
 
 template <class ITypeLE>
 void IndexGenerator::TranslateLineList(int numInds, const ITypeLE *inds, int indexOffset) {
-	u16 *outInds = inds_;
-	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i + 1];
-	}
-	inds_ = outInds;
+	if (numInds <= 0)
+		return;
+	inds_ = TranslateIndices(inds_, numInds & ~1, inds, indexOffset);
 }
 
 template <class ITypeLE>
@@ -261,13 +298,17 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 	if (sizeof(ITypeLE) == sizeof(inds_[0]) && indexOffset == 0 && clockwise) {
 		memcpy(inds_, inds, numInds * sizeof(ITypeLE));
 		inds_ += numInds;
+	} else if (clockwise) {
+		int numTris = numInds / 3;  // Round to whole triangles
+		if (numTris > 0)
+			inds_ = TranslateIndices(inds_, numTris * 3, inds, indexOffset);
 	} else {
 		u16 *outInds = inds_;
 		int numTris = numInds / 3;  // Round to whole triangles
 		numInds = numTris * 3;
 		const int v1 = clockwise ? 1 : 2;
 		const int v2 = clockwise ? 2 : 1;
-		// TODO: This can actually be SIMD-d, although will need complex shuffles if clockwise.
+		// TODO: This can actually be SIMD-d, although will need complex shuffles.
 		for (int i = 0; i < numInds; i += 3) {
 			*outInds++ = indexOffset + inds[i];
 			*outInds++ = indexOffset + inds[i + v1];
@@ -282,7 +323,23 @@ void IndexGenerator::TranslateStrip(int numInds, const ITypeLE *inds, int indexO
 	int wind = clockwise ? 1 : 2;
 	int numTris = numInds - 2;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numTris; i++) {
+	int i = 0;
+#ifdef INDEXGEN_SIMD
+	// Eight triangles at a time. Every other triangle swaps its last two vertices.
+	// Since that's an even number, the winding for the remainder is unchanged.
+	const Vec8U16 offset = Vec8U16::Splat((u16)indexOffset);
+	const Vec8U16 even = Vec8U16::Load(evenLanes);
+	for (; i + 8 <= numTris; i += 8) {
+		const Vec8U16 v0 = LoadIndices8(inds + i) + offset;
+		const Vec8U16 v1 = LoadIndices8(inds + i + 1) + offset;
+		const Vec8U16 v2 = LoadIndices8(inds + i + 2) + offset;
+		const Vec8U16 second = (v1 & even) | v2.AndNot(even);
+		const Vec8U16 third = (v2 & even) | v1.AndNot(even);
+		StoreInterleaved3(outInds, v0, clockwise ? second : third, clockwise ? third : second);
+		outInds += 24;
+	}
+#endif
+	for (; i < numTris; i++) {
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i + wind];
 		wind ^= 3;  // Toggle between 1 and 2
@@ -296,9 +353,20 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 	if (numInds <= 0) return;
 	int numTris = numInds - 2;
 	u16 *outInds = inds_;
+	int i = 0;
+#ifdef INDEXGEN_SIMD
+	const Vec8U16 offset = Vec8U16::Splat((u16)indexOffset);
+	const Vec8U16 first = Vec8U16::Splat((u16)(indexOffset + inds[0]));
+	for (; i + 8 <= numTris; i += 8) {
+		const Vec8U16 v1 = LoadIndices8(inds + i + 1) + offset;
+		const Vec8U16 v2 = LoadIndices8(inds + i + 2) + offset;
+		StoreInterleaved3(outInds, first, clockwise ? v1 : v2, clockwise ? v2 : v1);
+		outInds += 24;
+	}
+#endif
 	const int v1 = clockwise ? 1 : 2;
 	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numTris; i++) {
+	for (; i < numTris; i++) {
 		*outInds++ = indexOffset + inds[0];
 		*outInds++ = indexOffset + inds[i + v1];
 		*outInds++ = indexOffset + inds[i + v2];
@@ -308,14 +376,10 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 
 template <class ITypeLE>
 inline void IndexGenerator::TranslateRectangles(int numInds, const ITypeLE *inds, int indexOffset) {
-	u16 *outInds = inds_;
+	if (numInds <= 0)
+		return;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
-	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i+1];
-	}
-	inds_ = outInds;
+	inds_ = TranslateIndices(inds_, numInds & ~1, inds, indexOffset);
 }
 
 // Could template this too, but would have to define in header.
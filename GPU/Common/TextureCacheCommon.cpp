@@ -18,6 +18,7 @@
 #include "ppsspp_config.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
@@ -29,6 +30,7 @@
 #include "Common/Math/SIMDHeaders.h"
 #include "Common/TimeUtil.h"
 #include "Common/Math/math_util.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Common/GPU/thin3d.h"
 #include "Core/HDRemaster.h"
 #include "Core/Config.h"
@@ -96,18 +98,15 @@ TextureCacheCommon::TextureCacheCommon(Draw::DrawContext *draw, Draw2D *draw2D)
 	// It's only possible to have 1KB of palette entries, although we allow 2KB in a hack.
 	clutBufRaw_ = (u32 *)AllocateAlignedMemory(2048, 16);
 	clutBufConverted_ = (u32 *)AllocateAlignedMemory(2048, 16);
-	// Here we need 2KB to expand a 1KB CLUT.
-	expandClut_ = (u32 *)AllocateAlignedMemory(2048, 16);
 
-	_assert_(clutBufRaw_ && clutBufConverted_ && expandClut_);
+	_assert_(clutBufRaw_ && clutBufConverted_);
 
 	// Zap so we get consistent behavior if the game fails to load some of the CLUT.
 	memset(clutBufRaw_, 0, 2048);
 	memset(clutBufConverted_, 0, 2048);
 	clutBuf_ = clutBufConverted_;
 
-	// These buffers will grow if necessary, but most won't need more than this.
-	tmpTexBuf32_.resize(512 * 512);  // 1MB
+	// This buffer will grow if necessary, but most won't need more than this.
 	tmpTexBufRearrange_.resize(512 * 512);   // 1MB
 
 	textureShaderCache_ = new TextureShaderCache(draw, draw2D_);
@@ -118,7 +117,6 @@ TextureCacheCommon::~TextureCacheCommon() {
 
 	FreeAlignedMemory(clutBufConverted_);
 	FreeAlignedMemory(clutBufRaw_);
-	FreeAlignedMemory(expandClut_);
 }
 
 void TextureCacheCommon::StartFrame() {
@@ -1718,12 +1716,15 @@ static void Expand4To8Bits(u8 *dest, const u8 *src, int srcWidth) {
 	}
 }
 
-CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags) {
-	u32 alphaSum = 0xFFFFFFFF;
-	u32 fullAlphaMask = 0x0;
+// Per thread, since big levels are decoded in parallel bands (see DecodeTextureLevel.)
+struct TexDecodeScratch {
+	AlignedVector<u32, 16> unswizzled;
+	// Here we need 2KB to expand a 1KB CLUT.
+	alignas(16) u32 expandClut[512];
+};
+static thread_local TexDecodeScratch texDecodeScratch;
 
-	bool expandTo32bit = (flags & TexDecodeFlags::EXPAND32) != 0;
-	bool reverseColors = (flags & TexDecodeFlags::REVERSE_COLORS) != 0;
+CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags) {
 	bool toClut8 = (flags & TexDecodeFlags::TO_CLUT8) != 0;
 
 	if (toClut8 && format != GE_TFMT_CLUT8 && format != GE_TFMT_CLUT4) {
@@ -1751,6 +1752,37 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 	size_t len = snprintf(buf, sizeof(buf), "Tex_%08x_%dx%d_%s", texaddr, w, h, GeTextureFormatToString(format, clutformat));
 	NotifyMemInfo(MemBlockFlags::TEXTURE, texaddr, byteSize, buf, len);
 
+	if (w * h < TEXCACHE_MIN_TEXELS_PARALLEL_DECODE || h <= TEXCACHE_DECODE_BAND_ROWS) {
+		return DecodeTextureRows(out, outPitch, format, clutformat, texaddr, texptr, level, bufw, w, h, swizzled, flags);
+	}
+
+	// Bands start on a swizzle block row (and DXT block row), so each one decodes just like a shorter
+	// texture further into memory.  Only the alpha results need combining.
+	const int bands = (h + TEXCACHE_DECODE_BAND_ROWS - 1) / TEXCACHE_DECODE_BAND_ROWS;
+	std::atomic<bool> allFull(true);
+	ParallelRangeLoop(&g_threadManager, [&](int l, int u) {
+		for (int band = l; band < u; ++band) {
+			const int y = band * TEXCACHE_DECODE_BAND_ROWS;
+			const int rows = std::min(h - y, TEXCACHE_DECODE_BAND_ROWS);
+			const u32 offset = (textureBitsPerPixel[format] * bufw * y) / 8;
+			CheckAlphaResult result = DecodeTextureRows(out + outPitch * y, outPitch, format, clutformat, texaddr + offset, texptr + offset, level, bufw, w, rows, swizzled, flags);
+			if (result != CHECKALPHA_FULL)
+				allFull = false;
+		}
+	}, 0, bands, 1);
+	return allFull ? CHECKALPHA_FULL : CHECKALPHA_ANY;
+}
+
+CheckAlphaResult TextureCacheCommon::DecodeTextureRows(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, const u8 *texptr, int level, int bufw, int w, int h, bool swizzled, TexDecodeFlags flags) {
+	u32 alphaSum = 0xFFFFFFFF;
+	u32 fullAlphaMask = 0x0;
+
+	bool expandTo32bit = (flags & TexDecodeFlags::EXPAND32) != 0;
+	bool reverseColors = (flags & TexDecodeFlags::REVERSE_COLORS) != 0;
+	bool toClut8 = (flags & TexDecodeFlags::TO_CLUT8) != 0;
+	AlignedVector<u32, 16> &tmpTexBuf32 = texDecodeScratch.unswizzled;
+	u32 *expandClut = texDecodeScratch.expandClut;
+
 	switch (format) {
 	case GE_TFMT_CLUT4:
 	{
@@ -1758,9 +1790,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 		const int clutSharingOffset = mipmapShareClut ? 0 : level * 16;
 
 		if (swizzled) {
-			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw / 2, texptr, bufw, h, 0);
-			texptr = (u8 *)tmpTexBuf32_.data();
+			tmpTexBuf32.resize(bufw * ((h + 7) & ~7));
+			UnswizzleFromMem(tmpTexBuf32.data(), bufw / 2, texptr, bufw, h, 0);
+			texptr = (u8 *)tmpTexBuf32.data();
 		}
 
 		if (toClut8) {
@@ -1798,14 +1830,14 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 					const u16 *clut = GetCurrentRawClut<u16>() + clutSharingOffset;
 					const int clutStart = gstate.getClutIndexStartPos();
 					if (gstate.getClutIndexShift() == 0 || gstate.getClutIndexMask() <= 16) {
-						ConvertFormatToRGBA8888(clutformat, expandClut_ + clutStart, clut + clutStart, 16);
+						ConvertFormatToRGBA8888(clutformat, expandClut + clutStart, clut + clutStart, 16);
 					} else {
 						// To be safe for shifts and wrap around, convert the entire CLUT.
-						ConvertFormatToRGBA8888(clutformat, expandClut_, clut, 512);
+						ConvertFormatToRGBA8888(clutformat, expandClut, clut, 512);
 					}
 					fullAlphaMask = 0xFF000000;
 					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4<u32>((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut_, &alphaSum);
+						DeIndexTexture4<u32>((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut, &alphaSum);
 					}
 				} else {
 					// If we're reversing colors, the CLUT was already reversed, no special handling needed.
@@ -1844,9 +1876,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 	case GE_TFMT_CLUT8:
 		if (toClut8) {
 			if (gstate.isTextureSwizzled()) {
-				tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-				UnswizzleFromMem(tmpTexBuf32_.data(), bufw, texptr, bufw, h, 1);
-				texptr = (u8 *)tmpTexBuf32_.data();
+				tmpTexBuf32.resize(bufw * ((h + 7) & ~7));
+				UnswizzleFromMem(tmpTexBuf32.data(), bufw, texptr, bufw, h, 1);
+				texptr = (u8 *)tmpTexBuf32.data();
 			}
 			// After deswizzling, we are in the correct format and can just copy.
 			for (int y = 0; y < h; ++y) {
@@ -1855,13 +1887,13 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 			// We can't know anything about alpha.
 			return CHECKALPHA_ANY;
 		}
-		return ReadIndexedTex(out, outPitch, level, texptr, 1, bufw, reverseColors, expandTo32bit);
+		return ReadIndexedTex(out, outPitch, level, texptr, 1, bufw, w, h, reverseColors, expandTo32bit);
 
 	case GE_TFMT_CLUT16:
-		return ReadIndexedTex(out, outPitch, level, texptr, 2, bufw, reverseColors, expandTo32bit);
+		return ReadIndexedTex(out, outPitch, level, texptr, 2, bufw, w, h, reverseColors, expandTo32bit);
 
 	case GE_TFMT_CLUT32:
-		return ReadIndexedTex(out, outPitch, level, texptr, 4, bufw, reverseColors, expandTo32bit);
+		return ReadIndexedTex(out, outPitch, level, texptr, 4, bufw, w, h, reverseColors, expandTo32bit);
 
 	case GE_TFMT_4444:
 	case GE_TFMT_5551:
@@ -1895,9 +1927,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 			}
 		}*/ else {
 			// We don't have enough space for all rows in out, so use a temp buffer.
-			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw * 2, texptr, bufw, h, 2);
-			const u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
+			tmpTexBuf32.resize(bufw * ((h + 7) & ~7));
+			UnswizzleFromMem(tmpTexBuf32.data(), bufw * 2, texptr, bufw, h, 2);
+			const u8 *unswizzled = (u8 *)tmpTexBuf32.data();
 
 			fullAlphaMask = TfmtRawToFullAlpha(format);
 			if (expandTo32bit) {
@@ -1944,9 +1976,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 				ReverseColors(out, out, format, h * outPitch / 4, useBGRA);
 			}
 		}*/ else {
-			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw * 4, texptr, bufw, h, 4);
-			const u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
+			tmpTexBuf32.resize(bufw * ((h + 7) & ~7));
+			UnswizzleFromMem(tmpTexBuf32.data(), bufw * 4, texptr, bufw, h, 4);
+			const u8 *unswizzled = (u8 *)tmpTexBuf32.data();
 
 			fullAlphaMask = TfmtRawToFullAlpha(format);
 			if (reverseColors) {
@@ -1979,14 +2011,14 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 	return AlphaSumIsFull(alphaSum, fullAlphaMask) ? CHECKALPHA_FULL : CHECKALPHA_ANY;
 }
 
-CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool reverseColors, bool expandTo32Bit) {
-	int w = gstate.getTextureWidth(level);
-	int h = gstate.getTextureHeight(level);
+CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, int w, int h, bool reverseColors, bool expandTo32Bit) {
+	AlignedVector<u32, 16> &tmpTexBuf32 = texDecodeScratch.unswizzled;
+	u32 *expandClut = texDecodeScratch.expandClut;
 
 	if (gstate.isTextureSwizzled()) {
-		tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-		UnswizzleFromMem(tmpTexBuf32_.data(), bufw * bytesPerIndex, texptr, bufw, h, bytesPerIndex);
-		texptr = (u8 *)tmpTexBuf32_.data();
+		tmpTexBuf32.resize(bufw * ((h + 7) & ~7));
+		UnswizzleFromMem(tmpTexBuf32.data(), bufw * bytesPerIndex, texptr, bufw, h, bytesPerIndex);
+		texptr = (u8 *)tmpTexBuf32.data();
 	}
 
 	// Misshitsu no Sacrifice has separate CLUT data, this is a hack to allow it.
@@ -2005,11 +2037,11 @@ CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int l
 		const int clutStart = gstate.getClutIndexStartPos();
 		if (clutStart > 256) {
 			// Access wraps around when start + index goes over.
-			ConvertFormatToRGBA8888(GEPaletteFormat(palFormat), expandClut_, clut16raw, 512);
+			ConvertFormatToRGBA8888(GEPaletteFormat(palFormat), expandClut, clut16raw, 512);
 		} else {
-			ConvertFormatToRGBA8888(GEPaletteFormat(palFormat), expandClut_ + clutStart, clut16raw + clutStart, 256);
+			ConvertFormatToRGBA8888(GEPaletteFormat(palFormat), expandClut + clutStart, clut16raw + clutStart, 256);
 		}
-		clut32 = expandClut_;
+		clut32 = expandClut;
 		palFormat = GE_CMODE_32BIT_ABGR8888;
 	}
 
@@ -46,6 +46,10 @@ enum FramebufferNotification {
 #define TEXCACHE_FRAME_CHANGE_FREQUENT_REGAIN_TRUST 33
 
 #define TEXCACHE_MAX_TEXELS_SCALED (256*256)  // Per frame
+// Levels at least this big are decoded in parallel, in bands of rows.
+#define TEXCACHE_MIN_TEXELS_PARALLEL_DECODE (256*128)
+// Must be a multiple of 8, the swizzle block height.
+#define TEXCACHE_DECODE_BAND_ROWS 32
 
 struct VirtualFramebuffer;
 class TextureReplacer;
@@ -406,9 +410,12 @@ class TextureCacheCommon {
 
 	virtual void BindAsClutTexture(Draw::Texture *tex, bool smooth) {}
 
+	// Large levels are split into bands of rows and decoded on the thread pool.
 	CheckAlphaResult DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags);
+	// Runs on worker threads, so must not touch member scratch buffers.
+	CheckAlphaResult DecodeTextureRows(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, const u8 *texptr, int level, int bufw, int w, int h, bool swizzled, TexDecodeFlags flags);
 	static void UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel);
-	CheckAlphaResult ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool reverseColors, bool expandTo32Bit);
+	CheckAlphaResult ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, int w, int h, bool reverseColors, bool expandTo32Bit);
 	ReplacedTexture *FindReplacement(TexCacheEntry *entry, int *w, int *h, int *d);
 	void PollReplacement(TexCacheEntry *entry, int *w, int *h, int *d);
 
@@ -512,7 +519,6 @@ class TextureCacheCommon {
 	};
 	std::vector<VideoInfo> videos_;
 
-	AlignedVector<u32, 16> tmpTexBuf32_;
 	AlignedVector<u32, 16> tmpTexBufRearrange_;
 
 	TexCacheEntry *nextTexture_ = nullptr;
@@ -549,8 +555,6 @@ class TextureCacheCommon {
 	bool nextNeedsRehash_;
 	bool nextNeedsChange_;
 	bool nextNeedsRebuild_;
-
-	u32 *expandClut_;
 };
 
 inline bool TexCacheEntry::Matches(u16 dim2, u8 format2, u8 maxLevel2) const {
@@ -20,6 +20,7 @@
 #include "ext/xxhash.h"
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 #include "Common/Log.h"
 #include "Common/Math/SIMDHeaders.h"
 
@@ -28,6 +29,11 @@
 
 #include "Common/Math/SIMDHeaders.h"
 
+#ifdef _M_SSE
+// For pshufb and the AVX2 variants, which are only used after checking cpu_info.
+#include <immintrin.h>
+#endif
+
 const u8 textureBitsPerPixel[16] = {
 	16,  //GE_TFMT_5650,
 	16,  //GE_TFMT_5551,
@@ -811,3 +817,326 @@ void CheckMask32(const u32 *src, int width, u32 *outMask) {
 	}
 	*outMask &= (u32)mask;
 }
+
+// CLUT4 lookups with a plain index (no shift, mask, or offset.)  These are by far the most common
+// palette textures, and a 16 entry palette fits in a byte shuffle, one per byte of the color.
+
+template <typename ClutT>
+static void DeIndexTexture4SimpleScalar(ClutT *dest, const u8 *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
+	ClutT alphaSum = (ClutT)(-1);
+	while (length >= 2) {
+		u8 index = *indexed++;
+		ClutT color0 = clut[index & 0xf];
+		ClutT color1 = clut[index >> 4];
+		*dest++ = color0;
+		*dest++ = color1;
+		alphaSum &= color0 & color1;
+		length -= 2;
+	}
+	if (length) {  // Last pixel. Can really only happen in 1xY textures, but making this work generically.
+		u8 index = *indexed++;
+		ClutT color0 = clut[index & 0xf];
+		*dest = color0;
+		alphaSum &= color0;
+	}
+	*outAlphaSum &= (u32)alphaSum;
+}
+
+#ifdef _M_SSE
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("ssse3")]]
+#endif
+static void DeIndexTexture4SimpleSSSE3(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	// Split the palette into a low byte and high byte table.
+	const __m128i clut0 = _mm_loadu_si128((const __m128i *)clut);
+	const __m128i clut1 = _mm_loadu_si128((const __m128i *)(clut + 8));
+	const __m128i lowMask = _mm_set1_epi16(0x00FF);
+	const __m128i tableLo = _mm_packus_epi16(_mm_and_si128(clut0, lowMask), _mm_and_si128(clut1, lowMask));
+	const __m128i tableHi = _mm_packus_epi16(_mm_srli_epi16(clut0, 8), _mm_srli_epi16(clut1, 8));
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+	__m128i wideMask = _mm_set1_epi32(0xFFFFFFFF);
+	while (length >= 32) {
+		const __m128i indices = _mm_loadu_si128((const __m128i *)indexed);
+		const __m128i lowNibbles = _mm_and_si128(indices, nibbleMask);
+		const __m128i highNibbles = _mm_and_si128(_mm_srli_epi16(indices, 4), nibbleMask);
+		// The low nibble is the first pixel.
+		for (int half = 0; half < 2; ++half) {
+			const __m128i n = half == 0 ? _mm_unpacklo_epi8(lowNibbles, highNibbles) : _mm_unpackhi_epi8(lowNibbles, highNibbles);
+			const __m128i lo = _mm_shuffle_epi8(tableLo, n);
+			const __m128i hi = _mm_shuffle_epi8(tableHi, n);
+			const __m128i color0 = _mm_unpacklo_epi8(lo, hi);
+			const __m128i color1 = _mm_unpackhi_epi8(lo, hi);
+			_mm_storeu_si128((__m128i *)dest, color0);
+			_mm_storeu_si128((__m128i *)(dest + 8), color1);
+			wideMask = _mm_and_si128(wideMask, _mm_and_si128(color0, color1));
+			dest += 16;
+		}
+		indexed += 16;
+		length -= 32;
+	}
+
+	u32 mask = SSEReduce16And(wideMask);
+	DeIndexTexture4SimpleScalar(dest, indexed, length, clut, &mask);
+	*outAlphaSum &= mask & 0xFFFF;
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("ssse3")]]
+#endif
+static void DeIndexTexture4SimpleSSSE3(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	// Transpose the palette into four byte planes, one table per byte of the color.
+	const __m128i byteTranspose = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	const __m128i t0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut), byteTranspose);
+	const __m128i t1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(clut + 4)), byteTranspose);
+	const __m128i t2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(clut + 8)), byteTranspose);
+	const __m128i t3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(clut + 12)), byteTranspose);
+	const __m128i t01lo = _mm_unpacklo_epi32(t0, t1);
+	const __m128i t23lo = _mm_unpacklo_epi32(t2, t3);
+	const __m128i t01hi = _mm_unpackhi_epi32(t0, t1);
+	const __m128i t23hi = _mm_unpackhi_epi32(t2, t3);
+	const __m128i table0 = _mm_unpacklo_epi64(t01lo, t23lo);
+	const __m128i table1 = _mm_unpackhi_epi64(t01lo, t23lo);
+	const __m128i table2 = _mm_unpacklo_epi64(t01hi, t23hi);
+	const __m128i table3 = _mm_unpackhi_epi64(t01hi, t23hi);
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+	__m128i wideMask = _mm_set1_epi32(0xFFFFFFFF);
+	while (length >= 32) {
+		const __m128i indices = _mm_loadu_si128((const __m128i *)indexed);
+		const __m128i lowNibbles = _mm_and_si128(indices, nibbleMask);
+		const __m128i highNibbles = _mm_and_si128(_mm_srli_epi16(indices, 4), nibbleMask);
+		for (int half = 0; half < 2; ++half) {
+			const __m128i n = half == 0 ? _mm_unpacklo_epi8(lowNibbles, highNibbles) : _mm_unpackhi_epi8(lowNibbles, highNibbles);
+			const __m128i b0 = _mm_shuffle_epi8(table0, n);
+			const __m128i b1 = _mm_shuffle_epi8(table1, n);
+			const __m128i b2 = _mm_shuffle_epi8(table2, n);
+			const __m128i b3 = _mm_shuffle_epi8(table3, n);
+			const __m128i b01lo = _mm_unpacklo_epi8(b0, b1);
+			const __m128i b23lo = _mm_unpacklo_epi8(b2, b3);
+			const __m128i b01hi = _mm_unpackhi_epi8(b0, b1);
+			const __m128i b23hi = _mm_unpackhi_epi8(b2, b3);
+			const __m128i color0 = _mm_unpacklo_epi16(b01lo, b23lo);
+			const __m128i color1 = _mm_unpackhi_epi16(b01lo, b23lo);
+			const __m128i color2 = _mm_unpacklo_epi16(b01hi, b23hi);
+			const __m128i color3 = _mm_unpackhi_epi16(b01hi, b23hi);
+			_mm_storeu_si128((__m128i *)dest, color0);
+			_mm_storeu_si128((__m128i *)(dest + 4), color1);
+			_mm_storeu_si128((__m128i *)(dest + 8), color2);
+			_mm_storeu_si128((__m128i *)(dest + 12), color3);
+			wideMask = _mm_and_si128(wideMask, _mm_and_si128(_mm_and_si128(color0, color1), _mm_and_si128(color2, color3)));
+			dest += 16;
+		}
+		indexed += 16;
+		length -= 32;
+	}
+
+	u32 mask = SSEReduce32And(wideMask);
+	DeIndexTexture4SimpleScalar(dest, indexed, length, clut, &mask);
+	*outAlphaSum &= mask;
+}
+
+// The AVX2 shuffle works per 128-bit lane, so the tables are just duplicated into both lanes.
+// Each lane takes 16 pixels, and the final permute puts them back in order.
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static void DeIndexTexture4SimpleAVX2(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	const __m128i clut0 = _mm_loadu_si128((const __m128i *)clut);
+	const __m128i clut1 = _mm_loadu_si128((const __m128i *)(clut + 8));
+	const __m128i lowMask = _mm_set1_epi16(0x00FF);
+	const __m256i tableLo = _mm256_broadcastsi128_si256(_mm_packus_epi16(_mm_and_si128(clut0, lowMask), _mm_and_si128(clut1, lowMask)));
+	const __m256i tableHi = _mm256_broadcastsi128_si256(_mm_packus_epi16(_mm_srli_epi16(clut0, 8), _mm_srli_epi16(clut1, 8)));
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+	__m256i wideMask = _mm256_set1_epi32(0xFFFFFFFF);
+	while (length >= 32) {
+		const __m128i indices = _mm_loadu_si128((const __m128i *)indexed);
+		const __m128i lowNibbles = _mm_and_si128(indices, nibbleMask);
+		const __m128i highNibbles = _mm_and_si128(_mm_srli_epi16(indices, 4), nibbleMask);
+		const __m256i n = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(lowNibbles, highNibbles)), _mm_unpackhi_epi8(lowNibbles, highNibbles), 1);
+		const __m256i lo = _mm256_shuffle_epi8(tableLo, n);
+		const __m256i hi = _mm256_shuffle_epi8(tableHi, n);
+		const __m256i colorA = _mm256_unpacklo_epi8(lo, hi);
+		const __m256i colorB = _mm256_unpackhi_epi8(lo, hi);
+		_mm256_storeu_si256((__m256i *)dest, _mm256_permute2x128_si256(colorA, colorB, 0x20));
+		_mm256_storeu_si256((__m256i *)(dest + 16), _mm256_permute2x128_si256(colorA, colorB, 0x31));
+		wideMask = _mm256_and_si256(wideMask, _mm256_and_si256(colorA, colorB));
+		dest += 32;
+		indexed += 16;
+		length -= 32;
+	}
+
+	u32 mask = SSEReduce16And(_mm_and_si128(_mm256_castsi256_si128(wideMask), _mm256_extracti128_si256(wideMask, 1)));
+	DeIndexTexture4SimpleScalar(dest, indexed, length, clut, &mask);
+	*outAlphaSum &= mask & 0xFFFF;
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static void DeIndexTexture4SimpleAVX2(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	// Same byte plane transpose as the SSSE3 path, but on both halves of the palette at once.
+	const __m256i byteTranspose = _mm256_setr_epi8(
+		0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+		0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	// Lanes: (entries 0-3, 8-11) and (entries 4-7, 12-15.)
+	const __m256i c02 = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)clut)), _mm_loadu_si128((const __m128i *)(clut + 8)), 1), byteTranspose);
+	const __m256i c13 = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(clut + 4))), _mm_loadu_si128((const __m128i *)(clut + 12)), 1), byteTranspose);
+	const __m256i tlo = _mm256_unpacklo_epi32(c02, c13);
+	const __m256i thi = _mm256_unpackhi_epi32(c02, c13);
+	const __m128i tlo0 = _mm256_castsi256_si128(tlo);
+	const __m128i tlo1 = _mm256_extracti128_si256(tlo, 1);
+	const __m128i thi0 = _mm256_castsi256_si128(thi);
+	const __m128i thi1 = _mm256_extracti128_si256(thi, 1);
+	const __m256i table0 = _mm256_broadcastsi128_si256(_mm_unpacklo_epi64(tlo0, tlo1));
+	const __m256i table1 = _mm256_broadcastsi128_si256(_mm_unpackhi_epi64(tlo0, tlo1));
+	const __m256i table2 = _mm256_broadcastsi128_si256(_mm_unpacklo_epi64(thi0, thi1));
+	const __m256i table3 = _mm256_broadcastsi128_si256(_mm_unpackhi_epi64(thi0, thi1));
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+	__m256i wideMask = _mm256_set1_epi32(0xFFFFFFFF);
+	while (length >= 32) {
+		const __m128i indices = _mm_loadu_si128((const __m128i *)indexed);
+		const __m128i lowNibbles = _mm_and_si128(indices, nibbleMask);
+		const __m128i highNibbles = _mm_and_si128(_mm_srli_epi16(indices, 4), nibbleMask);
+		const __m256i n = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(lowNibbles, highNibbles)), _mm_unpackhi_epi8(lowNibbles, highNibbles), 1);
+		const __m256i b0 = _mm256_shuffle_epi8(table0, n);
+		const __m256i b1 = _mm256_shuffle_epi8(table1, n);
+		const __m256i b2 = _mm256_shuffle_epi8(table2, n);
+		const __m256i b3 = _mm256_shuffle_epi8(table3, n);
+		const __m256i b01lo = _mm256_unpacklo_epi8(b0, b1);
+		const __m256i b23lo = _mm256_unpacklo_epi8(b2, b3);
+		const __m256i b01hi = _mm256_unpackhi_epi8(b0, b1);
+		const __m256i b23hi = _mm256_unpackhi_epi8(b2, b3);
+		// Each of these has pixels (n, n + 16) in the two lanes.
+		const __m256i color0 = _mm256_unpacklo_epi16(b01lo, b23lo);
+		const __m256i color1 = _mm256_unpackhi_epi16(b01lo, b23lo);
+		const __m256i color2 = _mm256_unpacklo_epi16(b01hi, b23hi);
+		const __m256i color3 = _mm256_unpackhi_epi16(b01hi, b23hi);
+		_mm256_storeu_si256((__m256i *)dest, _mm256_permute2x128_si256(color0, color1, 0x20));
+		_mm256_storeu_si256((__m256i *)(dest + 8), _mm256_permute2x128_si256(color2, color3, 0x20));
+		_mm256_storeu_si256((__m256i *)(dest + 16), _mm256_permute2x128_si256(color0, color1, 0x31));
+		_mm256_storeu_si256((__m256i *)(dest + 24), _mm256_permute2x128_si256(color2, color3, 0x31));
+		wideMask = _mm256_and_si256(wideMask, _mm256_and_si256(_mm256_and_si256(color0, color1), _mm256_and_si256(color2, color3)));
+		dest += 32;
+		indexed += 16;
+		length -= 32;
+	}
+
+	u32 mask = SSEReduce32And(_mm_and_si128(_mm256_castsi256_si128(wideMask), _mm256_extracti128_si256(wideMask, 1)));
+	DeIndexTexture4SimpleScalar(dest, indexed, length, clut, &mask);
+	*outAlphaSum &= mask;
+}
+
+#elif PPSSPP_ARCH(ARM_NEON)
+
+inline uint8x16_t NEONLookup16(uint8x16_t table, uint8x16_t indices) {
+#if PPSSPP_ARCH(ARM64_NEON)
+	return vqtbl1q_u8(table, indices);
+#else
+	uint8x8x2_t table2 = { { vget_low_u8(table), vget_high_u8(table) } };
+	return vcombine_u8(vtbl2_u8(table2, vget_low_u8(indices)), vtbl2_u8(table2, vget_high_u8(indices)));
+#endif
+}
+
+static void DeIndexTexture4SimpleNEON(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	// De-interleaving gives us the low and high byte tables directly.
+	const uint8x16x2_t tables = vld2q_u8((const u8 *)clut);
+	const uint8x16_t nibbleMask = vdupq_n_u8(0x0F);
+
+	// The alpha mask is just an AND, so we can reduce each byte plane separately.
+	uint8x16_t lowMask = vdupq_n_u8(0xFF);
+	uint8x16_t highMask = vdupq_n_u8(0xFF);
+	while (length >= 32) {
+		const uint8x16_t indices = vld1q_u8(indexed);
+		// The low nibble is the first pixel.
+		const uint8x16x2_t n = vzipq_u8(vandq_u8(indices, nibbleMask), vshrq_n_u8(indices, 4));
+		for (int half = 0; half < 2; ++half) {
+			uint8x16x2_t color;
+			color.val[0] = NEONLookup16(tables.val[0], n.val[half]);
+			color.val[1] = NEONLookup16(tables.val[1], n.val[half]);
+			vst2q_u8((u8 *)dest, color);
+			lowMask = vandq_u8(lowMask, color.val[0]);
+			highMask = vandq_u8(highMask, color.val[1]);
+			dest += 16;
+		}
+		indexed += 16;
+		length -= 32;
+	}
+
+	const uint8x16x2_t planes = vzipq_u8(lowMask, highMask);
+	u32 mask = NEONReduce16And(vandq_u16(vreinterpretq_u16_u8(planes.val[0]), vreinterpretq_u16_u8(planes.val[1])));
+	DeIndexTexture4SimpleScalar(dest, indexed, length, clut, &mask);
+	*outAlphaSum &= mask & 0xFFFF;
+}
+
+static void DeIndexTexture4SimpleNEON(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	const uint8x16x4_t tables = vld4q_u8((const u8 *)clut);
+	const uint8x16_t nibbleMask = vdupq_n_u8(0x0F);
+
+	// Like the 16-bit version, reduce the alpha mask per byte plane.
+	uint8x16_t byteMask[4] = { vdupq_n_u8(0xFF), vdupq_n_u8(0xFF), vdupq_n_u8(0xFF), vdupq_n_u8(0xFF) };
+	while (length >= 32) {
+		const uint8x16_t indices = vld1q_u8(indexed);
+		const uint8x16x2_t n = vzipq_u8(vandq_u8(indices, nibbleMask), vshrq_n_u8(indices, 4));
+		for (int half = 0; half < 2; ++half) {
+			uint8x16x4_t color;
+			for (int b = 0; b < 4; ++b) {
+				color.val[b] = NEONLookup16(tables.val[b], n.val[half]);
+				byteMask[b] = vandq_u8(byteMask[b], color.val[b]);
+			}
+			vst4q_u8((u8 *)dest, color);
+			dest += 16;
+		}
+		indexed += 16;
+		length -= 32;
+	}
+
+	// Interleave the byte planes back into colors to finish the reduction.
+	u32 mask = 0xFFFFFFFF;
+	alignas(16) u32 masks[16];
+	uint8x16x4_t planes = { { byteMask[0], byteMask[1], byteMask[2], byteMask[3] } };
+	vst4q_u8((u8 *)masks, planes);
+	for (int i = 0; i < 16; ++i)
+		mask &= masks[i];
+	DeIndexTexture4SimpleScalar(dest, indexed, length, clut, &mask);
+	*outAlphaSum &= mask;
+}
+
+#endif
+
+void DeIndexTexture4Simple(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+#ifdef _M_SSE
+	if (cpu_info.bAVX2) {
+		DeIndexTexture4SimpleAVX2(dest, indexed, length, clut, outAlphaSum);
+		return;
+	}
+	if (cpu_info.bSSSE3) {
+		DeIndexTexture4SimpleSSSE3(dest, indexed, length, clut, outAlphaSum);
+		return;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	DeIndexTexture4SimpleNEON(dest, indexed, length, clut, outAlphaSum);
+	return;
+#endif
+	DeIndexTexture4SimpleScalar(dest, indexed, length, clut, outAlphaSum);
+}
+
+void DeIndexTexture4Simple(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+#ifdef _M_SSE
+	if (cpu_info.bAVX2) {
+		DeIndexTexture4SimpleAVX2(dest, indexed, length, clut, outAlphaSum);
+		return;
+	}
+	if (cpu_info.bSSSE3) {
+		DeIndexTexture4SimpleSSSE3(dest, indexed, length, clut, outAlphaSum);
+		return;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	DeIndexTexture4SimpleNEON(dest, indexed, length, clut, outAlphaSum);
+	return;
+#endif
+	DeIndexTexture4SimpleScalar(dest, indexed, length, clut, outAlphaSum);
+}
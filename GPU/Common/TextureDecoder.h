@@ -144,44 +144,33 @@ inline void DeIndexTexture(/*WRITEONLY*/ ClutT *dest, const u32 texaddr, int len
 	DeIndexTexture(dest, indexed, length, clut, outAlphaSum);
 }
 
+// CLUT4 with a plain index, the common case. Uses SIMD shuffles where available (picked at runtime on x86.)
+void DeIndexTexture4Simple(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum);
+void DeIndexTexture4Simple(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum);
+
 template <typename ClutT>
 inline void DeIndexTexture4(/*WRITEONLY*/ ClutT *dest, const u8 *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
 	// Usually, there is no special offset, mask, or shift.
-	const bool nakedIndex = gstate.isClutIndexSimple();
+	if (gstate.isClutIndexSimple()) {
+		DeIndexTexture4Simple(dest, indexed, length, clut, outAlphaSum);
+		return;
+	}
 
 	ClutT alphaSum = (ClutT)(-1);
-	if (nakedIndex) {
-		while (length >= 2) {
-			u8 index = *indexed++;
-			ClutT color0 = clut[index & 0xf];
-			ClutT color1 = clut[index >> 4];
-			*dest++ = color0;
-			*dest++ = color1;
-			alphaSum &= color0 & color1;
-			length -= 2;
-		}
-		if (length) {  // Last pixel. Can really only happen in 1xY textures, but making this work generically.
-			u8 index = *indexed++;
-			ClutT color0 = clut[index & 0xf];
-			*dest = color0;
-			alphaSum &= color0;
-		}
-	} else {
-		while (length >= 2) {
-			u8 index = *indexed++;
-			ClutT color0 = clut[gstate.transformClutIndex((index >> 0) & 0xf)];
-			ClutT color1 = clut[gstate.transformClutIndex((index >> 4) & 0xf)];
-			*dest++ = color0;
-			*dest++ = color1;
-			alphaSum &= color0 & color1;
-			length -= 2;
-		}
-		if (length) {
-			u8 index = *indexed++;
-			ClutT color0 = clut[gstate.transformClutIndex((index >> 0) & 0xf)];
-			*dest = color0;
-			alphaSum &= color0;
-		}
+	while (length >= 2) {
+		u8 index = *indexed++;
+		ClutT color0 = clut[gstate.transformClutIndex((index >> 0) & 0xf)];
+		ClutT color1 = clut[gstate.transformClutIndex((index >> 4) & 0xf)];
+		*dest++ = color0;
+		*dest++ = color1;
+		alphaSum &= color0 & color1;
+		length -= 2;
+	}
+	if (length) {
+		u8 index = *indexed++;
+		ClutT color0 = clut[gstate.transformClutIndex((index >> 0) & 0xf)];
+		*dest = color0;
+		alphaSum &= color0;
 	}
 
 	*outAlphaSum &= (u32)alphaSum;
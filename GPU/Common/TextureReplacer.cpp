@@ -53,6 +53,9 @@ TextureReplacer::TextureReplacer(Draw::DrawContext *draw) {
 		basist::basisu_transcoder_init();
 		basisu_initialized = true;
 	}
+	// No draw context in the unit tests, they don't replace anything.
+	if (!draw)
+		return;
 	// We don't want to keep the draw object around, so extract the info we need.
 	if (draw->GetDataFormatSupport(Draw::DataFormat::BC3_UNORM_BLOCK)) formatSupport_.bc123 = true;
 	if (draw->GetDataFormatSupport(Draw::DataFormat::ASTC_4x4_UNORM_BLOCK)) formatSupport_.astc = true;
@@ -875,17 +875,34 @@ static u32 LoadReplay(const std::string &filename) {
 		System_SetWindowTitle("(GE frame dump: old format, missing DISC_ID)");
 	}
 
-	u32 sz = 0;
-	pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz));
-	u32 bufsz = 0;
-	pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
-
-	lastExecCommands.resize(sz);
-	lastExecPushbuf.resize(bufsz);
+	lastExecCommands.clear();
+	lastExecPushbuf.clear();
 
 	bool truncated = false;
-	truncated = truncated || !ReadCompressed(fp, lastExecCommands.data(), sizeof(Command) * sz, header.version);
-	truncated = truncated || !ReadCompressed(fp, lastExecPushbuf.data(), bufsz, header.version);
+	bool firstChunk = true;
+	while (!truncated) {
+		u32 sz = 0;
+		if (pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz)) != sizeof(sz)) {
+			// Streamed dumps just end after the last chunk.
+			truncated = firstChunk;
+			break;
+		}
+		u32 bufsz = 0;
+		pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
+
+		// Each chunk appends to the same buffers, and pushbuf positions are relative to the first.
+		size_t commandsPos = lastExecCommands.size();
+		size_t pushbufPos = lastExecPushbuf.size();
+		lastExecCommands.resize(commandsPos + sz);
+		lastExecPushbuf.resize(pushbufPos + bufsz);
+
+		truncated = truncated || !ReadCompressed(fp, lastExecCommands.data() + commandsPos, sizeof(Command) * sz, header.version);
+		truncated = truncated || !ReadCompressed(fp, lastExecPushbuf.data() + pushbufPos, bufsz, header.version);
+
+		firstChunk = false;
+		if (header.version < 7)
+			break;
+	}
 
 	pspFileSystem.CloseFile(fp);
 
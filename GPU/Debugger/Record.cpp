@@ -28,6 +28,7 @@
 #include "Common/File/FileUtil.h"
 #include "Common/Thread/ThreadManager.h"
 #include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
 #include "Common/System/System.h"
@@ -45,22 +46,56 @@
 #include "GPU/Common/VertexDecoderCommon.h"
 #include "GPU/Debugger/Record.h"
 #include "GPU/Debugger/RecordFormat.h"
+#include "ext/xxhash.h"
 
 namespace GPURecord {
 
+// How many finished chunks may wait for the writer thread before recording blocks.
+static const size_t MAX_STREAM_QUEUE = 4;
+// Positions in the pushbuf are 32-bit, so stop streaming well before they could wrap.
+static const u32 MAX_STREAM_PUSHBUF = 0xC0000000;
+// How much already written data to keep around for deduplication.  Past this, we start over.
+static const size_t MAX_STREAM_INDEX_BYTES = 128 * 1024 * 1024;
+
+Recorder::~Recorder() {
+	if (streamThread.joinable())
+		FinishStream();
+}
+
 void Recorder::FlushRegisters() {
 	if (!lastRegisters.empty()) {
 		Command last{ CommandType::REGISTERS };
-		last.ptr = (u32)pushbuf.size();
 		last.sz = (u32)(lastRegisters.size() * sizeof(u32));
-		pushbuf.resize(pushbuf.size() + last.sz);
-		memcpy(pushbuf.data() + last.ptr, lastRegisters.data(), last.sz);
+		last.ptr = AppendPushbuf(lastRegisters.data(), last.sz, 1);
 		lastRegisters.clear();
 
 		commands.push_back(last);
 	}
 }
 
+// Returns the position of the data within the whole recording (which may include already streamed chunks.)
+u32 Recorder::AppendPushbuf(const void *p, u32 sz, u32 align) {
+	u32 pos = (u32)pushbuf.size();
+	u32 pad = 0;
+	if ((pushbufBase + pos) & (align - 1)) {
+		pad = align - ((pushbufBase + pos) & (align - 1));
+	}
+	pushbuf.resize(pos + pad + sz);
+	if (pad) {
+		memset(pushbuf.data() + pos, 0, pad);
+	}
+	memcpy(pushbuf.data() + pos + pad, p, sz);
+	return pushbufBase + pos + pad;
+}
+
+Command Recorder::EmitCommandWithData(CommandType t, const void *p, u32 sz) {
+	FlushRegisters();
+
+	Command cmd{ t, sz, AppendPushbuf(p, sz, 1) };
+	commands.push_back(cmd);
+	return cmd;
+}
+
 static Path GenRecordingFilename() {
 	const Path dumpDir = GetSysDirectory(DIRECTORY_DUMP);
 
@@ -128,6 +163,13 @@ void Recorder::DirtyDrawnVRAM() {
 bool Recorder::BeginRecording() {
 	if (PSP_CoreParameter().fileType == IdentifiedFileType::PPSSPP_GE_DUMP) {
 		// Can't record a GE dump.
+		nextFrame = false;
+		streamMode = false;
+		return false;
+	}
+	if (streamMode && !BeginStream()) {
+		nextFrame = false;
+		streamMode = false;
 		return false;
 	}
 
@@ -138,22 +180,17 @@ bool Recorder::BeginRecording() {
 	flipLastAction = gpuStats.numFlips;
 	flipFinishAt = -1;
 
-	u32 ptr = (u32)pushbuf.size();
-	u32 sz = 512 * 4;
-	pushbuf.resize(pushbuf.size() + sz);
-	gstate.Save((u32_le *)(pushbuf.data() + ptr));
-	commands.push_back({ CommandType::INIT, sz, ptr });
+	u32_le initState[512];
+	gstate.Save(initState);
+	EmitCommandWithData(CommandType::INIT, initState, sizeof(initState));
 	lastVRAM.resize(2 * 1024 * 1024);
 
 	// Also save the initial CLUT.
 	GPUDebugBuffer clut;
 	if (gpuDebug->GetCurrentClut(clut)) {
-		sz = clut.GetStride() * clut.PixelSize();
+		u32 sz = clut.GetStride() * clut.PixelSize();
 		_assert_msg_(sz == 1024, "CLUT should be 1024 bytes");
-		ptr = (u32)pushbuf.size();
-		pushbuf.resize(pushbuf.size() + sz);
-		memcpy(pushbuf.data() + ptr, clut.GetData(), sz);
-		commands.push_back({ CommandType::CLUT, sz, ptr });
+		EmitCommandWithData(CommandType::CLUT, clut.GetData(), sz);
 	}
 
 	DirtyAllVRAM(DirtyVRAMFlag::DIRTY);
@@ -172,20 +209,15 @@ static void WriteCompressed(FILE *fp, const void *p, size_t sz) {
 	delete[] compressed;
 }
 
-Path Recorder::WriteRecording() {
-	FlushRegisters();
-
-	const Path filename = GenRecordingFilename();
-
-	NOTICE_LOG(Log::G3D, "Recording filename: %s", filename.c_str());
-
-	FILE *fp = File::OpenCFile(filename, "wb");
+static void WriteHeader(FILE *fp) {
 	Header header{};
 	memcpy(header.magic, HEADER_MAGIC, sizeof(header.magic));
 	header.version = VERSION;
 	strncpy(header.gameID, g_paramSFO.GetDiscID().c_str(), sizeof(header.gameID));
 	fwrite(&header, sizeof(header), 1, fp);
+}
 
+static void WriteChunk(FILE *fp, const std::vector<Command> &commands, const std::vector<u8> &pushbuf) {
 	u32 sz = (u32)commands.size();
 	fwrite(&sz, sizeof(sz), 1, fp);
 	u32 bufsz = (u32)pushbuf.size();
@@ -193,12 +225,117 @@ Path Recorder::WriteRecording() {
 
 	WriteCompressed(fp, commands.data(), commands.size() * sizeof(Command));
 	WriteCompressed(fp, pushbuf.data(), bufsz);
+}
 
+Path Recorder::WriteRecording() {
+	FlushRegisters();
+
+	const Path filename = GenRecordingFilename();
+
+	NOTICE_LOG(Log::G3D, "Recording filename: %s", filename.c_str());
+
+	FILE *fp = File::OpenCFile(filename, "wb");
+	WriteHeader(fp);
+	WriteChunk(fp, commands, pushbuf);
 	fclose(fp);
 
 	return filename;
 }
 
+bool Recorder::BeginStream() {
+	streamFilename = GenRecordingFilename();
+	streamFile = File::OpenCFile(streamFilename, "wb");
+	if (!streamFile) {
+		ERROR_LOG(Log::G3D, "Unable to open %s for streaming GE dump", streamFilename.c_str());
+		return false;
+	}
+
+	NOTICE_LOG(Log::G3D, "Streaming recording to: %s", streamFilename.c_str());
+	WriteHeader(streamFile);
+
+	pushbufBase = 0;
+	streamFrames = 0;
+	streamIndex.clear();
+	streamIndexBytes = 0;
+	streamQueue.clear();
+	streamQueueDone = false;
+	streamThread = std::thread([this]() {
+		StreamThreadFunc();
+	});
+	return true;
+}
+
+void Recorder::StreamThreadFunc() {
+	SetCurrentThreadName("GERecordStream");
+
+	std::unique_lock<std::mutex> guard(streamLock);
+	while (true) {
+		streamCond.wait(guard, [this]() { return !streamQueue.empty() || streamQueueDone; });
+		if (streamQueue.empty())
+			break;
+
+		StreamChunk chunk = std::move(streamQueue.front());
+		streamQueue.pop_front();
+		// Let the emu thread continue recording while we compress.
+		streamCond.notify_all();
+
+		guard.unlock();
+		WriteChunk(streamFile, chunk.commands, chunk.pushbuf);
+		guard.lock();
+	}
+}
+
+void Recorder::FlushStreamChunk() {
+	FlushRegisters();
+	if (commands.empty() && pushbuf.empty())
+		return;
+
+	StreamChunk chunk;
+	chunk.commands.swap(commands);
+	chunk.pushbuf.swap(pushbuf);
+	pushbufBase += (u32)chunk.pushbuf.size();
+
+	std::unique_lock<std::mutex> guard(streamLock);
+	// If writing falls behind, wait rather than letting memory grow.
+	streamCond.wait(guard, [this]() { return streamQueue.size() < MAX_STREAM_QUEUE; });
+	streamQueue.push_back(std::move(chunk));
+	streamCond.notify_all();
+}
+
+void Recorder::FinishStream() {
+	FlushStreamChunk();
+
+	{
+		std::lock_guard<std::mutex> guard(streamLock);
+		streamQueueDone = true;
+		streamCond.notify_all();
+	}
+	streamThread.join();
+
+	fclose(streamFile);
+	streamFile = nullptr;
+	streamIndex.clear();
+	streamIndexBytes = 0;
+	pushbufBase = 0;
+	streamMode = false;
+}
+
+// Returns true if the recording should end with this frame.
+bool Recorder::FrameComplete() {
+	if (!streamMode)
+		return true;
+
+	FlushStreamChunk();
+	streamFrames++;
+	flipLastAction = gpuStats.numFlips;
+
+	if (pushbufBase >= MAX_STREAM_PUSHBUF) {
+		WARN_LOG(Log::G3D, "Streaming GE dump too large, stopping after %d frames", streamFrames);
+		return true;
+	}
+	return streamStopRequested || (streamMaxFrames > 0 && streamFrames >= streamMaxFrames);
+}
+
 static void GetVertDataSizes(int vcount, const void *indices, u32 &vbytes, u32 &ibytes) {
 	VertexDecoder vdec;
 	VertexDecoderOptions opts{};
@@ -277,7 +414,26 @@ Command Recorder::EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 a
 
 	Command cmd{ t, sz, 0 };
 
-	if (sz) {
+	if (sz && streamMode) {
+		// Earlier chunks have already been written out, so find duplicates by hash instead.
+		u64 hash = XXH3_64bits_withSeed(p, sz, sz);
+		auto it = streamIndex.find(hash);
+		// Check the actual bytes too, a collision would silently corrupt the dump.
+		if (it != streamIndex.end() && (it->second.ptr & (align - 1)) == 0 && it->second.data.size() == sz && memcmp(it->second.data.data(), p, sz) == 0) {
+			cmd.ptr = it->second.ptr;
+		} else {
+			cmd.ptr = AppendPushbuf(p, sz, align);
+			if (streamIndexBytes + sz > MAX_STREAM_INDEX_BYTES) {
+				streamIndex.clear();
+				streamIndexBytes = 0;
+			}
+			StreamIndexEntry &entry = streamIndex[hash];
+			streamIndexBytes -= entry.data.size();
+			entry.ptr = cmd.ptr;
+			entry.data.assign((const u8 *)p, (const u8 *)p + sz);
+			streamIndexBytes += sz;
+		}
+	} else if (sz) {
 		// If at all possible, try to find it already in the buffer.
 		const u8 *prev = nullptr;
 		const size_t NEAR_WINDOW = std::max((int)sz * 2, 1024 * 10);
@@ -292,17 +448,7 @@ Command Recorder::EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 a
 		if (prev) {
 			cmd.ptr = (u32)(prev - pushbuf.data());
 		} else {
-			cmd.ptr = (u32)pushbuf.size();
-			int pad = 0;
-			if (cmd.ptr & (align - 1)) {
-				pad = align - (cmd.ptr & (align - 1));
-				cmd.ptr += pad;
-			}
-			pushbuf.resize(pushbuf.size() + sz + pad);
-			if (pad) {
-				memset(pushbuf.data() + cmd.ptr - pad, 0, pad);
-			}
-			memcpy(pushbuf.data() + cmd.ptr, p, sz);
+			cmd.ptr = AppendPushbuf(p, sz, align);
 		}
 	}
 
@@ -426,7 +572,10 @@ void Recorder::EmitTextureData(int level, u32 texaddr) {
 		bytes += (u32)sizeof(framebuf);
 	}
 
-	if (bytes > 0) {
+	if (bytes > 0 && streamMode) {
+		// EmitCommandWithRAM() already deduplicates by hash.
+		EmitCommandWithRAM(type, p, bytes, 16);
+	} else if (bytes > 0) {
 		FlushRegisters();
 
 		// Dumps are huge - let's try to find this already emitted.
@@ -541,12 +690,7 @@ void Recorder::EmitClut(u32 op) {
 			};
 			u32 flags = GetTargetFlags(addr, bytes);
 			ClutAddrData data{ addr, flags };
-
-			FlushRegisters();
-			Command cmd{ CommandType::CLUTADDR, sizeof(data), (u32)pushbuf.size() };
-			pushbuf.resize(pushbuf.size() + sizeof(data));
-			memcpy(pushbuf.data() + cmd.ptr, &data, sizeof(data));
-			commands.push_back(cmd);
+			EmitCommandWithData(CommandType::CLUTADDR, &data, sizeof(data));
 
 			if ((flags & 2) == 0)
 				UpdateLastVRAM(addr, bytes);
@@ -574,7 +718,8 @@ void Recorder::EmitBezierSpline(u32 op) {
 }
 
 bool Recorder::RecordNextFrame(const std::function<void(const Path &)> callback) {
-	if (!nextFrame) {
+	if (!nextFrame && !IsStreaming()) {
+		streamMode = false;
 		flipLastAction = gpuStats.numFlips;
 		flipFinishAt = -1;
 		writeCallback = callback;
@@ -584,13 +729,34 @@ bool Recorder::RecordNextFrame(const std::function<void(const Path &)> callback)
 	return false;
 }
 
+bool Recorder::RecordStream(int maxFrames, const std::function<void(const Path &)> callback) {
+	if (IsActivePending())
+		return false;
+
+	flipLastAction = gpuStats.numFlips;
+	flipFinishAt = -1;
+	writeCallback = callback;
+	streamMode = true;
+	streamMaxFrames = maxFrames;
+	streamStopRequested = false;
+	nextFrame = true;
+	return true;
+}
+
 void Recorder::FinishRecording() {
 	// We're done - this was just to write the result out.
 	if (!active) {
 		return;
 	}
 
-	Path filename = WriteRecording();
+	Path filename;
+	if (streamMode) {
+		filename = streamFilename;
+		FinishStream();
+		NOTICE_LOG(Log::System, "Streamed %d frames", streamFrames);
+	} else {
+		filename = WriteRecording();
+	}
 	commands.clear();
 	pushbuf.clear();
 	lastVRAM.clear();
@@ -616,11 +782,7 @@ void Recorder::CheckEdramTrans() {
 		return;
 	lastEdramTrans = value;
 
-	FlushRegisters();
-	Command cmd{ CommandType::EDRAMTRANS, sizeof(value), (u32)pushbuf.size() };
-	pushbuf.resize(pushbuf.size() + sizeof(value));
-	memcpy(pushbuf.data() + cmd.ptr, &value, sizeof(value));
-	commands.push_back(cmd);
+	EmitCommandWithData(CommandType::EDRAMTRANS, &value, sizeof(value));
 }
 
 void Recorder::NotifyCommand(u32 pc) {
@@ -684,11 +846,7 @@ void Recorder::NotifyMemcpy(u32 dest, u32 src, u32 sz) {
 
 	CheckEdramTrans();
 	if (Memory::IsVRAMAddress(dest)) {
-		FlushRegisters();
-		Command cmd{ CommandType::MEMCPYDEST, sizeof(dest), (u32)pushbuf.size() };
-		pushbuf.resize(pushbuf.size() + sizeof(dest));
-		memcpy(pushbuf.data() + cmd.ptr, &dest, sizeof(dest));
-		commands.push_back(cmd);
+		EmitCommandWithData(CommandType::MEMCPYDEST, &dest, sizeof(dest));
 
 		sz = Memory::ValidSize(dest, sz);
 		if (sz != 0) {
@@ -714,12 +872,7 @@ void Recorder::NotifyMemset(u32 dest, int v, u32 sz) {
 	if (Memory::IsVRAMAddress(dest)) {
 		sz = Memory::ValidSize(dest, sz);
 		MemsetCommand data{ dest, v, sz };
-
-		FlushRegisters();
-		Command cmd{ CommandType::MEMSET, sizeof(data), (u32)pushbuf.size() };
-		pushbuf.resize(pushbuf.size() + sizeof(data));
-		memcpy(pushbuf.data() + cmd.ptr, &data, sizeof(data));
-		commands.push_back(cmd);
+		EmitCommandWithData(CommandType::MEMSET, &data, sizeof(data));
 		ClearLastVRAM(dest, v, sz);
 		DirtyVRAM(dest, sz, DirtyVRAMFlag::CLEAN);
 	}
@@ -751,7 +904,8 @@ bool Recorder::HasDrawCommands() const {
 
 void Recorder::NotifyDisplay(u32 framebuf, int stride, int fmt) {
 	bool writePending = false;
-	if (active && HasDrawCommands()) {
+	// When streaming, every frame counts, even ones without draws (like loading screens and videos.)
+	if (active && (streamMode || HasDrawCommands())) {
 		writePending = true;
 	}
 	if (!active && nextFrame && (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) == 0) {
@@ -769,16 +923,9 @@ void Recorder::NotifyDisplay(u32 framebuf, int stride, int fmt) {
 	};
 
 	DisplayBufData disp{ { framebuf }, stride, fmt };
+	EmitCommandWithData(CommandType::DISPLAY, &disp, sizeof(disp));
 
-	FlushRegisters();
-	u32 ptr = (u32)pushbuf.size();
-	u32 sz = (u32)sizeof(disp);
-	pushbuf.resize(pushbuf.size() + sz);
-	memcpy(pushbuf.data() + ptr, &disp, sz);
-
-	commands.push_back({ CommandType::DISPLAY, sz, ptr });
-
-	if (writePending) {
+	if (writePending && FrameComplete()) {
 		NOTICE_LOG(Log::System, "Recording complete on display");
 		FinishRecording();
 	}
@@ -786,10 +933,21 @@ void Recorder::NotifyDisplay(u32 framebuf, int stride, int fmt) {
 
 void Recorder::NotifyBeginFrame() {
 	const bool noDisplayAction = flipLastAction + 4 < gpuStats.numFlips;
-	// We do this only to catch things that don't call NotifyDisplay.
-	if (active && HasDrawCommands() && (noDisplayAction || gpuStats.numFlips == flipFinishAt)) {
-		NOTICE_LOG(Log::System, "Recording complete on frame");
+	if (streamMode && streamStopRequested) {
+		// Stop right away, this might be a while between displays or draws.
+		if (active) {
+			NOTICE_LOG(Log::System, "Recording stopped on frame");
+			FinishRecording();
+		} else {
+			// Never got to start.
+			nextFrame = false;
+			streamMode = false;
+		}
+		return;
+	}
 
+	// We do this only to catch things that don't call NotifyDisplay.
+	if (active && (streamMode || HasDrawCommands()) && (noDisplayAction || gpuStats.numFlips == flipFinishAt)) {
 		CheckEdramTrans();
 		struct DisplayBufData {
 			PSPPointer<u8> topaddr;
@@ -798,16 +956,15 @@ void Recorder::NotifyBeginFrame() {
 
 		DisplayBufData disp;
 		__DisplayGetFramebuf(&disp.topaddr, &disp.linesize, &disp.pixelFormat, 0);
+		EmitCommandWithData(CommandType::DISPLAY, &disp, sizeof(disp));
 
-		FlushRegisters();
-		u32 ptr = (u32)pushbuf.size();
-		u32 sz = (u32)sizeof(disp);
-		pushbuf.resize(pushbuf.size() + sz);
-		memcpy(pushbuf.data() + ptr, &disp, sz);
-
-		commands.push_back({ CommandType::DISPLAY, sz, ptr });
-
-		FinishRecording();
+		if (FrameComplete()) {
+			NOTICE_LOG(Log::System, "Recording complete on frame");
+			FinishRecording();
+		} else {
+			// Keep streaming, one chunk per frame.
+			flipFinishAt = gpuStats.numFlips + 1;
+		}
 	}
 	if (!active && nextFrame && (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) == 0 && noDisplayAction) {
 		NOTICE_LOG(Log::System, "Recording starting on frame...");
@@ -19,14 +19,19 @@
 
 #include <functional>
 #include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <set>
 
 #include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
 #include "GPU/Debugger/RecordFormat.h"
 
-class Path;
-
 namespace GPURecord {
 
 constexpr uint32_t DIRTY_VRAM_SHIFT = 8;
@@ -42,6 +47,8 @@ enum class DirtyVRAMFlag : uint8_t {
 
 class Recorder {
 public:
+	~Recorder();
+
 	bool IsActive() const {
 		return active;
 	}
@@ -49,6 +56,15 @@ class Recorder {
 		return nextFrame || active;
 	}
 	bool RecordNextFrame(const std::function<void(const Path &)> callback);
+	// Records frames continuously (until StopStream or maxFrames), writing each frame out as it completes.
+	// Memory use stays bounded, since only a limited amount of data is kept around for deduplication.
+	bool RecordStream(int maxFrames, const std::function<void(const Path &)> callback);
+	void StopStream() {
+		streamStopRequested = true;
+	}
+	bool IsStreaming() const {
+		return streamMode && IsActivePending();
+	}
 	void ClearCallback() {
 		// Not super thread safe..
 		writeCallback = nullptr;
@@ -70,11 +86,19 @@ class Recorder {
 	bool BeginRecording();
 	Path WriteRecording();
 
+	bool BeginStream();
+	void FlushStreamChunk();
+	void FinishStream();
+	void StreamThreadFunc();
+	bool FrameComplete();
+
 	bool HasDrawCommands() const;
 	void CheckEdramTrans();
 	void FinishRecording();
 
 	Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 align);
+	Command EmitCommandWithData(CommandType t, const void *p, u32 sz);
+	u32 AppendPushbuf(const void *p, u32 sz, u32 align);
 
 	void UpdateLastVRAM(u32 addr, u32 bytes);
 	void ClearLastVRAM(u32 addr, u8 c, u32 bytes);
@@ -104,6 +128,35 @@ class Recorder {
 	std::vector<u8> lastVRAM;
 
 	DirtyVRAMFlag dirtyVRAM[DIRTY_VRAM_SIZE];
+
+	struct StreamChunk {
+		std::vector<Command> commands;
+		std::vector<u8> pushbuf;
+	};
+
+	// Data already in the recording, kept to check hash matches against.
+	struct StreamIndexEntry {
+		u32 ptr;
+		std::vector<u8> data;
+	};
+
+	// Streaming mode state.  The pushbuf only holds the current chunk, starting at pushbufBase.
+	// Checked from the UI thread through IsStreaming().
+	std::atomic<bool> streamMode = false;
+	std::atomic<bool> streamStopRequested = false;
+	int streamMaxFrames = 0;
+	int streamFrames = 0;
+	u32 pushbufBase = 0;
+	// Hash of data (seeded with its size) -> absolute pushbuf position and the data itself.
+	std::unordered_map<u64, StreamIndexEntry> streamIndex;
+	size_t streamIndexBytes = 0;
+	Path streamFilename;
+	FILE *streamFile = nullptr;
+	std::thread streamThread;
+	std::mutex streamLock;
+	std::condition_variable streamCond;
+	std::deque<StreamChunk> streamQueue;
+	bool streamQueueDone = false;
 };
 
 }  // namespace GPURecord
@@ -35,7 +35,8 @@ static const char * const HEADER_MAGIC = "PPSSPPGE";
 // Version 4: Expanded header with game ID
 // Version 5: Uses zstd
 // Version 6: Corrects dirty VRAM flag
-static const int VERSION = 6;
+// Version 7: May contain multiple command/pushbuf chunks (streamed recordings)
+static const int VERSION = 7;
 static const int MIN_VERSION = 2;
 
 enum class CommandType : u8 {
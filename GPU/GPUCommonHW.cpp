@@ -464,6 +464,9 @@ void GPUCommonHW::DeviceRestore(Draw::DrawContext *draw) {
 }
 
 void GPUCommonHW::UpdateCmdInfo() {
+	// Cached state segments were built against the old flags.
+	ClearStateSegments();
+
 	if (g_Config.bSoftwareSkinning) {
 		cmdInfo_[GE_CMD_VERTEXTYPE].flags &= ~FLAG_FLUSHBEFOREONCHANGE;
 		cmdInfo_[GE_CMD_VERTEXTYPE].func = &GPUCommonHW::Execute_VertexTypeSkinning;
@@ -518,7 +521,7 @@ void GPUCommonHW::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat
 
 void GPUCommonHW::CheckFlushOp(int cmd, u32 diff) {
 	const u8 cmdFlags = cmdInfo_[cmd].flags;
-	if (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE)) {
+	if (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE) && !DrawEngineCommon::IsStateChangeIgnored(cmd)) {
 		if (dumpThisFrame_) {
 			NOTICE_LOG(Log::G3D, "================ FLUSH ================");
 		}
@@ -557,11 +560,13 @@ void GPUCommonHW::DoState(PointerWrap &p) {
 
 		gstate_c.Dirty(DIRTY_TEXTURE_IMAGE);
 		framebufferManager_->DestroyAllFBOs();
+		ClearStateSegments();
 	}
 }
 
 void GPUCommonHW::ClearCacheNextFrame() {
 	textureCache_->ClearNextFrame();
+	ClearStateSegments();
 }
 
 // Needs to be called on GPU thread, not reporting thread.
@@ -779,6 +784,7 @@ void GPUCommonHW::InvalidateCache(u32 addr, int size, GPUInvalidationType type)
 		textureCache_->Invalidate(addr, size, type);
 	else
 		textureCache_->InvalidateAll(type);
+	InvalidateStateSegments(addr, size);
 
 	if (type != GPU_INVALIDATE_ALL && framebufferManager_->MayIntersectFramebufferColor(addr)) {
 		// Vempire invalidates (with writeback) after drawing, but before blitting.
@@ -833,11 +839,26 @@ void GPUCommonHW::FastRunLoop(DisplayList &list) {
 
 	const CommandInfo *cmdInfo = cmdInfo_;
 	int dc = downcount;
+	// Set after any command with an execute handler, so we only look up cached segments at the start of a run.
+	bool runStart = true;
 	for (; dc > 0; --dc) {
 		// We know that display list PCs have the upper nibble == 0 - no need to mask the pointer
 		const u32 op = *(const u32_le *)(Memory::base + list.pc);
 		const u32 cmd = op >> 24;
 		const CommandInfo &info = cmdInfo[cmd];
+		const bool plainState = (info.flags & (FLAG_EXECUTE | FLAG_EXECUTEONCHANGE)) == 0;
+		if (plainState && runStart) {
+			runStart = false;
+			int count = ApplyStateSegment(list.pc, dc);
+			if (count > 0) {
+				list.pc += count * 4;
+				// The loop decrements once more.
+				dc -= count - 1;
+				continue;
+			}
+		}
+		runStart = !plainState;
+
 		const u32 diff = op ^ gstate.cmdmem[cmd];
 		if (diff == 0) {
 			if (info.flags & FLAG_EXECUTE) {
@@ -847,7 +868,7 @@ void GPUCommonHW::FastRunLoop(DisplayList &list) {
 			}
 		} else {
 			uint64_t flags = info.flags;
-			if (flags & FLAG_FLUSHBEFOREONCHANGE) {
+			if ((flags & FLAG_FLUSHBEFOREONCHANGE) && !DrawEngineCommon::IsStateChangeIgnored(cmd)) {
 				drawEngineCommon_->Flush();
 			}
 			gstate.cmdmem[cmd] = op;
@@ -866,6 +887,139 @@ void GPUCommonHW::FastRunLoop(DisplayList &list) {
 	downcount = 0;
 }
 
+static inline int StateSegmentIndex(u32 pc) {
+	// Lists are often allocated at round addresses, so mix the bits a little.
+	return (int)(((pc >> 2) * 2654435761U) >> 24);
+}
+
+// Returns the number of ops applied, or 0 if the run at pc should be executed normally.
+int GPUCommonHW::ApplyStateSegment(u32 pc, int maxOps) {
+	StateSegment &seg = stateSegments_[StateSegmentIndex(pc)];
+	if (seg.pc != pc) {
+		// First time we see this run. Execute it normally, and remember it for the next time.
+		BuildStateSegment(seg, pc, maxOps);
+		return 0;
+	}
+
+	const int count = (int)seg.ops.size();
+	if (count == 0 || count > maxOps) {
+		return 0;
+	}
+
+	if (memcmp(Memory::base + pc, seg.ops.data(), count * sizeof(u32_le)) != 0) {
+		// The game rewrote the list in place. If it keeps doing that, stop trying.
+		int misses = seg.misses + 1;
+		if (misses >= STATE_SEGMENT_MAX_MISSES) {
+			seg.ops.clear();
+			seg.delta.clear();
+			seg.cacheable = false;
+		} else {
+			BuildStateSegment(seg, pc, maxOps);
+		}
+		seg.misses = misses;
+		return 0;
+	}
+	if (!seg.cacheable) {
+		// Still the same short run, unless what ended it became a state command too.
+		if (count < maxOps && Memory::IsValidAddress(pc + count * 4)) {
+			const u32 next = *(const u32_le *)(Memory::base + pc + count * 4);
+			if ((cmdInfo_[next >> 24].flags & (FLAG_EXECUTE | FLAG_EXECUTEONCHANGE)) == 0)
+				BuildStateSegment(seg, pc, maxOps);
+		}
+		return 0;
+	}
+
+	// Only the final value of each command matters, since nothing in the run draws.
+	// Commands that don't flush can't affect pending draws, so flushing lazily on the first
+	// change that needs it is equivalent to stepping through the run.
+	bool flushed = false;
+	uint64_t dirty = 0;
+	for (const u32 op : seg.delta) {
+		const u32 cmd = op >> 24;
+		if (op != gstate.cmdmem[cmd]) {
+			const uint64_t flags = cmdInfo_[cmd].flags;
+			if ((flags & FLAG_FLUSHBEFOREONCHANGE) && !flushed && !DrawEngineCommon::IsStateChangeIgnored(cmd)) {
+				drawEngineCommon_->Flush();
+				flushed = true;
+			}
+			gstate.cmdmem[cmd] = op;
+			dirty |= flags >> 8;
+		}
+	}
+	if (dirty)
+		gstate_c.Dirty(dirty);
+	return count;
+}
+
+void GPUCommonHW::BuildStateSegment(StateSegment &seg, u32 pc, int maxOps) {
+	const u32_le *src = (const u32_le *)(Memory::base + pc);
+	const int limit = std::min(maxOps, (int)STATE_SEGMENT_MAX_OPS);
+	int count = 0;
+	while (count < limit && Memory::IsValidAddress(pc + count * 4)) {
+		const u32 cmd = src[count] >> 24;
+		if (cmdInfo_[cmd].flags & (FLAG_EXECUTE | FLAG_EXECUTEONCHANGE))
+			break;
+		count++;
+	}
+	if (count == maxOps && count < STATE_SEGMENT_MAX_OPS) {
+		// Cut short by the stall address, the rest of the run may not be written yet.
+		return;
+	}
+
+	if (seg.pc != pc) {
+		seg.pc = pc;
+		seg.misses = 0;
+	}
+	seg.ops.assign(src, src + count);
+	seg.delta.clear();
+	// Not worth the lookup, just remember that.  The ops are still checked, so it's rebuilt if the list changes.
+	seg.cacheable = count >= STATE_SEGMENT_MIN_OPS;
+	if (!seg.cacheable)
+		return;
+
+	u8 slot[256];
+	memset(slot, 0xFF, sizeof(slot));
+	for (int i = 0; i < count; i++) {
+		const u32 op = src[i];
+		const u32 cmd = op >> 24;
+		if (slot[cmd] == 0xFF) {
+			slot[cmd] = (u8)seg.delta.size();
+			seg.delta.push_back(op);
+		} else {
+			seg.delta[slot[cmd]] = op;
+		}
+	}
+}
+
+void GPUCommonHW::InvalidateStateSegments(u32 addr, int size) {
+	if (size <= 0) {
+		ClearStateSegments();
+		return;
+	}
+	const u32 end = addr + (u32)size;
+	for (StateSegment &seg : stateSegments_) {
+		if (seg.pc == 0)
+			continue;
+		const u32 segEnd = seg.pc + std::max((u32)seg.ops.size(), 1U) * 4;
+		if (seg.pc < end && addr < segEnd) {
+			seg.pc = 0;
+			seg.cacheable = false;
+			seg.ops.clear();
+			seg.delta.clear();
+		}
+	}
+}
+
+void GPUCommonHW::ClearStateSegments() {
+	for (StateSegment &seg : stateSegments_) {
+		seg.pc = 0;
+		seg.misses = 0;
+		seg.cacheable = false;
+		seg.ops.clear();
+		seg.delta.clear();
+	}
+}
+
 void GPUCommonHW::Execute_VertexType(u32 op, u32 diff) {
 	if (diff) {
 		// TODO: We only need to dirty vshader-state here if the output format will be different.
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "GPUCommon.h"
 
 // Shared GPUCommon implementation for the HW backends.
@@ -85,6 +87,31 @@ class GPUCommonHW : public GPUCommon {
 	void CheckDepthUsage(VirtualFramebuffer *vfb) override;
 	void CheckFlushOp(int cmd, u32 diff);
 
+	// A run of plain state commands (no execute handler) from a display list, remembered by
+	// address so that lists resubmitted unchanged can apply the run as a single state delta.
+	// An entry that isn't cacheable marks a run that's too short (ops kept, to notice changes), or
+	// one that keeps changing (no ops.)
+	struct StateSegment {
+		u32 pc = 0;
+		int misses = 0;
+		bool cacheable = false;
+		std::vector<u32_le> ops;
+		std::vector<u32> delta;
+	};
+
+	int ApplyStateSegment(u32 pc, int maxOps);
+	void BuildStateSegment(StateSegment &seg, u32 pc, int maxOps);
+	void InvalidateStateSegments(u32 addr, int size);
+	void ClearStateSegments();
+
+	enum {
+		STATE_SEGMENT_CACHE_SIZE = 256,
+		STATE_SEGMENT_MIN_OPS = 8,
+		STATE_SEGMENT_MAX_OPS = 256,
+		STATE_SEGMENT_MAX_MISSES = 4,
+	};
+	StateSegment stateSegments_[STATE_SEGMENT_CACHE_SIZE];
+
 protected:
 	size_t FormatGPUStatsCommon(char *buf, size_t size);
 	void UpdateCmdInfo() override;
@@ -164,15 +164,25 @@ void DevMenuScreen::CreatePopupContents(UI::ViewGroup *parent) {
 	});
 
 	if (PSP_CoreParameter().fileType != IdentifiedFileType::PPSSPP_GE_DUMP) {
+		static const auto frameDumpCreated = [](const Path &dumpPath) {
+			NOTICE_LOG(Log::System, "Frame dump created at '%s'", dumpPath.c_str());
+			if (System_GetPropertyBool(SYSPROP_CAN_SHOW_FILE)) {
+				System_ShowFileInFolder(dumpPath);
+			} else {
+				g_OSD.Show(OSDType::MESSAGE_SUCCESS, dumpPath.ToVisualString(), 7.0f);
+			}
+		};
 		items->Add(new Choice(dev->T("Create frame dump")))->OnClick.Add([](UI::EventParams &e) {
-			gpuDebug->GetRecorder()->RecordNextFrame([](const Path &dumpPath) {
-				NOTICE_LOG(Log::System, "Frame dump created at '%s'", dumpPath.c_str());
-				if (System_GetPropertyBool(SYSPROP_CAN_SHOW_FILE)) {
-					System_ShowFileInFolder(dumpPath);
-				} else {
-					g_OSD.Show(OSDType::MESSAGE_SUCCESS, dumpPath.ToVisualString(), 7.0f);
-				}
-			});
+			gpuDebug->GetRecorder()->RecordNextFrame(frameDumpCreated);
+			return UI::EVENT_DONE;
+		});
+		items->Add(new Choice(dev->T("Start/stop streaming frame dump")))->OnClick.Add([](UI::EventParams &e) {
+			GPURecord::Recorder *recorder = gpuDebug->GetRecorder();
+			if (recorder->IsStreaming()) {
+				recorder->StopStream();
+			} else {
+				recorder->RecordStream(0, frameDumpCreated);
+			}
 			return UI::EVENT_DONE;
 		});
 	}
@@ -409,6 +419,7 @@ static const JitDisableFlag jitDisableFlags[] = {
 	{ MIPSComp::JitDisable::LSU_UNALIGNED, "LSU_UNALIGNED" },
 	{ MIPSComp::JitDisable::LSU_FPU, "LSU_FPU" },
 	{ MIPSComp::JitDisable::LSU_VFPU, "LSU_VFPU" },
+	{ MIPSComp::JitDisable::IDLE_LOOPS, "Idle loop skipping" },
 	{ MIPSComp::JitDisable::SIMD, "SIMD" },
 	{ MIPSComp::JitDisable::BLOCKLINK, "Block Linking" },
 	{ MIPSComp::JitDisable::POINTERIFY, "Pointerify" },
@@ -23,6 +23,7 @@
 #include "Common/System/OSD.h"
 #include "Common/GPU/OpenGL/GLFeatures.h"
 #include "Common/File/FileUtil.h"
+#include "Common/Log/LogManager.h"
 #include "Common/StringUtils.h"
 #include "GPU/Common/TextureReplacer.h"
 #include "GPU/Common/PostShader.h"
@@ -135,6 +136,12 @@ void DeveloperToolsScreen::CreateGeneralTab(UI::LinearLayout *list) {
 
 	list->Add(new CheckBox(&g_Config.bEnableLogging, dev->T("Enable Logging")))->OnClick.Handle(this, &DeveloperToolsScreen::OnLoggingChanged);
 	list->Add(new Choice(dev->T("Logging Channels")))->OnClick.Handle(this, &DeveloperToolsScreen::OnLogConfig);
+	static const char *asyncLogModes[] = { "Off", "Drop when full", "Wait when full" };
+	PopupMultiChoice *asyncLog = list->Add(new PopupMultiChoice(&g_Config.iAsyncLogging, dev->T("Asynchronous logging"), asyncLogModes, 0, ARRAY_SIZE(asyncLogModes), I18NCat::DEVELOPER, screenManager()));
+	asyncLog->OnChoice.Add([](UI::EventParams &e) {
+		g_logManager.SetAsyncMode((LogAsyncMode)g_Config.iAsyncLogging);
+		return UI::EVENT_DONE;
+	});
 	list->Add(new CheckBox(&g_Config.bLogFrameDrops, dev->T("Log Dropped Frame Statistics")));
 	if (GetGPUBackend() == GPUBackend::VULKAN) {
 		list->Add(new CheckBox(&g_Config.bGpuLogProfiler, dev->T("GPU log profiler")));
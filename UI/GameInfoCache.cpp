@@ -40,6 +40,7 @@
 #include "Core/SaveState.h"
 #include "Core/System.h"
 #include "Core/Loaders.h"
+#include "Core/Util/GameInfoIndex.h"
 #include "Core/Util/GameManager.h"
 #include "Core/Util/RecentFiles.h"
 #include "Core/Config.h"
@@ -110,12 +111,16 @@ bool GameInfo::Delete() {
 				// Just delete the eboot.
 				File::MoveFileToTrashOrDelete(filePath_);
 				g_recentFiles.Remove(filePath_.ToString());
+				DirectoryFileSystem::NotifyHostFilesChanged();
 				return true;
 			}
 
 			// Delete the whole tree. We better be sure, see IsReasonableEbootDirectory.
 			INFO_LOG(Log::System, "Deleting directory %s", directoryToRemove.c_str());
-			if (!File::MoveDirectoryTreeToTrashOrDelete(directoryToRemove)) {
+			bool success = File::MoveDirectoryTreeToTrashOrDelete(directoryToRemove);
+			// A game may be running, and might've already looked at this savedata.
+			DirectoryFileSystem::NotifyHostFilesChanged();
+			if (!success) {
 				ERROR_LOG(Log::System, "Failed to delete file");
 				return false;
 			}
@@ -335,6 +340,7 @@ bool GameInfo::DeleteAllSaveData() {
 			ERROR_LOG(Log::System, "Failed to delete savedata %s", saveDataDir[j].c_str());
 		}
 	}
+	DirectoryFileSystem::NotifyHostFilesChanged();
 	return true;
 }
 
@@ -501,8 +507,8 @@ static bool LoadReplacementImage(GameInfo *info, GameInfoTex *tex, const char *f
 
 class GameInfoWorkItem : public Task {
 public:
-	GameInfoWorkItem(const Path &gamePath, std::shared_ptr<GameInfo> &info, GameInfoFlags flags)
-		: gamePath_(gamePath), info_(info), flags_(flags) {}
+	GameInfoWorkItem(const Path &gamePath, std::shared_ptr<GameInfo> &info, GameInfoFlags flags, const std::shared_ptr<GameInfoIndex> &index)
+		: gamePath_(gamePath), info_(info), flags_(flags), index_(index) {}
 
 	~GameInfoWorkItem() {
 		info_->DisposeFileLoader();
@@ -525,6 +531,11 @@ class GameInfoWorkItem : public Task {
 	}
 
 	void Run() override {
+		if (index_ && LoadFromIndex()) {
+			// Had everything we wanted, no need to open the file at all.
+			return;
+		}
+
 		// An early-return will result in the destructor running, where we can set
 		// flags like working and pending.
 		if (!info_->CreateLoader() || !info_->GetFileLoader() || !info_->GetFileLoader()->Exists()) {
@@ -593,6 +604,7 @@ class GameInfoWorkItem : public Task {
 					} else if (pbp.GetSubFileSize(PBP_ICON0_PNG) > 0) {
 						std::lock_guard<std::mutex> lock(info_->lock);
 						pbp.GetSubFileAsString(PBP_ICON0_PNG, &info_->icon.data);
+						iconFromGame_ = true;
 					} else {
 						Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
 						Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
@@ -808,6 +820,7 @@ class GameInfoWorkItem : public Task {
 						// Nothing more to do
 					} else if (ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
 						info_->icon.dataLoaded = true;
+						iconFromGame_ = true;
 					} else {
 						Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
 						Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
@@ -878,6 +891,10 @@ class GameInfoWorkItem : public Task {
 			info_->gameSizeUncompressed = info_->GetSizeUncompressedInBytes();
 		}
 
+		if (index_ && (flags_ & (GameInfoFlags::PARAM_SFO | GameInfoFlags::ICON)) && GameInfoIndex::CanIndex(gamePath_, info_->fileType)) {
+			SaveToIndex();
+		}
+
 		// Time to update the flags.
 		std::unique_lock<std::mutex> lock(info_->lock);
 		info_->MarkReadyNoLock(flags_);
@@ -885,9 +902,80 @@ class GameInfoWorkItem : public Task {
 	}
 
 private:
+	// Fills in what we can from the index, and removes that from flags_.
+	// Returns true if that was everything.
+	bool LoadFromIndex() {
+		const int indexedFlags = (int)(GameInfoFlags::FILE_TYPE | GameInfoFlags::PARAM_SFO | GameInfoFlags::ICON);
+		int loaded = (int)flags_ & indexedFlags;
+		if (loaded == 0 || gamePath_.Type() != PathType::NATIVE)
+			return false;
+
+		GameInfoIndexEntry entry;
+		if (!index_->Lookup(gamePath_, &entry))
+			return false;
+
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->fileType = (IdentifiedFileType)entry.fileType;
+			info_->paramSFO.ReadSFO((const u8 *)entry.paramSFO.data(), entry.paramSFO.size());
+			info_->ParseParamSFO();
+			info_->id = entry.id;
+			info_->id_version = entry.id_version;
+			info_->region = entry.region;
+		}
+		if (flags_ & GameInfoFlags::PARAM_SFO) {
+			info_->hasConfig = g_Config.hasGameConfig(info_->id);
+		}
+
+		if (flags_ & GameInfoFlags::ICON) {
+			if (LoadReplacementImage(info_.get(), &info_->icon, "icon.png")) {
+				// Nothing more to do
+			} else if (!entry.icon.empty()) {
+				std::lock_guard<std::mutex> lock(info_->lock);
+				info_->icon.data = std::move(entry.icon);
+				info_->icon.dataLoaded = true;
+			} else {
+				// Let the full path figure out the fallback icon.
+				loaded &= ~(int)GameInfoFlags::ICON;
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(info_->lock);
+		info_->MarkReadyNoLock((GameInfoFlags)loaded);
+		flags_ = (GameInfoFlags)((int)flags_ & ~loaded);
+		return flags_ == (GameInfoFlags)0;
+	}
+
+	void SaveToIndex() {
+		GameInfoIndexEntry entry;
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			// Only set once we actually managed to read it.
+			if (!(info_->hasFlags & GameInfoFlags::PARAM_SFO))
+				return;
+
+			u8 *sfoData = nullptr;
+			size_t sfoSize = 0;
+			info_->paramSFO.WriteSFO(&sfoData, &sfoSize);
+			entry.paramSFO.assign((const char *)sfoData, sfoSize);
+			delete[] sfoData;
+
+			entry.fileType = (int)info_->fileType;
+			entry.id = info_->id;
+			entry.id_version = info_->id_version;
+			entry.region = info_->region;
+			if (iconFromGame_)
+				entry.icon = info_->icon.data;
+		}
+		index_->Update(gamePath_, std::move(entry));
+	}
+
 	Path gamePath_;
 	std::shared_ptr<GameInfo> info_;
 	GameInfoFlags flags_{};
+	std::shared_ptr<GameInfoIndex> index_;
+	// Whether the icon is the game's own ICON0.PNG, rather than a replacement or fallback.
+	bool iconFromGame_ = false;
 
 	DISALLOW_COPY_AND_ASSIGN(GameInfoWorkItem);
 };
@@ -901,10 +989,13 @@ GameInfoCache::~GameInfoCache() {
 	Shutdown();
 }
 
-void GameInfoCache::Init() {}
+void GameInfoCache::Init() {
+	index_ = std::make_shared<GameInfoIndex>();
+}
 
 void GameInfoCache::Shutdown() {
 	CancelAll();
+	index_->Save();
 }
 
 void GameInfoCache::Clear() {
@@ -1010,7 +1101,7 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 		}
 		if (wanted != (GameInfoFlags)0) {
 			// We're missing info that we want. Go get it!
-			GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info, wanted);
+			GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info, wanted, index_);
 			g_threadManager.EnqueueTask(item);
 		}
 		return info;
@@ -1023,7 +1114,7 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 	mapLock_.unlock();
 
 	// Just get all the stuff we wanted.
-	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info, wantFlags);
+	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info, wantFlags, index_);
 	g_threadManager.EnqueueTask(item);
 	return info;
 }
@@ -62,6 +62,7 @@ enum class GameInfoFlags {
 ENUM_CLASS_BITOPS(GameInfoFlags);
 
 class FileLoader;
+class GameInfoIndex;
 enum class IdentifiedFileType;
 
 struct GameInfoTex {
@@ -220,6 +221,10 @@ class GameInfoCache {
 	// and if they get destructed while being in use, that's bad.
 	std::map<std::string, std::shared_ptr<GameInfo> > info_;
 	std::mutex mapLock_;
+
+	// On-disk cache of file types, PARAM.SFOs and icons, so we don't have to open every game on startup.
+	// Shared with the work items, which can outlive us.
+	std::shared_ptr<GameInfoIndex> index_;
 };
 
 // This one can be global, no good reason not to.
@@ -658,6 +658,7 @@ void NativeInit(int argc, const char *argv[], const char *savegame_dir, const ch
 
 	if (forceLogLevel)
 		g_logManager.SetAllLogLevels(logLevel);
+	g_logManager.SetAsyncMode((LogAsyncMode)g_Config.iAsyncLogging);
 
 	PostLoadConfig();
 
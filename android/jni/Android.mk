@@ -348,6 +348,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Common/Net/NetBuffer.cpp \
   $(SRC)/Common/Net/Resolve.cpp \
   $(SRC)/Common/Net/Sinks.cpp \
+  $(SRC)/Common/Net/SocketWatcher.cpp \
   $(SRC)/Common/Net/URL.cpp \
   $(SRC)/Common/Net/WebsocketServer.cpp \
   $(SRC)/Common/Profiler/Profiler.cpp \
@@ -765,6 +766,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/Util/BlockAllocator.cpp \
   $(SRC)/Core/Util/PPGeDraw.cpp \
   $(SRC)/Core/Util/RecentFiles.cpp \
+  $(SRC)/Core/Util/GameInfoIndex.cpp \
   $(SRC)/git-version.cpp
 
 LOCAL_MODULE := ppsspp_core
@@ -993,10 +995,28 @@ ifeq ($(UNITTEST),1)
   LOCAL_MODULE := ppsspp_unittest
   LOCAL_SRC_FILES := \
     $(SRC)/unittest/JitHarness.cpp \
+    $(SRC)/unittest/HTTPHarness.cpp \
+    $(SRC)/unittest/TestIndexGenerator.cpp \
     $(SRC)/unittest/TestIRPassSimplify.cpp \
     $(SRC)/unittest/TestShaderGenerators.cpp \
     $(SRC)/unittest/TestSoftwareGPUJit.cpp \
     $(SRC)/unittest/TestThreadManager.cpp \
+    $(SRC)/unittest/TestThreadQueueList.cpp \
+    $(SRC)/unittest/TestTextureDecoder.cpp \
+    $(SRC)/unittest/TestLogManager.cpp \
+    $(SRC)/unittest/TestMemBlockInfo.cpp \
+    $(SRC)/unittest/TestAdhocServer.cpp \
+    $(SRC)/unittest/TestSocketWatcher.cpp \
+    $(SRC)/unittest/TestHTTPServer.cpp \
+    $(SRC)/unittest/TestHTTPFileLoader.cpp \
+    $(SRC)/unittest/TestBlockAllocator.cpp \
+    $(SRC)/unittest/TestGameInfoIndex.cpp \
+    $(SRC)/unittest/TestCompressedISO.cpp \
+    $(SRC)/unittest/TestTextureBandDecode.cpp \
+    $(SRC)/unittest/TestProfiler.cpp \
+    $(SRC)/unittest/TestHLEScratch.cpp \
+    $(SRC)/unittest/TestDirectoryFileSystem.cpp \
+    $(SRC)/unittest/TestMemMap.cpp \
     $(SRC)/unittest/TestVertexJit.cpp \
     $(SRC)/unittest/TestVFS.cpp \
     $(TESTARMEMITTER_FILE) \
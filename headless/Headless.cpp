@@ -41,6 +41,10 @@
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
 #include "Core/WebServer.h"
+#include "Core/Loaders.h"
+#include "Core/FileSystems/BlockDevices.h"
+#include "Core/FileLoaders/CachingFileLoader.h"
+#include "Core/FileLoaders/DiskCachingFileLoader.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/SaveState.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
@@ -150,6 +154,14 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
 	fprintf(stderr, "  --bench               run multiple times and output speed\n");
+	fprintf(stderr, "  --cache-stats         print file loader cache and prefetch counters\n");
+#ifdef USE_PROFILER
+	fprintf(stderr, "  --trace=FILE          write a Chrome trace (chrome://tracing, Perfetto) of profiled scopes\n");
+	fprintf(stderr, "  --trace-frames=A-B    only include frames A through B in the trace\n");
+#endif
+	fprintf(stderr, "  --compress=FORMAT in.iso out\n");
+	fprintf(stderr, "                        convert an image instead of running tests\n");
+	fprintf(stderr, "                        options: cso, cso2, zso\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -232,6 +244,7 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 		if (coreState == CORE_NEXTFRAME) {
 			coreState = CORE_RUNNING_CPU;
 			headlessHost->SwapBuffers();
+			PROFILE_END_FRAME();
 		}
 		if (coreState == CORE_STEPPING_CPU && !coreParameter.startBreak) {
 			break;
@@ -301,6 +314,30 @@ std::vector<std::string> ReadFromListFile(const std::string &listFilename) {
 	return testFilenames;
 }
 
+static int CompressImage(const Path &input, const Path &output, CompressedISOFormat format) {
+	std::unique_ptr<FileLoader> fileLoader(ConstructFileLoader(input));
+	std::unique_ptr<BlockDevice> blockDevice(constructBlockDevice(fileLoader.get()));
+	if (!blockDevice) {
+		fprintf(stderr, "Unable to open %s\n", input.c_str());
+		return 1;
+	}
+
+	double startTime = time_now_d();
+	std::string errorString;
+	if (!WriteCompressedISO(blockDevice.get(), output, format, &errorString)) {
+		fprintf(stderr, "Failed to write %s: %s\n", output.c_str(), errorString.c_str());
+		return 1;
+	}
+	printf("Wrote %s in %0.2f seconds\n", output.c_str(), time_now_d() - startTime);
+	return 0;
+}
+
+static void PrintCacheStats(const char *name, const FileLoaderCacheStats &stats) {
+	const double mb = 1.0 / (1024.0 * 1024.0);
+	printf("%s: %0.1f MB hit, %0.1f MB miss, %0.1f MB prefetched, %0.1f MB prefetch wasted\n", name,
+		stats.hitBytes * mb, stats.missBytes * mb, stats.prefetchBytes * mb, stats.prefetchWastedBytes * mb);
+}
+
 static void AddRecursively(std::vector<std::string> *tests, Path actualPath) {
 	// TODO: Some file systems can optimize this.
 	std::vector<File::FileInfo> fileInfo;
@@ -357,12 +394,19 @@ int main(int argc, const char* argv[])
 	int debuggerPort = -1;
 	bool oldAtrac = false;
 	bool outputDebugStringLog = false;
+	bool cacheStats = false;
+	const char *traceFilename = nullptr;
+	int traceFirstFrame = 0;
+	int traceLastFrame = std::numeric_limits<int>::max();
 
 	std::vector<std::string> testFilenames;
 	std::vector<std::string> ignoredTests;
 	const char *mountIso = nullptr;
 	const char *mountRoot = nullptr;
 	const char *screenshotFilename = nullptr;
+	const char *compressInput = nullptr;
+	const char *compressOutput = nullptr;
+	CompressedISOFormat compressFormat = CompressedISOFormat::CSO;
 
 	for (int i = 1; i < argc; i++)
 	{
@@ -430,6 +474,32 @@ int main(int argc, const char* argv[])
 			testOptions.maxScreenshotError = strtod(argv[i] + strlen("--max-mse="), nullptr);
 		else if (!strncmp(argv[i], "--debugger=", strlen("--debugger=")) && strlen(argv[i]) > strlen("--debugger="))
 			debuggerPort = (int)strtoul(argv[i] + strlen("--debugger="), NULL, 10);
+		else if (!strncmp(argv[i], "--compress=", strlen("--compress=")) && strlen(argv[i]) > strlen("--compress="))
+		{
+			const char *formatName = argv[i] + strlen("--compress=");
+			if (!strcmp(formatName, "cso"))
+				compressFormat = CompressedISOFormat::CSO;
+			else if (!strcmp(formatName, "cso2"))
+				compressFormat = CompressedISOFormat::CSO2;
+			else if (!strcmp(formatName, "zso"))
+				compressFormat = CompressedISOFormat::ZSO;
+			else
+				return printUsage(argv[0], "Unknown format specified after --compress=. Allowed: cso, cso2, zso.");
+			if (i + 2 >= argc)
+				return printUsage(argv[0], "Missing input and output after --compress");
+			compressInput = argv[++i];
+			compressOutput = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--cache-stats"))
+			cacheStats = true;
+#ifdef USE_PROFILER
+		else if (!strncmp(argv[i], "--trace=", strlen("--trace=")) && strlen(argv[i]) > strlen("--trace="))
+			traceFilename = argv[i] + strlen("--trace=");
+		else if (!strncmp(argv[i], "--trace-frames=", strlen("--trace-frames=")) && strlen(argv[i]) > strlen("--trace-frames=")) {
+			if (sscanf(argv[i] + strlen("--trace-frames="), "%d-%d", &traceFirstFrame, &traceLastFrame) != 2 || traceFirstFrame > traceLastFrame)
+				return printUsage(argv[0], "Expected a frame range like 10-20 after --trace-frames=");
+		}
+#endif
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
@@ -458,7 +528,7 @@ int main(int argc, const char* argv[])
 		testFilenames.end()
 	);
 
-	if (testFilenames.empty())
+	if (testFilenames.empty() && !compressInput)
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
 
 	g_Config.bEnableLogging = (fullLog || outputDebugStringLog);
@@ -477,6 +547,13 @@ int main(int argc, const char* argv[])
 	// Needs to be after log so we don't interfere with test output.
 	g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
 
+	if (compressInput) {
+		int result = CompressImage(Path(std::string(compressInput)), Path(std::string(compressOutput)), compressFormat);
+		g_logManager.Shutdown();
+		g_threadManager.Teardown();
+		return result;
+	}
+
 	HeadlessHost *headlessHost = getHost(gpuCore);
 	g_headlessHost = headlessHost;
 
@@ -645,6 +722,18 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	if (cacheStats) {
+		PrintCacheStats("Memory cache", CachingFileLoader::GetStats());
+		PrintCacheStats("Disk cache", DiskCachingFileLoader::GetStats());
+	}
+
+#ifdef USE_PROFILER
+	if (traceFilename) {
+		if (!Profiler_SaveChromeTrace(Path(traceFilename), traceFirstFrame, traceLastFrame))
+			fprintf(stderr, "Failed to write trace to %s\n", traceFilename);
+	}
+#endif
+
 	if (debuggerPort > 0) {
 		ShutdownWebServer();
 	}
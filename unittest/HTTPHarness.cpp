@@ -0,0 +1,44 @@
+#include <cstdio>
+
+#include "Common/File/FileUtil.h"
+#include "Common/Net/Resolve.h"
+
+#include "unittest/HTTPHarness.h"
+
+HTTPTestServer::HTTPTestServer(ServerExecutor *executor, const char *name, http::Server::UrlHandlerFunc handler) : server(executor), name(name) {
+	server.SetFallbackHandler(handler);
+}
+
+HTTPTestServer::~HTTPTestServer() {
+	running = false;
+	if (thread.joinable())
+		thread.join();
+	server.Stop();
+}
+
+bool HTTPTestServer::Start() {
+	if (!server.Listen(0, name, net::DNSType::IPV4))
+		return false;
+	thread = std::thread([this] {
+		while (running)
+			server.RunSlice(0.05);
+	});
+	return true;
+}
+
+HTTPTestImage::HTTPTestImage(const Path &path, int size, u32 seed) : path(path), data(size) {
+	for (u8 &b : data) {
+		seed = seed * 1103515245 + 12345;
+		b = (u8)(seed >> 16);
+	}
+
+	FILE *fp = File::OpenCFile(path, "wb");
+	if (fp) {
+		written = fwrite(data.data(), data.size(), 1, fp) == 1;
+		fclose(fp);
+	}
+}
+
+HTTPTestImage::~HTTPTestImage() {
+	File::Delete(path);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+#include "Common/Net/HTTPServer.h"
+
+// An http::Server on a free local port, running on its own thread until destroyed.
+struct HTTPTestServer {
+	HTTPTestServer(ServerExecutor *executor, const char *name, http::Server::UrlHandlerFunc handler);
+	~HTTPTestServer();
+
+	bool Start();
+	int Port() {
+		return server.Port();
+	}
+
+	http::Server server;
+	const char *name;
+	std::thread thread;
+	std::atomic<bool> running{ true };
+};
+
+// A fake disc image of pseudo-random bytes, written out for the server to read.  Deleted again when destroyed.
+struct HTTPTestImage {
+	HTTPTestImage(const Path &path, int size, u32 seed);
+	~HTTPTestImage();
+
+	Path path;
+	std::vector<u8> data;
+	bool written = false;
+};
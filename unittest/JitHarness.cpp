@@ -28,6 +28,7 @@
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
+#include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSAsm.h"
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
@@ -225,3 +226,61 @@ bool TestJit() {
 
 	return jit_speed >= interp_speed;
 }
+
+bool TestIdleLoop() {
+	SetupJitHarness();
+
+	// "%08x" is the loop start, and marks the branch to check.
+	struct LoopTest {
+		const char *lines[5];
+		bool idle;
+	};
+	static const LoopTest tests[] = {
+		// Plain flag poll.
+		{ { "lw v0, 0(a0)", "beq v0, zero, 0x%08x", "nop" }, true },
+		// Masked flag poll, with an extra load in the delay slot of a likely branch.
+		{ { "lw v0, 0(a0)", "andi v0, v0, 1", "beql v0, zero, 0x%08x", "lw v1, 4(a0)" }, true },
+		// Comparing against an invariant register.
+		{ { "lbu v0, 0(a0)", "bne v0, a1, 0x%08x", "nop" }, true },
+		// Counting loops progress on their own.
+		{ { "addiu v0, v0, 1", "bne v0, a1, 0x%08x", "nop" }, false },
+		// The delay slot changes the address for the next iteration.
+		{ { "lw v0, 0(a0)", "beq v0, zero, 0x%08x", "addiu a0, a0, 4" }, false },
+		// Stores are side effects.
+		{ { "sw zero, 0(a1)", "lw v0, 0(a0)", "beq v0, zero, 0x%08x", "nop" }, false },
+		// LO/HI aren't tracked, so these don't count.
+		{ { "mflo v0", "beq v0, zero, 0x%08x", "nop" }, false },
+		// Linking branches write RA.
+		{ { "lw v0, 0(a0)", "bltzal v0, 0x%08x", "nop" }, false },
+		// Not a loop at all.
+		{ { "lw v0, 0(a0)", "beq v0, zero, 0x08900000", "nop" }, false },
+	};
+
+	bool success = true;
+	for (size_t i = 0; i < ARRAY_SIZE(tests); ++i) {
+		const u32 start = PSP_GetUserMemoryBase() + (u32)i * 0x40;
+		u32 branchAddr = start + 4;
+		u32 addr = start;
+		for (const char *line : tests[i].lines) {
+			if (!line)
+				break;
+			char buf[256];
+			snprintf(buf, sizeof(buf), line, start);
+			if (!MIPSAsm::MipsAssembleOpcode(buf, currentDebugMIPS, addr)) {
+				printf("ERROR: %s\n", MIPSAsm::GetAssembleError().c_str());
+				success = false;
+			}
+			if (strstr(line, "0x") && (MIPSGetInfo(Memory::Read_Instruction(addr)) & IS_CONDBRANCH))
+				branchAddr = addr;
+			addr += 4;
+		}
+
+		if (MIPSAnalyst::IsIdleLoop(branchAddr) != tests[i].idle) {
+			printf("Idle loop test %d: expected %s\n", (int)i, tests[i].idle ? "idle" : "not idle");
+			success = false;
+		}
+	}
+
+	DestroyJitHarness();
+	return success;
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Log/LogManager.h"
+#include "Common/Net/Resolve.h"
+#include "Common/Net/SocketCompat.h"
+#include "Common/TimeUtil.h"
+#include "Core/HLE/proAdhocServer.h"
+
+#include "unittest/UnitTest.h"
+
+// A load generator for the built-in adhoc server: lots of fake PSPs on 127.0.0.x logging in,
+// joining groups, scanning and chatting.  Each client needs its own IP, since the server
+// only allows one connection per IP.
+
+static const uint16_t LOAD_TEST_PORT = SERVER_PORT + 1000;
+static const int LOAD_TEST_CLIENTS = 240;
+static const int LOAD_TEST_GROUP_SIZE = 8;
+static const int LOAD_TEST_CHAT_ROUNDS = 20;
+
+// The first two get crosslinked into the same game.
+static const char *const loadTestProducts[] = { "ULES01408", "ULUS10511", "NPJH59999" };
+
+struct LoadClient {
+	int sock = -1;
+	int game = 0;
+	int group = -1;
+	uint8_t rx[2048];
+	size_t rxpos = 0;
+};
+
+static size_t ServerPacketSize(uint8_t opcode) {
+	switch (opcode) {
+	case OPCODE_CONNECT: return sizeof(SceNetAdhocctlConnectPacketS2C);
+	case OPCODE_DISCONNECT: return sizeof(SceNetAdhocctlDisconnectPacketS2C);
+	case OPCODE_SCAN: return sizeof(SceNetAdhocctlScanPacketS2C);
+	case OPCODE_SCAN_COMPLETE: return 1;
+	case OPCODE_CONNECT_BSSID: return sizeof(SceNetAdhocctlConnectBSSIDPacketS2C);
+	case OPCODE_CHAT: return sizeof(SceNetAdhocctlChatPacketS2C);
+	default: return 0;
+	}
+}
+
+// Waits (up to the socket timeout) for the next packet from the server, returns its opcode or -1.
+static int ReadServerPacket(LoadClient &client) {
+	while (true) {
+		if (client.rxpos > 0) {
+			size_t size = ServerPacketSize(client.rx[0]);
+			if (size == 0)
+				return -1;
+			if (client.rxpos >= size) {
+				int opcode = client.rx[0];
+				memmove(client.rx, client.rx + size, client.rxpos - size);
+				client.rxpos -= size;
+				return opcode;
+			}
+		}
+		int received = (int)recv(client.sock, (char *)client.rx + client.rxpos, (int)(sizeof(client.rx) - client.rxpos), MSG_NOSIGNAL);
+		if (received <= 0)
+			return -1;
+		client.rxpos += received;
+	}
+}
+
+static bool SendToServer(const LoadClient &client, const void *data, size_t size) {
+	return send(client.sock, (const char *)data, (int)size, MSG_NOSIGNAL) == (int)size;
+}
+
+static bool BindLoadClient(int sock, int index) {
+	// 127.0.0.2 and up, all loopback.
+	sockaddr_in local{};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(0x7F000002 + (index / 200) * 256 + (index % 200));
+	return bind(sock, (sockaddr *)&local, sizeof(local)) == 0;
+}
+
+static int ConnectLoadClient(int index) {
+	int sock = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0)
+		return -1;
+
+	int on = 1;
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on));
+#if PPSSPP_PLATFORM(WINDOWS)
+	DWORD timeout = 5000;
+#else
+	timeval timeout{ 5, 0 };
+#endif
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+
+	sockaddr_in server{};
+	server.sin_family = AF_INET;
+	server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	server.sin_port = htons(LOAD_TEST_PORT);
+	if (!BindLoadClient(sock, index) || connect(sock, (sockaddr *)&server, sizeof(server)) != 0) {
+		closesocket(sock);
+		return -1;
+	}
+	return sock;
+}
+
+static bool RunAdhocServerLoad(std::vector<LoadClient> &clients) {
+	// Log everyone in.  Half of them go on to join groups.
+	const int numJoiners = (int)clients.size() / 2;
+	std::map<std::pair<int, int>, int> groupSizes;
+	std::map<int, int> gameGroups;
+	double st = time_now_d();
+	for (int i = 0; i < (int)clients.size(); ++i) {
+		LoadClient &client = clients[i];
+		client.sock = ConnectLoadClient(i);
+		EXPECT_TRUE(client.sock >= 0);
+
+		SceNetAdhocctlLoginPacketC2S login{};
+		login.base.opcode = OPCODE_LOGIN;
+		login.mac.data[0] = 0x02;
+		login.mac.data[4] = (uint8_t)(i >> 8);
+		login.mac.data[5] = (uint8_t)i;
+		snprintf((char *)login.name.data, sizeof(login.name.data), "Load%d", i);
+		const int product = i % ARRAY_SIZE(loadTestProducts);
+		memcpy(login.game.data, loadTestProducts[product], PRODUCT_CODE_LENGTH);
+		EXPECT_TRUE(SendToServer(client, &login, sizeof(login)));
+
+		// Crosslinked, so the first two products are the same game.
+		client.game = product == 2 ? 1 : 0;
+		if (i < numJoiners) {
+			client.group = i / LOAD_TEST_GROUP_SIZE;
+			if (groupSizes[std::make_pair(client.game, client.group)]++ == 0)
+				gameGroups[client.game]++;
+
+			SceNetAdhocctlConnectPacketC2S connect{};
+			connect.base.opcode = OPCODE_CONNECT;
+			snprintf((char *)connect.group.data, ADHOCCTL_GROUPNAME_LEN, "G%04d", client.group);
+			EXPECT_TRUE(SendToServer(client, &connect, sizeof(connect)));
+		}
+	}
+
+	// Everyone that joined hears about every other member of the group, and gets a BSSID.
+	for (int i = 0; i < numJoiners; ++i) {
+		LoadClient &client = clients[i];
+		const int expectedPeers = groupSizes[std::make_pair(client.game, client.group)] - 1;
+		int peers = 0;
+		bool bssid = false;
+		while (!bssid || peers < expectedPeers) {
+			int opcode = ReadServerPacket(client);
+			EXPECT_TRUE(opcode == OPCODE_CONNECT || opcode == OPCODE_CONNECT_BSSID);
+			if (opcode == OPCODE_CONNECT)
+				peers++;
+			else
+				bssid = true;
+		}
+		EXPECT_EQ_INT(peers, expectedPeers);
+	}
+	double loginTime = time_now_d() - st;
+
+	// One at a time, so this measures the round trip through the server loop.
+	double maxLatency = 0.0;
+	st = time_now_d();
+	for (int i = numJoiners; i < (int)clients.size(); ++i) {
+		LoadClient &client = clients[i];
+		double scanStart = time_now_d();
+		uint8_t opcode = OPCODE_SCAN;
+		EXPECT_TRUE(SendToServer(client, &opcode, 1));
+		int groups = 0;
+		int reply;
+		while ((reply = ReadServerPacket(client)) == OPCODE_SCAN)
+			groups++;
+		EXPECT_EQ_INT(reply, OPCODE_SCAN_COMPLETE);
+		EXPECT_EQ_INT(groups, gameGroups[client.game]);
+		maxLatency = std::max(maxLatency, time_now_d() - scanStart);
+	}
+	const int numScans = (int)clients.size() - numJoiners;
+	double scanTime = time_now_d() - st;
+
+	// The first member of each group chats, all at once, and everyone else in the group should hear it.
+	st = time_now_d();
+	int delivered = 0;
+	for (int round = 0; round < LOAD_TEST_CHAT_ROUNDS; ++round) {
+		std::map<std::pair<int, int>, int> senders;
+		for (int i = 0; i < numJoiners; ++i) {
+			if (senders.emplace(std::make_pair(clients[i].game, clients[i].group), i).second) {
+				SceNetAdhocctlChatPacketC2S chat{};
+				chat.base.opcode = OPCODE_CHAT;
+				snprintf(chat.message, sizeof(chat.message), "Round %d", round);
+				EXPECT_TRUE(SendToServer(clients[i], &chat, sizeof(chat)));
+			}
+		}
+		for (int i = 0; i < numJoiners; ++i) {
+			if (senders[std::make_pair(clients[i].game, clients[i].group)] == i)
+				continue;
+			EXPECT_EQ_INT(ReadServerPacket(clients[i]), OPCODE_CHAT);
+			delivered++;
+		}
+	}
+	double chatTime = time_now_d() - st;
+
+	printf("AdhocServer: %d clients logged in and joined in %0.1f ms\n", (int)clients.size(), loginTime * 1000.0);
+	printf("AdhocServer: scan round trip %0.3f ms average, %0.3f ms worst\n", scanTime * 1000.0 / numScans, maxLatency * 1000.0);
+	printf("AdhocServer: %0.1f K chat messages delivered/s\n", delivered / chatTime / 1000.0);
+	return true;
+}
+
+bool TestAdhocServer() {
+	net::Init();
+	__AdhocServerInit();
+
+	// The server logs every login and group change, which is a bit much here.
+	const LogLevel savedLevel = g_logManager.GetLogLevel(Log::sceNet);
+	g_logManager.SetLogLevel(Log::sceNet, LogLevel::LWARNING);
+
+	// Not every OS routes all of 127.0.0.0/8 to loopback (macOS doesn't, by default.)
+	int probe = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	bool canBind = probe >= 0 && BindLoadClient(probe, LOAD_TEST_CLIENTS - 1);
+	if (probe >= 0)
+		closesocket(probe);
+
+	bool success = true;
+	if (!canBind) {
+		printf("AdhocServer: can't bind to 127.0.x.x addresses, skipping load test\n");
+	} else {
+		std::thread serverThread(proAdhocServerThread, LOAD_TEST_PORT);
+		double st = time_now_d();
+		while (!adhocServerRunning && time_now_d() - st < 2.0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		std::vector<LoadClient> clients(LOAD_TEST_CLIENTS);
+		if (!adhocServerRunning) {
+			printf("AdhocServer: failed to start on port %d\n", LOAD_TEST_PORT);
+			success = false;
+		} else {
+			success = RunAdhocServerLoad(clients);
+		}
+
+		for (LoadClient &client : clients) {
+			if (client.sock >= 0)
+				closesocket(client.sock);
+		}
+		adhocServerRunning = false;
+		serverThread.join();
+	}
+
+	g_logManager.SetLogLevel(Log::sceNet, savedLevel);
+	net::Shutdown();
+	return success;
+}
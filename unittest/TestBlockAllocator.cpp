@@ -0,0 +1,227 @@
+#include <cstdio>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/CommonTypes.h"
+#include "Core/Util/BlockAllocator.h"
+
+#include "unittest/UnitTest.h"
+
+// The original BlockAllocator placement, a plain walk over every block in address order.
+// The indexed allocator must make exactly the same choices, since they end up in savestates.
+class ReferenceAllocator {
+public:
+	ReferenceAllocator(u32 start, u32 size, u32 grain) : rangeSize_(size), grain_(grain) {
+		blocks_.push_back(Block{ start, size, false });
+	}
+
+	u32 AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop) {
+		if (size == 0 || size > rangeSize_)
+			return -1;
+		if (grain < grain_)
+			grain = grain_;
+		if (sizeGrain < grain_)
+			sizeGrain = grain_;
+		size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
+
+		if (!fromTop) {
+			for (size_t i = 0; i < blocks_.size(); ++i) {
+				u32 offset = blocks_[i].start % grain;
+				if (offset != 0)
+					offset = grain - offset;
+				u32 needed = offset + size;
+				if (blocks_[i].taken || blocks_[i].size < needed)
+					continue;
+
+				if (blocks_[i].size != needed)
+					SplitAt(i, blocks_[i].start + needed);
+				if (offset >= grain_) {
+					SplitAt(i, blocks_[i].start + offset);
+					++i;
+				}
+				blocks_[i].taken = true;
+				return blocks_[i].start;
+			}
+		} else {
+			for (size_t i = blocks_.size(); i-- > 0; ) {
+				u32 offset = (blocks_[i].start + blocks_[i].size - size) % grain;
+				u32 needed = offset + size;
+				if (blocks_[i].taken || blocks_[i].size < needed)
+					continue;
+
+				if (blocks_[i].size != needed) {
+					SplitAt(i, blocks_[i].start + blocks_[i].size - needed);
+					++i;
+				}
+				if (offset >= grain_)
+					SplitAt(i, blocks_[i].start + blocks_[i].size - offset);
+				blocks_[i].taken = true;
+				return blocks_[i].start;
+			}
+		}
+		return -1;
+	}
+
+	u32 AllocAt(u32 position, u32 size) {
+		if (size > rangeSize_)
+			return -1;
+		u32 alignedPosition = position & ~(grain_ - 1);
+		u32 alignedSize = (size + position - alignedPosition + grain_ - 1) & ~(grain_ - 1);
+
+		int i = Find(alignedPosition);
+		if (i < 0 || blocks_[i].taken || blocks_[i].start + blocks_[i].size < alignedPosition + alignedSize)
+			return -1;
+		if (blocks_[i].start != alignedPosition) {
+			SplitAt(i, alignedPosition);
+			++i;
+		}
+		if (blocks_[i].size > alignedSize)
+			SplitAt(i, alignedPosition + alignedSize);
+		blocks_[i].taken = true;
+		return position;
+	}
+
+	bool Free(u32 position, bool exact) {
+		int i = Find(position);
+		if (i < 0 || !blocks_[i].taken || (exact && blocks_[i].start != position))
+			return false;
+		blocks_[i].taken = false;
+		if (i + 1 < (int)blocks_.size() && !blocks_[i + 1].taken) {
+			blocks_[i].size += blocks_[i + 1].size;
+			blocks_.erase(blocks_.begin() + i + 1);
+		}
+		if (i > 0 && !blocks_[i - 1].taken) {
+			blocks_[i - 1].size += blocks_[i].size;
+			blocks_.erase(blocks_.begin() + i);
+		}
+		return true;
+	}
+
+	u32 LargestFree() const {
+		u32 largest = 0;
+		for (const Block &b : blocks_) {
+			if (!b.taken && b.size > largest)
+				largest = b.size;
+		}
+		return largest;
+	}
+
+	u32 TotalFree() const {
+		u32 sum = 0;
+		for (const Block &b : blocks_) {
+			if (!b.taken)
+				sum += b.size;
+		}
+		return sum;
+	}
+
+	struct Block {
+		u32 start;
+		u32 size;
+		bool taken;
+	};
+	const std::vector<Block> &Blocks() const {
+		return blocks_;
+	}
+
+private:
+	int Find(u32 addr) const {
+		for (size_t i = 0; i < blocks_.size(); ++i) {
+			if (addr >= blocks_[i].start && addr < blocks_[i].start + blocks_[i].size)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	// Splits block i in two at addr, both halves keep its state.
+	void SplitAt(size_t i, u32 addr) {
+		Block upper{ addr, blocks_[i].start + blocks_[i].size - addr, blocks_[i].taken };
+		blocks_[i].size = addr - blocks_[i].start;
+		blocks_.insert(blocks_.begin() + i + 1, upper);
+	}
+
+	std::vector<Block> blocks_;
+	u32 rangeSize_;
+	u32 grain_;
+};
+
+static bool CompareAllocators(BlockAllocator &alloc, const ReferenceAllocator &ref) {
+	for (const auto &b : ref.Blocks()) {
+		EXPECT_EQ_HEX(alloc.GetBlockStartFromAddress(b.start + b.size - 1), b.start);
+		EXPECT_EQ_HEX(alloc.GetBlockSizeFromAddress(b.start), b.size);
+		EXPECT_EQ_INT(alloc.IsBlockFree(b.start), !b.taken);
+	}
+	EXPECT_EQ_HEX(alloc.GetLargestFreeBlockSize(), ref.LargestFree());
+	EXPECT_EQ_HEX(alloc.GetTotalFreeBytes(), ref.TotalFree());
+	return true;
+}
+
+static bool TestRandomAllocations(u32 grain, u32 seed) {
+	const u32 rangeStart = 0x08800000;
+	const u32 rangeSize = 0x00400000;
+
+	BlockAllocator alloc(grain);
+	alloc.Init(rangeStart, rangeSize, false);
+	ReferenceAllocator ref(rangeStart, rangeSize, grain);
+
+	u32 state = seed;
+	auto random = [&](u32 range) {
+		state = state * 1103515245 + 12345;
+		return (state >> 8) % range;
+	};
+
+	static const u32 alignments[] = { 0, 0x10, 0x100, 0x1000, 0x10000 };
+	std::vector<u32> live;
+	for (int step = 0; step < 20000; ++step) {
+		u32 op = random(10);
+		if (op < 5 || live.empty()) {
+			// Mostly small sizes, some large ones to fragment the range.
+			u32 size = random(4) == 0 ? random(0x40000) + 1 : random(0x2000) + 1;
+			u32 align = alignments[random(ARRAY_SIZE(alignments))];
+			u32 sizeGrain = alignments[random(ARRAY_SIZE(alignments) - 2)];
+			bool fromTop = random(2) == 0;
+			u32 size1 = size, size2 = size;
+			u32 addr = alloc.AllocAligned(size1, sizeGrain, align, fromTop, "test");
+			u32 expected = ref.AllocAligned(size2, sizeGrain, align, fromTop);
+			EXPECT_EQ_HEX(addr, expected);
+			EXPECT_EQ_HEX(size1, size2);
+			if (addr != (u32)-1)
+				live.push_back(addr);
+		} else if (op < 6) {
+			u32 position = rangeStart + random(rangeSize);
+			u32 size = random(0x4000) + 1;
+			u32 addr = alloc.AllocAt(position, size, "test");
+			u32 expected = ref.AllocAt(position, size);
+			EXPECT_EQ_HEX(addr, expected);
+			if (addr != (u32)-1)
+				live.push_back(addr);
+		} else {
+			size_t i = random((u32)live.size());
+			u32 position = live[i];
+			if (random(2) == 0) {
+				bool freed = alloc.FreeExact(position);
+				EXPECT_EQ_INT(freed, ref.Free(position, true));
+				// AllocAt() may have returned a position inside the block.
+				if (!freed) {
+					EXPECT_TRUE(alloc.Free(position));
+					EXPECT_TRUE(ref.Free(position, false));
+				}
+			} else {
+				EXPECT_TRUE(alloc.Free(position));
+				EXPECT_TRUE(ref.Free(position, false));
+			}
+			live.erase(live.begin() + i);
+		}
+
+		if ((step & 63) == 0 && !CompareAllocators(alloc, ref))
+			return false;
+	}
+	return CompareAllocators(alloc, ref);
+}
+
+bool TestBlockAllocator() {
+	RET(TestRandomAllocations(0x10, 1));
+	RET(TestRandomAllocations(0x100, 2));
+	RET(TestRandomAllocations(0x100, 3));
+	return true;
+}
@@ -0,0 +1,188 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Data/Encoding/Compression.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Core/FileLoaders/LocalFileLoader.h"
+#include "Core/FileSystems/BlockDevices.h"
+
+#include "unittest/UnitTest.h"
+
+static void FillRandom(u8 *data, size_t size, u32 seed) {
+	for (size_t i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (u8)(seed >> 16);
+	}
+}
+
+static bool LZ4RoundTrip(const std::vector<u8> &src) {
+	// Incompressible data grows a little, by about 1/255 plus a few bytes.
+	std::vector<u8> compressed(src.size() + src.size() / 255 + 16);
+	size_t compressedSize = lz4_compress_block(src.data(), src.size(), compressed.data(), compressed.size());
+	EXPECT_TRUE(compressedSize != 0);
+
+	std::vector<u8> decompressed(src.size() + 1);
+	int result = lz4_decompress_block(compressed.data(), compressedSize, decompressed.data(), src.size());
+	EXPECT_EQ_INT(result, (int)src.size());
+	EXPECT_TRUE(memcmp(decompressed.data(), src.data(), src.size()) == 0);
+	return true;
+}
+
+static bool TestLZ4RoundTrips() {
+	std::vector<u8> data;
+
+	// Incompressible, long enough that the literal length needs several 255 bytes.
+	data.resize(70000);
+	FillRandom(data.data(), data.size(), 1);
+	RET(LZ4RoundTrip(data));
+
+	// All zeros, so one long match (overlapping its own output.)
+	data.assign(70000, 0);
+	RET(LZ4RoundTrip(data));
+
+	// Shorter than the minimum match and the end-of-block limits, only literals.
+	for (size_t size = 0; size <= 13; ++size) {
+		data.assign(size, 'a');
+		RET(LZ4RoundTrip(data));
+	}
+
+	// Lengths right at the 15 and 15 + 255 boundaries of the token and length bytes.
+	static const size_t runs[] = { 14, 15, 16, 18, 19, 20, 269, 270, 271, 274, 275, 525 };
+	for (size_t run : runs) {
+		data.resize(run * 2 + 64);
+		FillRandom(data.data(), run, 2);
+		memset(&data[run], 'z', run);
+		FillRandom(&data[run * 2], 64, 3);
+		RET(LZ4RoundTrip(data));
+	}
+
+	// A mix, like a disc sector of text and tables.
+	data.resize(2048);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = (u8)("PSP GAME DATA "[i % 14] + (i / 512));
+	RET(LZ4RoundTrip(data));
+
+	// Doesn't fit: the compressor says so rather than overflowing.
+	data.resize(4096);
+	FillRandom(data.data(), data.size(), 4);
+	std::vector<u8> small(1024);
+	EXPECT_EQ_INT((int)lz4_compress_block(data.data(), data.size(), small.data(), small.size()), 0);
+	return true;
+}
+
+static bool TestLZ4Corrupt() {
+	std::vector<u8> src(8192);
+	for (size_t i = 0; i < src.size(); ++i)
+		src[i] = (u8)(i % 97 < 50 ? 0 : i);
+	std::vector<u8> compressed(src.size() * 2);
+	size_t compressedSize = lz4_compress_block(src.data(), src.size(), compressed.data(), compressed.size());
+	EXPECT_TRUE(compressedSize != 0 && compressedSize < src.size());
+	std::vector<u8> out(src.size());
+
+	// Truncated anywhere, it must never decode to a full block.
+	for (size_t size = 0; size < compressedSize; ++size) {
+		int result = lz4_decompress_block(compressed.data(), size, out.data(), out.size());
+		EXPECT_TRUE(result != (int)src.size());
+	}
+
+	// Output buffer too small for a match.
+	EXPECT_TRUE(lz4_decompress_block(compressed.data(), compressedSize, out.data(), 100) != (int)src.size());
+
+	// Offset 0, and an offset reaching back before the start.
+	const u8 zeroOffset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+	EXPECT_EQ_INT(lz4_decompress_block(zeroOffset, sizeof(zeroOffset), out.data(), out.size()), -1);
+	const u8 farOffset[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+	EXPECT_EQ_INT(lz4_decompress_block(farOffset, sizeof(farOffset), out.data(), out.size()), -1);
+	// Literal length running past the input.
+	const u8 longLiterals[] = { 0xF0, 0xFF, 0x10, 'a', 'b' };
+	EXPECT_EQ_INT(lz4_decompress_block(longLiterals, sizeof(longLiterals), out.data(), out.size()), -1);
+	// Length bytes cut off.
+	const u8 cutLength[] = { 0xF0, 0xFF };
+	EXPECT_EQ_INT(lz4_decompress_block(cutLength, sizeof(cutLength), out.data(), out.size()), -1);
+	return true;
+}
+
+class MemoryBlockDevice : public BlockDevice {
+public:
+	MemoryBlockDevice(const std::vector<u8> &data) : BlockDevice(nullptr), data_(data) {}
+
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override {
+		memcpy(outPtr, &data_[(size_t)blockNumber * GetBlockSize()], GetBlockSize());
+		return true;
+	}
+	u32 GetNumBlocks() const override {
+		return (u32)(data_.size() / GetBlockSize());
+	}
+	bool IsDisc() const override {
+		return true;
+	}
+
+private:
+	const std::vector<u8> &data_;
+};
+
+static bool TestCompressedImage(const std::vector<u8> &image, CompressedISOFormat format, const char *magic, int version) {
+	const Path path("compressed_iso_test.cso");
+	MemoryBlockDevice source(image);
+	std::string error;
+	EXPECT_TRUE(WriteCompressedISO(&source, path, format, &error));
+
+	bool success = false;
+	{
+		LocalFileLoader loader(path);
+		u8 header[24];
+		EXPECT_EQ_INT((int)loader.ReadAt(0, sizeof(header), 1, header), 1);
+		EXPECT_TRUE(memcmp(header, magic, 4) == 0);
+		EXPECT_EQ_INT(header[20], version);
+		// It should've actually compressed something.
+		EXPECT_TRUE(loader.FileSize() < (s64)image.size());
+
+		CISOFileBlockDevice device(&loader);
+		EXPECT_EQ_INT(device.GetNumBlocks(), source.GetNumBlocks());
+
+		std::vector<u8> block(2048);
+		for (u32 i = 0; i < device.GetNumBlocks(); ++i) {
+			EXPECT_TRUE(device.ReadBlock(i, block.data()));
+			EXPECT_TRUE(memcmp(block.data(), &image[(size_t)i * 2048], 2048) == 0);
+		}
+
+		std::vector<u8> all(image.size());
+		EXPECT_TRUE(device.ReadBlocks(0, device.GetNumBlocks(), all.data()));
+		EXPECT_TRUE(all == image);
+		success = true;
+	}
+
+	File::Delete(path);
+	return success;
+}
+
+bool TestCompressedISO() {
+	RET(TestLZ4RoundTrips());
+	RET(TestLZ4Corrupt());
+
+	// Zero, random (stored plain) and repetitive blocks, so every kind of frame shows up.
+	std::vector<u8> image(2048 * 300);
+	for (u32 i = 0; i < 300; ++i) {
+		u8 *block = &image[(size_t)i * 2048];
+		switch (i % 3) {
+		case 0:
+			break;
+		case 1:
+			FillRandom(block, 2048, i);
+			break;
+		case 2:
+			for (int j = 0; j < 2048; ++j)
+				block[j] = (u8)((j * 7) % 61 + i);
+			break;
+		}
+	}
+
+	RET(TestCompressedImage(image, CompressedISOFormat::CSO, "CISO", 1));
+	RET(TestCompressedImage(image, CompressedISOFormat::CSO2, "CISO", 2));
+	RET(TestCompressedImage(image, CompressedISOFormat::ZSO, "ZISO", 1));
+	return true;
+}
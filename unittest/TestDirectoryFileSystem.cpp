@@ -0,0 +1,147 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Core/FileSystems/DirectoryFileSystem.h"
+#include "Core/FileSystems/MetaFileSystem.h"
+#include "Core/MIPS/MIPS.h"
+
+#include "unittest/UnitTest.h"
+
+static bool WriteGuestFile(MetaFileSystem &fs, const std::string &filename, int size, FileAccess access = FileAccess(FILEACCESS_WRITE | FILEACCESS_CREATE | FILEACCESS_TRUNCATE)) {
+	int handle = fs.OpenFile(filename, access);
+	EXPECT_TRUE(handle > 0);
+	std::vector<u8> data(size, 0x55);
+	EXPECT_EQ_INT((int)fs.WriteFile(handle, data.data(), size), size);
+	fs.CloseFile(handle);
+	return true;
+}
+
+static bool CanOpenForReading(MetaFileSystem &fs, const std::string &filename) {
+	int handle = fs.OpenFile(filename, FileAccess(FILEACCESS_READ | FILEACCESS_PPSSPP_QUIET));
+	if (handle <= 0)
+		return false;
+	fs.CloseFile(handle);
+	return true;
+}
+
+// Each of these first looks at a path, so it's cached, and then changes what's there.
+static bool TestCreateAfterMissing(MetaFileSystem &fs) {
+	EXPECT_FALSE(fs.GetFileInfo("ms0:/created.bin").exists);
+	EXPECT_FALSE(CanOpenForReading(fs, "ms0:/created.bin"));
+
+	RET(WriteGuestFile(fs, "ms0:/created.bin", 100));
+	PSPFileInfo info = fs.GetFileInfo("ms0:/created.bin");
+	EXPECT_TRUE(info.exists);
+	EXPECT_EQ_INT((int)info.size, 100);
+	EXPECT_TRUE(CanOpenForReading(fs, "ms0:/created.bin"));
+	return true;
+}
+
+static bool TestWriteChangesSize(MetaFileSystem &fs) {
+	EXPECT_EQ_INT((int)fs.GetFileInfo("ms0:/created.bin").size, 100);
+
+	int handle = fs.OpenFile("ms0:/created.bin", FileAccess(FILEACCESS_WRITE | FILEACCESS_APPEND));
+	EXPECT_TRUE(handle > 0);
+	EXPECT_EQ_INT((int)fs.GetFileInfo("ms0:/created.bin").size, 100);
+	u8 data[50]{};
+	EXPECT_EQ_INT((int)fs.WriteFile(handle, data, sizeof(data)), (int)sizeof(data));
+	// Still open, but the size has to be right already.
+	EXPECT_EQ_INT((int)fs.GetFileInfo("ms0:/created.bin").size, 150);
+	fs.CloseFile(handle);
+	EXPECT_EQ_INT((int)fs.GetFileInfo("ms0:/created.bin").size, 150);
+	return true;
+}
+
+static bool TestMkDirRenameRemove(MetaFileSystem &fs) {
+	EXPECT_FALSE(fs.GetFileInfo("ms0:/dir").exists);
+	EXPECT_TRUE(fs.MkDir("ms0:/dir"));
+	PSPFileInfo dirInfo = fs.GetFileInfo("ms0:/dir");
+	EXPECT_TRUE(dirInfo.exists);
+	EXPECT_EQ_INT(dirInfo.type, FILETYPE_DIRECTORY);
+
+	EXPECT_FALSE(fs.GetFileInfo("ms0:/renamed.bin").exists);
+	EXPECT_FALSE(CanOpenForReading(fs, "ms0:/renamed.bin"));
+	EXPECT_EQ_INT(fs.RenameFile("ms0:/created.bin", "ms0:/renamed.bin"), 0);
+	EXPECT_FALSE(fs.GetFileInfo("ms0:/created.bin").exists);
+	EXPECT_FALSE(CanOpenForReading(fs, "ms0:/created.bin"));
+	EXPECT_EQ_INT((int)fs.GetFileInfo("ms0:/renamed.bin").size, 150);
+	EXPECT_TRUE(CanOpenForReading(fs, "ms0:/renamed.bin"));
+
+	EXPECT_TRUE(fs.RemoveFile("ms0:/renamed.bin"));
+	EXPECT_FALSE(fs.GetFileInfo("ms0:/renamed.bin").exists);
+	EXPECT_FALSE(CanOpenForReading(fs, "ms0:/renamed.bin"));
+	return true;
+}
+
+static bool TestChDirRelative(MetaFileSystem &fs) {
+	RET(WriteGuestFile(fs, "ms0:/file.txt", 10));
+	RET(WriteGuestFile(fs, "ms0:/dir/file.txt", 20));
+
+	std::string outpath;
+	IFileSystem *system = nullptr;
+	EXPECT_EQ_INT(fs.ChDir("ms0:/"), 0);
+	EXPECT_EQ_INT(fs.MapFilePath("file.txt", outpath, &system), 0);
+	EXPECT_EQ_STR(outpath, std::string("/file.txt"));
+	EXPECT_EQ_INT((int)fs.GetFileInfo("file.txt").size, 10);
+
+	// Same relative path, different directory.
+	EXPECT_EQ_INT(fs.ChDir("ms0:/dir"), 0);
+	EXPECT_EQ_INT(fs.MapFilePath("file.txt", outpath, &system), 0);
+	EXPECT_EQ_STR(outpath, std::string("/dir/file.txt"));
+	EXPECT_EQ_INT((int)fs.GetFileInfo("file.txt").size, 20);
+	EXPECT_EQ_INT(fs.MapFilePath("../file.txt", outpath, &system), 0);
+	EXPECT_EQ_STR(outpath, std::string("/file.txt"));
+
+	EXPECT_EQ_INT(fs.ChDir("ms0:/"), 0);
+	EXPECT_EQ_INT(fs.MapFilePath("file.txt", outpath, &system), 0);
+	EXPECT_EQ_STR(outpath, std::string("/file.txt"));
+	return true;
+}
+
+static bool TestHostChanges(MetaFileSystem &fs, const Path &dir) {
+	// Different case than the guest asks for, which matters on case sensitive hosts.
+	EXPECT_FALSE(fs.GetFileInfo("ms0:/dir/host.bin").exists);
+	EXPECT_FALSE(CanOpenForReading(fs, "ms0:/dir/host.bin"));
+	EXPECT_TRUE(File::WriteStringToFile(false, std::string(30, 'h'), dir / "dir" / "HOST.BIN"));
+
+	// Like deleting or adding savedata from the menu.
+	DirectoryFileSystem::NotifyHostFilesChanged();
+	PSPFileInfo info = fs.GetFileInfo("ms0:/dir/host.bin");
+	EXPECT_TRUE(info.exists);
+	EXPECT_EQ_INT((int)info.size, 30);
+	EXPECT_TRUE(CanOpenForReading(fs, "ms0:/dir/host.bin"));
+
+	EXPECT_TRUE(File::Delete(dir / "dir" / "HOST.BIN"));
+	DirectoryFileSystem::NotifyHostFilesChanged();
+	EXPECT_FALSE(fs.GetFileInfo("ms0:/dir/host.bin").exists);
+	EXPECT_FALSE(CanOpenForReading(fs, "ms0:/dir/host.bin"));
+	return true;
+}
+
+bool TestDirectoryFileSystem() {
+	const Path dir("directory_fs_test");
+	if (File::Exists(dir))
+		File::DeleteDirRecursively(dir);
+
+	// Disk operations are timestamped for replays.
+	currentMIPS = &mipsr4k;
+
+	bool success;
+	{
+		MetaFileSystem fs;
+		fs.Mount("ms0:", std::make_shared<DirectoryFileSystem>(&fs, dir, FileSystemFlags::SIMULATE_FAT32 | FileSystemFlags::CARD));
+
+		success = TestCreateAfterMissing(fs) && TestWriteChangesSize(fs) && TestMkDirRenameRemove(fs) && TestChDirRelative(fs) && TestHostChanges(fs, dir);
+		fs.Shutdown();
+	}
+
+	currentMIPS = nullptr;
+	File::DeleteDirRecursively(dir);
+	return success;
+}
@@ -0,0 +1,107 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Core/Loaders.h"
+#include "Core/Util/GameInfoIndex.h"
+
+#include "unittest/UnitTest.h"
+
+static bool WriteTestFile(const Path &path, const std::string &data) {
+	FILE *fp = File::OpenCFile(path, "wb");
+	if (!fp)
+		return false;
+	bool success = fwrite(data.data(), 1, data.size(), fp) == data.size();
+	fclose(fp);
+	return success;
+}
+
+static GameInfoIndexEntry MakeEntry(const char *id) {
+	GameInfoIndexEntry entry;
+	entry.fileType = (int)IdentifiedFileType::PSP_ISO;
+	entry.paramSFO = std::string("PSF\0fake", 8);
+	entry.id = id;
+	entry.id_version = std::string(id) + "_1.00";
+	entry.region = 1;
+	entry.icon = std::string("\x89PNG\0\0\0\x0dIHDR", 12);
+	return entry;
+}
+
+static bool TestIndexRoundTrip(const Path &dir) {
+	const Path indexPath = dir / "gameinfo.ppidx";
+	const Path gamePath = dir / "game.iso";
+	const Path otherPath = dir / "other.iso";
+	EXPECT_TRUE(WriteTestFile(gamePath, std::string(4096, 'a')));
+	EXPECT_TRUE(WriteTestFile(otherPath, std::string(2048, 'b')));
+
+	{
+		GameInfoIndex index(indexPath);
+		GameInfoIndexEntry entry;
+		EXPECT_FALSE(index.Lookup(gamePath, &entry));
+		index.Update(gamePath, MakeEntry("ULUS00001"));
+		index.Update(otherPath, MakeEntry("ULUS00002"));
+		index.Save();
+	}
+
+	// Saving must not leave the temporary file behind.
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(dir, &files);
+	EXPECT_EQ_INT((int)files.size(), 3);
+	EXPECT_TRUE(File::Exists(indexPath));
+
+	{
+		GameInfoIndex index(indexPath);
+		GameInfoIndexEntry entry;
+		EXPECT_TRUE(index.Lookup(gamePath, &entry));
+		EXPECT_EQ_INT((int)entry.size, 4096);
+		EXPECT_EQ_INT(entry.fileType, (int)IdentifiedFileType::PSP_ISO);
+		EXPECT_EQ_STR(entry.paramSFO, std::string("PSF\0fake", 8));
+		EXPECT_EQ_STR(entry.id, std::string("ULUS00001"));
+		EXPECT_EQ_STR(entry.id_version, std::string("ULUS00001_1.00"));
+		EXPECT_EQ_INT(entry.region, 1);
+		EXPECT_EQ_STR(entry.icon, MakeEntry("").icon);
+
+		// Updates without an icon keep the one already known for the same file.
+		GameInfoIndexEntry update = MakeEntry("ULUS00002");
+		update.icon.clear();
+		index.Update(otherPath, std::move(update));
+		EXPECT_TRUE(index.Lookup(otherPath, &entry));
+		EXPECT_EQ_STR(entry.icon, MakeEntry("").icon);
+	}
+
+	// Replacing the file (different size) invalidates its entry, and the change gets saved.
+	EXPECT_TRUE(WriteTestFile(gamePath, std::string(8192, 'c')));
+	{
+		GameInfoIndex index(indexPath);
+		GameInfoIndexEntry entry;
+		EXPECT_FALSE(index.Lookup(gamePath, &entry));
+		EXPECT_TRUE(index.Lookup(otherPath, &entry));
+		index.Save();
+	}
+
+	// Put back the original size, the dropped entry should stay dropped.
+	EXPECT_TRUE(WriteTestFile(gamePath, std::string(4096, 'a')));
+	File::Delete(otherPath);
+	{
+		GameInfoIndex index(indexPath);
+		GameInfoIndexEntry entry;
+		EXPECT_FALSE(index.Lookup(gamePath, &entry));
+		EXPECT_FALSE(index.Lookup(otherPath, &entry));
+	}
+
+	return true;
+}
+
+bool TestGameInfoIndex() {
+	const Path dir("gameinfo_index_test");
+	File::DeleteDirRecursively(dir);
+	File::CreateFullPath(dir);
+
+	bool success = TestIndexRoundTrip(dir);
+
+	File::DeleteDirRecursively(dir);
+	return success;
+}
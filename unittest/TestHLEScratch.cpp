@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Core/HLE/HLE.h"
+#include "Core/HLE/sceKernel.h"
+
+#include "unittest/UnitTest.h"
+
+static bool TestScratchNested() {
+	kernelStats.ResetFrame();
+
+	HLEScratchScope outer;
+	u8 *a = (u8 *)hleScratchAlloc(100);
+	EXPECT_EQ_INT(kernelStats.scratchAllocs, 1);
+	EXPECT_EQ_INT(((uintptr_t)a & 15), 0);
+	memset(a, 0xAA, 100);
+
+	u8 *b;
+	{
+		HLEScratchScope inner;
+		b = (u8 *)hleScratchAlloc(20);
+		EXPECT_EQ_INT(kernelStats.scratchAllocs, 2);
+		EXPECT_TRUE(b >= a + 100);
+		EXPECT_EQ_INT(((uintptr_t)b & 15), 0);
+		memset(b, 0xBB, 20);
+	}
+
+	// Ending the inner scope mustn't release anything, the outer one may still be using it.
+	u8 *c = (u8 *)hleScratchAlloc(20);
+	EXPECT_TRUE(c >= b + 20);
+	EXPECT_EQ_INT(a[99], 0xAA);
+	EXPECT_EQ_INT(b[19], 0xBB);
+
+	// Freeing arena memory is a no-op.
+	hleScratchFree(b);
+	EXPECT_TRUE(hleScratchAlloc(20) != b);
+	EXPECT_EQ_INT(kernelStats.scratchHeapAllocs, 0);
+	return true;
+}
+
+static bool TestScratchOverflow() {
+	kernelStats.ResetFrame();
+
+	HLEScratchScope scope;
+	// Bigger than the whole arena, straight to the heap.
+	u8 *big = (u8 *)hleScratchAlloc(1024 * 1024);
+	EXPECT_TRUE(big != nullptr);
+	EXPECT_EQ_INT(kernelStats.scratchAllocs, 0);
+	EXPECT_EQ_INT(kernelStats.scratchHeapAllocs, 1);
+	memset(big, 0xCC, 1024 * 1024);
+	hleScratchFree(big);
+
+	// Fill it up in pieces until one doesn't fit anymore.
+	std::vector<u8 *> pieces;
+	while (kernelStats.scratchHeapAllocs == 1) {
+		pieces.push_back((u8 *)hleScratchAlloc(4000));
+		EXPECT_TRUE(pieces.size() < 1000);
+	}
+	EXPECT_EQ_INT(kernelStats.scratchAllocs, (int)pieces.size() - 1);
+	// The last one came from the heap, and works like any other memory.
+	memset(pieces.back(), 0xDD, 4000);
+	for (u8 *piece : pieces)
+		hleScratchFree(piece);
+
+	// Containers still work once it's full.
+	std::vector<int, HLEScratchAllocator<int>> values;
+	for (int i = 0; i < 10000; ++i)
+		values.push_back(i);
+	for (int i = 0; i < 10000; ++i)
+		EXPECT_EQ_INT(values[i], i);
+	return true;
+}
+
+static bool TestScratchReset() {
+	void *first;
+	{
+		HLEScratchScope scope;
+		first = hleScratchAlloc(64);
+		hleScratchAlloc(64);
+	}
+
+	kernelStats.ResetFrame();
+	{
+		// The outermost scope ended, so everything is available again.
+		HLEScratchScope scope;
+		EXPECT_TRUE(hleScratchAlloc(64) == first);
+		EXPECT_EQ_INT(kernelStats.scratchAllocs, 1);
+	}
+
+	// And outside of any scope, it's all heap (and not counted against a syscall.)
+	kernelStats.ResetFrame();
+	void *outside = hleScratchAlloc(64);
+	EXPECT_TRUE(outside != first);
+	EXPECT_EQ_INT(kernelStats.scratchAllocs, 0);
+	EXPECT_EQ_INT(kernelStats.scratchHeapAllocs, 0);
+	hleScratchFree(outside);
+	return true;
+}
+
+bool TestHLEScratch() {
+	RET(TestScratchNested());
+	RET(TestScratchOverflow());
+	RET(TestScratchReset());
+	return true;
+}
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/FileDescriptor.h"
+#include "Common/File/Path.h"
+#include "Common/Net/HTTPServer.h"
+#include "Common/Net/Resolve.h"
+#include "Common/Net/Sinks.h"
+#include "Common/Net/SocketCompat.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "Core/FileLoaders/CachingFileLoader.h"
+#include "Core/FileLoaders/HTTPFileLoader.h"
+#include "Core/WebServer.h"
+
+#include "unittest/HTTPHarness.h"
+#include "unittest/UnitTest.h"
+
+static const int LOADER_IMAGE_SIZE = 8 * 1024 * 1024;
+// One way, so a round trip is twice this.
+static const double PROXY_LATENCY = 0.005;
+static const int SEQUENTIAL_READ_SIZE = 32 * 1024;
+
+// Sits between the loader and the server, and holds back everything going either way for a while,
+// like a slow network would.  New connections cost an extra trip, for the handshake.
+class LatencyProxy {
+public:
+	LatencyProxy(int serverPort, double latency) : serverPort_(serverPort), latency_(latency) {}
+	~LatencyProxy() {
+		quit_ = true;
+		if (acceptThread_.joinable())
+			acceptThread_.join();
+		for (auto &conn : conns_) {
+			conn->up.join();
+			conn->down.join();
+			closesocket(conn->client);
+			closesocket(conn->server);
+		}
+		if (listener_ >= 0)
+			closesocket(listener_);
+	}
+
+	bool Start() {
+		listener_ = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t addrlen = sizeof(addr);
+		if (listener_ < 0 || bind(listener_, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener_, 64) != 0 || getsockname(listener_, (sockaddr *)&addr, &addrlen) != 0)
+			return false;
+		port_ = ntohs(addr.sin_port);
+		acceptThread_ = std::thread([this] { AcceptLoop(); });
+		return true;
+	}
+
+	int Port() const { return port_; }
+	int Connections() const { return connections_; }
+
+private:
+	struct Conn {
+		int client;
+		int server;
+		std::thread up;
+		std::thread down;
+	};
+
+	void AcceptLoop() {
+		while (!quit_) {
+			if (!fd_util::WaitUntilReady(listener_, 0.05, false))
+				continue;
+			int client = (int)accept(listener_, nullptr, nullptr);
+			if (client < 0)
+				continue;
+
+			int server = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+			sockaddr_in addr{};
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = htons(serverPort_);
+			if (connect(server, (sockaddr *)&addr, sizeof(addr)) != 0) {
+				closesocket(client);
+				closesocket(server);
+				continue;
+			}
+			int opt = 1;
+			setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char *)&opt, sizeof(opt));
+			setsockopt(server, IPPROTO_TCP, TCP_NODELAY, (const char *)&opt, sizeof(opt));
+
+			auto conn = std::make_unique<Conn>();
+			conn->client = client;
+			conn->server = server;
+			conn->up = std::thread([this, client, server] { Forward(client, server, latency_ * 2.0); });
+			conn->down = std::thread([this, client, server] { Forward(server, client, 0.0); });
+			conns_.push_back(std::move(conn));
+			connections_++;
+		}
+	}
+
+	void Forward(int from, int to, double firstDelay) {
+		struct Chunk {
+			double due;
+			std::string data;
+		};
+		std::deque<Chunk> queue;
+		bool eof = false;
+		char buf[65536];
+
+		while (!quit_) {
+			double now = time_now_d();
+			while (!queue.empty() && queue.front().due <= now) {
+				const std::string &data = queue.front().data;
+				for (size_t pos = 0; pos < data.size(); ) {
+					int sent = (int)send(to, data.data() + pos, (int)(data.size() - pos), MSG_NOSIGNAL);
+					if (sent <= 0)
+						return;
+					pos += sent;
+				}
+				queue.pop_front();
+			}
+			if (eof && queue.empty()) {
+				shutdown(to, SHUT_WR);
+				return;
+			}
+
+			double wait = queue.empty() ? 0.05 : std::max(0.0, queue.front().due - now);
+			if (eof) {
+				sleep_ms((int)(wait * 1000.0) + 1, "latency-proxy");
+				continue;
+			}
+			if (!fd_util::WaitUntilReady(from, wait, false))
+				continue;
+			int received = (int)recv(from, buf, sizeof(buf), MSG_NOSIGNAL);
+			if (received <= 0) {
+				eof = true;
+				continue;
+			}
+			queue.push_back(Chunk{ time_now_d() + latency_ + firstDelay, std::string(buf, received) });
+			firstDelay = 0.0;
+		}
+	}
+
+	int serverPort_;
+	double latency_;
+	int port_ = 0;
+	int listener_ = -1;
+	std::atomic<bool> quit_{ false };
+	std::atomic<int> connections_{ 0 };
+	std::thread acceptThread_;
+	std::vector<std::unique_ptr<Conn>> conns_;
+};
+
+// Like older versions of the server: one request per connection.
+static void ServeDiscImageAndClose(const http::ServerRequest &request, const std::vector<u8> &image) {
+	// Written by hand, since WriteHttpResponseHeader would offer keep-alive.
+	std::string range;
+	s64 begin = 0, last = 0;
+	if (request.Method() == http::RequestHeader::HEAD) {
+		request.Out()->Printf("HTTP/1.0 200 OK\r\nContent-Length: %d\r\nAccept-Ranges: bytes\r\nConnection: close\r\n\r\n", (int)image.size());
+	} else if (request.GetHeader("range", &range) && sscanf(range.c_str(), "bytes=%lld-%lld", &begin, &last) == 2) {
+		request.Out()->Printf("HTTP/1.0 206 Partial Content\r\nContent-Length: %lld\r\nContent-Range: bytes %lld-%lld/%d\r\nConnection: close\r\n\r\n", last - begin + 1, begin, last, (int)image.size());
+		request.Out()->Push((const char *)&image[begin], (size_t)(last - begin + 1));
+	}
+}
+
+static bool TestLoaderReads(int port, const std::vector<u8> &image) {
+	Path url(StringFromFormat("http://127.0.0.1:%d/disc.iso", port));
+
+	// Straight to the loader first, a big read gets split up and pipelined.
+	HTTPFileLoader direct(url);
+	EXPECT_EQ_INT((int)direct.FileSize(), LOADER_IMAGE_SIZE);
+	std::vector<u8> buf(1024 * 1024 + 1000);
+	EXPECT_EQ_INT((int)direct.ReadAt(12345, buf.size(), buf.data()), (int)buf.size());
+	EXPECT_TRUE(memcmp(buf.data(), &image[12345], buf.size()) == 0);
+	// Off the end gets cut short.
+	EXPECT_EQ_INT((int)direct.ReadAt(LOADER_IMAGE_SIZE - 100, 1000, buf.data()), 100);
+	EXPECT_TRUE(memcmp(buf.data(), &image[LOADER_IMAGE_SIZE - 100], 100) == 0);
+
+	// A cancel stops the read in progress, but not the ones after it.
+	std::vector<u8> whole(LOADER_IMAGE_SIZE);
+	std::thread canceller([&] {
+		sleep_ms(5, "cancel-read");
+		direct.Cancel();
+	});
+	size_t cancelledBytes = direct.ReadAt(0, whole.size(), whole.data());
+	canceller.join();
+	EXPECT_TRUE(cancelledBytes < whole.size());
+	EXPECT_EQ_INT((int)direct.ReadAt(12345, buf.size(), buf.data()), (int)buf.size());
+	EXPECT_TRUE(memcmp(buf.data(), &image[12345], buf.size()) == 0);
+
+	// Then through the cache, with reads all over the place, some of them at once.
+	CachingFileLoader cached(new HTTPFileLoader(url));
+	std::atomic<bool> failed{ false };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 2; ++t) {
+		readers.push_back(std::thread([&, t] {
+			u32 seed = 0x4321 + t;
+			std::vector<u8> data(200000);
+			for (int i = 0; i < 100 && !failed; ++i) {
+				seed = seed * 1103515245 + 12345;
+				size_t size = 1 + (seed >> 8) % data.size();
+				seed = seed * 1103515245 + 12345;
+				s64 pos = (seed >> 8) % (LOADER_IMAGE_SIZE - size);
+				if (cached.ReadAt(pos, size, data.data()) != size || memcmp(data.data(), &image[pos], size) != 0) {
+					printf("HTTPFileLoader: read of %d bytes at %lld came back wrong\n", (int)size, pos);
+					failed = true;
+				}
+			}
+		}));
+	}
+	for (auto &reader : readers)
+		reader.join();
+	return !failed;
+}
+
+// Reads through the whole image from start to finish, like a game streaming a movie.
+static bool BenchmarkSequentialRead(int port, const std::vector<u8> &image, double &mbPerSecond) {
+	CachingFileLoader cached(new HTTPFileLoader(Path(StringFromFormat("http://127.0.0.1:%d/disc.iso", port))));
+	if (cached.FileSize() != LOADER_IMAGE_SIZE)
+		return false;
+
+	std::vector<u8> buf(SEQUENTIAL_READ_SIZE);
+	double st = time_now_d();
+	for (s64 pos = 0; pos < LOADER_IMAGE_SIZE; pos += SEQUENTIAL_READ_SIZE) {
+		if (cached.ReadAt(pos, SEQUENTIAL_READ_SIZE, buf.data()) != SEQUENTIAL_READ_SIZE || memcmp(buf.data(), &image[pos], SEQUENTIAL_READ_SIZE) != 0)
+			return false;
+	}
+	mbPerSecond = LOADER_IMAGE_SIZE / (time_now_d() - st) / (1024.0 * 1024.0);
+	return true;
+}
+
+bool TestHTTPFileLoader() {
+	net::Init();
+
+	HTTPTestImage testImage(Path("http_file_loader_test.bin"), LOADER_IMAGE_SIZE, 0x1234567);
+	EXPECT_TRUE(testImage.written);
+	const Path &imagePath = testImage.path;
+	const std::vector<u8> &image = testImage.data;
+
+	bool success;
+	double keepAliveRate = 0.0, closeRate = 0.0;
+	int keepAliveConns = 0, closeConns = 0;
+	{
+		HTTPTestServer server(new PooledExecutor(8), "HTTPFileLoader test", [&](const http::ServerRequest &request) {
+			ServeDiscImage(request, imagePath);
+		});
+		success = server.Start();
+		if (success) {
+			LatencyProxy proxy(server.Port(), PROXY_LATENCY);
+			success = proxy.Start() && TestLoaderReads(proxy.Port(), image) && BenchmarkSequentialRead(proxy.Port(), image, keepAliveRate);
+			keepAliveConns = proxy.Connections();
+		}
+	}
+	if (success) {
+		HTTPTestServer server(new PooledExecutor(8), "HTTPFileLoader test", [&](const http::ServerRequest &request) {
+			ServeDiscImageAndClose(request, image);
+		});
+		success = server.Start();
+		if (success) {
+			LatencyProxy proxy(server.Port(), PROXY_LATENCY);
+			success = proxy.Start() && TestLoaderReads(proxy.Port(), image) && BenchmarkSequentialRead(proxy.Port(), image, closeRate);
+			closeConns = proxy.Connections();
+		}
+	}
+	if (success) {
+		printf("HTTPFileLoader: sequential read with %0.1f ms round trips, one request per connection: %0.1f MB/s (%d connections)\n", PROXY_LATENCY * 2000.0, closeRate, closeConns);
+		printf("HTTPFileLoader: sequential read with %0.1f ms round trips, keep-alive and pipelining: %0.1f MB/s (%d connections)\n", PROXY_LATENCY * 2000.0, keepAliveRate, keepAliveConns);
+	}
+
+	net::Shutdown();
+	return success;
+}
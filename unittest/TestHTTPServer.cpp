@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/Net/HTTPServer.h"
+#include "Common/Net/Resolve.h"
+#include "Common/Net/Sinks.h"
+#include "Common/Net/SocketCompat.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "Core/FileLoaders/HTTPFileLoader.h"
+#include "Core/WebServer.h"
+
+#include "unittest/HTTPHarness.h"
+#include "unittest/UnitTest.h"
+
+static const int TEST_IMAGE_SIZE = 8 * 1024 * 1024;
+static const int BENCHMARK_CLIENTS = 8;
+static const int BENCHMARK_READ_SIZE = 16 * 1024;
+static const double BENCHMARK_SECONDS = 0.5;
+
+// The way disc images used to be served: a fresh file read for every range request.
+static void ServeDiscImageUncached(const http::ServerRequest &request, const Path &filename) {
+	s64 sz = File::GetFileSize(filename);
+	if (request.Method() == http::RequestHeader::HEAD) {
+		request.WriteHttpResponseHeader("1.0", 200, sz, "application/octet-stream", "Accept-Ranges: bytes\r\n");
+		return;
+	}
+
+	std::string range;
+	s64 begin = 0, last = 0;
+	if (!request.GetHeader("range", &range) || sscanf(range.c_str(), "bytes=%lld-%lld", &begin, &last) != 2 || begin > last || last >= sz) {
+		request.WriteHttpResponseHeader("1.0", 400, -1, "text/plain");
+		return;
+	}
+
+	FILE *fp = File::OpenCFile(filename, "rb");
+	if (!fp || fseek(fp, begin, SEEK_SET) != 0) {
+		request.WriteHttpResponseHeader("1.0", 500, -1, "text/plain");
+		if (fp)
+			fclose(fp);
+		return;
+	}
+
+	s64 len = last - begin + 1;
+	char contentRange[1024];
+	snprintf(contentRange, sizeof(contentRange), "Content-Range: bytes %lld-%lld/%lld\r\n", begin, last, sz);
+	request.WriteHttpResponseHeader("1.0", 206, len, "application/octet-stream", contentRange);
+
+	const size_t CHUNK_SIZE = 16 * 1024;
+	char *buf = new char[CHUNK_SIZE];
+	for (s64 pos = 0; pos < len; pos += CHUNK_SIZE) {
+		s64 chunklen = std::min(len - pos, (s64)CHUNK_SIZE);
+		if (fread(buf, chunklen, 1, fp) != 1)
+			break;
+		request.Out()->Push(buf, chunklen);
+	}
+	fclose(fp);
+	delete[] buf;
+	request.Out()->Flush();
+}
+
+static int ConnectTestClient(int port) {
+	int sock = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0)
+		return -1;
+#if PPSSPP_PLATFORM(WINDOWS)
+	DWORD timeout = 5000;
+#else
+	timeval timeout{ 5, 0 };
+#endif
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+
+	sockaddr_in server{};
+	server.sin_family = AF_INET;
+	server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	server.sin_port = htons(port);
+	if (connect(sock, (sockaddr *)&server, sizeof(server)) != 0) {
+		closesocket(sock);
+		return -1;
+	}
+	return sock;
+}
+
+struct TestResponse {
+	int status = 0;
+	bool keepAlive = false;
+	std::string body;
+};
+
+// Reads one response, leaving anything after it in pending.  Returns false on a short read.
+static bool ReadTestResponse(int sock, std::string &pending, TestResponse &response) {
+	auto fill = [&]() {
+		char buf[16384];
+		int received = (int)recv(sock, buf, sizeof(buf), MSG_NOSIGNAL);
+		if (received <= 0)
+			return false;
+		pending.append(buf, received);
+		return true;
+	};
+
+	size_t headerEnd;
+	while ((headerEnd = pending.find("\r\n\r\n")) == std::string::npos) {
+		if (!fill())
+			return false;
+	}
+
+	std::string header = pending.substr(0, headerEnd + 2);
+	pending.erase(0, headerEnd + 4);
+	if (sscanf(header.c_str(), "HTTP/%*d.%*d %d", &response.status) != 1)
+		return false;
+	response.keepAlive = header.find("Connection: keep-alive\r\n") != std::string::npos;
+
+	size_t lengthPos = header.find("Content-Length: ");
+	if (lengthPos == std::string::npos)
+		return false;
+	size_t length = (size_t)atoll(header.c_str() + lengthPos + strlen("Content-Length: "));
+	while (pending.size() < length) {
+		if (!fill())
+			return false;
+	}
+	response.body = pending.substr(0, length);
+	pending.erase(0, length);
+	return true;
+}
+
+static bool TestKeepAlive(int port, const std::vector<u8> &image) {
+	int sock = ConnectTestClient(port);
+	EXPECT_TRUE(sock >= 0);
+
+	// All sent at once, the responses should come back in order.
+	const int ranges[][2] = { { 0, 99 }, { 65530, 200000 }, { TEST_IMAGE_SIZE - 10, TEST_IMAGE_SIZE - 1 } };
+	std::string requests;
+	for (const auto &range : ranges)
+		requests += StringFromFormat("GET /disc.iso HTTP/1.1\r\nHost: localhost\r\nRange: bytes=%d-%d\r\n\r\n", range[0], range[1]);
+	EXPECT_EQ_INT((int)send(sock, requests.c_str(), (int)requests.size(), MSG_NOSIGNAL), (int)requests.size());
+
+	std::string pending;
+	for (const auto &range : ranges) {
+		TestResponse response;
+		EXPECT_TRUE(ReadTestResponse(sock, pending, response));
+		EXPECT_EQ_INT(response.status, 206);
+		EXPECT_TRUE(response.keepAlive);
+		EXPECT_EQ_INT((int)response.body.size(), range[1] - range[0] + 1);
+		EXPECT_TRUE(memcmp(response.body.data(), &image[range[0]], response.body.size()) == 0);
+	}
+
+	// Still open, after a pause that's long enough to have parked it.
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	requests = "GET /disc.iso HTTP/1.1\r\nRange: bytes=1000-1999\r\n\r\n";
+	EXPECT_EQ_INT((int)send(sock, requests.c_str(), (int)requests.size(), MSG_NOSIGNAL), (int)requests.size());
+	TestResponse response;
+	EXPECT_TRUE(ReadTestResponse(sock, pending, response));
+	EXPECT_EQ_INT(response.status, 206);
+	EXPECT_TRUE(memcmp(response.body.data(), &image[1000], 1000) == 0);
+	closesocket(sock);
+
+	// HTTP/1.0 without asking for keep-alive gets the connection closed after.
+	sock = ConnectTestClient(port);
+	EXPECT_TRUE(sock >= 0);
+	requests = "GET /disc.iso HTTP/1.0\r\nRange: bytes=0-9\r\n\r\n";
+	EXPECT_EQ_INT((int)send(sock, requests.c_str(), (int)requests.size(), MSG_NOSIGNAL), (int)requests.size());
+	pending.clear();
+	EXPECT_TRUE(ReadTestResponse(sock, pending, response));
+	EXPECT_EQ_INT(response.status, 206);
+	EXPECT_FALSE(response.keepAlive);
+	char c;
+	EXPECT_EQ_INT((int)recv(sock, &c, 1, MSG_NOSIGNAL), 0);
+	closesocket(sock);
+	return true;
+}
+
+// Several emulators streaming from the same host, with random reads like a game would do.
+static bool BenchmarkRemoteISO(int port, const std::vector<u8> &image, double &mbPerSecond) {
+	std::atomic<bool> failed{ false };
+	std::atomic<int64_t> totalBytes{ 0 };
+	std::vector<std::thread> clients;
+	Path url(StringFromFormat("http://127.0.0.1:%d/disc.iso", port));
+
+	double st = time_now_d();
+	for (int i = 0; i < BENCHMARK_CLIENTS; ++i) {
+		clients.push_back(std::thread([&, i] {
+			HTTPFileLoader loader(url);
+			if (loader.FileSize() != TEST_IMAGE_SIZE) {
+				failed = true;
+				return;
+			}
+
+			u32 seed = 0x1234 + i;
+			std::vector<u8> buf(BENCHMARK_READ_SIZE);
+			while (!failed && time_now_d() - st < BENCHMARK_SECONDS) {
+				seed = seed * 1103515245 + 12345;
+				// Games mostly read in whole sectors.
+				s64 pos = (s64)((seed >> 8) % ((TEST_IMAGE_SIZE - BENCHMARK_READ_SIZE) / 2048)) * 2048;
+				if (loader.ReadAt(pos, BENCHMARK_READ_SIZE, buf.data()) != BENCHMARK_READ_SIZE || memcmp(buf.data(), &image[pos], BENCHMARK_READ_SIZE) != 0) {
+					failed = true;
+					return;
+				}
+				totalBytes += BENCHMARK_READ_SIZE;
+			}
+		}));
+	}
+	for (auto &client : clients)
+		client.join();
+
+	mbPerSecond = totalBytes / (time_now_d() - st) / (1024.0 * 1024.0);
+	return !failed;
+}
+
+bool TestHTTPServer() {
+	net::Init();
+
+	HTTPTestImage testImage(Path("http_server_test.bin"), TEST_IMAGE_SIZE, 0x7654321);
+	EXPECT_TRUE(testImage.written);
+	const Path &imagePath = testImage.path;
+	const std::vector<u8> &image = testImage.data;
+
+	bool success = true;
+	{
+		HTTPTestServer server(new PooledExecutor(4), "HTTPServer test", [&](const http::ServerRequest &request) {
+			ServeDiscImage(request, imagePath);
+		});
+		success = server.Start() && TestKeepAlive(server.Port(), image);
+	}
+
+	double oldRate = 0.0, newRate = 0.0;
+	if (success) {
+		HTTPTestServer server(new NewThreadExecutor(), "HTTPServer test", [&](const http::ServerRequest &request) {
+			ServeDiscImageUncached(request, imagePath);
+		});
+		success = server.Start() && BenchmarkRemoteISO(server.Port(), image, oldRate);
+	}
+	if (success) {
+		HTTPTestServer server(new PooledExecutor(4), "HTTPServer test", [&](const http::ServerRequest &request) {
+			ServeDiscImage(request, imagePath);
+		});
+		success = server.Start() && BenchmarkRemoteISO(server.Port(), image, newRate);
+	}
+	if (success) {
+		printf("HTTPServer: %d clients reading %d KB at a time, thread per connection and file reads: %0.1f MB/s\n", BENCHMARK_CLIENTS, BENCHMARK_READ_SIZE / 1024, oldRate);
+		printf("HTTPServer: %d clients reading %d KB at a time, worker pool and block cache: %0.1f MB/s\n", BENCHMARK_CLIENTS, BENCHMARK_READ_SIZE / 1024, newRate);
+	}
+
+	net::Shutdown();
+	return success;
+}
@@ -0,0 +1,214 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+#include "Common/TimeUtil.h"
+#include "GPU/ge_constants.h"
+#include "GPU/Common/IndexGenerator.h"
+
+#include "unittest/UnitTest.h"
+
+// Straightforward scalar versions, used both as the reference for the vectorized paths and as
+// the baseline for the timings. These match the original IndexGenerator loops.
+
+template <class ITypeLE>
+static u16 *RefTranslate(u16 *out, int prim, int numInds, const ITypeLE *inds, int indexOffset, bool clockwise) {
+	const int v1 = clockwise ? 1 : 2;
+	const int v2 = clockwise ? 2 : 1;
+	switch (prim) {
+	case GE_PRIM_POINTS:
+		for (int i = 0; i < numInds; i++)
+			*out++ = indexOffset + inds[i];
+		break;
+	case GE_PRIM_LINES:
+	case GE_PRIM_RECTANGLES:
+		for (int i = 0; i < (numInds & ~1); i += 2) {
+			*out++ = indexOffset + inds[i];
+			*out++ = indexOffset + inds[i + 1];
+		}
+		break;
+	case GE_PRIM_LINE_STRIP:
+		for (int i = 0; i < numInds - 1; i++) {
+			*out++ = indexOffset + inds[i];
+			*out++ = indexOffset + inds[i + 1];
+		}
+		break;
+	case GE_PRIM_TRIANGLES:
+		if (sizeof(ITypeLE) == sizeof(u16) && indexOffset == 0 && clockwise) {
+			// Plain copy, which doesn't round to whole triangles.
+			for (int i = 0; i < numInds; i++)
+				*out++ = inds[i];
+			break;
+		}
+		for (int i = 0; i < (numInds / 3) * 3; i += 3) {
+			*out++ = indexOffset + inds[i];
+			*out++ = indexOffset + inds[i + v1];
+			*out++ = indexOffset + inds[i + v2];
+		}
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+	{
+		int wind = clockwise ? 1 : 2;
+		for (int i = 0; i < numInds - 2; i++) {
+			*out++ = indexOffset + inds[i];
+			*out++ = indexOffset + inds[i + wind];
+			wind ^= 3;
+			*out++ = indexOffset + inds[i + wind];
+		}
+		break;
+	}
+	case GE_PRIM_TRIANGLE_FAN:
+		for (int i = 0; i < numInds - 2; i++) {
+			*out++ = indexOffset + inds[0];
+			*out++ = indexOffset + inds[i + v1];
+			*out++ = indexOffset + inds[i + v2];
+		}
+		break;
+	}
+	return out;
+}
+
+static u16 *RefAddFan(u16 *out, int numVerts, int indexOffset, bool clockwise) {
+	const int v1 = clockwise ? 1 : 2;
+	const int v2 = clockwise ? 2 : 1;
+	for (int i = 0; i < numVerts - 2; i++) {
+		*out++ = indexOffset;
+		*out++ = indexOffset + i + v1;
+		*out++ = indexOffset + i + v2;
+	}
+	return out;
+}
+
+template <class ITypeLE>
+static bool CompareTranslate(const char *typeName, int prim, int numInds, const ITypeLE *inds, int indexOffset, bool clockwise) {
+	// Generous padding, since some paths may write a little past the end.
+	static u16 expected[4096 * 3 + 64];
+	static u16 actual[4096 * 3 + 64];
+
+	u16 *expectedEnd = RefTranslate(expected, prim, numInds, inds, indexOffset, clockwise);
+	IndexGenerator gen;
+	gen.Setup(actual);
+	gen.TranslatePrim(prim, numInds, inds, indexOffset, clockwise);
+
+	const int expectedCount = (int)(expectedEnd - expected);
+	if (gen.VertexCount() != expectedCount || memcmp(expected, actual, expectedCount * sizeof(u16)) != 0) {
+		printf("TranslatePrim mismatch: %s prim %d count %d offset %d %s\n", typeName, prim, numInds, indexOffset, clockwise ? "cw" : "ccw");
+		return false;
+	}
+	return true;
+}
+
+static bool TestIndexGeneratorCorrectness() {
+	static const int counts[] = { 0, 1, 2, 3, 4, 7, 8, 9, 10, 11, 16, 17, 23, 24, 25, 26, 33, 100, 1001, 4096 };
+	static const int offsets[] = { 0, 1, 300, 65530 };
+
+	std::vector<u8> inds8(4096 + 16);
+	std::vector<u16_le> inds16(4096 + 16);
+	std::vector<u32_le> inds32(4096 + 16);
+	u32 seed = 0x1234567;
+	for (size_t i = 0; i < inds32.size(); i++) {
+		seed = seed * 1103515245 + 12345;
+		inds8[i] = (u8)(seed >> 16);
+		inds16[i] = (u16)(seed >> 8);
+		// Upper bits should be ignored, like the scalar path does.
+		inds32[i] = seed;
+	}
+
+	for (int prim = GE_PRIM_POINTS; prim <= GE_PRIM_RECTANGLES; prim++) {
+		for (int count : counts) {
+			for (int offset : offsets) {
+				for (int cw = 0; cw < 2; cw++) {
+					RET(CompareTranslate("u8", prim, count, inds8.data(), offset, cw != 0));
+					RET(CompareTranslate("u16", prim, count, inds16.data(), offset, cw != 0));
+					RET(CompareTranslate("u32", prim, count, inds32.data(), offset, cw != 0));
+				}
+			}
+		}
+	}
+
+	static u16 expected[4096 * 3 + 64];
+	static u16 actual[4096 * 3 + 64];
+	for (int count : counts) {
+		for (int offset : offsets) {
+			for (int cw = 0; cw < 2; cw++) {
+				u16 *expectedEnd = RefAddFan(expected, count, offset, cw != 0);
+				IndexGenerator gen;
+				gen.Setup(actual);
+				gen.AddPrim(GE_PRIM_TRIANGLE_FAN, count, offset, cw != 0);
+				const int expectedCount = (int)(expectedEnd - expected);
+				EXPECT_EQ_INT(gen.VertexCount(), expectedCount);
+				if (memcmp(expected, actual, expectedCount * sizeof(u16)) != 0) {
+					printf("AddFan mismatch: count %d offset %d %s\n", count, offset, cw ? "cw" : "ccw");
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+template <class ITypeLE>
+static void BenchmarkTranslate(const char *desc, int prim, const ITypeLE *inds, int numInds, u16 *out) {
+	const int rounds = 200;
+
+	int total = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < rounds; ++j) {
+			RefTranslate(out, prim, numInds, inds, 17, true);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	double scalarRate = total / (time_now_d() - st);
+
+	total = 0;
+	IndexGenerator gen;
+	st = time_now_d();
+	do {
+		for (int j = 0; j < rounds; ++j) {
+			gen.Setup(out);
+			gen.TranslatePrim(prim, numInds, inds, 17, true);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	double genRate = total / (time_now_d() - st);
+
+	const double mindsScale = numInds / 1000000.0;
+	printf("%-16s scalar: %8.1f Minds/s, IndexGenerator: %8.1f Minds/s (%0.2fx)\n", desc, scalarRate * mindsScale, genRate * mindsScale, genRate / scalarRate);
+}
+
+static void BenchmarkIndexGenerator() {
+	// Roughly the size of a big tessellated terrain or particle draw.
+	const int numInds = 30000;
+	std::vector<u8> inds8(numInds + 16);
+	std::vector<u16_le> inds16(numInds + 16);
+	std::vector<u32_le> inds32(numInds + 16);
+	for (int i = 0; i < (int)inds16.size(); i++) {
+		inds8[i] = (u8)i;
+		inds16[i] = (u16)i;
+		inds32[i] = (u32)i;
+	}
+	std::vector<u16> out(numInds * 3 + 64);
+
+	BenchmarkTranslate("strip u8", GE_PRIM_TRIANGLE_STRIP, inds8.data(), numInds, out.data());
+	BenchmarkTranslate("strip u16", GE_PRIM_TRIANGLE_STRIP, inds16.data(), numInds, out.data());
+	BenchmarkTranslate("strip u32", GE_PRIM_TRIANGLE_STRIP, inds32.data(), numInds, out.data());
+	BenchmarkTranslate("fan u16", GE_PRIM_TRIANGLE_FAN, inds16.data(), numInds, out.data());
+	BenchmarkTranslate("list u8", GE_PRIM_TRIANGLES, inds8.data(), numInds, out.data());
+	BenchmarkTranslate("list u16", GE_PRIM_TRIANGLES, inds16.data(), numInds, out.data());
+	BenchmarkTranslate("list u32", GE_PRIM_TRIANGLES, inds32.data(), numInds, out.data());
+	BenchmarkTranslate("points u16", GE_PRIM_POINTS, inds16.data(), numInds, out.data());
+}
+
+bool TestIndexGenerator() {
+	if (!TestIndexGeneratorCorrectness()) {
+		return false;
+	}
+
+	// The interesting thing here is the logged output.
+	BenchmarkIndexGenerator();
+	return true;
+}
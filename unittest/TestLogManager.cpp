@@ -0,0 +1,148 @@
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Log/LogManager.h"
+#include "Common/TimeUtil.h"
+
+#include "unittest/UnitTest.h"
+
+static void LogTo(LogManager &manager, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	manager.LogLine(LogLevel::LINFO, Log::System, __FILE__, __LINE__, fmt, args);
+	va_end(args);
+}
+
+struct CollectedLog {
+	std::mutex lock;
+	std::vector<std::string> messages;
+	// Makes the output slow, so queues fill up.
+	std::atomic<bool> slow{ false };
+};
+
+static void CollectLogMessage(const LogMessage &message, void *userdata) {
+	CollectedLog *log = (CollectedLog *)userdata;
+	if (log->slow)
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	std::lock_guard<std::mutex> guard(log->lock);
+	log->messages.push_back(message.msg);
+}
+
+static bool TestAsyncLogOrdering(LogManager &manager, CollectedLog &log) {
+	// More messages than fit in a queue, from a few threads at once.
+	const int NUM_THREADS = 4;
+	const int NUM_MESSAGES = 20000;
+
+	manager.SetAsyncMode(LogAsyncMode::Block);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < NUM_THREADS; ++t) {
+		threads.push_back(std::thread([&manager, t] {
+			for (int i = 0; i < NUM_MESSAGES; ++i)
+				LogTo(manager, "%d %d", t, i);
+		}));
+	}
+	for (auto &th : threads)
+		th.join();
+	manager.FlushAsync();
+
+	EXPECT_EQ_INT((int)log.messages.size(), NUM_THREADS * NUM_MESSAGES);
+	EXPECT_EQ_INT((int)manager.GetAsyncDroppedCount(), 0);
+
+	// Each thread's messages have to come out in the order they were logged.
+	int next[NUM_THREADS]{};
+	for (const std::string &msg : log.messages) {
+		int t = -1, i = -1;
+		EXPECT_EQ_INT(sscanf(msg.c_str(), "%d %d", &t, &i), 2);
+		EXPECT_TRUE(t >= 0 && t < NUM_THREADS);
+		EXPECT_EQ_INT(i, next[t]);
+		next[t]++;
+	}
+	return true;
+}
+
+static bool TestAsyncLogDrop(LogManager &manager, CollectedLog &log) {
+	const int NUM_MESSAGES = 3000;
+
+	log.messages.clear();
+	log.slow = true;
+	manager.SetAsyncMode(LogAsyncMode::Drop);
+	for (int i = 0; i < NUM_MESSAGES; ++i)
+		LogTo(manager, "%d", i);
+	manager.FlushAsync();
+	log.slow = false;
+
+	// Nothing should go missing without being counted.
+	const int dropped = (int)manager.GetAsyncDroppedCount();
+	EXPECT_EQ_INT((int)log.messages.size() + dropped, NUM_MESSAGES);
+	printf("Async log dropped %d of %d messages with a slow output\n", dropped, NUM_MESSAGES);
+
+	// Once off, messages are written before LogLine returns.
+	manager.SetAsyncMode(LogAsyncMode::Off);
+	log.messages.clear();
+	LogTo(manager, "sync");
+	EXPECT_EQ_INT((int)log.messages.size(), 1);
+	return true;
+}
+
+static void WriteLogMessage(const LogMessage &message, void *userdata) {
+	// Roughly what the file output does.
+	FILE *fp = (FILE *)userdata;
+	fprintf(fp, "%s %s %s", message.timestamp, message.header, message.msg.c_str());
+	fflush(fp);
+}
+
+static void BenchmarkLogManager(LogManager &manager) {
+	FILE *fp = tmpfile();
+	if (!fp)
+		return;
+	manager.SetExternalLogCallback(&WriteLogMessage, fp);
+
+	// Less than a queue holds, so this measures the logging thread and not the writer.
+	const int NUM_MESSAGES = 800;
+	static const LogAsyncMode modes[] = { LogAsyncMode::Off, LogAsyncMode::Block };
+	static const char *const modeNames[] = { "sync", "async" };
+	for (int m = 0; m < 2; ++m) {
+		manager.SetAsyncMode(modes[m]);
+		double st = time_now_d();
+		for (int i = 0; i < NUM_MESSAGES; ++i)
+			LogTo(manager, "sceIoRead(%d, %08x, %d): %d bytes", 3, 0x08804000 + i * 16, 2048, 2048);
+		// What the logging thread sees, not counting the writer.
+		double logging = time_now_d() - st;
+		manager.FlushAsync();
+		double total = time_now_d() - st;
+		printf("LogLine %-5s: %0.2f us/message on the calling thread, %0.2f us including output\n", modeNames[m], logging * 1000000.0 / NUM_MESSAGES, total * 1000000.0 / NUM_MESSAGES);
+	}
+
+	manager.SetAsyncMode(LogAsyncMode::Off);
+	manager.SetExternalLogCallback(nullptr, nullptr);
+	fclose(fp);
+}
+
+bool TestLogManager() {
+	// A separate instance, so the test doesn't mess with real logging.
+	LogManager manager;
+	CollectedLog log;
+	manager.SetOutputsEnabled(LogOutput::ExternalCallback);
+	manager.SetExternalLogCallback(&CollectLogMessage, &log);
+
+	const LogLevel savedLevel = g_logManager.GetLogLevel(Log::System);
+	const bool savedEnabled = g_logManager.GetLogChannel(Log::System)->enabled;
+	manager.SetEnabled(Log::System, true);
+	manager.SetLogLevel(Log::System, LogLevel::LINFO);
+
+	bool success = TestAsyncLogOrdering(manager, log) && TestAsyncLogDrop(manager, log);
+	if (success)
+		BenchmarkLogManager(manager);
+
+	manager.SetAsyncMode(LogAsyncMode::Off);
+	manager.SetLogLevel(Log::System, savedLevel);
+	manager.SetEnabled(Log::System, savedEnabled);
+	return success;
+}
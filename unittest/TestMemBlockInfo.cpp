@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/TimeUtil.h"
+#include "Core/Debugger/MemBlockInfo.h"
+
+#include "unittest/UnitTest.h"
+
+// Straightforward model of what MemBlockInfo should remember, one entry per byte.
+struct MemInfoModel {
+	static const uint32_t BASE = 0x08800000;
+	static const uint32_t SIZE = 0x10000;
+
+	struct Byte {
+		uint32_t pc = 0;
+		int tag = -1;
+		bool allocated = false;
+	};
+	std::vector<Byte> bytes = std::vector<Byte>(SIZE);
+
+	void Mark(uint32_t start, uint32_t size, uint32_t pc, bool allocated, int tag) {
+		for (uint32_t i = start - BASE; i < start - BASE + size; ++i) {
+			bytes[i].allocated = allocated;
+			if (pc != 0)
+				bytes[i].pc = pc;
+			if (tag != -1)
+				bytes[i].tag = tag;
+		}
+	}
+};
+
+static const char *const memInfoTags[] = { "MemInit", "DmacMemcpy", "ReplaceMemcpy/", "GPU/", "sceIoRead" };
+
+static bool CompareMemInfo(const MemInfoModel &model, MemBlockFlags flag, uint32_t start, uint32_t size) {
+	std::vector<MemBlockInfo> results = FindMemInfoByFlag(flag, start, size);
+
+	std::vector<MemInfoModel::Byte> found(size);
+	for (size_t r = 0; r < results.size(); ++r) {
+		const MemBlockInfo &info = results[r];
+		EXPECT_TRUE(info.start < start + size && info.start + info.size > start);
+
+		int tag = -1;
+		for (int i = 0; i < (int)ARRAY_SIZE(memInfoTags); ++i) {
+			if (info.tag == memInfoTags[i])
+				tag = i;
+		}
+		EXPECT_TRUE(tag != -1 || info.tag.empty());
+
+		// Neighbors that are the same should've been merged.
+		if (r > 0) {
+			const MemBlockInfo &prev = results[r - 1];
+			EXPECT_FALSE(prev.start + prev.size == info.start && prev.pc == info.pc && prev.tag == info.tag && prev.allocated == info.allocated);
+		}
+
+		uint32_t from = std::max(info.start, start);
+		uint32_t to = std::min(info.start + info.size, start + size);
+		for (uint32_t addr = from; addr < to; ++addr) {
+			found[addr - start] = { info.pc, tag, info.allocated };
+		}
+	}
+
+	for (uint32_t i = 0; i < size; ++i) {
+		const MemInfoModel::Byte &expected = model.bytes[start + i - MemInfoModel::BASE];
+		// Ranges without a pc or tag aren't reported.
+		if (expected.pc == 0 && expected.tag == -1)
+			continue;
+		if (found[i].pc != expected.pc || found[i].tag != expected.tag || found[i].allocated != expected.allocated) {
+			printf("MemBlockInfo mismatch at %08x: pc %08x/%08x tag %d/%d allocated %d/%d\n", start + i, found[i].pc, expected.pc, found[i].tag, expected.tag, found[i].allocated, expected.allocated);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool TestMemBlockInfoRandom() {
+	MemInfoModel writes;
+	MemInfoModel allocs;
+
+	u32 seed = 0x7654321;
+	auto nextRand = [&]() {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	};
+
+	for (int iter = 0; iter < 20000; ++iter) {
+		uint32_t size = 1 + nextRand() % (nextRand() % 8 == 0 ? 0x2000 : 0x100);
+		uint32_t start = MemInfoModel::BASE + nextRand() % (MemInfoModel::SIZE - size);
+		uint32_t pc = 0x08804000 + (nextRand() % 4) * 4;
+		int tag = nextRand() % ARRAY_SIZE(memInfoTags);
+		const char *tagStr = memInfoTags[tag];
+
+		switch (nextRand() % 4) {
+		case 0:
+		case 1:
+			NotifyMemInfoPC(MemBlockFlags::WRITE | MemBlockFlags::SKIP_MEMCHECK, start, size, pc, tagStr, strlen(tagStr));
+			writes.Mark(start, size, pc, true, tag);
+			break;
+		case 2:
+			NotifyMemInfoPC(MemBlockFlags::ALLOC | MemBlockFlags::SKIP_MEMCHECK, start, size, pc, tagStr, strlen(tagStr));
+			allocs.Mark(start, size, pc, true, tag);
+			break;
+		case 3:
+			// Keeps the previous tag, just not allocated anymore.
+			NotifyMemInfoPC(MemBlockFlags::FREE | MemBlockFlags::SKIP_MEMCHECK, start, size, pc, "", 0);
+			allocs.Mark(start, size, 0, false, -1);
+			break;
+		}
+
+		// Every so often, look at something - which also flushes.
+		if ((iter % 97) == 0) {
+			uint32_t checkSize = 1 + nextRand() % 0x1000;
+			uint32_t checkStart = MemInfoModel::BASE + nextRand() % (MemInfoModel::SIZE - checkSize);
+			RET(CompareMemInfo(writes, MemBlockFlags::WRITE, checkStart, checkSize));
+			RET(CompareMemInfo(allocs, MemBlockFlags::ALLOC, checkStart, checkSize));
+		}
+	}
+
+	RET(CompareMemInfo(writes, MemBlockFlags::WRITE, MemInfoModel::BASE, MemInfoModel::SIZE));
+	RET(CompareMemInfo(allocs, MemBlockFlags::ALLOC, MemInfoModel::BASE, MemInfoModel::SIZE));
+	return true;
+}
+
+static bool TestMemBlockInfoThreads() {
+	// Several threads at once, each writing its own area, which all have to get merged in.
+	const int NUM_THREADS = 4;
+	const uint32_t AREA_SIZE = MemInfoModel::SIZE / NUM_THREADS;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < NUM_THREADS; ++t) {
+		threads.push_back(std::thread([=] {
+			const uint32_t base = MemInfoModel::BASE + t * AREA_SIZE;
+			for (int i = 0; i < 10000; ++i) {
+				uint32_t offset = (i * 64) % AREA_SIZE;
+				NotifyMemInfoPC(MemBlockFlags::WRITE | MemBlockFlags::SKIP_MEMCHECK, base + offset, 64, 0x08900000 + t * 4, "GPU/", 4);
+			}
+		}));
+	}
+	for (auto &th : threads)
+		th.join();
+
+	for (int t = 0; t < NUM_THREADS; ++t) {
+		std::vector<MemBlockInfo> results = FindMemInfoByFlag(MemBlockFlags::WRITE, MemInfoModel::BASE + t * AREA_SIZE, AREA_SIZE);
+		// All the same, so it should be one block covering the whole area.
+		EXPECT_EQ_INT((int)results.size(), 1);
+		EXPECT_EQ_HEX(results[0].start, MemInfoModel::BASE + t * AREA_SIZE);
+		EXPECT_EQ_HEX(results[0].size, AREA_SIZE);
+		EXPECT_EQ_HEX(results[0].pc, 0x08900000 + t * 4);
+	}
+	return true;
+}
+
+static void BenchmarkMemBlockInfo() {
+	// Lots of small scattered copies, like a game streaming data around with memcpy.
+	const int rounds = 10000;
+	u32 seed = 0x1234;
+	char tag[32];
+
+	int total = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < rounds; ++j) {
+			seed = seed * 1103515245 + 12345;
+			uint32_t start = 0x08800000 + (seed >> 8) % 0x01000000;
+			size_t len = snprintf(tag, sizeof(tag), "Memcpy/%d", j & 15);
+			NotifyMemInfoPC(MemBlockFlags::WRITE | MemBlockFlags::SKIP_MEMCHECK, start, 32 + (j & 0xFF), 0x08804000, tag, len);
+			++total;
+		}
+		MemBlockInfoFrameEnd();
+	} while (time_now_d() - st < 0.25);
+	// Make sure everything got processed.
+	FindMemInfo(0x08800000, 0x01000000);
+	double rate = total / (time_now_d() - st);
+	printf("MemBlockInfo: %0.2f M notifications/s\n", rate / 1000000.0);
+}
+
+bool TestMemBlockInfo() {
+	MemBlockInfoInit();
+	MemBlockOverrideDetailed();
+
+	bool success = TestMemBlockInfoRandom();
+	if (success) {
+		// Start over for the next tests.
+		MemBlockInfoShutdown();
+		MemBlockInfoInit();
+		success = TestMemBlockInfoThreads();
+	}
+	if (success)
+		BenchmarkMemBlockInfo();
+
+	MemBlockReleaseDetailed();
+	MemBlockInfoShutdown();
+	return success;
+}
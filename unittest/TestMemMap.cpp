@@ -0,0 +1,109 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Common/CommonTypes.h"
+#include "Core/MemMap.h"
+#include "Core/MemMapHelpers.h"
+
+#include "unittest/UnitTest.h"
+
+static bool TestCanonicalAddress() {
+	// Uncached and kernel mirrors of RAM.
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0x08800000), 0x08800000);
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0x48800000), 0x08800000);
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0x88800000), 0x08800000);
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0xC8812345), 0x08812345);
+
+	// VRAM also has swizzled and depth mirrors, every 2 MB.
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0x04000000), 0x04000000);
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0x04200010), 0x04000010);
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0x04600010), 0x04000010);
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0x44700010), 0x04100010);
+
+	// Scratchpad.
+	EXPECT_EQ_HEX(Memory::CanonicalAddress(0x40010000), 0x00010000);
+	return true;
+}
+
+static bool TestIsAddressInRange() {
+	EXPECT_TRUE(Memory::IsAddressInRange(0x08800000, 0x08800000, 0x20));
+	EXPECT_TRUE(Memory::IsAddressInRange(0x0880001F, 0x08800000, 0x20));
+	EXPECT_FALSE(Memory::IsAddressInRange(0x08800020, 0x08800000, 0x20));
+	EXPECT_FALSE(Memory::IsAddressInRange(0x087FFFFF, 0x08800000, 0x20));
+	EXPECT_FALSE(Memory::IsAddressInRange(0x08800000, 0x08800000, 0));
+
+	// Through mirrors, either way around.
+	EXPECT_TRUE(Memory::IsAddressInRange(0x48800010, 0x08800000, 0x20));
+	EXPECT_TRUE(Memory::IsAddressInRange(0x08800010, 0x48800000, 0x20));
+	EXPECT_FALSE(Memory::IsAddressInRange(0x48800020, 0x88800000, 0x20));
+
+	EXPECT_TRUE(Memory::IsAddressInRange(0x04200010, 0x04000000, 0x20));
+	EXPECT_TRUE(Memory::IsAddressInRange(0x04000010, 0x04600000, 0x20));
+	EXPECT_FALSE(Memory::IsAddressInRange(0x04200020, 0x04000000, 0x20));
+	// A range running past the end of one VRAM mirror continues at the start of VRAM.
+	EXPECT_TRUE(Memory::IsAddressInRange(0x04200008, 0x041FFFF0, 0x20));
+	EXPECT_TRUE(Memory::IsAddressInRange(0x04000008, 0x041FFFF0, 0x20));
+	EXPECT_FALSE(Memory::IsAddressInRange(0x04000010, 0x041FFFF0, 0x20));
+
+	// Ranges covering all of VRAM or RAM don't reach into the other.
+	EXPECT_FALSE(Memory::IsAddressInRange(0x08000000, 0x04000000, Memory::VRAM_SIZE));
+	EXPECT_FALSE(Memory::IsAddressInRange(0x44000000, 0x08000000, Memory::RAM_NORMAL_SIZE));
+	EXPECT_FALSE(Memory::IsAddressInRange(0x04000000, 0x48000000, Memory::RAM_NORMAL_SIZE));
+	return true;
+}
+
+static void FillPattern(u32 address, u32 len) {
+	u8 *ptr = Memory::GetPointerWrite(address);
+	for (u32 i = 0; i < len; ++i)
+		ptr[i] = (u8)(i * 7 + 1);
+}
+
+static bool CheckPattern(u32 address, u32 len) {
+	const u8 *ptr = Memory::GetPointer(address);
+	for (u32 i = 0; i < len; ++i) {
+		if (ptr[i] != (u8)(i * 7 + 1)) {
+			printf("CopyRange mismatch at %08x + %x\n", address, i);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Copies between two mirrors of the same memory, overlapping by all but a few bytes.
+static bool TestCopyOverlap(u32 base, u32 mirrorOffset) {
+	const u32 len = 0x1000;
+
+	// Forwards, where a plain front-to-back copy would read bytes it already wrote.
+	FillPattern(base, len);
+	EXPECT_TRUE(Memory::CopyRange(base + mirrorOffset + 0x10, base, len, nullptr));
+	RET(CheckPattern(base + 0x10, len));
+
+	// And backwards.
+	FillPattern(base + 0x10, len);
+	EXPECT_TRUE(Memory::CopyRange(base, base + mirrorOffset + 0x10, len, nullptr));
+	RET(CheckPattern(base, len));
+
+	// Through the mirror on the other side too.
+	FillPattern(base, len);
+	EXPECT_TRUE(Memory::CopyRange(base + 0x10, base + mirrorOffset, len, nullptr));
+	RET(CheckPattern(base + 0x10, len));
+	return true;
+}
+
+static bool TestCopyRange() {
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	Memory::Init();
+
+	bool success = TestCopyOverlap(0x08800000, 0x40000000) && TestCopyOverlap(0x08800000, 0x80000000) &&
+		TestCopyOverlap(0x04000000, 0x00200000) && TestCopyOverlap(0x04000000, 0x40600000);
+
+	Memory::Shutdown();
+	return success;
+}
+
+bool TestMemMap() {
+	RET(TestCanonicalAddress());
+	RET(TestIsAddressInRange());
+	RET(TestCopyRange());
+	return true;
+}
@@ -0,0 +1,186 @@
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The profiler itself is always built, the define only enables the macros and declarations.
+#ifndef USE_PROFILER
+#define USE_PROFILER
+#endif
+
+#include "Common/Data/Format/JSONReader.h"
+#include "Common/Profiler/Profiler.h"
+
+#include "unittest/UnitTest.h"
+
+struct TraceThreadEvents {
+	// Phase and name of each event, in order.
+	std::vector<std::pair<std::string, std::string>> events;
+
+	int Count(const char *phase, const char *name) const {
+		int count = 0;
+		for (const auto &ev : events) {
+			if (ev.first == phase && (!name || ev.second == name))
+				count++;
+		}
+		return count;
+	}
+};
+
+// Thread names aren't available everywhere, so threads are told apart by the scopes they log.
+static bool ParseTrace(const std::string &trace, std::vector<TraceThreadEvents> *threads) {
+	json::JsonReader reader(trace.data(), trace.size());
+	EXPECT_TRUE(reader.ok());
+	const JsonNode *traceEvents = reader.root().getArray("traceEvents");
+	EXPECT_TRUE(traceEvents != nullptr);
+
+	std::map<int, TraceThreadEvents> byId;
+	for (const JsonNode *node : traceEvents->value) {
+		json::JsonGet ev = node->value;
+		std::string phase = ev.getStringOr("ph", "");
+		TraceThreadEvents &thread = byId[ev.getInt("tid")];
+		if (phase != "M")
+			thread.events.emplace_back(phase, ev.getStringOr("name", ""));
+	}
+
+	threads->clear();
+	for (auto &iter : byId)
+		threads->push_back(std::move(iter.second));
+	return true;
+}
+
+static const TraceThreadEvents *FindThread(const std::vector<TraceThreadEvents> &threads, const char *name) {
+	for (const TraceThreadEvents &thread : threads) {
+		if (thread.Count("B", name) != 0)
+			return &thread;
+	}
+	return nullptr;
+}
+
+// Every end must have a begin before it, and everything must be closed at the end.
+static bool CheckBalanced(const TraceThreadEvents &thread) {
+	int depth = 0;
+	for (const auto &ev : thread.events) {
+		if (ev.first == "B") {
+			depth++;
+		} else if (ev.first == "E") {
+			EXPECT_TRUE(depth > 0);
+			depth--;
+		}
+	}
+	EXPECT_EQ_INT(depth, 0);
+	return true;
+}
+
+static void ProfileScope(const char *name) {
+	int thread;
+	int category = internal_profiler_enter(name, &thread);
+	internal_profiler_leave(thread, category);
+}
+
+static bool TestProfilerRingWrap() {
+	const int frame = Profiler_GetCurrentFrame();
+
+	// Way more than a ring holds, inside one long scope whose begin gets overwritten.
+	std::thread wrapThread([] {
+		int thread;
+		int outer = internal_profiler_enter("ProfilerOuter", &thread);
+		for (int i = 0; i < 100000; ++i)
+			ProfileScope("ProfilerInner");
+		internal_profiler_leave(thread, outer);
+	});
+	wrapThread.join();
+
+	// The thread has exited, but its events should still be there.
+	std::vector<TraceThreadEvents> threads;
+	RET(ParseTrace(Profiler_GetChromeTrace(frame, frame), &threads));
+	const TraceThreadEvents *wrap = FindThread(threads, "ProfilerInner");
+	EXPECT_TRUE(wrap != nullptr);
+	EXPECT_EQ_INT(wrap->Count("B", "ProfilerOuter"), 0);
+	EXPECT_TRUE(wrap->Count("B", "ProfilerInner") > 1000);
+	EXPECT_TRUE(wrap->Count("B", "ProfilerInner") < 100000);
+	EXPECT_EQ_INT(wrap->Count("E", nullptr), wrap->Count("B", nullptr));
+	RET(CheckBalanced(*wrap));
+
+	// Exporting doesn't throw them away by itself.
+	const size_t numThreads = threads.size();
+	RET(ParseTrace(Profiler_GetChromeTrace(frame, frame), &threads));
+	EXPECT_TRUE(FindThread(threads, "ProfilerInner") != nullptr);
+
+	// But now that they've been exported, a new thread takes the ring.
+	std::thread reuseThread([] {
+		ProfileScope("ProfilerReuse");
+	});
+	reuseThread.join();
+
+	RET(ParseTrace(Profiler_GetChromeTrace(frame, frame), &threads));
+	EXPECT_EQ_INT((int)threads.size(), (int)numThreads);
+	EXPECT_TRUE(FindThread(threads, "ProfilerInner") == nullptr);
+	const TraceThreadEvents *reuse = FindThread(threads, "ProfilerReuse");
+	EXPECT_TRUE(reuse != nullptr);
+	EXPECT_EQ_INT((int)reuse->events.size(), 2);
+	return true;
+}
+
+static bool TestProfilerFrameBalance() {
+	const int frame = Profiler_GetCurrentFrame();
+
+	// A scope that's still open when the frame ends, and another one after.
+	std::atomic<int> step{ 0 };
+	std::thread spanThread([&] {
+		int thread;
+		int category = internal_profiler_enter("ProfilerSpan", &thread);
+		step = 1;
+		while (step != 2)
+			std::this_thread::yield();
+		internal_profiler_leave(thread, category);
+		ProfileScope("ProfilerAfter");
+	});
+	while (step != 1)
+		std::this_thread::yield();
+	internal_profiler_end_frame();
+	step = 2;
+	spanThread.join();
+
+	// The first frame only has the begin, so the end is made up.
+	std::vector<TraceThreadEvents> threads;
+	RET(ParseTrace(Profiler_GetChromeTrace(frame, frame), &threads));
+	const TraceThreadEvents *first = FindThread(threads, "ProfilerSpan");
+	EXPECT_TRUE(first != nullptr);
+	EXPECT_EQ_INT(first->Count("B", "ProfilerSpan"), 1);
+	EXPECT_EQ_INT(first->Count("B", "ProfilerAfter"), 0);
+	EXPECT_EQ_INT((int)first->events.size(), 2);
+	RET(CheckBalanced(*first));
+
+	// And the second only has its end, which gets dropped.
+	RET(ParseTrace(Profiler_GetChromeTrace(frame + 1, frame + 1), &threads));
+	EXPECT_TRUE(FindThread(threads, "ProfilerSpan") == nullptr);
+	const TraceThreadEvents *second = FindThread(threads, "ProfilerAfter");
+	EXPECT_TRUE(second != nullptr);
+	EXPECT_EQ_INT((int)second->events.size(), 2);
+	RET(CheckBalanced(*second));
+
+	// Both together are just the two scopes.
+	RET(ParseTrace(Profiler_GetChromeTrace(frame, frame + 1), &threads));
+	const TraceThreadEvents *both = FindThread(threads, "ProfilerSpan");
+	EXPECT_TRUE(both != nullptr);
+	EXPECT_EQ_INT(both->Count("B", "ProfilerAfter"), 1);
+	EXPECT_EQ_INT((int)both->events.size(), 4);
+	RET(CheckBalanced(*both));
+	return true;
+}
+
+bool TestProfiler() {
+	// Only needed for the per-category history, which ending a frame updates.
+	static bool initialized = false;
+	if (!initialized) {
+		internal_profiler_init();
+		initialized = true;
+	}
+
+	RET(TestProfilerRingWrap());
+	RET(TestProfilerFrameBalance());
+	return true;
+}
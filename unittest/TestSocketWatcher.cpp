@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/FileDescriptor.h"
+#include "Common/Net/Resolve.h"
+#include "Common/Net/SocketCompat.h"
+#include "Common/Net/SocketWatcher.h"
+#include "Common/TimeUtil.h"
+
+#include "unittest/UnitTest.h"
+
+static const int PING_COUNT = 500;
+// What sceNetAdhoc used to wait between checks of a blocked socket.
+static const int RETRY_DELAY_US = 500;
+
+static int OpenLoopbackSocket(sockaddr_in &addr) {
+	int sock = (int)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0)
+		return -1;
+	addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addrlen = sizeof(addr);
+	if (bind(sock, (sockaddr *)&addr, sizeof(addr)) != 0 || getsockname(sock, (sockaddr *)&addr, &addrlen) != 0) {
+		closesocket(sock);
+		return -1;
+	}
+	fd_util::SetNonBlocking(sock, true);
+	return sock;
+}
+
+// One side of the ping-pong, standing in for a PPSSPP instance with a PSP thread blocked in a receive.
+struct PingInstance {
+	int sock = -1;
+	sockaddr_in addr{};
+
+	std::mutex lock;
+	std::condition_variable cv;
+	bool ready = false;
+	net::SocketWatcher watcher;
+
+	PingInstance() : watcher([this](uint64_t id) {
+		std::lock_guard<std::mutex> guard(lock);
+		ready = true;
+		cv.notify_one();
+	}) {
+		sock = OpenLoopbackSocket(addr);
+	}
+	~PingInstance() {
+		if (sock >= 0)
+			closesocket(sock);
+	}
+
+	// Waits for the next packet, either by checking on a timer or by letting the watcher wake us.
+	bool Receive(uint32_t &value, bool useWatcher) {
+		double st = time_now_d();
+		while (time_now_d() - st < 2.0) {
+			int ret = (int)recv(sock, (char *)&value, sizeof(value), MSG_NOSIGNAL);
+			if (ret == sizeof(value))
+				return true;
+			if (!useWatcher) {
+				std::this_thread::sleep_for(std::chrono::microseconds(RETRY_DELAY_US));
+				continue;
+			}
+
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				ready = false;
+			}
+			// Might have arrived between the recv and the watch, the watcher will see it anyway.
+			watcher.Watch(0, sock, true, false);
+			std::unique_lock<std::mutex> guard(lock);
+			cv.wait_for(guard, std::chrono::milliseconds(100), [this] { return ready; });
+		}
+		return false;
+	}
+
+	bool Send(const PingInstance &to, uint32_t value) {
+		return sendto(sock, (const char *)&value, sizeof(value), MSG_NOSIGNAL, (const sockaddr *)&to.addr, sizeof(to.addr)) == sizeof(value);
+	}
+};
+
+static bool TestSocketWatcherBasics() {
+	std::atomic<int> fired{ 0 };
+	std::atomic<uint64_t> lastId{ 0 };
+	net::SocketWatcher watcher([&](uint64_t id) {
+		lastId = id;
+		fired++;
+	});
+	EXPECT_TRUE(watcher.IsRunning());
+
+	sockaddr_in addrA, addrB;
+	int a = OpenLoopbackSocket(addrA);
+	int b = OpenLoopbackSocket(addrB);
+	EXPECT_TRUE(a >= 0 && b >= 0);
+
+	auto waitFired = [&](int count) {
+		double st = time_now_d();
+		while (fired < count && time_now_d() - st < 1.0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return fired == count;
+	};
+
+	// Nothing to read yet, so this shouldn't fire until something gets sent.
+	watcher.Watch(42, b, true, false);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	EXPECT_EQ_INT(fired, 0);
+	uint32_t value = 1;
+	sendto(a, (const char *)&value, sizeof(value), 0, (const sockaddr *)&addrB, sizeof(addrB));
+	EXPECT_TRUE(waitFired(1));
+	EXPECT_EQ_INT((int)lastId, 42);
+
+	// It only fires once, even though the data is still there.
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	EXPECT_EQ_INT(fired, 1);
+
+	// Watching again fires right away, since it's still readable.
+	watcher.Watch(43, b, true, false);
+	EXPECT_TRUE(waitFired(2));
+	EXPECT_EQ_INT((int)lastId, 43);
+
+	// Unwatched sockets stay quiet.
+	recv(b, (char *)&value, sizeof(value), 0);
+	watcher.Watch(44, b, true, false);
+	watcher.Unwatch(44);
+	sendto(a, (const char *)&value, sizeof(value), 0, (const sockaddr *)&addrB, sizeof(addrB));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	EXPECT_EQ_INT(fired, 2);
+
+	closesocket(a);
+	closesocket(b);
+	return true;
+}
+
+// Two instances bouncing a counter back and forth, measuring the round trip.
+static bool BenchmarkPingPong(bool useWatcher, double &avgUS, double &worstUS) {
+	PingInstance local, remote;
+	if (local.sock < 0 || remote.sock < 0)
+		return false;
+
+	std::atomic<bool> remoteOK{ true };
+	std::thread remoteThread([&] {
+		uint32_t value;
+		for (int i = 0; i < PING_COUNT; ++i) {
+			if (!remote.Receive(value, useWatcher) || !remote.Send(local, value + 1)) {
+				remoteOK = false;
+				return;
+			}
+		}
+	});
+
+	bool success = true;
+	double worst = 0.0;
+	double st = time_now_d();
+	for (int i = 0; i < PING_COUNT; ++i) {
+		double pingStart = time_now_d();
+		uint32_t value = 0;
+		if (!local.Send(remote, (uint32_t)i * 2) || !local.Receive(value, useWatcher)) {
+			success = false;
+			break;
+		}
+		if (value != (uint32_t)i * 2 + 1) {
+			printf("SocketWatcher: ping %d came back as %d\n", i * 2, value);
+			success = false;
+			break;
+		}
+		worst = std::max(worst, time_now_d() - pingStart);
+	}
+	double total = time_now_d() - st;
+	remoteThread.join();
+
+	avgUS = total * 1000000.0 / PING_COUNT;
+	worstUS = worst * 1000000.0;
+	return success && remoteOK;
+}
+
+bool TestSocketWatcher() {
+	net::Init();
+	bool success = TestSocketWatcherBasics();
+
+	if (success) {
+		double timerAvg, timerWorst, watcherAvg, watcherWorst;
+		success = BenchmarkPingPong(false, timerAvg, timerWorst) && BenchmarkPingPong(true, watcherAvg, watcherWorst);
+		if (success) {
+			printf("SocketWatcher: loopback round trip with %d us retries: %0.1f us average, %0.1f us worst\n", RETRY_DELAY_US, timerAvg, timerWorst);
+			printf("SocketWatcher: loopback round trip with readiness wakeups: %0.1f us average, %0.1f us worst\n", watcherAvg, watcherWorst);
+		}
+	}
+
+	net::Shutdown();
+	return success;
+}
@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/Debugger/MemBlockInfo.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "GPU/Common/TextureCacheCommon.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "GPU/GPUState.h"
+
+#include "unittest/UnitTest.h"
+
+static void FillRandom(u8 *data, size_t size, u32 seed) {
+	for (size_t i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (u8)(seed >> 16);
+	}
+}
+
+// Just enough of a texture cache to get at the decoders, without any draw context.
+class BandDecodeTextureCache : public TextureCacheCommon {
+public:
+	BandDecodeTextureCache() : TextureCacheCommon(nullptr, nullptr) {
+		// Any CLUT will do, as long as both passes use the same one.
+		FillRandom((u8 *)clutBufRaw_, 2048, 5);
+		FillRandom((u8 *)clutBufConverted_, 2048, 6);
+	}
+
+	void ForgetLastTexture() override {}
+	void ApplySamplingParams(const SamplerCacheKey &key) override {}
+	void DeviceLost() override {}
+	void DeviceRestore(Draw::DrawContext *draw) override {}
+	void *GetNativeTextureView(const TexCacheEntry *entry, bool flat) const override { return nullptr; }
+
+	// Banded once the level is big enough.
+	CheckAlphaResult DecodeLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, u32 texaddr, int bufw, TexDecodeFlags flags) {
+		return DecodeTextureLevel(out, outPitch, format, clutformat, texaddr, 0, bufw, flags);
+	}
+	CheckAlphaResult DecodeSinglePass(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, u32 texaddr, int bufw, TexDecodeFlags flags) {
+		const int w = gstate.getTextureWidth(0);
+		const int h = gstate.getTextureHeight(0);
+		return DecodeTextureRows(out, outPitch, format, clutformat, texaddr, Memory::GetPointer(texaddr), 0, bufw, w, h, gstate.isTextureSwizzled(), flags);
+	}
+
+protected:
+	void BindTexture(TexCacheEntry *entry) override {}
+	void Unbind() override {}
+	void ReleaseTexture(TexCacheEntry *entry, bool delete_them) override {}
+	void BuildTexture(TexCacheEntry *const entry) override {}
+	void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) override {}
+};
+
+struct BandDecodeCase {
+	GETextureFormat format;
+	GEPaletteFormat clutformat;
+	bool swizzled;
+	TexDecodeFlags flags;
+	int log2w;
+	int log2h;
+};
+
+static bool TestBandDecodeCase(BandDecodeTextureCache &cache, const BandDecodeCase &c, u32 texaddr) {
+	const int w = 1 << c.log2w;
+	const int h = 1 << c.log2h;
+	const int bufw = w;
+	gstate.texsize[0] = c.log2w | (c.log2h << 8);
+	gstate.texmode = c.swizzled ? 1 : 0;
+	// Full index mask, no shift or offset.
+	gstate.clutformat = c.clutformat | (0xFF << 8);
+
+	const u32 byteSize = (textureBitsPerPixel[c.format] * bufw * h) / 8;
+	u8 *texptr = Memory::GetPointerWriteRange(texaddr, byteSize);
+	EXPECT_TRUE(texptr != nullptr);
+	FillRandom(texptr, byteSize, c.format * 16 + c.log2h);
+
+	// Big enough for any output format, with the rest left alone.
+	const int outPitch = w * 4;
+	std::vector<u8> banded(outPitch * h, 0xCD);
+	std::vector<u8> single(outPitch * h, 0xCD);
+	CheckAlphaResult bandedAlpha = cache.DecodeLevel(banded.data(), outPitch, c.format, c.clutformat, texaddr, bufw, c.flags);
+	CheckAlphaResult singleAlpha = cache.DecodeSinglePass(single.data(), outPitch, c.format, c.clutformat, texaddr, bufw, c.flags);
+
+	if (banded != single || bandedAlpha != singleAlpha) {
+		printf("Banded decode mismatch: format %d clut %d swizzled %d flags %d %dx%d\n", c.format, c.clutformat, c.swizzled ? 1 : 0, (int)c.flags, w, h);
+		return false;
+	}
+	return true;
+}
+
+bool TestTextureBandDecode() {
+	static_assert(TEXCACHE_MIN_TEXELS_PARALLEL_DECODE == 256 * 128, "Update the sizes below");
+	static const BandDecodeCase cases[] = {
+		{ GE_TFMT_8888, GE_CMODE_16BIT_BGR5650, true, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_8888, GE_CMODE_16BIT_BGR5650, true, TexDecodeFlags::REVERSE_COLORS, 9, 8 },
+		{ GE_TFMT_5551, GE_CMODE_16BIT_BGR5650, true, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_4444, GE_CMODE_16BIT_BGR5650, true, TexDecodeFlags::EXPAND32, 8, 7 },
+		{ GE_TFMT_5650, GE_CMODE_16BIT_BGR5650, false, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_DXT1, GE_CMODE_16BIT_BGR5650, false, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_DXT3, GE_CMODE_16BIT_BGR5650, false, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_DXT5, GE_CMODE_16BIT_BGR5650, false, TexDecodeFlags{}, 9, 8 },
+		{ GE_TFMT_CLUT4, GE_CMODE_16BIT_ABGR4444, true, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_CLUT4, GE_CMODE_16BIT_ABGR5551, true, TexDecodeFlags::EXPAND32, 8, 7 },
+		{ GE_TFMT_CLUT4, GE_CMODE_32BIT_ABGR8888, false, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_CLUT4, GE_CMODE_32BIT_ABGR8888, true, TexDecodeFlags::TO_CLUT8, 8, 7 },
+		{ GE_TFMT_CLUT8, GE_CMODE_32BIT_ABGR8888, true, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_CLUT8, GE_CMODE_16BIT_ABGR4444, true, TexDecodeFlags::EXPAND32, 8, 7 },
+		{ GE_TFMT_CLUT8, GE_CMODE_16BIT_ABGR4444, true, TexDecodeFlags::TO_CLUT8, 8, 7 },
+		{ GE_TFMT_CLUT16, GE_CMODE_16BIT_ABGR5551, true, TexDecodeFlags{}, 8, 7 },
+		{ GE_TFMT_CLUT32, GE_CMODE_32BIT_ABGR8888, true, TexDecodeFlags{}, 8, 7 },
+	};
+
+	if (!g_threadManager.IsInitialized())
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	// Texture decoding tags memory, which wants a PC.
+	currentMIPS = &mipsr4k;
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	Memory::Init();
+	MemBlockInfoInit();
+	const GPUgstate savedState = gstate;
+
+	bool success = true;
+	{
+		BandDecodeTextureCache cache;
+		for (const BandDecodeCase &c : cases) {
+			// Both in RAM and in VRAM, where 512x256 at 32 bits just fits.
+			if (!TestBandDecodeCase(cache, c, 0x08800000) || !TestBandDecodeCase(cache, c, 0x04000000)) {
+				success = false;
+				break;
+			}
+		}
+	}
+
+	gstate = savedState;
+	MemBlockInfoShutdown();
+	Memory::Shutdown();
+	currentMIPS = nullptr;
+	return success;
+}
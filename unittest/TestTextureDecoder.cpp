@@ -0,0 +1,251 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/TimeUtil.h"
+#include "GPU/Common/TextureDecoder.h"
+
+#include "unittest/UnitTest.h"
+
+// Straightforward scalar versions, used both as the reference for the SIMD paths and as the
+// baseline for the timings. These match the original DeIndexTexture4 / DoUnswizzleTex16 loops.
+
+template <typename ClutT>
+static void RefDeIndexTexture4(ClutT *dest, const u8 *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
+	ClutT alphaSum = (ClutT)(-1);
+	while (length >= 2) {
+		u8 index = *indexed++;
+		ClutT color0 = clut[index & 0xf];
+		ClutT color1 = clut[index >> 4];
+		*dest++ = color0;
+		*dest++ = color1;
+		alphaSum &= color0 & color1;
+		length -= 2;
+	}
+	if (length) {
+		ClutT color0 = clut[*indexed & 0xf];
+		*dest = color0;
+		alphaSum &= color0;
+	}
+	*outAlphaSum &= (u32)alphaSum;
+}
+
+static void RefUnswizzleTex16(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch) {
+	const u32 pitchBy32 = pitch >> 2;
+	const u32 *src = (const u32 *)texptr;
+	for (int by = 0; by < byc; by++) {
+		for (int bx = 0; bx < bxc; bx++) {
+			for (int n = 0; n < 8; n++) {
+				memcpy(ydestp + n * pitchBy32 + bx * 4, src, 16);
+				src += 4;
+			}
+		}
+		ydestp += pitchBy32 * 8;
+	}
+}
+
+// Each of these reruns the tests with the x86 paths turned off one by one, so all get covered.
+struct CPUFeatureLevel {
+	const char *name;
+	bool avx2;
+	bool ssse3;
+};
+
+template <typename ClutT>
+static bool CompareDeIndexTexture4(const char *levelName, const ClutT *clut, const u8 *indexed, int length, int destOffset) {
+	static ClutT expected[4096 + 64];
+	static ClutT actual[4096 + 64];
+	// Fill with junk so we notice writes past the end.
+	memset(expected, 0xCD, sizeof(expected));
+	memset(actual, 0xCD, sizeof(actual));
+
+	u32 expectedAlpha = 0xFFFFFFFF;
+	u32 actualAlpha = 0xFFFFFFFF;
+	RefDeIndexTexture4(expected + destOffset, indexed, length, clut, &expectedAlpha);
+	DeIndexTexture4Simple(actual + destOffset, indexed, length, clut, &actualAlpha);
+
+	if (memcmp(expected, actual, sizeof(expected)) != 0 || expectedAlpha != actualAlpha) {
+		printf("DeIndexTexture4Simple mismatch: %s %d-bit length %d offset %d (alpha %08x vs %08x)\n", levelName, (int)sizeof(ClutT) * 8, length, destOffset, expectedAlpha, actualAlpha);
+		return false;
+	}
+	return true;
+}
+
+static bool TestDeIndexTexture4Correctness(const char *levelName) {
+	static const int lengths[] = { 0, 1, 2, 3, 15, 16, 31, 32, 33, 63, 64, 65, 100, 127, 480, 512, 4095, 4096 };
+
+	std::vector<u8> indexed(2048 + 16);
+	u32 seed = 0x13579BD;
+	for (size_t i = 0; i < indexed.size(); i++) {
+		seed = seed * 1103515245 + 12345;
+		indexed[i] = (u8)(seed >> 16);
+	}
+
+	alignas(16) u16 clut16[16 + 8];
+	alignas(16) u32 clut32[16 + 4];
+	for (int pass = 0; pass < 3; ++pass) {
+		for (int i = 0; i < 16; ++i) {
+			seed = seed * 1103515245 + 12345;
+			clut32[i] = seed;
+			clut16[i] = (u16)(seed >> 8);
+			// The second pass has full alpha everywhere, the third has one gap near the end.
+			if (pass >= 1) {
+				clut32[i] |= 0xFF000000;
+				clut16[i] |= 0x8000;
+			}
+		}
+		if (pass == 2) {
+			clut32[14] &= 0x00FFFFFF;
+			clut16[14] &= 0x7FFF;
+		}
+
+		for (int length : lengths) {
+			for (int offset = 0; offset < 4; ++offset) {
+				// Start at an unaligned index pointer too, DecodeTextureRows doesn't promise alignment.
+				RET(CompareDeIndexTexture4(levelName, clut16, indexed.data() + offset, length, offset));
+				RET(CompareDeIndexTexture4(levelName, clut32, indexed.data() + offset, length, offset));
+			}
+		}
+	}
+	return true;
+}
+
+static bool TestUnswizzleCorrectness() {
+	static const int blockCounts[][2] = { { 1, 1 }, { 1, 8 }, { 4, 2 }, { 8, 8 }, { 32, 4 } };
+
+	for (auto &counts : blockCounts) {
+		const int bxc = counts[0];
+		const int byc = counts[1];
+		// Test both an exact pitch and one with extra space.
+		for (int extra = 0; extra < 2; ++extra) {
+			const u32 pitch = bxc * 16 + extra * 32;
+			std::vector<u32> src(bxc * byc * 32);
+			for (size_t i = 0; i < src.size(); ++i)
+				src[i] = (u32)(i * 2654435761U);
+			std::vector<u32> expected(pitch / 4 * byc * 8, 0xCDCDCDCD);
+			std::vector<u32> actual(pitch / 4 * byc * 8, 0xCDCDCDCD);
+
+			RefUnswizzleTex16((const u8 *)src.data(), expected.data(), bxc, byc, pitch);
+			DoUnswizzleTex16((const u8 *)src.data(), actual.data(), bxc, byc, pitch);
+			if (expected != actual) {
+				printf("DoUnswizzleTex16 mismatch: %dx%d blocks, pitch %d\n", bxc, byc, pitch);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+template <typename ClutT>
+static void BenchmarkDeIndexTexture4(const char *desc, const u8 *indexed, int length, const ClutT *clut, ClutT *out) {
+	const int rounds = 200;
+
+	int total = 0;
+	u32 alpha = 0xFFFFFFFF;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < rounds; ++j) {
+			RefDeIndexTexture4(out, indexed, length, clut, &alpha);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	double scalarRate = total / (time_now_d() - st);
+
+	total = 0;
+	st = time_now_d();
+	do {
+		for (int j = 0; j < rounds; ++j) {
+			DeIndexTexture4Simple(out, indexed, length, clut, &alpha);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	double simdRate = total / (time_now_d() - st);
+
+	const double mpixScale = length / 1000000.0;
+	printf("%-24s scalar: %8.1f Mpix/s, DeIndexTexture4Simple: %8.1f Mpix/s (%0.2fx)\n", desc, scalarRate * mpixScale, simdRate * mpixScale, simdRate / scalarRate);
+}
+
+static void BenchmarkUnswizzle() {
+	// A 512x256 16-bit texture, the worst a PSP game will usually throw at us.
+	const int bxc = 512 * 2 / 16;
+	const int byc = 256 / 8;
+	const u32 pitch = bxc * 16;
+	std::vector<u32> src(bxc * byc * 32);
+	std::vector<u32> dest(src.size());
+	const int rounds = 20;
+
+	int total = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < rounds; ++j) {
+			RefUnswizzleTex16((const u8 *)src.data(), dest.data(), bxc, byc, pitch);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	double scalarRate = total / (time_now_d() - st);
+
+	total = 0;
+	st = time_now_d();
+	do {
+		for (int j = 0; j < rounds; ++j) {
+			DoUnswizzleTex16((const u8 *)src.data(), dest.data(), bxc, byc, pitch);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	double simdRate = total / (time_now_d() - st);
+
+	const double mbScale = (src.size() * 4) / (1024.0 * 1024.0);
+	printf("%-24s scalar: %8.1f MB/s, DoUnswizzleTex16: %8.1f MB/s (%0.2fx)\n", "unswizzle 512x256", scalarRate * mbScale, simdRate * mbScale, simdRate / scalarRate);
+}
+
+static void BenchmarkTextureDecoder(const char *levelName) {
+	// A 512 wide row is the common case, but let's do a whole 512x32 band at once.
+	const int length = 512 * 32;
+	std::vector<u8> indexed(length / 2);
+	for (int i = 0; i < (int)indexed.size(); ++i)
+		indexed[i] = (u8)(i * 37);
+	alignas(16) u16 clut16[16];
+	alignas(16) u32 clut32[16];
+	for (int i = 0; i < 16; ++i) {
+		clut16[i] = (u16)(0x8000 | (i * 0x0421));
+		clut32[i] = 0xFF000000 | (i * 0x00111111);
+	}
+	std::vector<u16> out16(length);
+	std::vector<u32> out32(length);
+
+	char desc[64];
+	snprintf(desc, sizeof(desc), "clut4->16 %s", levelName);
+	BenchmarkDeIndexTexture4(desc, indexed.data(), length, clut16, out16.data());
+	snprintf(desc, sizeof(desc), "clut4->32 %s", levelName);
+	BenchmarkDeIndexTexture4(desc, indexed.data(), length, clut32, out32.data());
+}
+
+bool TestTextureDecoder() {
+	const CPUInfo savedInfo = cpu_info;
+	const CPUFeatureLevel levels[] = {
+		{ "native", cpu_info.bAVX2, cpu_info.bSSSE3 },
+		{ "ssse3", false, cpu_info.bSSSE3 },
+		{ "scalar", false, false },
+	};
+
+	bool success = true;
+	for (const CPUFeatureLevel &level : levels) {
+		// Only the x86 paths check cpu_info, elsewhere these will all be the same.
+		cpu_info.bAVX2 = level.avx2;
+		cpu_info.bSSSE3 = level.ssse3;
+		if (!TestDeIndexTexture4Correctness(level.name)) {
+			success = false;
+			break;
+		}
+		// The interesting thing here is the logged output.
+		BenchmarkTextureDecoder(level.name);
+	}
+	cpu_info = savedInfo;
+
+	if (!success || !TestUnswizzleCorrectness())
+		return false;
+	BenchmarkUnswizzle();
+	return true;
+}
@@ -0,0 +1,178 @@
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Serialize/SerializeFuncs.h"
+#include "Common/TimeUtil.h"
+#include "Core/HLE/ThreadQueueList.h"
+
+#include "unittest/UnitTest.h"
+
+// Straightforward model of the scheduler's ready queue: one FIFO per priority, and the best
+// (lowest) priority wins.  The real thing has to pick exactly the same threads in the same order.
+struct ReferenceReadyQueue {
+	std::deque<SceUID> queues[ThreadQueueList::NUM_QUEUES];
+
+	SceUID pop_first_better(u32 priority) {
+		for (u32 i = 0; i < priority && i < ThreadQueueList::NUM_QUEUES; ++i) {
+			if (!queues[i].empty()) {
+				SceUID id = queues[i].front();
+				queues[i].pop_front();
+				return id;
+			}
+		}
+		return 0;
+	}
+
+	SceUID peek_first() const {
+		for (const auto &q : queues) {
+			if (!q.empty())
+				return q.front();
+		}
+		return 0;
+	}
+
+	void remove(u32 priority, SceUID id) {
+		auto &q = queues[priority];
+		for (auto it = q.begin(); it != q.end(); ++it) {
+			if (*it == id) {
+				q.erase(it);
+				return;
+			}
+		}
+	}
+
+	void rotate(u32 priority) {
+		auto &q = queues[priority];
+		if (q.size() > 1) {
+			q.push_back(q.front());
+			q.pop_front();
+		}
+	}
+};
+
+static bool TestThreadQueueListStress() {
+	// Enough threads at few enough priorities to hit rebalancing and growth.
+	const int NUM_THREADS = 300;
+	static const u32 priorities[] = { 0, 8, 16, 17, 31, 32, 32, 33, 63, 64, 95, 110, 111, 126, 127 };
+
+	ThreadQueueList list;
+	ReferenceReadyQueue ref;
+	// -1 when not queued, otherwise the priority it's queued at.
+	std::vector<int> queuedAt(NUM_THREADS + 1, -1);
+
+	u32 seed = 0x2468ACE;
+	auto nextRand = [&]() {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	};
+
+	for (int iter = 0; iter < 200000; ++iter) {
+		SceUID id = 1 + nextRand() % NUM_THREADS;
+		u32 op = nextRand() % 8;
+		switch (op) {
+		case 0:
+		case 1:
+		case 2:
+			if (queuedAt[id] == -1) {
+				u32 priority = priorities[nextRand() % ARRAY_SIZE(priorities)];
+				list.prepare(priority);
+				if (op == 0) {
+					list.push_front(priority, id);
+					ref.queues[priority].push_front(id);
+				} else {
+					list.push_back(priority, id);
+					ref.queues[priority].push_back(id);
+				}
+				queuedAt[id] = priority;
+			}
+			break;
+
+		case 3:
+			if (queuedAt[id] != -1) {
+				list.remove(queuedAt[id], id);
+				ref.remove(queuedAt[id], id);
+				queuedAt[id] = -1;
+			}
+			break;
+
+		case 4:
+		{
+			u32 priority = priorities[nextRand() % ARRAY_SIZE(priorities)];
+			list.prepare(priority);
+			list.rotate(priority);
+			ref.rotate(priority);
+			EXPECT_EQ_INT(list.empty(priority), ref.queues[priority].empty());
+			break;
+		}
+
+		case 5:
+		case 6:
+		{
+			// Like __KernelNextThread() with a running thread at this priority.
+			u32 priority = priorities[nextRand() % ARRAY_SIZE(priorities)] + 1;
+			SceUID expected = ref.pop_first_better(priority);
+			SceUID actual = list.pop_first_better(priority);
+			EXPECT_EQ_INT(actual, expected);
+			if (actual != 0)
+				queuedAt[actual] = -1;
+			break;
+		}
+
+		case 7:
+			EXPECT_EQ_INT(list.peek_first(), ref.peek_first());
+			if (ref.peek_first() != 0) {
+				SceUID expected = ref.pop_first_better(ThreadQueueList::NUM_QUEUES);
+				SceUID actual = list.pop_first();
+				EXPECT_EQ_INT(actual, expected);
+				queuedAt[actual] = -1;
+			}
+			break;
+		}
+	}
+
+	// Drain what's left, which should come out in the same order too.
+	while (ref.peek_first() != 0) {
+		SceUID expected = ref.pop_first_better(ThreadQueueList::NUM_QUEUES);
+		EXPECT_EQ_INT(list.pop_first(), expected);
+	}
+	EXPECT_EQ_INT(list.peek_first(), 0);
+	EXPECT_EQ_INT(list.pop_first_better(ThreadQueueList::NUM_QUEUES), 0);
+	return true;
+}
+
+static void BenchmarkThreadQueueList() {
+	// Lots of threads, spread around like a busy game.  Mostly the lower priorities are sleeping.
+	const int NUM_THREADS = 64;
+	ThreadQueueList list;
+	for (int i = 0; i < NUM_THREADS; ++i) {
+		u32 priority = 16 + (i % 16) * 6;
+		list.prepare(priority);
+		list.push_back(priority, i + 1);
+	}
+
+	int total = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < 10000; ++j) {
+			// Reschedule with a running thread at priority 0x10, nothing better ready.
+			if (list.pop_first_better(0x10) != 0)
+				return;
+			// And switch among the best ones.
+			SceUID id = list.pop_first();
+			list.push_back(16, id);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	double rate = total / (time_now_d() - st);
+	printf("ThreadQueueList: %0.1f M reschedules/s\n", rate / 1000000.0);
+}
+
+bool TestThreadQueueList() {
+	if (!TestThreadQueueListStress())
+		return false;
+
+	BenchmarkThreadQueueList();
+	return true;
+}
@@ -1248,6 +1248,23 @@ bool TestSoftwareGPUJit();
 bool TestIRPassSimplify();
 bool TestThreadManager();
 bool TestVFS();
+bool TestIndexGenerator();
+bool TestThreadQueueList();
+bool TestTextureDecoder();
+bool TestLogManager();
+bool TestMemBlockInfo();
+bool TestAdhocServer();
+bool TestSocketWatcher();
+bool TestHTTPServer();
+bool TestHTTPFileLoader();
+bool TestBlockAllocator();
+bool TestGameInfoIndex();
+bool TestCompressedISO();
+bool TestTextureBandDecode();
+bool TestProfiler();
+bool TestHLEScratch();
+bool TestDirectoryFileSystem();
+bool TestMemMap();
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -1263,6 +1280,7 @@ TestItem availableTests[] = {
 	TEST_ITEM(RiscVEmitter),
 #endif
 	TEST_ITEM(VertexJit),
+	TEST_ITEM(IndexGenerator),
 	TEST_ITEM(Asin),
 	TEST_ITEM(SinCos),
 	TEST_ITEM(VFPUSinCos),
@@ -1270,6 +1288,7 @@ TestItem availableTests[] = {
 	TEST_ITEM(Parsers),
 	TEST_ITEM(IRPassSimplify),
 	TEST_ITEM(Jit),
+	TEST_ITEM(IdleLoop),
 	TEST_ITEM(VFPUMatrixTranspose),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
@@ -1280,6 +1299,22 @@ TestItem availableTests[] = {
 	TEST_ITEM(Path),
 	TEST_ITEM(AndroidContentURI),
 	TEST_ITEM(ThreadManager),
+	TEST_ITEM(ThreadQueueList),
+	TEST_ITEM(TextureDecoder),
+	TEST_ITEM(LogManager),
+	TEST_ITEM(MemBlockInfo),
+	TEST_ITEM(AdhocServer),
+	TEST_ITEM(SocketWatcher),
+	TEST_ITEM(HTTPServer),
+	TEST_ITEM(HTTPFileLoader),
+	TEST_ITEM(BlockAllocator),
+	TEST_ITEM(GameInfoIndex),
+	TEST_ITEM(CompressedISO),
+	TEST_ITEM(TextureBandDecode),
+	TEST_ITEM(Profiler),
+	TEST_ITEM(HLEScratch),
+	TEST_ITEM(DirectoryFileSystem),
+	TEST_ITEM(MemMap),
 	TEST_ITEM(WrapText),
 	TEST_ITEM(TinySet),
 	TEST_ITEM(FastVec),